@@ -0,0 +1,46 @@
+#pragma once
+
+#include <openvr_driver.h>
+
+namespace vr {
+
+// Cache of the properties mirroring decisions depend on, plus the physical-index -> registry-slot
+// map. Entries are only re-read from IVRProperties when an event names their device, so frames
+// without device events never query properties. Host thread only.
+class DeviceDiscovery {
+ public:
+  static const uint32_t k_unNoSlot = 0xFFFFFFFF;
+
+  DeviceDiscovery();
+
+  // Forgets every cached device and mapping
+  void Reset();
+
+  // Re-reads the class (and, for controllers, the role hint) of one physical device.
+  // Returns true if the cached values changed.
+  bool RefreshDevice(uint32_t unPhysicalIndex);
+
+  // Fills an entry without asking the host, e.g. from a recording being replayed
+  void SetDevice(uint32_t unPhysicalIndex, int32_t nDeviceClass, int32_t nControllerRole);
+
+  // Drops a device's cached properties so the next RefreshDevice re-reads them
+  void Invalidate(uint32_t unPhysicalIndex);
+
+  int32_t GetDeviceClass(uint32_t unPhysicalIndex) const { return m_nDeviceClass[unPhysicalIndex]; }
+  int32_t GetControllerRole(uint32_t unPhysicalIndex) const { return m_nControllerRole[unPhysicalIndex]; }
+
+  // Whole tables, in PoseRecordingHeader layout
+  const int32_t* GetDeviceClasses() const { return m_nDeviceClass; }
+  const int32_t* GetControllerRoles() const { return m_nControllerRole; }
+
+  // O(1) physical index -> mirror slot, k_unNoSlot if the device is not mirrored
+  uint32_t GetMirrorSlot(uint32_t unPhysicalIndex) const { return m_unMirrorSlot[unPhysicalIndex]; }
+  void SetMirrorSlot(uint32_t unPhysicalIndex, uint32_t unSlot) { m_unMirrorSlot[unPhysicalIndex] = unSlot; }
+
+ private:
+  int32_t m_nDeviceClass[vr::k_unMaxTrackedDeviceCount];    // ETrackedDeviceClass, Invalid if unknown
+  int32_t m_nControllerRole[vr::k_unMaxTrackedDeviceCount]; // ETrackedControllerRole, Invalid for non-controllers
+  uint32_t m_unMirrorSlot[vr::k_unMaxTrackedDeviceCount];
+};
+
+}  // namespace vr
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+// Asynchronous, allocation-free driver logging.
+//
+//   DRIVER_LOG_INFO(DriverLogCategory_Provider, "Mirroring {} device(s) at {} Hz", count, rate);
+//
+// Each "{}" in the format takes the next argument. The format must be a string literal (only the
+// pointer is stored). A statement whose level is disabled costs one load and one branch and does
+// not evaluate its arguments. Enabled statements pack their arguments into a fixed-size record in
+// a lock-free ring; a background thread formats the records and forwards them to VRDriverLog.
+
+namespace vr {
+
+enum EDriverLogLevel : uint8_t {
+  DriverLogLevel_Error = 0,
+  DriverLogLevel_Warning = 1,
+  DriverLogLevel_Info = 2,
+  DriverLogLevel_Verbose = 3,  // Per-event detail (was ENABLE_VERBOSE_CONTROLLER_LOGGING)
+  DriverLogLevel_Trace = 4,    // Per-frame detail (was ENABLE_VERY_VERBOSE_CONTROLLER_LOGGING)
+};
+
+enum EDriverLogCategory : uint8_t {
+  DriverLogCategory_Provider = 0, // MyTrackedDeviceProvider lifecycle and settings
+  DriverLogCategory_Device,       // MyControllerDriver lifecycle
+  DriverLogCategory_Pose,         // Per-frame pose pipeline
+  DriverLogCategory_Recording,    // Pose recording/replay
+  DriverLogCategory_Count
+};
+
+static const uint32_t k_unDriverLogMaxArgs = 8;
+static const uint32_t k_unDriverLogTextSize = 160; // Shared storage for string arguments, truncated when full
+
+enum EDriverLogArgType : uint8_t {
+  DriverLogArg_Int,
+  DriverLogArg_UInt,
+  DriverLogArg_Double,
+  DriverLogArg_Bool,
+  DriverLogArg_Text, // Offset into DriverLogRecord::rgchText
+};
+
+struct DriverLogRecord {
+  double flTimestamp; // Seconds since the driver was loaded, printed at the start of the line
+  const char* pchFormat;
+  EDriverLogLevel eLevel;
+  EDriverLogCategory eCategory;
+  uint8_t unArgCount;
+  uint8_t unTextUsed;
+  EDriverLogArgType eArgType[k_unDriverLogMaxArgs];
+  union {
+    int64_t i;
+    uint64_t u;
+    double d;
+  } args[k_unDriverLogMaxArgs];
+  char rgchText[k_unDriverLogTextSize];
+};
+
+// Starts the background writer (call after the driver context is initialized) and stops it,
+// draining anything still queued (call before the driver context is cleaned up).
+void DriverLogStart();
+void DriverLogStop();
+
+// Runtime configuration. Levels apply per category; the rate limit caps Info and more detailed records
+// per category per second, while errors and warnings are never rate limited.
+void DriverLogSetLevel(EDriverLogLevel eLevel);
+void DriverLogSetCategoryLevel(EDriverLogCategory eCategory, EDriverLogLevel eLevel);
+void DriverLogSetRateLimit(uint32_t unRecordsPerSecond);
+
+// Category names as they appear in the log lines ("provider", "device", ...), and the reverse lookup
+const char* DriverLogGetCategoryName(EDriverLogCategory eCategory);
+bool DriverLogFindCategory(const char* pchName, EDriverLogCategory& outCategory);
+
+// Records dropped because the ring was full or the category was over its rate limit
+uint64_t DriverLogGetDroppedCount();
+
+extern std::atomic<uint8_t> g_rgDriverLogLevel[DriverLogCategory_Count];
+
+inline bool DriverLogEnabled(EDriverLogLevel eLevel, EDriverLogCategory eCategory) {
+  return eLevel <= g_rgDriverLogLevel[eCategory].load(std::memory_order_relaxed);
+}
+
+// Timestamps and queues a packed record; drops it if the ring is full or (below Warning) the category is rate limited
+void DriverLogSubmit(DriverLogRecord& record);
+
+// Argument packing
+
+void DriverLogPackText(DriverLogRecord& record, const char* pchText);
+
+template <typename T>
+inline void DriverLogPackArg(DriverLogRecord& record, const T& value) {
+  if (record.unArgCount >= k_unDriverLogMaxArgs) {
+    return;
+  }
+  const uint8_t index = record.unArgCount;
+  if constexpr (std::is_same<T, bool>::value) {
+    record.eArgType[index] = DriverLogArg_Bool;
+    record.args[index].u = value ? 1 : 0;
+  } else if constexpr (std::is_enum<T>::value) {
+    record.eArgType[index] = DriverLogArg_Int;
+    record.args[index].i = (int64_t)value;
+  } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+    record.eArgType[index] = DriverLogArg_Int;
+    record.args[index].i = (int64_t)value;
+  } else if constexpr (std::is_integral<T>::value) {
+    record.eArgType[index] = DriverLogArg_UInt;
+    record.args[index].u = (uint64_t)value;
+  } else if constexpr (std::is_floating_point<T>::value) {
+    record.eArgType[index] = DriverLogArg_Double;
+    record.args[index].d = (double)value;
+  } else if constexpr (std::is_same<T, std::string>::value) {
+    DriverLogPackText(record, value.c_str());
+    return;
+  } else {
+    static_assert(std::is_convertible<const T&, const char*>::value, "Unsupported driver log argument type");
+    DriverLogPackText(record, static_cast<const char*>(value));
+    return;
+  }
+  record.unArgCount = index + 1;
+}
+
+template <typename... Args>
+void DriverLogWrite(EDriverLogLevel eLevel, EDriverLogCategory eCategory, const char* pchFormat, const Args&... args) {
+  DriverLogRecord record;
+  record.pchFormat = pchFormat;
+  record.eLevel = eLevel;
+  record.eCategory = eCategory;
+  record.unArgCount = 0;
+  record.unTextUsed = 0;
+  (DriverLogPackArg(record, args), ...);
+  DriverLogSubmit(record);
+}
+
+}  // namespace vr
+
+#define DRIVER_LOG(level, category, ...)                                  \
+  do {                                                                    \
+    if (::vr::DriverLogEnabled(level, category)) {                        \
+      ::vr::DriverLogWrite(level, category, __VA_ARGS__);                 \
+    }                                                                     \
+  } while (0)
+
+#define DRIVER_LOG_ERROR(category, ...) DRIVER_LOG(::vr::DriverLogLevel_Error, category, __VA_ARGS__)
+#define DRIVER_LOG_WARNING(category, ...) DRIVER_LOG(::vr::DriverLogLevel_Warning, category, __VA_ARGS__)
+#define DRIVER_LOG_INFO(category, ...) DRIVER_LOG(::vr::DriverLogLevel_Info, category, __VA_ARGS__)
+#define DRIVER_LOG_VERBOSE(category, ...) DRIVER_LOG(::vr::DriverLogLevel_Verbose, category, __VA_ARGS__)
+#define DRIVER_LOG_TRACE(category, ...) DRIVER_LOG(::vr::DriverLogLevel_Trace, category, __VA_ARGS__)
@@ -1,9 +1,22 @@
 #pragma once
 
 #include <openvr_driver.h>
+#include <array> // Required for the per-frame pose snapshot
+#include <atomic>
+#include <chrono> // For the inline dormant sampling deadline
+#include <condition_variable> // Wakes the tracking thread from its dormant wait
 #include <memory> // Required for std::unique_ptr
+#include <mutex>
+#include <thread> // Required for the optional tracking thread
+#include <vector>
 
+#include "device_discovery.h" // Property cache and physical index -> slot map
+#include "input_mirror.h" // Mirrored controller buttons, axes and haptics
+#include "mirror_registry.h" // Per-device mirroring state
 #include "my_controller_driver.h" // Include the new controller driver header
+#include "external_pose_source.h" // Poses from an external tracker
+#include "pose_exporter.h" // Shared-memory pose export
+#include "pose_recording.h" // Raw pose recording and replay
 
 namespace vr { // Added namespace
 
@@ -12,7 +25,7 @@ class MyTrackedDeviceProvider : public vr::IServerTrackedDeviceProvider { // Add
   MyTrackedDeviceProvider(); // Added constructor
   virtual ~MyTrackedDeviceProvider(); // Added destructor
 
-  // Member variables to store device indices
+  // Physical indices of the first left/right hand controllers being mirrored
   uint32_t m_unLeftControllerDeviceIndex;
   uint32_t m_unRightControllerDeviceIndex;
 
@@ -25,9 +38,70 @@ class MyTrackedDeviceProvider : public vr::IServerTrackedDeviceProvider { // Add
   virtual void LeaveStandby() override;
 
  private: // Added private section
-  std::unique_ptr<MyControllerDriver> left_controller_;
-  std::unique_ptr<MyControllerDriver> right_controller_;
+  // Creates a MyControllerDriver for a registry slot mirroring unPhysicalIndex and adds it to the host
+  bool AddMirroredDevice(uint32_t unPhysicalIndex, vr::ETrackedDeviceClass eDeviceClass, int32_t nControllerRole);
+  // Adds a mirror for a cached controller or generic tracker that doesn't have one yet
+  bool MirrorDeviceIfNeeded(uint32_t unPhysicalIndex);
 
+  // Incremental discovery: drains the host's event queue and only re-reads the devices an event names
+  void PollDeviceEvents();
+  bool IsOwnMirror(uint32_t unDeviceIndex) const;
+  void OnDeviceActivated(uint32_t unDeviceIndex);
+  void OnDeviceDeactivated(uint32_t unDeviceIndex);
+  void OnControllerRoleChanged(uint32_t unDeviceIndex);
+
+  // Discovery for pose sources that define their own devices: copies their classes and roles into m_discovery
+  void SyncSourceDevices();
+  void OnSourceDevicesChanged();
+
+  DeviceDiscovery m_discovery;
+
+  // Hot per-device state lives in the registry; the driver objects are only the host-facing side
+  MirrorRegistry m_registry;
+  InputMirror m_input; // Controllers only; indexed by the same slots as m_registry
+  std::vector<std::unique_ptr<MyControllerDriver>> m_mirroredDevices;
+
+  // Fills one raw pose snapshot, from the host or from m_replay, and appends it to m_recorder if recording
+  void SampleRawPoses(vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount);
+
+  PoseRecorder m_recorder;
+  PoseReplay m_replay;
+
+  // Where SampleRawPoses reads from: m_hostSource, m_replay or m_externalSource
+  HostPoseSource m_hostSource;
+  std::unique_ptr<IPoseSource> m_externalSource;
+  IPoseSource* m_pPoseSource;
+  uint32_t m_unSourceDeviceChangeCount; // Last GetDeviceChangeCount() synced into m_discovery
+
+  // For sources that provide input: publishes each slot's new input state into m_input and hands the
+  // haptic pulses requested on it back to the source. Host thread, once per frame.
+  void ExchangeSourceInput();
+  std::array<uint32_t, MirrorRegistry::k_unMaxSlots> m_unSourceInputSeen; // TakeInputState version per slot
+  std::array<uint32_t, MirrorRegistry::k_unMaxSlots> m_unHapticPulseSeen; // TakeHapticPulse version per slot
+  PoseExporter m_exporter;
+
+  // One raw pose snapshot per frame, shared read-only by every mirrored device.
+  // Preallocated here so RunFrame never touches the heap.
+  std::array<vr::TrackedDevicePose_t, vr::k_unMaxTrackedDeviceCount> m_rawPoses;
+
+  // Optional driver-owned tracking thread. When m_flTrackingThreadHz > 0 it samples and converts
+  // poses at that rate and RunFrame only submits the latest published pose of each device.
+  void StartTrackingThread();
+  void StopTrackingThread();
+  void TrackingThreadMain();
+  // Cuts the tracking thread's dormant wait short, e.g. when a device may have come back. Host thread.
+  void WakeTrackingThread();
+
+  float m_flTrackingThreadHz; // 0 = sample inline in RunFrame
+  std::chrono::steady_clock::time_point m_nextInlineSample; // Inline sampling waits for this while every mirror is dormant
+  std::atomic<bool> m_bStandby; // Between EnterStandby and LeaveStandby; RunFrame only drains events and nothing samples
+  std::thread m_trackingThread;
+  std::atomic<bool> m_bTrackingThreadRunning;
+  std::atomic<bool> m_bTrackingThreadDormant; // Waiting out a dormant interval in m_trackingWake
+  std::mutex m_trackingWakeMutex;
+  std::condition_variable m_trackingWake;
+  bool m_bTrackingWakeRequested; // Guarded by m_trackingWakeMutex
+  std::array<vr::TrackedDevicePose_t, vr::k_unMaxTrackedDeviceCount> m_trackingThreadRawPoses; // Owned by the tracking thread
 };
 
 }  // namespace vr // Added namespace
@@ -0,0 +1,79 @@
+#pragma once
+
+// Section and key names for the driver's IVRSettings entries.
+// Defaults live in driver/resources/settings/default.vrsettings.
+
+namespace vr {
+
+static const char* const k_pch_MyDriver_Section = "driver_mydriver";
+
+// Pose prediction (see pose_prediction.h)
+static const char* const k_pch_MyDriver_PredictionMode_Int32 = "predictionMode";
+static const char* const k_pch_MyDriver_PredictionHorizonMs_Float = "predictionHorizonMs";
+
+// Tracking thread rate, 0 samples inline on the RunFrame thread
+static const char* const k_pch_MyDriver_TrackingThreadHz_Float = "trackingThreadHz";
+
+// Change detection for pose submissions (see pose_change_detection.h)
+static const char* const k_pch_MyDriver_SuppressUnchangedPoses_Bool = "suppressUnchangedPoses";
+static const char* const k_pch_MyDriver_ChangePositionEpsilonMm_Float = "changePositionEpsilonMm";
+static const char* const k_pch_MyDriver_ChangeRotationEpsilonDeg_Float = "changeRotationEpsilonDeg";
+static const char* const k_pch_MyDriver_PoseKeepAliveMs_Float = "poseKeepAliveMs";
+
+// Adaptive update rate (see update_scheduler.h)
+static const char* const k_pch_MyDriver_AdaptiveUpdateRate_Bool = "adaptiveUpdateRate";
+static const char* const k_pch_MyDriver_IdleAfterMs_Float = "idleAfterMs";
+static const char* const k_pch_MyDriver_IdleKeepAliveMs_Float = "idleKeepAliveMs";
+static const char* const k_pch_MyDriver_DormantSampleIntervalMs_Float = "dormantSampleIntervalMs";
+static const char* const k_pch_MyDriver_MotionPositionMm_Float = "motionPositionMm";
+static const char* const k_pch_MyDriver_MotionRotationDeg_Float = "motionRotationDeg";
+static const char* const k_pch_MyDriver_BlockStandbyWhileMoving_Bool = "blockStandbyWhileMoving";
+
+// Raw pose recording and replay (see pose_recording.h), empty paths disable them
+static const char* const k_pch_MyDriver_RecordPath_String = "recordPath";
+static const char* const k_pch_MyDriver_ReplayPath_String = "replayPath";
+static const char* const k_pch_MyDriver_ReplayRealTime_Bool = "replayRealTime";
+static const char* const k_pch_MyDriver_ReplayLoop_Bool = "replayLoop";
+
+// Shared-memory pose export (see pose_export.h), empty name disables it
+static const char* const k_pch_MyDriver_PoseExportName_String = "poseExportName";
+
+// Pose source (EPoseSourceType, see pose_source.h) and the external sources' settings
+static const char* const k_pch_MyDriver_PoseSource_Int32 = "poseSource";
+static const char* const k_pch_MyDriver_ExternalPoseSharedMemoryName_String = "externalPoseSharedMemoryName";
+static const char* const k_pch_MyDriver_ExternalPoseUdpPort_Int32 = "externalPoseUdpPort";
+static const char* const k_pch_MyDriver_ExternalPoseDelayMs_Float = "externalPoseDelayMs";
+static const char* const k_pch_MyDriver_ExternalPoseStaleMs_Float = "externalPoseStaleMs";
+
+// Pose filtering (see pose_filter.h)
+static const char* const k_pch_MyDriver_PoseFilterMode_Int32 = "poseFilterMode";
+static const char* const k_pch_MyDriver_OneEuroMinCutoffHz_Float = "oneEuroMinCutoffHz";
+static const char* const k_pch_MyDriver_OneEuroPositionBeta_Float = "oneEuroPositionBeta";
+static const char* const k_pch_MyDriver_OneEuroRotationBeta_Float = "oneEuroRotationBeta";
+static const char* const k_pch_MyDriver_OneEuroDerivativeCutoffHz_Float = "oneEuroDerivativeCutoffHz";
+static const char* const k_pch_MyDriver_KalmanPositionProcessNoise_Float = "kalmanPositionProcessNoise";
+static const char* const k_pch_MyDriver_KalmanPositionMeasurementNoiseMm_Float = "kalmanPositionMeasurementNoiseMm";
+static const char* const k_pch_MyDriver_KalmanRotationProcessNoise_Float = "kalmanRotationProcessNoise";
+static const char* const k_pch_MyDriver_KalmanRotationMeasurementNoiseDeg_Float = "kalmanRotationMeasurementNoiseDeg";
+
+// Per-device calibration (see pose_calibration.h), read from the section prefix + the mirror's serial.
+// Rotations are "w x y z" strings, translations "x y z" in meters.
+static const char* const k_pch_MyDriver_CalibrationSectionPrefix = "driver_mydriver_calibration_";
+static const char* const k_pch_MyDriver_Calibration_WorldFromDriverRotation_String = "worldFromDriverRotation";
+static const char* const k_pch_MyDriver_Calibration_WorldFromDriverTranslation_String = "worldFromDriverTranslation";
+static const char* const k_pch_MyDriver_Calibration_DriverFromHeadRotation_String = "driverFromHeadRotation";
+static const char* const k_pch_MyDriver_Calibration_DriverFromHeadTranslation_String = "driverFromHeadTranslation";
+
+// Multi-source fusion (see pose_fusion.h), read from the section prefix + the mirror's serial. Key
+// names are formats taking the source number, 1 to 3; offsets use the calibration string format.
+static const char* const k_pch_MyDriver_FusionBlendMs_Float = "fusionBlendMs";
+static const char* const k_pch_MyDriver_FusionSectionPrefix = "driver_mydriver_fusion_";
+static const char* const k_pch_MyDriver_Fusion_SourceIndex_Int32Format = "source%uIndex";
+static const char* const k_pch_MyDriver_Fusion_SourceRotation_StringFormat = "source%uRotation";
+static const char* const k_pch_MyDriver_Fusion_SourceTranslation_StringFormat = "source%uTranslation";
+
+// Driver log verbosity (EDriverLogLevel, see driver_log.h) and per-category records per second
+static const char* const k_pch_MyDriver_LogLevel_Int32 = "logLevel";
+static const char* const k_pch_MyDriver_LogRateLimitPerSecond_Int32 = "logRateLimitPerSecond";
+
+}  // namespace vr
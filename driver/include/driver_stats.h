@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace vr {
+
+// Always-on hot-path instrumentation. Timers feed fixed-size latency histograms with a relaxed
+// atomic add per sample, so they can stay enabled in production. The data is read out as JSON
+// through MyControllerDriver::DebugRequest ("stats", "reset_stats").
+
+enum EDriverTimer : uint8_t {
+  DriverTimer_RunFrame = 0,     // MyTrackedDeviceProvider::RunFrame, whole call
+  DriverTimer_RawPoseFetch,     // GetRawTrackedDevicePoses (or the replay read standing in for it)
+  DriverTimer_PoseConversion,   // MirrorRegistry::UpdatePoses: batch conversion, prediction and publishing
+  DriverTimer_PoseSubmit,       // Each TrackedDevicePoseUpdated call
+  DriverTimer_Count
+};
+
+// Log-linear (HDR-style) histogram of nanosecond durations: each power of two is split into
+// k_unSubBuckets linear buckets, so any recorded value is reported within 1/k_unSubBuckets of
+// its true value across the whole 64-bit range, in a fixed 4 KB table.
+class LatencyHistogram {
+ public:
+  static const uint32_t k_unSubBucketBits = 3;
+  static const uint32_t k_unSubBuckets = 1 << k_unSubBucketBits;
+  static const uint32_t k_unBucketCount = (64 - k_unSubBucketBits + 1) * k_unSubBuckets;
+
+  LatencyHistogram();
+
+  // Safe from any thread; concurrent Reset() may lose samples recorded at the same moment
+  void Record(uint64_t unNanoseconds);
+  void Reset();
+
+  uint64_t GetCount() const { return m_unCount.load(std::memory_order_relaxed); }
+  uint64_t GetSum() const { return m_unSum.load(std::memory_order_relaxed); }
+  uint64_t GetMax() const { return m_unMax.load(std::memory_order_relaxed); }
+
+  // Upper edge of the bucket holding the given percentile (0-100), clamped to the max; 0 when empty
+  uint64_t GetPercentile(double flPercentile) const;
+
+ private:
+  static uint32_t BucketIndex(uint64_t unValue);
+  static uint64_t BucketUpperBound(uint32_t unIndex);
+
+  std::atomic<uint64_t> m_unBuckets[k_unBucketCount];
+  std::atomic<uint64_t> m_unCount;
+  std::atomic<uint64_t> m_unSum;
+  std::atomic<uint64_t> m_unMax;
+};
+
+extern LatencyHistogram g_rgDriverTimers[DriverTimer_Count];
+
+// Times its own scope into one of the driver timers
+class ScopedDriverTimer {
+ public:
+  explicit ScopedDriverTimer(EDriverTimer eTimer) : m_eTimer(eTimer), m_start(std::chrono::steady_clock::now()) {}
+  ~ScopedDriverTimer() {
+    const std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - m_start;
+    g_rgDriverTimers[m_eTimer].Record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  }
+
+  ScopedDriverTimer(const ScopedDriverTimer&) = delete;
+  ScopedDriverTimer& operator=(const ScopedDriverTimer&) = delete;
+
+ private:
+  EDriverTimer m_eTimer;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+void ResetDriverTimers();
+
+// Appends printf-style text at pchBuffer + unUsed, never past unSize; returns the new length.
+// Once the buffer is full further appends are no-ops, so callers can chain them unchecked.
+size_t AppendJson(char* pchBuffer, size_t unSize, size_t unUsed, const char* pchFormat, ...);
+
+// Appends {"run_frame":{...},...} with count, mean, p50/p90/p99 and max in microseconds for each timer
+size_t AppendDriverTimersJson(char* pchBuffer, size_t unSize, size_t unUsed);
+
+}  // namespace vr
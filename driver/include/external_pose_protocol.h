@@ -0,0 +1,267 @@
+#pragma once
+
+// Formats an external tracker uses to feed poses to the driver (poseSource 1 or 2), plus a
+// header-only shared-memory ring writer for the sending side. Like pose_export.h this only
+// depends on openvr_driver.h and the platform headers, so trackers can include it directly.
+//
+// Besides poses, a tracker that can read its controllers' buttons and axes sends them as
+// ExternalInputSamples, and the driver sends back the haptic pulses games request on the mirrors
+// as ExternalHapticPulses.
+//
+// Shared memory: the tracker creates the named region and appends pose and input samples to
+// their rings; the driver drains them every time it samples, without copying them anywhere but
+// its own per-device history, and appends haptic pulses to a third ring the tracker drains. A
+// writer that laps its reader simply overwrites the oldest entries.
+//
+// UDP: the tracker sends datagrams to 127.0.0.1:<externalPoseUdpPort>, each an
+// ExternalPosePacketHeader followed by unSampleCount ExternalPoseSamples or ExternalInputSamples.
+// Haptic pulses come back as datagrams of ExternalHapticPulses to the address the last datagram
+// came from.
+
+#include <openvr_driver.h>
+#include <atomic>
+#include <cstring>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace vr {
+
+static const uint32_t k_unExternalPoseVersion = 2; // 2 added input and haptics
+static const uint32_t k_unExternalPoseMaxDevices = vr::k_unMaxTrackedDeviceCount;
+
+enum EExternalPoseFlags {
+  ExternalPose_Connected = 1u << 0,   // The device exists; without it the mirror reports disconnected
+  ExternalPose_Valid = 1u << 1,       // The pose is tracked; without it the mirror reports out of range
+  ExternalPose_HasVelocity = 1u << 2, // velocity/angularVelocity are filled in; otherwise the driver derives them
+};
+
+// One measurement of one device. Timestamps are std::chrono::steady_clock nanoseconds (see
+// PoseExportNowNs in pose_export.h), which the driver and the tracker share on one machine.
+struct ExternalPoseSample {
+  uint32_t unDeviceIndex;       // Sender's numbering, below k_unExternalPoseMaxDevices; becomes the mirror's index
+  uint32_t unFlags;             // EExternalPoseFlags
+  int32_t nDeviceClass;         // ETrackedDeviceClass to mirror it as (Controller or GenericTracker)
+  int32_t nControllerRole;      // ETrackedControllerRole for controllers
+  int64_t nTimestampNs;         // When the pose was measured
+  double position[3];           // Meters, in the tracking space
+  double rotation[4];           // w, x, y, z
+  double velocity[3];           // m/s
+  double angularVelocity[3];    // rad/s, tracking space
+};
+
+static_assert(sizeof(ExternalPoseSample) == 128, "ExternalPoseSample is a wire format; keep it packed");
+
+static const uint32_t k_unExternalInputAxisCount = 6;
+
+// Buttons and axes of one controller, numbered like the mirror's input profile
+// (resources/input/mirror_controller_profile.json):
+//   buttons: system, application menu, A click/touch, B click/touch, trigger click/touch,
+//            grip click/touch, joystick click/touch, trackpad click/touch (bit 0 upwards)
+//   axes:    trigger, grip (0..1), joystick x/y, trackpad x/y (-1..1)
+struct ExternalInputSample {
+  uint32_t unDeviceIndex;  // Same numbering as the poses
+  uint32_t unButtons;      // Bit set while pressed/touched
+  float flAxes[k_unExternalInputAxisCount];
+  int64_t nTimestampNs;    // When the state was read
+};
+
+static_assert(sizeof(ExternalInputSample) == 40, "ExternalInputSample is a wire format; keep it packed");
+
+// A vibration a game requested on a mirrored device, to be played on the tracker's device
+struct ExternalHapticPulse {
+  uint32_t unDeviceIndex;
+  float flDurationSeconds;
+  float flFrequency;
+  float flAmplitude;
+  int64_t nTimestampNs;    // When the driver received the request
+};
+
+static_assert(sizeof(ExternalHapticPulse) == 24, "ExternalHapticPulse is a wire format; keep it packed");
+
+// UDP
+
+static const char k_rgchExternalPosePacketMagic[4] = {'M', 'D', 'E', 'P'};
+static const uint32_t k_unExternalPoseMaxSamplesPerPacket = 64;
+
+enum EExternalPosePayload {
+  ExternalPosePayload_Poses = 0,    // Tracker to driver, ExternalPoseSamples
+  ExternalPosePayload_Input = 1,    // Tracker to driver, ExternalInputSamples
+  ExternalPosePayload_Haptics = 2,  // Driver to tracker, ExternalHapticPulses
+};
+
+struct ExternalPosePacketHeader {
+  char rgchMagic[4];
+  uint32_t unVersion;
+  uint32_t unSampleCount;  // At most k_unExternalPoseMaxSamplesPerPacket
+  uint32_t unPayload;      // EExternalPosePayload
+};
+
+// Shared-memory ring
+
+static const char k_rgchExternalPoseRingMagic[4] = {'M', 'D', 'E', 'R'};
+static const uint32_t k_unExternalPoseRingCapacity = 1024; // Powers of two
+static const uint32_t k_unExternalInputRingCapacity = 256;
+static const uint32_t k_unExternalHapticRingCapacity = 64;
+
+struct ExternalPoseRingHeader {
+  char rgchMagic[4];                         // Written last by the tracker
+  uint32_t unVersion;
+  uint32_t unSampleSize;                     // sizeof(ExternalPoseSample)
+  uint32_t unCapacity;                       // k_unExternalPoseRingCapacity
+  std::atomic<uint64_t> unWriteIndex;        // Samples appended so far; entry i lives at i % unCapacity
+  std::atomic<uint64_t> unInputWriteIndex;   // Same for the input ring, written by the tracker
+  std::atomic<uint64_t> unHapticWriteIndex;  // Same for the haptic ring, written by the driver
+};
+
+template <typename T>
+struct alignas(64) ExternalRingEntry {
+  std::atomic<uint64_t> unSequence;    // i + 1 once entry i is complete, 0 while it is being written
+  T sample;
+};
+
+typedef ExternalRingEntry<ExternalPoseSample> ExternalPoseRingEntry;
+
+struct ExternalPoseRing {
+  ExternalPoseRingHeader header;
+  ExternalPoseRingEntry entries[k_unExternalPoseRingCapacity];
+  ExternalRingEntry<ExternalInputSample> inputEntries[k_unExternalInputRingCapacity];
+  ExternalRingEntry<ExternalHapticPulse> hapticEntries[k_unExternalHapticRingCapacity];
+};
+
+// Appends to one of the rings. Single writer per ring; never blocks.
+template <typename T, uint32_t N>
+inline void ExternalRingAppend(std::atomic<uint64_t>& unWriteIndex, ExternalRingEntry<T> (&entries)[N], const T& sample) {
+  const uint64_t index = unWriteIndex.load(std::memory_order_relaxed);
+  ExternalRingEntry<T>& entry = entries[index & (N - 1)];
+  entry.unSequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(&entry.sample, &sample, sizeof(T));
+  entry.unSequence.store(index + 1, std::memory_order_release);
+  unWriteIndex.store(index + 1, std::memory_order_release);
+}
+
+// Reads the next entry after unReadIndex, skipping anything the writer has lapped or is
+// overwriting. Returns false once the reader has caught up. Single reader per ring.
+template <typename T, uint32_t N>
+inline bool ExternalRingRead(const std::atomic<uint64_t>& unWriteIndex, const ExternalRingEntry<T> (&entries)[N], uint64_t& unReadIndex, T& outSample) {
+  const uint64_t writeIndex = unWriteIndex.load(std::memory_order_acquire);
+  if (writeIndex < unReadIndex || writeIndex - unReadIndex > N) {
+    unReadIndex = writeIndex - (writeIndex < N ? writeIndex : N); // Lapped, or the writer restarted
+  }
+  for (; unReadIndex < writeIndex; ++unReadIndex) {
+    const ExternalRingEntry<T>& entry = entries[unReadIndex & (N - 1)];
+    if (entry.unSequence.load(std::memory_order_acquire) != unReadIndex + 1) {
+      continue; // Already overwritten by a newer lap
+    }
+    memcpy(&outSample, &entry.sample, sizeof(T));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (entry.unSequence.load(std::memory_order_relaxed) == unReadIndex + 1) {
+      ++unReadIndex;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Tracker side of the ring. Single writer; Write never blocks.
+class ExternalPoseRingWriter {
+ public:
+  ExternalPoseRingWriter() : m_pRing(nullptr), m_hMapping(nullptr), m_unHapticReadIndex(0) { m_szName[0] = '\0'; }
+  ~ExternalPoseRingWriter() { Close(); }
+  ExternalPoseRingWriter(const ExternalPoseRingWriter&) = delete;
+  ExternalPoseRingWriter& operator=(const ExternalPoseRingWriter&) = delete;
+
+  bool Open(const char* pchName) {
+    Close();
+#if defined(_WIN32)
+    HANDLE hMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)sizeof(ExternalPoseRing),
+                                         pchName[0] == '/' ? pchName + 1 : pchName);
+    void* pView = hMapping ? MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(ExternalPoseRing)) : nullptr;
+    if (!pView) {
+      if (hMapping) {
+        CloseHandle(hMapping);
+      }
+      return false;
+    }
+    m_hMapping = hMapping;
+#else
+    shm_unlink(pchName); // Start from a fresh region; a reader still on the old one re-opens by name
+    const int fd = shm_open(pchName, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0 || ftruncate(fd, (off_t)sizeof(ExternalPoseRing)) != 0) {
+      if (fd >= 0) {
+        close(fd);
+        shm_unlink(pchName);
+      }
+      return false;
+    }
+    void* pView = mmap(nullptr, sizeof(ExternalPoseRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (pView == MAP_FAILED) {
+      shm_unlink(pchName);
+      return false;
+    }
+#endif
+    m_pRing = static_cast<ExternalPoseRing*>(pView);
+    m_pRing->header.unVersion = k_unExternalPoseVersion;
+    m_pRing->header.unSampleSize = sizeof(ExternalPoseSample);
+    m_pRing->header.unCapacity = k_unExternalPoseRingCapacity;
+    m_pRing->header.unWriteIndex.store(0, std::memory_order_relaxed);
+    m_pRing->header.unInputWriteIndex.store(0, std::memory_order_relaxed);
+    m_pRing->header.unHapticWriteIndex.store(0, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < k_unExternalPoseRingCapacity; ++i) {
+      m_pRing->entries[i].unSequence.store(0, std::memory_order_relaxed);
+    }
+    for (uint32_t i = 0; i < k_unExternalInputRingCapacity; ++i) {
+      m_pRing->inputEntries[i].unSequence.store(0, std::memory_order_relaxed);
+    }
+    for (uint32_t i = 0; i < k_unExternalHapticRingCapacity; ++i) {
+      m_pRing->hapticEntries[i].unSequence.store(0, std::memory_order_relaxed);
+    }
+    m_unHapticReadIndex = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(m_pRing->header.rgchMagic, k_rgchExternalPoseRingMagic, sizeof(m_pRing->header.rgchMagic));
+    strncpy(m_szName, pchName, sizeof(m_szName) - 1);
+    m_szName[sizeof(m_szName) - 1] = '\0';
+    return true;
+  }
+
+  void Close() {
+    if (!m_pRing) {
+      return;
+    }
+#if defined(_WIN32)
+    UnmapViewOfFile(m_pRing);
+    CloseHandle(m_hMapping);
+    m_hMapping = nullptr;
+#else
+    munmap(m_pRing, sizeof(ExternalPoseRing));
+    shm_unlink(m_szName);
+#endif
+    m_pRing = nullptr;
+  }
+
+  bool IsOpen() const { return m_pRing != nullptr; }
+
+  void Write(const ExternalPoseSample& sample) { ExternalRingAppend(m_pRing->header.unWriteIndex, m_pRing->entries, sample); }
+  void WriteInput(const ExternalInputSample& sample) { ExternalRingAppend(m_pRing->header.unInputWriteIndex, m_pRing->inputEntries, sample); }
+
+  // Next haptic pulse the driver appended, oldest first; false when there is none
+  bool ReadHapticPulse(ExternalHapticPulse& outPulse) {
+    return ExternalRingRead(m_pRing->header.unHapticWriteIndex, m_pRing->hapticEntries, m_unHapticReadIndex, outPulse);
+  }
+
+ private:
+  ExternalPoseRing* m_pRing;
+  void* m_hMapping; // Windows only
+  uint64_t m_unHapticReadIndex;
+  char m_szName[256];
+};
+
+}  // namespace vr
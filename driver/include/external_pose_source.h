@@ -0,0 +1,141 @@
+#pragma once
+
+#include <openvr_driver.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "external_pose_protocol.h"
+#include "pose_source.h"
+#include "seqlock.h"
+
+namespace vr {
+
+// Common part of the external sources: keeps the last few samples of every device the tracker
+// has sent and turns them into a raw pose snapshot at sampling time.
+//
+//   Interpolation: poses are evaluated at now - flDelaySeconds between the two samples that
+//   bracket that time (position lerp, rotation nlerp). A delay of about one tracker frame gives
+//   smooth output from irregular samples; 0 always uses the newest sample.
+//   Staleness: a device whose newest sample is older than flStaleSeconds reports out of range.
+//
+// Samples are added by one producer thread at a time (Push) and read by whichever thread calls
+// Sample; each device's history goes through a SeqLock. Input samples (PushInput) are kept the
+// same way, newest only, for TakeInputState on the host thread.
+class ExternalPoseSource : public IPoseSource {
+ public:
+  ExternalPoseSource(double flDelaySeconds, double flStaleSeconds);
+
+  void Sample(vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount) override;
+
+  bool ProvidesDevices() const override { return true; }
+  bool GetDevice(uint32_t unIndex, int32_t& nDeviceClass, int32_t& nControllerRole) const override;
+  uint32_t GetDeviceChangeCount() const override { return m_unDeviceChangeCount.load(std::memory_order_acquire); }
+
+  bool ProvidesInput() const override { return true; }
+  bool TakeInputState(uint32_t unIndex, uint32_t& unLastSeen, MirrorInputState& outState) const override;
+
+  // Samples dropped for a bad index, rotation or timestamp order
+  uint64_t GetRejectedCount() const { return m_unRejectedCount.load(std::memory_order_relaxed); }
+
+ protected:
+  // Called at the start of every Sample, on the sampling thread; pull-based sources receive here
+  virtual void Poll() {}
+  // Adds one sample to its device's history
+  void Push(const ExternalPoseSample& sample);
+  // Replaces a device's input state
+  void PushInput(const ExternalInputSample& sample);
+
+ private:
+  static const uint32_t k_unHistoryLength = 4;
+
+  struct SampleHistory {
+    ExternalPoseSample samples[k_unHistoryLength];
+    uint32_t unCount;
+    uint32_t unNewest; // Index into samples
+  };
+
+  void ResolvePose(const SampleHistory& history, int64_t nNowNs, vr::TrackedDevicePose_t& outPose) const;
+
+  const int64_t m_nDelayNs;
+  const int64_t m_nStaleNs;
+
+  SampleHistory m_writerHistory[k_unExternalPoseMaxDevices]; // Producer's own copy, so Push never reads the SeqLock
+  SeqLock<SampleHistory> m_history[k_unExternalPoseMaxDevices];
+  std::atomic<uint64_t> m_unKnownDevices; // Bit per index with at least one sample
+  SeqLock<MirrorInputState> m_inputState[k_unExternalPoseMaxDevices];
+
+  std::atomic<int32_t> m_nDeviceClass[k_unExternalPoseMaxDevices];
+  std::atomic<int32_t> m_nControllerRole[k_unExternalPoseMaxDevices];
+  std::atomic<uint32_t> m_unDeviceChangeCount;
+  std::atomic<uint64_t> m_unRejectedCount;
+};
+
+// Drains a tracker's shared-memory pose and input rings on every Sample. The tracker may start
+// after the driver, or restart; until samples flow, the region is looked up again at most once a
+// second. Haptic pulses are queued per device by SendHapticPulse and appended to the haptic ring
+// by the next Sample, so the region is only ever touched by the sampling thread.
+class SharedMemoryPoseSource : public ExternalPoseSource {
+ public:
+  SharedMemoryPoseSource(double flDelaySeconds, double flStaleSeconds);
+  ~SharedMemoryPoseSource();
+
+  bool Open(const char* pchName);
+  void Close();
+  const char* GetName() const override { return "shared memory"; }
+
+  void SendHapticPulse(uint32_t unIndex, const MirrorHapticPulse& pulse) override;
+
+ protected:
+  void Poll() override;
+
+ private:
+  bool Map();
+  void Unmap();
+
+  // Appends the queued haptic pulses to the ring; sampling thread
+  void FlushHapticPulses();
+
+  std::string m_sName;
+  ExternalPoseRing* m_pRing;
+  uint64_t m_unReadIndex;
+  uint64_t m_unInputReadIndex;
+  SeqLock<ExternalHapticPulse> m_pendingHaptic[k_unExternalPoseMaxDevices];
+  std::atomic<uint64_t> m_unPendingHaptics; // Bit per index with a pulse queued since the last flush
+  std::chrono::steady_clock::time_point m_nextMapAttempt;
+#if defined(_WIN32)
+  void* m_hMapping;
+#endif
+};
+
+// Receives datagrams on 127.0.0.1 on its own thread, blocked in epoll until a datagram or Close
+// arrives. Haptic pulses are sent straight back from the host thread to whichever address the
+// last valid datagram came from. Linux only.
+class UdpPoseSource : public ExternalPoseSource {
+ public:
+  UdpPoseSource(double flDelaySeconds, double flStaleSeconds);
+  ~UdpPoseSource();
+
+  bool Open(uint16_t unPort);
+  void Close();
+  const char* GetName() const override { return "udp"; }
+
+  void SendHapticPulse(uint32_t unIndex, const MirrorHapticPulse& pulse) override;
+
+  // Datagrams dropped for a bad header or size
+  uint64_t GetRejectedPacketCount() const { return m_unRejectedPackets.load(std::memory_order_relaxed); }
+
+ private:
+  void ReceiveThreadMain();
+
+  int m_socket;
+  int m_epoll;
+  int m_wakeEvent; // eventfd that Close signals to end the receive thread
+  std::thread m_receiveThread;
+  std::atomic<uint64_t> m_unRejectedPackets;
+  std::atomic<uint64_t> m_unSender; // IPv4 address << 16 | port of the last valid datagram, 0 before the first
+  unsigned char m_packet[sizeof(ExternalPosePacketHeader) + k_unExternalPoseMaxSamplesPerPacket * sizeof(ExternalPoseSample)];
+};
+
+}  // namespace vr
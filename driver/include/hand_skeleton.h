@@ -0,0 +1,101 @@
+#pragma once
+
+#include <openvr_driver.h>
+
+namespace vr {
+
+struct MirrorInputState;
+
+// Bones of SteamVR's hand skeleton ("/skeleton/hand/left" and "/skeleton/hand/right"), in the
+// order UpdateSkeletonComponent expects them
+enum EHandBone {
+  HandBone_Root = 0,
+  HandBone_Wrist,
+  HandBone_Thumb0,
+  HandBone_Thumb1,
+  HandBone_Thumb2,
+  HandBone_Thumb3,
+  HandBone_IndexFinger0,
+  HandBone_IndexFinger1,
+  HandBone_IndexFinger2,
+  HandBone_IndexFinger3,
+  HandBone_IndexFinger4,
+  HandBone_MiddleFinger0,
+  HandBone_MiddleFinger1,
+  HandBone_MiddleFinger2,
+  HandBone_MiddleFinger3,
+  HandBone_MiddleFinger4,
+  HandBone_RingFinger0,
+  HandBone_RingFinger1,
+  HandBone_RingFinger2,
+  HandBone_RingFinger3,
+  HandBone_RingFinger4,
+  HandBone_PinkyFinger0,
+  HandBone_PinkyFinger1,
+  HandBone_PinkyFinger2,
+  HandBone_PinkyFinger3,
+  HandBone_PinkyFinger4,
+  HandBone_Aux_Thumb,
+  HandBone_Aux_IndexFinger,
+  HandBone_Aux_MiddleFinger,
+  HandBone_Aux_RingFinger,
+  HandBone_Aux_PinkyFinger,
+  HandBone_Count
+};
+
+enum EHandFinger {
+  HandFinger_Thumb = 0,
+  HandFinger_Index,
+  HandFinger_Middle,
+  HandFinger_Ring,
+  HandFinger_Pinky,
+  HandFinger_Count
+};
+
+static const uint32_t k_unHandBoneLanes = 32; // HandBone_Count padded to a whole number of AVX vectors
+
+// One reference pose of every bone, parent-relative, as structure-of-arrays so the blend kernel
+// loads eight bones of one channel at a time. The padding lane holds identity.
+struct HandBoneTable {
+  alignas(32) float position[3][k_unHandBoneLanes];
+  alignas(32) float rotation[4][k_unHandBoneLanes]; // w, x, y, z
+};
+
+// SteamVR's open hand and fist reference poses of one hand, plus which finger's curl drives each
+// bone. Built once; every closed rotation is in the same hemisphere as its open one, so the
+// kernel's nlerp needs no sign test.
+struct HandSkeletonPoses {
+  HandBoneTable open;
+  HandBoneTable closed;
+  uint8_t finger[k_unHandBoneLanes]; // EHandFinger, HandFinger_Count for bones that never move (root, wrist, padding)
+};
+
+// The shared reference poses of the left or right hand
+const HandSkeletonPoses& GetHandSkeletonPoses(bool bLeftHand);
+
+// Curl of every finger, 0 open to 1 closed, from the mirrored controller's input: the trigger
+// drives the index finger, the grip the other three, and touching any thumb control rests the thumb
+void ComputeFingerCurls(const MirrorInputState& state, float flOutCurls[HandFinger_Count]);
+
+// Blends every bone between the open and closed pose by its finger's curl into pOutBones, which
+// must hold k_unHandBoneLanes entries (the padding lane is scratch). Positions are lerped and
+// rotations nlerped. Allocation-free; runs the widest kernel the CPU supports.
+void BlendHandSkeleton(const HandSkeletonPoses& poses, const float flCurls[HandFinger_Count], vr::VRBoneTransform_t* pOutBones);
+
+// Blend kernels BlendHandSkeleton can run; it picks the best one the CPU supports
+enum EHandSkeletonKernel {
+  HandSkeletonKernel_Scalar = 0,
+  HandSkeletonKernel_SSE2 = 1, // x86 builds only
+  HandSkeletonKernel_AVX = 2,  // x86 builds on a CPU and OS with AVX
+};
+
+// BlendHandSkeleton with a given kernel, so tests and benchmarks can compare them. Returns false,
+// leaving pOutBones untouched, if the kernel isn't available here.
+bool BlendHandSkeletonWithKernel(EHandSkeletonKernel eKernel, const HandSkeletonPoses& poses, const float flCurls[HandFinger_Count],
+                                 vr::VRBoneTransform_t* pOutBones);
+bool IsHandSkeletonKernelSupported(EHandSkeletonKernel eKernel);
+
+// Name of the blend kernel picked for this CPU ("AVX", "SSE2" or "Scalar"), for logging
+const char* GetHandSkeletonKernelName();
+
+}  // namespace vr
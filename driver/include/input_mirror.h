@@ -0,0 +1,127 @@
+#pragma once
+
+#include <openvr_driver.h>
+#include <atomic>
+#include <chrono>
+
+#include "hand_skeleton.h"
+#include "seqlock.h"
+
+namespace vr {
+
+// Input components every mirrored controller exposes, matching resources/input/mirror_controller_profile.json
+enum EMirrorButton {
+  MirrorButton_SystemClick,
+  MirrorButton_ApplicationMenuClick,
+  MirrorButton_AClick,
+  MirrorButton_ATouch,
+  MirrorButton_BClick,
+  MirrorButton_BTouch,
+  MirrorButton_TriggerClick,
+  MirrorButton_TriggerTouch,
+  MirrorButton_GripClick,
+  MirrorButton_GripTouch,
+  MirrorButton_JoystickClick,
+  MirrorButton_JoystickTouch,
+  MirrorButton_TrackpadClick,
+  MirrorButton_TrackpadTouch,
+  MirrorButton_Count
+};
+
+enum EMirrorAxis {
+  MirrorAxis_TriggerValue,  // 0..1
+  MirrorAxis_GripValue,     // 0..1
+  MirrorAxis_JoystickX,     // -1..1
+  MirrorAxis_JoystickY,
+  MirrorAxis_TrackpadX,
+  MirrorAxis_TrackpadY,
+  MirrorAxis_Count
+};
+
+// Input state of one physical controller, as published by whatever reads it
+struct MirrorInputState {
+  uint32_t unButtons;                     // Bit (1 << EMirrorButton) set while pressed/touched
+  float flAxes[MirrorAxis_Count];
+  std::chrono::steady_clock::time_point sampleTime;
+};
+
+// A haptic request the host made on a mirror, to be played on the physical device
+struct MirrorHapticPulse {
+  float flDurationSeconds;
+  float flFrequency;
+  float flAmplitude;
+};
+
+// Input side of the mirrored controllers. The host offers a driver no way to read another
+// driver's input, so the physical state is published here (from any thread) by whatever source
+// can read it, and haptics requested on a mirror are handed back the same way.
+//
+// Component handles are created once per slot at activation and kept in flat per-slot arrays.
+// SubmitInputs skips slots with nothing newly published and otherwise diffs against the last
+// submitted state, so the host calls scale with the number of changed values. Nothing allocates.
+//
+// Left and right hand mirrors also get a skeleton component whose finger curls follow the
+// trigger, grip and touch state (see hand_skeleton.h); it is only re-blended and resent when a
+// curl changes.
+class InputMirror {
+ public:
+  static const uint32_t k_unMaxSlots = vr::k_unMaxTrackedDeviceCount;
+
+  InputMirror();
+
+  // Creates the slot's components on the mirror's property container, plus a hand skeleton if
+  // nControllerRole is a hand. Host thread, from MyControllerDriver::Activate.
+  bool CreateComponents(uint32_t unSlot, vr::PropertyContainerHandle_t ulContainer, int32_t nControllerRole);
+  // Follows a role change of the physical device: creates the skeleton of the new hand, or stops
+  // updating the old one if the role is no longer a hand. Returns true if the skeleton changed. Host thread.
+  bool SetHand(uint32_t unSlot, vr::PropertyContainerHandle_t ulContainer, int32_t nControllerRole);
+  // Forgets the slot's handles; the host drops them when the device deactivates
+  void ReleaseComponents(uint32_t unSlot);
+
+  // Publishes the physical device's latest input state for a slot; any thread
+  void PublishInputState(uint32_t unSlot, const MirrorInputState& state);
+
+  // Sends every slot's changed values to the host. Host thread, once per frame.
+  void SubmitInputs();
+
+  // Routes a VREvent_Input_HapticVibration to the slot owning its component. Returns false if it isn't ours.
+  bool OnHapticEvent(const vr::VREvent_HapticVibration_t& haptic);
+
+  // Latest haptic pulse for a slot, for the source driving the physical device; any thread.
+  // Returns true and advances unLastSeen only if a pulse arrived since unLastSeen.
+  bool TakeHapticPulse(uint32_t unSlot, uint32_t& unLastSeen, MirrorHapticPulse& outPulse) const;
+
+  // Host component updates sent / haptic events routed for one slot
+  uint64_t GetUpdateCount(uint32_t unSlot) const { return m_unUpdateCount[unSlot].load(std::memory_order_relaxed); }
+  uint64_t GetHapticCount(uint32_t unSlot) const { return m_unHapticCount[unSlot].load(std::memory_order_relaxed); }
+  void ResetCounters();
+
+ private:
+  // Host thread only
+  uint32_t m_unSlotLimit; // One past the highest slot with components
+  bool m_bCreated[k_unMaxSlots];
+  vr::VRInputComponentHandle_t m_ulButton[k_unMaxSlots][MirrorButton_Count];
+  vr::VRInputComponentHandle_t m_ulAxis[k_unMaxSlots][MirrorAxis_Count];
+  vr::VRInputComponentHandle_t m_ulHaptic[k_unMaxSlots];
+  MirrorInputState m_submittedState[k_unMaxSlots];
+  uint32_t m_unSubmittedVersion[k_unMaxSlots];
+
+  // Creates the slot's skeleton component for one hand and submits it blended for flCurls
+  bool CreateSkeleton(uint32_t unSlot, vr::PropertyContainerHandle_t ulContainer, bool bLeftHand, const float flCurls[HandFinger_Count]);
+  // Blends the slot's hand for flCurls and sends it with and without the controller; returns the host calls made
+  uint64_t SubmitSkeleton(uint32_t unSlot, const float flCurls[HandFinger_Count]);
+
+  vr::VRInputComponentHandle_t m_ulSkeleton[k_unMaxSlots]; // Invalid for slots that aren't a hand
+  bool m_bLeftHand[k_unMaxSlots];
+  float m_flSubmittedCurls[k_unMaxSlots][HandFinger_Count];
+  alignas(32) vr::VRBoneTransform_t m_skeletonBones[k_unHandBoneLanes]; // Blend output, reused by every slot
+
+  // Handoffs
+  SeqLock<MirrorInputState> m_publishedState[k_unMaxSlots];
+  SeqLock<MirrorHapticPulse> m_hapticPulse[k_unMaxSlots];
+
+  std::atomic<uint64_t> m_unUpdateCount[k_unMaxSlots];
+  std::atomic<uint64_t> m_unHapticCount[k_unMaxSlots];
+};
+
+}  // namespace vr
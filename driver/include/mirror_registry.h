@@ -0,0 +1,180 @@
+#pragma once
+
+#include <openvr_driver.h>
+#include <atomic>
+#include <chrono>
+
+#include "pose_calibration.h"
+#include "pose_change_detection.h"
+#include "pose_conversion.h"
+#include "pose_filter.h"
+#include "pose_fusion.h"
+#include "pose_exporter.h"
+#include "mirror_sweep_policies.h"
+#include "seqlock.h"
+#include "update_scheduler.h"
+
+namespace vr {
+
+// Per-slot state bits, owned by whichever thread runs UpdatePoses
+enum EMirrorSlotFlags : uint8_t {
+  MirrorSlot_PhysicalConnected = 1 << 0, // The physical device reported bDeviceIsConnected in the last sweep
+  MirrorSlot_PoseValid = 1 << 1,         // The last sweep produced a valid pose from the physical device
+};
+
+// Health counters of one slot since it was added or last reset
+struct MirrorSlotCounters {
+  uint64_t unFrames;        // Sweeps that updated the slot
+  uint64_t unInvalidPoses;  // ...where the physical device was connected but its pose was invalid
+  uint64_t unDisconnects;   // Connected -> disconnected transitions of the physical device
+  uint64_t unOutOfRange;    // Sweeps that published the out-of-range fallback pose
+  uint64_t unSent;          // Poses SubmitPoses sent to the host
+  uint64_t unSuppressed;    // Poses SubmitPoses skipped as unchanged, or as idle between keep-alives
+};
+
+// Registry of every mirrored device. The hot per-device state is kept as structure-of-arrays so
+// UpdatePoses and SubmitPoses are single linear sweeps over all slots, with no per-device virtual
+// calls. MyControllerDriver objects only hold a slot index into this table.
+//
+// Slots are appended by the host thread (Init) and never removed. UpdatePoses may run on the
+// tracking thread and is the only writer of the published poses; SubmitPoses, GetPose and
+// EnterStandby read them lock-free. Host-side changes to a slot (activation, standby) are handed
+// to the sweep as pending state instead of being written into the poses directly.
+class MirrorRegistry {
+ public:
+  static const uint32_t k_unMaxSlots = vr::k_unMaxTrackedDeviceCount;
+  static const uint32_t k_unInvalidSlot = 0xFFFFFFFF;
+
+  MirrorRegistry();
+
+  // Reserves a slot mirroring the physical device at unPhysicalIndex. Returns k_unInvalidSlot when full.
+  uint32_t AddSlot(uint32_t unPhysicalIndex);
+  // Drops every slot. Only call with the tracking thread stopped.
+  void Clear();
+  uint32_t GetSlotCount() const { return m_unSlotCount.load(std::memory_order_acquire); }
+  uint32_t GetPhysicalIndex(uint32_t unSlot) const { return m_unPhysicalIndex[unSlot]; }
+  uint32_t GetObjectId(uint32_t unSlot) const { return m_unObjectId[unSlot].load(std::memory_order_acquire); }
+  // Slot whose mirror the host activated as unObjectId, k_unInvalidSlot if none. Host thread only.
+  uint32_t GetSlotForObjectId(uint32_t unObjectId) const {
+    return unObjectId < vr::k_unMaxTrackedDeviceCount ? m_unSlotForObjectId[unObjectId] : k_unInvalidSlot;
+  }
+
+  // Called from MyControllerDriver::Activate/Deactivate; a slot only takes part in the sweeps while activated.
+  // The next sweep writes the calibration offsets into the slot's pose, where they stay for as long as it is
+  // active; SubmitPoses holds the slot back until then. Also ends a standby of the slot.
+  void ActivateSlot(uint32_t unSlot, uint32_t unObjectId, const DriverPoseCalibration& calibration);
+  // True from ActivateSlot until a sweep has picked the activation up, for any slot
+  bool IsActivationPending() const;
+  // Extra physical devices fused into the slot's pose together with its own (none unbinds). Call before ActivateSlot.
+  void SetFusionSources(uint32_t unSlot, const PoseFusionSource* pSources, uint32_t unSourceCount) {
+    m_fusion.Bind(unSlot, m_unPhysicalIndex[unSlot], pSources, unSourceCount);
+  }
+  void SetFusionBlendSeconds(double flSeconds) { m_fusion.SetBlendSeconds(flSeconds); }
+  void DeactivateSlot(uint32_t unSlot);
+
+  // How far ahead (in seconds) the mirrored poses are extrapolated, 0 disables prediction
+  void SetPredictionHorizon(double flSeconds);
+
+  // Enables/configures skipping of submissions that would not change anything on the host
+  void SetChangeDetection(const PoseChangeDetection& settings);
+
+  // Selects/configures the smoothing filter run over every slot in UpdatePoses. Call before the tracking thread starts.
+  void SetPoseFilter(const PoseFilterSettings& settings);
+
+  // Enables/configures the adaptive update rate of idle mirrors. Call before the tracking thread starts.
+  void SetUpdateScheduler(const UpdateSchedulerSettings& settings) { m_scheduler.Configure(settings); }
+  const UpdateScheduler& GetUpdateScheduler() const { return m_scheduler; }
+  // Call once sweeps have stopped (standby), so the scheduler no longer reports the last sweep's motion
+  void ClearMotion() { m_scheduler.ClearMotion(); }
+
+  // Also writes every sweep's published poses to pExporter (nullptr stops). Call before the tracking thread starts.
+  void SetPoseExporter(PoseExporter* pExporter) { m_pExporter = pExporter; }
+
+  // Number of poses SubmitPoses sent to the host / skipped as unchanged or idle for one slot
+  uint64_t GetSentCount(uint32_t unSlot) const { return m_unSentCount[unSlot].load(std::memory_order_relaxed); }
+  uint64_t GetSuppressedCount(uint32_t unSlot) const { return m_unSuppressedCount[unSlot].load(std::memory_order_relaxed); }
+
+  MirrorSlotCounters GetCounters(uint32_t unSlot) const;
+  // Zeroes every slot's counters; safe while the sweeps are running
+  void ResetCounters();
+
+  // Converts every activated slot's pose out of a raw pose snapshot and publishes it. Runs the
+  // instantiation of Sweep whose stages match the current settings.
+  void UpdatePoses(const vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount);
+
+  // Sends every activated slot's most recently published pose to the host
+  void SubmitPoses();
+
+  // The slot's most recently published pose, reported as not tracking while the slot is in standby
+  vr::DriverPose_t GetPose(uint32_t unSlot) const;
+
+  // Reports the slot as not tracking until LeaveStandby or its next activation, and submits that right away.
+  // The sweeps keep running; SubmitPoses and GetPose lay the standby state over what they publish.
+  void EnterStandby(uint32_t unSlot);
+  // Ends the standby of every slot
+  void LeaveStandby();
+
+ private:
+  // A converted pose together with the time its raw sample was taken
+  struct PublishedPose {
+    vr::DriverPose_t pose;
+    std::chrono::steady_clock::time_point sampleTime;
+  };
+
+  // The body of UpdatePoses, with every optional stage resolved at compile time (see mirror_sweep_policies.h)
+  template <class FilterPolicy, class PredictionPolicy, class SinkPolicy, class LogPolicy>
+  void Sweep(const vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount);
+
+  typedef void (MirrorRegistry::*SweepFunction)(const vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount);
+  static const SweepFunction k_rgSweeps[MirrorSweepStage_Combinations]; // Indexed by EMirrorSweepStage bits
+
+  std::atomic<uint32_t> m_unSlotCount;
+  double m_flPredictionSeconds;
+  PoseChangeDetection m_changeDetection;
+
+  // Hot state, one entry per slot
+  uint32_t m_unPhysicalIndex[k_unMaxSlots];
+  std::atomic<uint32_t> m_unObjectId[k_unMaxSlots]; // k_unTrackedDeviceIndexInvalid until activated
+  uint8_t m_flags[k_unMaxSlots];                    // EMirrorSlotFlags
+  vr::DriverPose_t m_lastPose[k_unMaxSlots];        // Working copies, only touched by UpdatePoses
+  SeqLock<PublishedPose> m_publishedPose[k_unMaxSlots];
+
+  // Host-to-sweep handoff: ActivateSlot stores the calibration, then bumps the activation count. A sweep that
+  // sees a count it hasn't applied yet applies the calibration and publishes the count back once swept.
+  SeqLock<DriverPoseCalibration> m_pendingCalibration[k_unMaxSlots];
+  std::atomic<uint32_t> m_unActivationCount[k_unMaxSlots];
+  std::atomic<uint32_t> m_unSweptActivationCount[k_unMaxSlots];
+  std::atomic<bool> m_bStandby[k_unMaxSlots]; // Set by EnterStandby, read by SubmitPoses and GetPose
+
+  // Reverse of m_unObjectId, maintained by ActivateSlot/DeactivateSlot on the host thread
+  uint32_t m_unSlotForObjectId[vr::k_unMaxTrackedDeviceCount];
+
+  // Submission state, only touched by SubmitPoses (counters are also read and reset by DebugRequest)
+  vr::DriverPose_t m_submittedPose[k_unMaxSlots];                       // Last pose actually sent
+  std::chrono::steady_clock::time_point m_submitTime[k_unMaxSlots];     // When it was sent, epoch if never
+  std::atomic<uint64_t> m_unSentCount[k_unMaxSlots];
+  std::atomic<uint64_t> m_unSuppressedCount[k_unMaxSlots];
+
+  // Sweep counters, only written by UpdatePoses (and ResetCounters)
+  std::atomic<uint64_t> m_unFrameCount[k_unMaxSlots];
+  std::atomic<uint64_t> m_unInvalidPoseCount[k_unMaxSlots];
+  std::atomic<uint64_t> m_unDisconnectCount[k_unMaxSlots];
+  std::atomic<uint64_t> m_unOutOfRangeCount[k_unMaxSlots];
+
+  // Whole-snapshot conversion output, scratch for UpdatePoses
+  PoseConversionBatch m_converted;
+
+  // Per-slot filter state, only touched by UpdatePoses
+  PoseFilterBank m_filters;
+
+  // Multi-source fusion state, only touched by the sweeps once the slots are activated
+  PoseFusionBank m_fusion;
+
+  // Per-slot activity for the adaptive update rate, updated by UpdatePoses
+  UpdateScheduler m_scheduler;
+
+  // Optional shared-memory export, written by UpdatePoses; owned by MyTrackedDeviceProvider
+  PoseExporter* m_pExporter;
+};
+
+}  // namespace vr
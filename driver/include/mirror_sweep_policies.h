@@ -0,0 +1,75 @@
+#pragma once
+
+#include <openvr_driver.h>
+#include <chrono>
+
+#include "driver_log.h"
+#include "pose_exporter.h"
+#include "pose_filter.h"
+#include "pose_prediction.h"
+
+namespace vr {
+
+// Stages of MirrorRegistry's per-frame pose sweep, as compile-time policies. The registry
+// instantiates the sweep once per combination and picks the instantiation matching the current
+// settings at the start of every sweep, so a disabled stage costs nothing per slot: no call, no
+// branch, no counter. Every policy is a stateless struct of static inline functions; the state
+// they act on stays in the registry and is passed in.
+
+// Bit per enabled stage; a combination of them indexes the registry's table of instantiations
+enum EMirrorSweepStage {
+  MirrorSweepStage_Log = 1 << 0,
+  MirrorSweepStage_Sink = 1 << 1,
+  MirrorSweepStage_Prediction = 1 << 2,
+  MirrorSweepStage_Filter = 1 << 3,
+  MirrorSweepStage_Combinations = 1 << 4,
+};
+
+// Filter stage: smooths the freshly converted poses of every slot in place (see pose_filter.h)
+struct NoPoseFilterPolicy {
+  static void Apply(PoseFilterBank&, vr::DriverPose_t*, const bool*, uint32_t, double) {}
+};
+
+struct PoseFilterBankPolicy {
+  static void Apply(PoseFilterBank& filters, vr::DriverPose_t* pPoses, const bool* pbFilter, uint32_t unSlotCount, double flTimeSeconds) {
+    filters.Apply(pPoses, pbFilter, unSlotCount, flTimeSeconds);
+  }
+};
+
+// Prediction stage: extrapolates the published copy of a valid pose (see pose_prediction.h)
+struct NoPredictionPolicy {
+  static void Predict(vr::DriverPose_t&, double) {}
+};
+
+struct HorizonPredictionPolicy {
+  static void Predict(vr::DriverPose_t& pose, double flSecondsAhead) { PredictDriverPose(pose, flSecondsAhead); }
+};
+
+// Sink stage: receives every published pose besides the SeqLock handoff to SubmitPoses
+struct NoPoseSinkPolicy {
+  static void Publish(PoseExporter*, uint32_t, uint32_t, uint32_t, const vr::DriverPose_t&, std::chrono::steady_clock::time_point) {}
+  static void EndFrame(PoseExporter*, uint32_t) {}
+};
+
+struct PoseExportSinkPolicy {
+  static void Publish(PoseExporter* pExporter, uint32_t unSlot, uint32_t unObjectId, uint32_t unPhysicalIndex, const vr::DriverPose_t& pose,
+                      std::chrono::steady_clock::time_point sampleTime) {
+    pExporter->PublishSlot(unSlot, unObjectId, unPhysicalIndex, pose, sampleTime);
+  }
+  static void EndFrame(PoseExporter* pExporter, uint32_t unSlotCount) { pExporter->EndFrame(unSlotCount); }
+};
+
+// Log stage: the sweep's per-slot events. Picked by the pose category's level, so at the default
+// level the sweep carries no logging code at all.
+struct NoSweepLogPolicy {
+  static void PoseLost(uint32_t, uint32_t) {}
+};
+
+struct DriverSweepLogPolicy {
+  static void PoseLost(uint32_t unSlot, uint32_t unPhysicalIndex) {
+    DRIVER_LOG_VERBOSE(DriverLogCategory_Pose, "MirrorRegistry::UpdatePoses - Slot {} (physical idx {}) lost its pose. Falling back to out_of_range pose.",
+                       unSlot, unPhysicalIndex);
+  }
+};
+
+}  // namespace vr
@@ -1,17 +1,20 @@
 #pragma once
 
 #include <openvr_driver.h>
+#include <string>
 
 namespace vr {
 
+class InputMirror;
+class MirrorRegistry;
+
+// The ITrackedDeviceServerDriver face of one mirrored device. All pose state lives in a
+// MirrorRegistry slot; this object only forwards the host's calls to it.
 class MyControllerDriver : public vr::ITrackedDeviceServerDriver {
  public:
-  MyControllerDriver();
+  MyControllerDriver(MirrorRegistry* pRegistry, InputMirror* pInput, uint32_t unSlot, const char* pchSerial, int32_t nControllerRole);
   virtual ~MyControllerDriver();
 
-  // Method to set the physical controller index
-  void SetPhysicalControllerIndex(uint32_t index);
-
   // Inherited via ITrackedDeviceServerDriver
   virtual vr::EVRInitError Activate(uint32_t unObjectId) override;
   virtual void Deactivate() override;
@@ -20,13 +23,17 @@ class MyControllerDriver : public vr::ITrackedDeviceServerDriver {
   virtual void DebugRequest(const char* pchRequest, char* pchResponseBuffer, uint32_t unResponseBufferSize) override;
   virtual vr::DriverPose_t GetPose() override;
 
-  // Method to update the pose
-  void RunFrame();
+  uint32_t GetSlot() const { return m_unSlot; }
+  // Follows a role change of the physical device: the role hint, and the hand skeleton while activated
+  void SetControllerRole(int32_t nControllerRole);
 
  private:
   uint32_t m_unObjectId; // Store the object ID
-  uint32_t m_unPhysicalControllerIndex; // Store the index of the physical controller
-  vr::DriverPose_t m_lastPose; // Stores the last known pose of the controller
+  MirrorRegistry* m_pRegistry; // Owned by MyTrackedDeviceProvider, outlives this driver
+  InputMirror* m_pInput; // Likewise; nullptr for devices without input (trackers)
+  uint32_t m_unSlot; // This device's slot in m_pRegistry
+  std::string m_sSerial; // Serial the device was added with, also keys its calibration section
+  int32_t m_nControllerRole; // Physical device's current role; picks the hand skeleton
 };
 
 }  // namespace vr
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <openvr_driver.h>
+
+namespace vr {
+
+// A rigid transform in the same form DriverPose_t carries its offsets
+struct PoseOffset {
+  vr::HmdQuaternion_t qRotation;
+  double vecTranslation[3]; // Meters
+};
+
+// Fixed offsets of one mirrored device. They are written into the DriverPose_t offset fields once
+// and the host composes them with every pose, so the driver does no per-frame math for them.
+//
+//   worldFromDriver: playspace alignment, applied to the mirrored pose in tracking space
+//   driverFromHead:  mount offset, applied in the device's own frame (e.g. tracker -> controller grip)
+struct DriverPoseCalibration {
+  PoseOffset worldFromDriver;
+  PoseOffset driverFromHead;
+};
+
+PoseOffset IdentityPoseOffset();
+DriverPoseCalibration IdentityPoseCalibration();
+bool IsIdentityPoseCalibration(const DriverPoseCalibration& calibration);
+
+// Reads the calibration of the mirror with the given serial from its own settings section,
+// "driver_mydriver_calibration_<serial>". Missing or malformed entries are identity.
+DriverPoseCalibration ReadDeviceCalibration(const char* pchSerial);
+
+// Reads a "w x y z" rotation and an "x y z" translation string entry of a settings section into
+// offset. A missing entry is identity; offset is left untouched if either is malformed.
+void ReadPoseOffset(const char* pchSection, const char* pchRotationKey, const char* pchTranslationKey, PoseOffset& offset);
+
+// Writes the calibration into pose's qWorldFromDriverRotation/vecWorldFromDriverTranslation and
+// qDriverFromHeadRotation/vecDriverFromHeadTranslation fields
+void ApplyPoseCalibration(vr::DriverPose_t& pose, const DriverPoseCalibration& calibration);
+
+// Offline solvers. Each takes unCount simultaneous pose pairs, e.g. two devices' entries from the
+// frames of a pose recording, skips pairs where either pose is invalid, and fits the offset in
+// the least-squares sense (rotation by quaternion averaging, then translation by its mean).
+// Returns false if no usable pairs were found. The RMS residuals of the fit are optional outputs.
+
+// Mount offset X of a device rigidly attached to a reference, with reference = device * X.
+// The result goes into driverFromHead of the device's mirror to make it follow the reference.
+bool SolveDriverFromHeadOffset(const vr::TrackedDevicePose_t* pDevicePoses, const vr::TrackedDevicePose_t* pReferencePoses, uint32_t unCount,
+                               PoseOffset& outOffset, double* pflRmsPositionError = nullptr, double* pflRmsRotationError = nullptr);
+
+// Alignment W between two tracking spaces observing the same motion, with reference = W * device.
+// The result goes into worldFromDriver of the device's mirror to bring it into the reference space.
+bool SolveWorldFromDriverOffset(const vr::TrackedDevicePose_t* pDevicePoses, const vr::TrackedDevicePose_t* pReferencePoses, uint32_t unCount,
+                                PoseOffset& outOffset, double* pflRmsPositionError = nullptr, double* pflRmsRotationError = nullptr);
+
+// Runs one of the solvers above over every frame of a pose recording (see pose_recording.h), pairing
+// the poses of two device indices. Returns false if the recording can't be read or has no usable pairs.
+bool SolveOffsetFromRecording(const char* pchRecordingPath, uint32_t unDeviceIndex, uint32_t unReferenceIndex, bool bWorldFromDriver,
+                              PoseOffset& outOffset, double* pflRmsPositionError = nullptr, double* pflRmsRotationError = nullptr);
+
+// Writes one offset into the calibration section of the mirror with the given serial, in the format
+// ReadDeviceCalibration reads back
+void WriteDeviceCalibrationOffset(const char* pchSerial, bool bWorldFromDriver, const PoseOffset& offset);
+
+}  // namespace vr
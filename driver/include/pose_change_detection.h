@@ -0,0 +1,28 @@
+#pragma once
+
+#include <openvr_driver.h>
+
+namespace vr {
+
+// Settings for skipping TrackedDevicePoseUpdated calls that would not change anything on the host
+struct PoseChangeDetection {
+  bool bEnabled;
+  double flPositionEpsilon;   // Meters
+  double flRotationEpsilon;   // Radians
+  double flKeepAliveSeconds;  // Submit at least this often even when nothing changed
+
+  // Derived by ReadPoseChangeDetectionSettings so the per-frame test needs no sqrt/acos
+  double flPositionEpsilonSq;
+  double flCosHalfRotationEpsilon;
+};
+
+// Reads the change detection settings. Disabled unless "suppressUnchangedPoses" is set.
+PoseChangeDetection ReadPoseChangeDetectionSettings();
+
+// True if submitting next after last would be visible to the host: a tracking state transition,
+// or (for valid poses) a position/rotation move beyond the epsilons. The host keeps extrapolating
+// the last submitted pose with its velocities, so a pose that was still moving is never
+// treated as unchanged unless that extrapolation stays within the epsilons over a keep-alive interval.
+bool IsPoseChangeSignificant(const vr::DriverPose_t& last, const vr::DriverPose_t& next, const PoseChangeDetection& settings);
+
+}  // namespace vr
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <openvr_driver.h>
+
+namespace vr {
+
+// Structure-of-arrays view of a whole raw pose snapshot, indexed by OpenVR device index.
+// Filled in one pass by ConvertRawPoses so the per-device sweeps only read plain floats.
+struct PoseConversionBatch {
+  static const uint32_t k_unCapacity = vr::k_unMaxTrackedDeviceCount; // Multiple of 8, no tail handling needed
+
+  alignas(32) float position[3][k_unCapacity];
+  alignas(32) float rotation[4][k_unCapacity]; // w, x, y, z; normalized, w >= 0
+  alignas(32) float velocity[3][k_unCapacity];
+  alignas(32) float angularVelocity[3][k_unCapacity];
+
+  // Scratch: upper-left 3x3 of mDeviceToAbsoluteTracking, row-major, one array per element
+  alignas(32) float matrix[9][k_unCapacity];
+};
+
+// Converts every entry of pRawPoses (up to k_unCapacity) into outBatch. Entries past unRawPoseCount
+// are left as identity. Validity is not checked here; callers still look at bPoseIsValid/bDeviceIsConnected.
+void ConvertRawPoses(const vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount, PoseConversionBatch& outBatch);
+
+// Rotation kernels ConvertRawPoses can run; it picks the best one the CPU supports
+enum EPoseConversionKernel {
+  PoseConversionKernel_Scalar = 0,
+  PoseConversionKernel_SSE2 = 1, // x86 builds only
+  PoseConversionKernel_AVX = 2,  // x86 builds on a CPU and OS with AVX
+};
+
+// ConvertRawPoses with a given kernel, so tests and benchmarks can compare them. Returns false,
+// leaving outBatch untouched, if the kernel isn't available here.
+bool ConvertRawPosesWithKernel(EPoseConversionKernel eKernel, const vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount,
+                               PoseConversionBatch& outBatch);
+bool IsPoseConversionKernelSupported(EPoseConversionKernel eKernel);
+
+// Whether the CPU and OS support AVX; shared by every kernel that picks an AVX path at runtime
+bool CpuSupportsAvx();
+
+// Name of the rotation kernel picked for this CPU ("AVX", "SSE2" or "Scalar"), for logging
+const char* GetPoseConversionKernelName();
+
+}  // namespace vr
@@ -0,0 +1,175 @@
+#pragma once
+
+// Shared-memory layout of the mirrored pose export, plus a header-only reader for tools that
+// want the poses without going through the OpenVR client API. Only depends on openvr_driver.h
+// (for DriverPose_t) and the platform headers, so it can be copied into other projects as is.
+//
+// The driver (see pose_exporter.h) owns the region. After every pose sweep it writes each
+// activated mirror's slot under that slot's sequence lock, then bumps unFrameCount. Readers never
+// block the driver: they copy a slot and retry if the sequence shows a write overlapped the copy.
+
+#include <openvr_driver.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace vr {
+
+static const char k_rgchPoseExportMagic[4] = {'M', 'D', 'P', 'E'};
+static const uint32_t k_unPoseExportVersion = 1;
+static const uint32_t k_unPoseExportMaxSlots = vr::k_unMaxTrackedDeviceCount;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "The export's atomics must be lock-free to work across processes");
+
+struct PoseExportHeader {
+  char rgchMagic[4];                    // Written last; readers treat the region as not ready until it matches
+  uint32_t unVersion;
+  uint32_t unSlotSize;                  // sizeof(PoseExportSlot), lets a reader reject a layout mismatch
+  uint32_t unMaxSlots;                  // k_unPoseExportMaxSlots
+  std::atomic<uint32_t> unSlotCount;    // Slots written so far (registry slot order)
+  uint32_t unReserved;
+  std::atomic<uint64_t> unFrameCount;   // Completed sweeps; bumped once every slot of a sweep is written
+};
+
+// Timestamps are nanoseconds of std::chrono::steady_clock (CLOCK_MONOTONIC on Linux, QPC on
+// Windows), which is the same in every process on the machine; see PoseExportNowNs().
+struct alignas(64) PoseExportSlot {
+  std::atomic<uint32_t> unSequence; // Odd while the driver is writing the slot, 0 if never written
+  uint32_t unObjectId;              // Host device index of the mirror
+  uint32_t unPhysicalIndex;         // Device index it mirrors
+  uint32_t unReserved;
+  uint64_t unFrame;                 // unFrameCount of the sweep that wrote it (the count before the bump)
+  int64_t nSampleTimeNs;            // When the raw pose was sampled
+  int64_t nPublishTimeNs;           // When the slot was written
+  vr::DriverPose_t pose;            // As handed to the host, including prediction and calibration
+};
+
+struct PoseExportRegion {
+  PoseExportHeader header;
+  PoseExportSlot slots[k_unPoseExportMaxSlots];
+};
+
+// One consistent copy of a slot
+struct PoseExportSample {
+  uint32_t unObjectId;
+  uint32_t unPhysicalIndex;
+  uint64_t unFrame;
+  int64_t nSampleTimeNs;
+  int64_t nPublishTimeNs;
+  vr::DriverPose_t pose;
+};
+
+inline int64_t PoseExportNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Maps an export region read-only. Names follow shm_open ("/mydriver_poses"); on Windows the
+// leading slash is dropped and the name is used for a named file mapping.
+class PoseExportReader {
+ public:
+  PoseExportReader() : m_pRegion(nullptr), m_hMapping(nullptr) {}
+  ~PoseExportReader() { Close(); }
+  PoseExportReader(const PoseExportReader&) = delete;
+  PoseExportReader& operator=(const PoseExportReader&) = delete;
+
+  // Fails if the driver hasn't created the region (yet) or it has an incompatible layout
+  bool Open(const char* pchName) {
+    Close();
+#if defined(_WIN32)
+    HANDLE hMapping = OpenFileMappingA(FILE_MAP_READ, FALSE, pchName[0] == '/' ? pchName + 1 : pchName);
+    const void* pView = hMapping ? MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, sizeof(PoseExportRegion)) : nullptr;
+    if (!pView) {
+      if (hMapping) {
+        CloseHandle(hMapping);
+      }
+      return false;
+    }
+    m_hMapping = hMapping;
+#else
+    const int fd = shm_open(pchName, O_RDONLY, 0);
+    if (fd < 0) {
+      return false;
+    }
+    void* pView = mmap(nullptr, sizeof(PoseExportRegion), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // The mapping keeps the region alive
+    if (pView == MAP_FAILED) {
+      return false;
+    }
+#endif
+    m_pRegion = static_cast<const PoseExportRegion*>(pView);
+
+    const PoseExportHeader& header = m_pRegion->header;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (memcmp(header.rgchMagic, k_rgchPoseExportMagic, sizeof(header.rgchMagic)) != 0 || header.unVersion != k_unPoseExportVersion ||
+        header.unSlotSize != sizeof(PoseExportSlot) || header.unMaxSlots != k_unPoseExportMaxSlots) {
+      Close();
+      return false;
+    }
+    return true;
+  }
+
+  void Close() {
+    if (!m_pRegion) {
+      return;
+    }
+#if defined(_WIN32)
+    UnmapViewOfFile(m_pRegion);
+    CloseHandle(m_hMapping);
+    m_hMapping = nullptr;
+#else
+    munmap(const_cast<PoseExportRegion*>(m_pRegion), sizeof(PoseExportRegion));
+#endif
+    m_pRegion = nullptr;
+  }
+
+  bool IsOpen() const { return m_pRegion != nullptr; }
+  uint32_t GetSlotCount() const { return m_pRegion->header.unSlotCount.load(std::memory_order_acquire); }
+
+  // Changes once per driver sweep; poll it to wait for new poses
+  uint64_t GetFrameCount() const { return m_pRegion->header.unFrameCount.load(std::memory_order_acquire); }
+
+  // Copies one slot. Returns false if it was never written, or if the driver kept overwriting it
+  // for unMaxRetries attempts in a row.
+  bool ReadSlot(uint32_t unSlot, PoseExportSample& outSample, uint32_t unMaxRetries = 64) const {
+    if (unSlot >= k_unPoseExportMaxSlots) {
+      return false;
+    }
+    const PoseExportSlot& slot = m_pRegion->slots[unSlot];
+    for (uint32_t attempt = 0; attempt < unMaxRetries; ++attempt) {
+      const uint32_t before = slot.unSequence.load(std::memory_order_acquire);
+      if (before == 0) {
+        return false;
+      }
+      if (before & 1u) {
+        continue; // Writer mid-copy
+      }
+      outSample.unObjectId = slot.unObjectId;
+      outSample.unPhysicalIndex = slot.unPhysicalIndex;
+      outSample.unFrame = slot.unFrame;
+      outSample.nSampleTimeNs = slot.nSampleTimeNs;
+      outSample.nPublishTimeNs = slot.nPublishTimeNs;
+      memcpy(&outSample.pose, &slot.pose, sizeof(vr::DriverPose_t));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.unSequence.load(std::memory_order_relaxed) == before) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  const PoseExportRegion* m_pRegion;
+  void* m_hMapping; // Windows only
+};
+
+}  // namespace vr
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <openvr_driver.h>
+#include <chrono>
+#include <string>
+
+#include "pose_export.h"
+
+namespace vr {
+
+// Driver side of the shared-memory pose export (layout and reader in pose_export.h). Creates the
+// named region on Open and removes it on Close. Only the thread running MirrorRegistry::UpdatePoses
+// writes, so each slot's sequence lock needs no writer-side CAS; writing a slot is one memcpy
+// between two stores, and readers never slow it down.
+class PoseExporter {
+ public:
+  PoseExporter();
+  ~PoseExporter();
+  PoseExporter(const PoseExporter&) = delete;
+  PoseExporter& operator=(const PoseExporter&) = delete;
+
+  bool Open(const char* pchName);
+  void Close();
+  bool IsOpen() const { return m_pRegion != nullptr; }
+
+  // Writes one slot of the current sweep
+  void PublishSlot(uint32_t unSlot, uint32_t unObjectId, uint32_t unPhysicalIndex, const vr::DriverPose_t& pose,
+                   std::chrono::steady_clock::time_point sampleTime);
+  // Marks the sweep complete so readers waiting on the frame count pick it up
+  void EndFrame(uint32_t unSlotCount);
+
+ private:
+  PoseExportRegion* m_pRegion;
+  std::string m_sName;
+  uint64_t m_unFrame;
+#if defined(_WIN32)
+  void* m_hMapping;
+#endif
+};
+
+}  // namespace vr
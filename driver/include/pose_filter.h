@@ -0,0 +1,77 @@
+#pragma once
+
+#include <openvr_driver.h>
+
+namespace vr {
+
+// Smoothing applied to the mirrored poses. Values match the "poseFilterMode" setting.
+enum EPoseFilterMode {
+  PoseFilter_Off = 0,
+  PoseFilter_OneEuro = 1, // Speed-adaptive low-pass: smooth when still, responsive when moving
+  PoseFilter_Kalman = 2,  // Constant-velocity Kalman filter; also replaces the velocities with its estimates
+};
+
+struct PoseFilterSettings {
+  EPoseFilterMode eMode;
+
+  // One Euro (Casiez et al. 2012). The cutoff rises from flMinCutoffHz by beta per unit of speed.
+  double flOneEuroMinCutoffHz;
+  double flOneEuroPositionBeta;   // Hz per m/s
+  double flOneEuroRotationBeta;   // Hz per rad/s
+  double flOneEuroDerivativeCutoffHz;
+
+  // Kalman. Process noise is the white-noise acceleration spectral density (units^2/s^3),
+  // measurement noise the standard deviation of one raw sample.
+  double flKalmanPositionProcessNoise;    // m^2/s^3
+  double flKalmanPositionMeasurementNoise; // m
+  double flKalmanRotationProcessNoise;    // rad^2/s^3
+  double flKalmanRotationMeasurementNoise; // rad
+};
+
+// Reads the filter settings. Off unless "poseFilterMode" is set.
+PoseFilterSettings ReadPoseFilterSettings();
+
+// Filter state for every mirror slot, preallocated as structure-of-arrays. Apply() runs the
+// configured filter over all slots in one pass; the mode is switched on once per call, not per
+// device, and nothing allocates. Rotations are filtered on the unit-quaternion manifold: the
+// error between prediction and measurement is taken as a rotation vector, scaled, and applied
+// back with the exponential map, so the output stays normalized.
+//
+// Only touched by whichever thread runs MirrorRegistry::UpdatePoses.
+class PoseFilterBank {
+ public:
+  static const uint32_t k_unMaxSlots = vr::k_unMaxTrackedDeviceCount;
+
+  PoseFilterBank();
+
+  // Applies new settings and restarts every slot's filter
+  void Configure(const PoseFilterSettings& settings);
+  EPoseFilterMode GetMode() const { return m_settings.eMode; }
+
+  // Filters pPoses[slot] in place for every slot with pbFilter[slot] set, using flTimeSeconds as the
+  // sample time. Slots not filtered this call restart from their next measurement.
+  void Apply(vr::DriverPose_t* pPoses, const bool* pbFilter, uint32_t unSlotCount, double flTimeSeconds);
+
+ private:
+  void ApplyOneEuro(vr::DriverPose_t& pose, uint32_t unSlot, double flDt);
+  void ApplyKalman(vr::DriverPose_t& pose, uint32_t unSlot, double flDt);
+  void Restart(const vr::DriverPose_t& pose, uint32_t unSlot);
+
+  PoseFilterSettings m_settings;
+
+  // Shared per-slot state
+  bool m_bInitialized[k_unMaxSlots];
+  double m_flLastTime[k_unMaxSlots];
+  double m_flPosition[3][k_unMaxSlots];  // Filtered position
+  double m_flRotation[4][k_unMaxSlots];  // Filtered rotation, w x y z
+
+  // Rates: One Euro keeps the low-passed derivative, Kalman the velocity state
+  double m_flVelocity[3][k_unMaxSlots];
+  double m_flAngularVelocity[3][k_unMaxSlots];
+
+  // Kalman covariance per axis, symmetric 2x2 over (value, rate): P00, P01, P11
+  double m_flPositionCov[3][3][k_unMaxSlots];
+  double m_flRotationCov[3][3][k_unMaxSlots];
+};
+
+}  // namespace vr
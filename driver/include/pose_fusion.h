@@ -0,0 +1,78 @@
+#pragma once
+
+#include <openvr_driver.h>
+
+#include "pose_calibration.h"
+#include "pose_conversion.h"
+
+namespace vr {
+
+static const uint32_t k_unMaxPoseFusionSources = 4; // Per mirror, including its own physical device
+
+// An extra physical device feeding a mirror, and its mount offset X with mirror = device * X
+// (the same convention as driverFromHead; SolveDriverFromHeadOffset fits it from a recording).
+struct PoseFusionSource {
+  uint32_t unPhysicalIndex;
+  PoseOffset offset;
+};
+
+// Reads the extra sources of the mirror with the given serial from "driver_mydriver_fusion_<serial>":
+// source1Index..source3Index, each with optional source<N>Rotation/source<N>Translation strings.
+// Returns how many were found, at most unMaxSources.
+uint32_t ReadDeviceFusionSources(const char* pchSerial, PoseFusionSource* pSources, uint32_t unMaxSources);
+
+// Fusion of several physical devices into one mirrored pose, per registry slot. Every frame, each
+// source's pose is moved into the mirror's frame by its offset, and the valid ones are averaged
+// with weights that follow their eTrackingResult: a tracker in view (Running_OK) outweighs an
+// occluded controller coasting on its IMU (Fallback_RotationOnly) by far.
+//
+// Handover is smooth both ways. A source gaining weight fades in over the blend time through a
+// low-pass on each source's share of the average. A source dropping out can't fade (its pose is gone), so the jump this causes
+// is captured as a correction on the output that decays over the blend time instead.
+//
+// Fixed-size tables and no allocation; only touched by the registry's sweep, apart from Bind.
+class PoseFusionBank {
+ public:
+  static const uint32_t k_unMaxSlots = vr::k_unMaxTrackedDeviceCount;
+
+  PoseFusionBank();
+
+  // Time constant of the weight fades and of the handover correction
+  void SetBlendSeconds(double flSeconds) { m_flBlendSeconds = flSeconds > 0.0 ? flSeconds : 0.0; }
+
+  // Makes unPrimaryIndex (with identity offset) plus the given extras the slot's sources, and
+  // restarts its blend. No extras unbinds the slot. Only call while the slot is out of the sweeps.
+  void Bind(uint32_t unSlot, uint32_t unPrimaryIndex, const PoseFusionSource* pExtras, uint32_t unExtraCount);
+  bool IsFused(uint32_t unSlot) const { return m_unSourceCount[unSlot] > 1; }
+
+  // Fuses the slot's sources out of one snapshot (raw flags plus its converted batch) into pose's
+  // position, rotation, velocities, result and poseIsValid. Returns whether any source is valid;
+  // bOutConnected tells whether any is connected.
+  bool Fuse(uint32_t unSlot, const vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount, const PoseConversionBatch& converted,
+            double flTimeSeconds, vr::DriverPose_t& pose, bool& bOutConnected);
+
+  // Index of the source currently weighing the most, for diagnostics
+  uint32_t GetDominantSource(uint32_t unSlot) const { return m_unDominant[unSlot]; }
+
+ private:
+  double m_flBlendSeconds;
+
+  // Bindings
+  uint32_t m_unSourceCount[k_unMaxSlots];
+  uint32_t m_unSourceIndex[k_unMaxPoseFusionSources][k_unMaxSlots];
+  double m_flOffsetRotation[k_unMaxPoseFusionSources][4][k_unMaxSlots];    // w x y z
+  double m_flOffsetTranslation[k_unMaxPoseFusionSources][3][k_unMaxSlots];
+
+  // Blend state
+  double m_flWeight[k_unMaxPoseFusionSources][k_unMaxSlots];  // Low-passed share of the average, 0 for invalid sources
+  uint32_t m_unContributing[k_unMaxSlots];                     // Bit per source that had weight last frame
+  double m_flLastTime[k_unMaxSlots];
+  bool m_bHasOutput[k_unMaxSlots];
+  double m_flOutputPosition[3][k_unMaxSlots];                  // Last fused pose, the handover reference
+  double m_flOutputRotation[4][k_unMaxSlots];
+  double m_flCorrectionPosition[3][k_unMaxSlots];              // Decaying handover correction
+  double m_flCorrectionRotation[4][k_unMaxSlots];
+  uint32_t m_unDominant[k_unMaxSlots];
+};
+
+}  // namespace vr
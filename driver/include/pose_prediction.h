@@ -0,0 +1,26 @@
+#pragma once
+
+#include <openvr_driver.h>
+
+namespace vr {
+
+// How far ahead MyControllerDriver extrapolates the mirrored pose.
+// Values match the "predictionMode" setting.
+enum EPosePredictionMode {
+  PosePrediction_Off = 0,         // Send the raw pose as sampled (poseTimeOffset = 0)
+  PosePrediction_FixedHorizon = 1, // Extrapolate by "predictionHorizonMs"
+  PosePrediction_DisplayTime = 2,  // Extrapolate to the HMD's next photon time (frame interval + vsync-to-photons)
+};
+
+// Reads the prediction settings (and, for PosePrediction_DisplayTime, the HMD display timing
+// properties) and returns the horizon in seconds. Returns 0 when prediction is off.
+double ReadPosePredictionHorizonSeconds();
+
+// Extrapolates pose in place by flSecondsAhead using a constant velocity model:
+// position moves linearly along vecVelocity, rotation is advanced by the quaternion
+// integrated from vecAngularVelocity (axis-angle, tracking space). poseTimeOffset is set to 0,
+// since the host would otherwise extrapolate the pose a second time, and the acceleration fields
+// are zeroed so the host sees a consistent pose.
+void PredictDriverPose(vr::DriverPose_t& pose, double flSecondsAhead);
+
+}  // namespace vr
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <openvr_driver.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+#include "pose_source.h"
+
+namespace vr {
+
+// On-disk layout of a raw pose recording. All fields are written in host byte order with the
+// recording machine's TrackedDevicePose_t layout; unPoseSize lets a reader reject a mismatch.
+//
+//   PoseRecordingHeader
+//   repeated: PoseRecordingFrameHeader, then unPoseCount * TrackedDevicePose_t (indices 0..unPoseCount-1)
+//
+// Frames only store poses up to the highest connected device index, which keeps idle slots out of the file.
+static const char k_rgchPoseRecordingMagic[4] = {'M', 'D', 'P', 'R'};
+static const uint32_t k_unPoseRecordingVersion = 1;
+
+struct PoseRecordingHeader {
+  char rgchMagic[4];
+  uint32_t unVersion;
+  uint32_t unPoseSize;  // sizeof(vr::TrackedDevicePose_t)
+  uint32_t unMaxPoses;  // vr::k_unMaxTrackedDeviceCount
+  int32_t nDeviceClass[vr::k_unMaxTrackedDeviceCount];    // ETrackedDeviceClass of each index at record time
+  int32_t nControllerRole[vr::k_unMaxTrackedDeviceCount]; // ETrackedControllerRole of each index at record time
+};
+
+struct PoseRecordingFrameHeader {
+  double flTimestamp; // Seconds since the recording started
+  uint32_t unPoseCount;
+  uint32_t unReserved;
+};
+
+// Appends each frame's raw pose snapshot to a recording file. Record() only copies into a
+// preallocated ring; a background thread does the file I/O. If the writer falls behind, frames
+// are dropped (and counted) instead of blocking the caller.
+class PoseRecorder {
+ public:
+  PoseRecorder();
+  ~PoseRecorder();
+
+  bool Open(const char* pchPath, const int32_t* pDeviceClasses, const int32_t* pControllerRoles);
+  void Close();
+  bool IsOpen() const { return m_pFile != nullptr; }
+
+  // Hot path: one ring slot copy, never allocates or blocks. Single producer.
+  void Record(const vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount);
+
+  uint64_t GetDroppedFrameCount() const { return m_unDroppedFrames.load(std::memory_order_relaxed); }
+
+ private:
+  static const uint32_t k_unRingFrames = 512; // ~2.6 MB, a few seconds of slack at 144 Hz
+
+  struct RingFrame {
+    PoseRecordingFrameHeader header;
+    vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+  };
+
+  void FlushThreadMain();
+  void FlushPending();
+
+  FILE* m_pFile;
+  std::unique_ptr<RingFrame[]> m_ring;
+  std::atomic<uint64_t> m_unWriteIndex; // Next frame Record() fills
+  std::atomic<uint64_t> m_unReadIndex;  // Next frame the flush thread writes out
+  std::atomic<uint64_t> m_unDroppedFrames;
+  std::atomic<bool> m_bFlushThreadRunning;
+  std::thread m_flushThread;
+  std::chrono::steady_clock::time_point m_startTime;
+};
+
+// Plays a recording back in place of GetRawTrackedDevicePoses. The file is memory-mapped and
+// frames are copied straight out of the mapping. As a pose source it also supplies the devices
+// that were recorded, in place of the host's.
+class PoseReplay : public IPoseSource {
+ public:
+  PoseReplay();
+  ~PoseReplay();
+
+  // bRealTime paces frames by their timestamps, otherwise every Read() advances one frame.
+  // bLoop restarts at the first frame when the end is reached, otherwise the last frame is held.
+  bool Open(const char* pchPath, bool bRealTime, bool bLoop);
+  void Close();
+  bool IsOpen() const { return m_pData != nullptr; }
+
+  const PoseRecordingHeader& GetHeader() const { return *reinterpret_cast<const PoseRecordingHeader*>(m_pData); }
+  // Number of frames in the recording; walks the whole file
+  uint32_t GetFrameCount() const;
+
+  // Fills pRawPoses with the current frame; indices the frame doesn't cover read as disconnected
+  void Read(vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount);
+
+  // IPoseSource
+  const char* GetName() const override { return "replay"; }
+  void Sample(vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount) override { Read(pRawPoses, unRawPoseCount); }
+  bool ProvidesDevices() const override { return true; }
+  bool GetDevice(uint32_t unIndex, int32_t& nDeviceClass, int32_t& nControllerRole) const override;
+
+ private:
+  // Byte size of the frame at unOffset, or 0 if it doesn't fit in the file
+  size_t FrameSizeAt(size_t unOffset) const;
+  double FrameTimestampAt(size_t unOffset) const;
+
+  const uint8_t* m_pData;
+  size_t m_unSize;
+  size_t m_unFirstFrameOffset;
+  size_t m_unFrameOffset; // Frame handed out by the next Read()
+  bool m_bRealTime;
+  bool m_bLoop;
+  bool m_bStarted;
+  std::chrono::steady_clock::time_point m_startTime;
+
+#if defined(_WIN32)
+  void* m_hFile;
+  void* m_hMapping;
+#endif
+};
+
+}  // namespace vr
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <openvr_driver.h>
+#include <memory>
+
+#include "input_mirror.h" // MirrorInputState and MirrorHapticPulse
+
+namespace vr {
+
+// Where the raw poses the mirrors follow come from. Values match the "poseSource" setting;
+// a replay (replayPath) overrides it.
+enum EPoseSourceType {
+  PoseSource_Host = 0,          // The host's physical devices, via GetRawTrackedDevicePoses
+  PoseSource_SharedMemory = 1,  // An external tracker writing a shared-memory ring (see external_pose_protocol.h)
+  PoseSource_Udp = 2,           // An external tracker sending loopback UDP datagrams (same sample format)
+};
+
+// A provider of raw pose snapshots, indexed like GetRawTrackedDevicePoses. MyTrackedDeviceProvider
+// samples exactly one source per frame (or tracking thread tick), on one thread at a time.
+class IPoseSource {
+ public:
+  virtual ~IPoseSource() {}
+
+  virtual const char* GetName() const = 0;
+
+  // Fills pRawPoses[0..unRawPoseCount) with the latest poses. Must not block or allocate.
+  virtual void Sample(vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount) = 0;
+
+  // False if the devices are the host's own, which are discovered through host events. True if the
+  // source defines its devices itself; their class and role hint are then read with GetDevice,
+  // again whenever GetDeviceChangeCount moves. Both may be called from the host thread while
+  // another thread samples.
+  virtual bool ProvidesDevices() const { return false; }
+  virtual bool GetDevice(uint32_t, int32_t&, int32_t&) const { return false; }
+  virtual uint32_t GetDeviceChangeCount() const { return 0; }
+
+  // True if the source also reads its devices' buttons and axes and can play haptics on them.
+  // Host thread, once per frame: TakeInputState returns a device's latest input state and advances
+  // unLastSeen if it changed since unLastSeen, and SendHapticPulse hands a pulse requested on its
+  // mirror to the device. Neither blocks or allocates.
+  virtual bool ProvidesInput() const { return false; }
+  virtual bool TakeInputState(uint32_t, uint32_t&, MirrorInputState&) const { return false; }
+  virtual void SendHapticPulse(uint32_t, const MirrorHapticPulse&) {}
+};
+
+// The default source: the host's physical devices
+class HostPoseSource : public IPoseSource {
+ public:
+  const char* GetName() const override { return "host"; }
+  void Sample(vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount) override {
+    vr::VRServerDriverHost()->GetRawTrackedDevicePoses(0.f, pRawPoses, unRawPoseCount);
+  }
+};
+
+// Creates and opens the external source selected by eType (PoseSource_SharedMemory or
+// PoseSource_Udp) from the settings. Returns nullptr if it could not be opened.
+std::unique_ptr<IPoseSource> CreateExternalPoseSource(EPoseSourceType eType);
+
+}  // namespace vr
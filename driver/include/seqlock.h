@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace vr {
+
+// Sequence lock for handing a small, trivially copyable value from a writer thread to any
+// number of readers. Readers never take a lock: they copy the value and retry only if a write
+// overlapped the copy. Writers serialize among themselves with a CAS on the sequence counter,
+// so an odd sequence means a write is in progress.
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+
+ public:
+  SeqLock() : m_seq(0), m_value() {}
+
+  void Store(const T& value) {
+    uint32_t seq = m_seq.load(std::memory_order_relaxed);
+    for (;;) {
+      if ((seq & 1u) == 0 && m_seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+        break;
+      }
+      seq = m_seq.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&m_value, &value, sizeof(T));
+    m_seq.store(seq + 2, std::memory_order_release);
+  }
+
+  T Load() const {
+    T value;
+    for (;;) {
+      const uint32_t before = m_seq.load(std::memory_order_acquire);
+      if (before & 1u) {
+        continue; // Writer mid-copy, try again
+      }
+      memcpy(&value, &m_value, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (m_seq.load(std::memory_order_relaxed) == before) {
+        return value;
+      }
+    }
+  }
+
+  // Number of completed stores, lets readers tell whether anything new was published
+  uint32_t Version() const { return m_seq.load(std::memory_order_acquire) >> 1; }
+
+ private:
+  alignas(64) std::atomic<uint32_t> m_seq;
+  T m_value;
+};
+
+}  // namespace vr
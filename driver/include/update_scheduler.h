@@ -0,0 +1,86 @@
+#pragma once
+
+#include <openvr_driver.h>
+#include <atomic>
+#include <chrono>
+
+namespace vr {
+
+// How much attention a mirror currently needs
+enum EMirrorActivity {
+  MirrorActivity_Active = 0,      // Moving, or its tracking state just changed: every pose goes out
+  MirrorActivity_Stationary = 1,  // Tracked but still for a while: keep-alive submissions only
+  MirrorActivity_Dormant = 2,     // Not tracked for a while: keep-alive submissions only
+};
+
+struct UpdateSchedulerSettings {
+  bool bEnabled;
+  double flIdleAfterSeconds;       // Time without motion (or without a valid pose) before a mirror idles
+  double flIdleKeepAliveSeconds;   // Submission interval of idle mirrors
+  double flDormantSampleSeconds;   // Sampling interval while every mirror is dormant
+  double flMotionPositionEpsilon;  // Meters; movement below this (jitter) doesn't count as motion
+  double flMotionRotationEpsilon;  // Radians
+  bool bBlockStandbyWhileMoving;   // Ask SteamVR not to enter standby while a mirror moves
+
+  // Derived by ReadUpdateSchedulerSettings so the per-frame test needs no sqrt/acos
+  double flMotionPositionEpsilonSq;
+  double flMotionCosHalfRotationEpsilon;
+};
+
+// Reads the scheduler settings. Disabled unless "adaptiveUpdateRate" is set.
+UpdateSchedulerSettings ReadUpdateSchedulerSettings();
+
+// Per-slot activity tracking for adaptive update rates. Update() runs in the registry's pose
+// sweep and compares every pose with the one where the mirror last moved; motion past the
+// epsilons, or any change of tracking state, makes the mirror active again in that same sweep,
+// so idling never delays a wake-up. Idle mirrors are only re-submitted every keep-alive interval,
+// and when all of them are dormant the provider samples at the dormant interval.
+class UpdateScheduler {
+ public:
+  static const uint32_t k_unMaxSlots = vr::k_unMaxTrackedDeviceCount;
+
+  UpdateScheduler();
+
+  void Configure(const UpdateSchedulerSettings& settings);
+  const UpdateSchedulerSettings& GetSettings() const { return m_settings; }
+  bool IsEnabled() const { return m_settings.bEnabled; }
+
+  // Makes the slot active and forgets its history, e.g. on activation
+  void ResetSlot(uint32_t unSlot, std::chrono::steady_clock::time_point now);
+
+  // Classifies the slot's newest pose. Sweep thread only.
+  EMirrorActivity Update(uint32_t unSlot, const vr::DriverPose_t& pose, std::chrono::steady_clock::time_point now);
+  // Summarizes the sweep's Update calls for AreAllDormant/IsAnyMoving. Sweep thread only.
+  void EndSweep();
+
+  // Any thread
+  EMirrorActivity GetActivity(uint32_t unSlot) const { return (EMirrorActivity)m_activity[unSlot].load(std::memory_order_relaxed); }
+  bool AreAllDormant() const { return m_bAllDormant.load(std::memory_order_relaxed); }
+  bool IsAnyMoving() const { return m_bAnyMoving.load(std::memory_order_relaxed); }
+  // Forgets the last sweep's motion when sweeps stop, so IsAnyMoving doesn't report it indefinitely
+  void ClearMotion() { m_bAnyMoving.store(false, std::memory_order_relaxed); }
+
+  // Whether a slot last submitted at lastSubmit should be submitted now
+  bool ShouldSubmit(uint32_t unSlot, std::chrono::steady_clock::time_point now, std::chrono::steady_clock::time_point lastSubmit) const {
+    return !m_settings.bEnabled || GetActivity(unSlot) == MirrorActivity_Active ||
+           std::chrono::duration<double>(now - lastSubmit).count() >= m_settings.flIdleKeepAliveSeconds;
+  }
+
+ private:
+  UpdateSchedulerSettings m_settings;
+
+  // Sweep thread only: where each mirror last moved, and when its activity last had reason to stay up
+  double m_flReferencePosition[3][k_unMaxSlots];
+  double m_flReferenceRotation[4][k_unMaxSlots];
+  bool m_bReferenceValid[k_unMaxSlots];
+  std::chrono::steady_clock::time_point m_lastActive[k_unMaxSlots];
+  uint32_t m_unUpdatedCount; // Update calls since the last EndSweep, and how many of them...
+  uint32_t m_unDormantCount; // ...came out dormant
+  uint32_t m_unMovingCount;  // ...came out active with a valid pose
+
+  std::atomic<uint8_t> m_activity[k_unMaxSlots];
+  std::atomic<bool> m_bAllDormant;
+  std::atomic<bool> m_bAnyMoving;
+};
+
+}  // namespace vr
@@ -0,0 +1,59 @@
+#include "device_discovery.h"
+#include "driver_log.h"
+
+namespace vr {
+
+DeviceDiscovery::DeviceDiscovery() {
+  Reset();
+}
+
+void DeviceDiscovery::Reset() {
+  for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i) {
+    m_nDeviceClass[i] = vr::TrackedDeviceClass_Invalid;
+    m_nControllerRole[i] = vr::TrackedControllerRole_Invalid;
+    m_unMirrorSlot[i] = k_unNoSlot;
+  }
+}
+
+bool DeviceDiscovery::RefreshDevice(uint32_t unPhysicalIndex) {
+  if (unPhysicalIndex >= vr::k_unMaxTrackedDeviceCount) {
+    return false;
+  }
+
+  vr::PropertyContainerHandle_t container = vr::VRProperties()->TrackedDeviceToPropertyContainer(unPhysicalIndex);
+  vr::ETrackedPropertyError propError;
+  int32_t deviceClass = vr::VRProperties()->GetInt32Property(container, vr::Prop_DeviceClass_Int32, &propError);
+  if (propError != vr::TrackedProp_Success) {
+    DRIVER_LOG_WARNING(DriverLogCategory_Provider, "DeviceDiscovery::RefreshDevice - Error getting DeviceClass for device index {}: {}", unPhysicalIndex, propError);
+    deviceClass = vr::TrackedDeviceClass_Invalid;
+  }
+
+  int32_t controllerRole = vr::TrackedControllerRole_Invalid;
+  if (deviceClass == vr::TrackedDeviceClass_Controller) {
+    controllerRole = vr::VRProperties()->GetInt32Property(container, vr::Prop_ControllerRoleHint_Int32, &propError);
+    if (propError != vr::TrackedProp_Success) {
+      // Treated as not ready yet; a later role-changed event retries
+      DRIVER_LOG_WARNING(DriverLogCategory_Provider, "DeviceDiscovery::RefreshDevice - Error getting ControllerRoleHint for device index {}: {}", unPhysicalIndex, propError);
+      deviceClass = vr::TrackedDeviceClass_Invalid;
+      controllerRole = vr::TrackedControllerRole_Invalid;
+    }
+  }
+
+  const bool changed = deviceClass != m_nDeviceClass[unPhysicalIndex] || controllerRole != m_nControllerRole[unPhysicalIndex];
+  m_nDeviceClass[unPhysicalIndex] = deviceClass;
+  m_nControllerRole[unPhysicalIndex] = controllerRole;
+  return changed;
+}
+
+void DeviceDiscovery::SetDevice(uint32_t unPhysicalIndex, int32_t nDeviceClass, int32_t nControllerRole) {
+  if (unPhysicalIndex < vr::k_unMaxTrackedDeviceCount) {
+    m_nDeviceClass[unPhysicalIndex] = nDeviceClass;
+    m_nControllerRole[unPhysicalIndex] = nControllerRole;
+  }
+}
+
+void DeviceDiscovery::Invalidate(uint32_t unPhysicalIndex) {
+  SetDevice(unPhysicalIndex, vr::TrackedDeviceClass_Invalid, vr::TrackedControllerRole_Invalid);
+}
+
+}  // namespace vr
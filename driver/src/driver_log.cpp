@@ -0,0 +1,238 @@
+#include "driver_log.h"
+#include "vrcommon/shared/driverlog.h" // For VRDriverLog
+
+#include <chrono>
+#include <cinttypes> // For PRId64/PRIu64
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+namespace vr {
+
+std::atomic<uint8_t> g_rgDriverLogLevel[DriverLogCategory_Count] = {
+    {DriverLogLevel_Info}, {DriverLogLevel_Info}, {DriverLogLevel_Info}, {DriverLogLevel_Info}};
+
+namespace {
+
+const uint32_t k_unRingSize = 1024; // Power of two
+
+// Bounded multi-producer queue (Vyukov): each cell's sequence says whether it is free for the
+// producer claiming position pos (seq == pos) or holds a record for the consumer (seq == pos + 1).
+struct RingCell {
+  std::atomic<uint64_t> unSequence;
+  DriverLogRecord record;
+};
+
+struct CategoryRateLimit {
+  std::atomic<int64_t> nWindowStartMs;
+  std::atomic<uint32_t> unWindowCount;
+  std::atomic<uint64_t> unSuppressed; // Reported and cleared by the writer thread
+};
+
+RingCell g_ring[k_unRingSize];
+std::atomic<uint64_t> g_unEnqueuePos(0);
+uint64_t g_unDequeuePos = 0; // Writer thread only
+std::atomic<uint64_t> g_unDropped(0);
+std::atomic<uint32_t> g_unRateLimit(50);
+CategoryRateLimit g_rateLimit[DriverLogCategory_Count];
+
+std::atomic<bool> g_bWriterRunning(false);
+std::thread g_writerThread;
+const std::chrono::steady_clock::time_point g_startTime = std::chrono::steady_clock::now();
+
+const char* const k_rgpchLevelNames[] = {"ERROR", "WARN", "INFO", "VERBOSE", "TRACE"};
+const char* const k_rgpchCategoryNames[] = {"provider", "device", "pose", "recording"};
+
+struct RingInitializer {
+  RingInitializer() {
+    for (uint32_t i = 0; i < k_unRingSize; ++i) {
+      g_ring[i].unSequence.store(i, std::memory_order_relaxed);
+    }
+  }
+} g_ringInitializer;
+
+// Returns false if the category already used up its budget for the current second
+bool AcquireRateLimit(EDriverLogCategory eCategory, int64_t nNowMs) {
+  CategoryRateLimit& limit = g_rateLimit[eCategory];
+  int64_t windowStart = limit.nWindowStartMs.load(std::memory_order_relaxed);
+  if (nNowMs - windowStart >= 1000 && limit.nWindowStartMs.compare_exchange_strong(windowStart, nNowMs, std::memory_order_relaxed)) {
+    limit.unWindowCount.store(0, std::memory_order_relaxed);
+  }
+  if (limit.unWindowCount.fetch_add(1, std::memory_order_relaxed) >= g_unRateLimit.load(std::memory_order_relaxed)) {
+    limit.unSuppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+bool Enqueue(const DriverLogRecord& record) {
+  uint64_t pos = g_unEnqueuePos.load(std::memory_order_relaxed);
+  for (;;) {
+    RingCell& cell = g_ring[pos & (k_unRingSize - 1)];
+    const uint64_t seq = cell.unSequence.load(std::memory_order_acquire);
+    const int64_t diff = (int64_t)seq - (int64_t)pos;
+    if (diff == 0) {
+      if (g_unEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        memcpy(&cell.record, &record, sizeof(record));
+        cell.unSequence.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      return false; // Full
+    } else {
+      pos = g_unEnqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool Dequeue(DriverLogRecord& outRecord) {
+  RingCell& cell = g_ring[g_unDequeuePos & (k_unRingSize - 1)];
+  if (cell.unSequence.load(std::memory_order_acquire) != g_unDequeuePos + 1) {
+    return false; // Empty
+  }
+  memcpy(&outRecord, &cell.record, sizeof(outRecord));
+  cell.unSequence.store(g_unDequeuePos + k_unRingSize, std::memory_order_release);
+  ++g_unDequeuePos;
+  return true;
+}
+
+// Formats one record as "[seconds][LEVEL][category] message" with "{}" replaced by the packed arguments.
+// The time is when the record was submitted, which can be a few milliseconds before vrserver stamps the line.
+void FormatRecord(const DriverLogRecord& record, char* pchOut, size_t unOutSize) {
+  int written = snprintf(pchOut, unOutSize, "[%.3f][%s][%s] ", record.flTimestamp, k_rgpchLevelNames[record.eLevel],
+                         k_rgpchCategoryNames[record.eCategory]);
+  size_t used = written > 0 ? (size_t)written : 0;
+  uint8_t argIndex = 0;
+
+  for (const char* p = record.pchFormat; *p && used + 1 < unOutSize; ++p) {
+    if (p[0] == '{' && p[1] == '}' && argIndex < record.unArgCount) {
+      const size_t remaining = unOutSize - used;
+      switch (record.eArgType[argIndex]) {
+        case DriverLogArg_Int: written = snprintf(pchOut + used, remaining, "%" PRId64, record.args[argIndex].i); break;
+        case DriverLogArg_UInt: written = snprintf(pchOut + used, remaining, "%" PRIu64, record.args[argIndex].u); break;
+        case DriverLogArg_Double: written = snprintf(pchOut + used, remaining, "%g", record.args[argIndex].d); break;
+        case DriverLogArg_Bool: written = snprintf(pchOut + used, remaining, "%s", record.args[argIndex].u ? "true" : "false"); break;
+        case DriverLogArg_Text: written = snprintf(pchOut + used, remaining, "%s", record.rgchText + record.args[argIndex].u); break;
+      }
+      used += written > 0 ? ((size_t)written < remaining ? (size_t)written : remaining - 1) : 0;
+      ++argIndex;
+      ++p; // Skip the '}'
+    } else {
+      pchOut[used++] = *p;
+    }
+  }
+  pchOut[used] = '\0';
+}
+
+void DrainRing() {
+  char line[512];
+  DriverLogRecord record;
+  while (Dequeue(record)) {
+    FormatRecord(record, line, sizeof(line));
+    VRDriverLog()->Log(line);
+  }
+
+  for (uint32_t category = 0; category < DriverLogCategory_Count; ++category) {
+    const uint64_t suppressed = g_rateLimit[category].unSuppressed.exchange(0, std::memory_order_relaxed);
+    if (suppressed > 0) {
+      const double now = std::chrono::duration<double>(std::chrono::steady_clock::now() - g_startTime).count();
+      snprintf(line, sizeof(line), "[%.3f][WARN][%s] %" PRIu64 " log record(s) suppressed by the rate limit", now, k_rgpchCategoryNames[category],
+               suppressed);
+      VRDriverLog()->Log(line);
+    }
+  }
+}
+
+void WriterThreadMain() {
+  while (g_bWriterRunning.load(std::memory_order_acquire)) {
+    DrainRing();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+}
+
+}  // namespace
+
+void DriverLogPackText(DriverLogRecord& record, const char* pchText) {
+  if (record.unArgCount >= k_unDriverLogMaxArgs) {
+    return;
+  }
+  const uint8_t index = record.unArgCount++;
+  record.eArgType[index] = DriverLogArg_Text;
+  record.args[index].u = record.unTextUsed;
+
+  // Copy as much as fits, always leaving a terminator
+  size_t offset = record.unTextUsed;
+  if (offset >= k_unDriverLogTextSize) {
+    record.args[index].u = k_unDriverLogTextSize - 1; // Points at the final terminator
+    return;
+  }
+  const char* p = pchText ? pchText : "(null)";
+  while (*p && offset + 1 < k_unDriverLogTextSize) {
+    record.rgchText[offset++] = *p++;
+  }
+  record.rgchText[offset++] = '\0';
+  record.unTextUsed = (uint8_t)offset;
+  record.rgchText[k_unDriverLogTextSize - 1] = '\0';
+}
+
+void DriverLogSubmit(DriverLogRecord& record) {
+  const std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - g_startTime;
+  record.flTimestamp = std::chrono::duration<double>(elapsed).count();
+
+  // Errors and warnings are rare and the ones that matter; only the chattier levels are rate limited
+  const bool limited = record.eLevel > DriverLogLevel_Warning;
+  if ((limited && !AcquireRateLimit(record.eCategory, std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count())) || !Enqueue(record)) {
+    g_unDropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void DriverLogStart() {
+  if (g_bWriterRunning.exchange(true, std::memory_order_acq_rel)) {
+    return; // Already running
+  }
+  g_writerThread = std::thread(WriterThreadMain);
+}
+
+void DriverLogStop() {
+  if (!g_bWriterRunning.exchange(false, std::memory_order_acq_rel)) {
+    return;
+  }
+  if (g_writerThread.joinable()) {
+    g_writerThread.join();
+  }
+  DrainRing(); // Anything queued after the thread's last pass
+}
+
+void DriverLogSetLevel(EDriverLogLevel eLevel) {
+  for (uint32_t category = 0; category < DriverLogCategory_Count; ++category) {
+    g_rgDriverLogLevel[category].store(eLevel, std::memory_order_relaxed);
+  }
+}
+
+void DriverLogSetCategoryLevel(EDriverLogCategory eCategory, EDriverLogLevel eLevel) {
+  g_rgDriverLogLevel[eCategory].store(eLevel, std::memory_order_relaxed);
+}
+
+void DriverLogSetRateLimit(uint32_t unRecordsPerSecond) {
+  g_unRateLimit.store(unRecordsPerSecond, std::memory_order_relaxed);
+}
+
+const char* DriverLogGetCategoryName(EDriverLogCategory eCategory) {
+  return eCategory < DriverLogCategory_Count ? k_rgpchCategoryNames[eCategory] : "unknown";
+}
+
+bool DriverLogFindCategory(const char* pchName, EDriverLogCategory& outCategory) {
+  for (uint32_t category = 0; category < DriverLogCategory_Count; ++category) {
+    if (strcmp(pchName, k_rgpchCategoryNames[category]) == 0) {
+      outCategory = (EDriverLogCategory)category;
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t DriverLogGetDroppedCount() {
+  return g_unDropped.load(std::memory_order_relaxed);
+}
+
+}  // namespace vr
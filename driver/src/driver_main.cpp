@@ -1,9 +1,19 @@
 #include "driver_main.h"
 
 #include <openvr_driver.h>
+#include <algorithm> // For std::max
+#include <chrono> // For the tracking thread's tick
+#include <string> // For the mirrored device serials
 #include <vector> // Required for GetInterfaceVersions
+#include "driver_log.h" // For DRIVER_LOG_*
+#include "driver_settings.h" // For the driver_mydriver settings keys
+#include "driver_stats.h" // For ScopedDriverTimer
 #include "my_controller_driver.h" // Include the controller driver
-#include "vrcommon/shared/driverlog.h" // For VRDriverLog
+#include "pose_change_detection.h" // For ReadPoseChangeDetectionSettings
+#include "pose_conversion.h" // For GetPoseConversionKernelName
+#include "pose_filter.h" // For ReadPoseFilterSettings
+#include "pose_prediction.h" // For ReadPosePredictionHorizonSeconds
+#include "update_scheduler.h" // For ReadUpdateSchedulerSettings
 
 // Define the vr namespace
 namespace vr {
@@ -14,91 +24,144 @@ vr::IServerTrackedDeviceProvider *g_pMyDriverProvider = nullptr;
 // MyTrackedDeviceProvider methods
 MyTrackedDeviceProvider::MyTrackedDeviceProvider()
     : m_unLeftControllerDeviceIndex(vr::k_unTrackedDeviceIndexInvalid),
-      m_unRightControllerDeviceIndex(vr::k_unTrackedDeviceIndexInvalid) {} // Constructor
-MyTrackedDeviceProvider::~MyTrackedDeviceProvider() {} // Destructor
+      m_unRightControllerDeviceIndex(vr::k_unTrackedDeviceIndexInvalid),
+      m_pPoseSource(&m_hostSource),
+      m_unSourceDeviceChangeCount(0),
+      m_unSourceInputSeen{},
+      m_unHapticPulseSeen{},
+      m_rawPoses{},
+      m_flTrackingThreadHz(0.f),
+      m_bStandby(false),
+      m_bTrackingThreadRunning(false),
+      m_bTrackingThreadDormant(false),
+      m_bTrackingWakeRequested(false),
+      m_trackingThreadRawPoses{} {} // Constructor
+MyTrackedDeviceProvider::~MyTrackedDeviceProvider() {
+    StopTrackingThread(); // In case Cleanup was never called
+} // Destructor
 
 // Implementation of IServerTrackedDeviceProvider methods
 vr::EVRInitError MyTrackedDeviceProvider::Init(vr::IVRDriverContext *pDriverContext)
 {
     VR_INIT_SERVER_DRIVER_CONTEXT(pDriverContext);
-    VRDriverLog()->Log("MyTrackedDeviceProvider::Init - Starting initialization");
+    vr::EVRSettingsError settingsError = vr::VRSettingsError_None;
+    const int32_t logLevel = vr::VRSettings()->GetInt32(k_pch_MyDriver_Section, k_pch_MyDriver_LogLevel_Int32, &settingsError);
+    if (settingsError == vr::VRSettingsError_None && logLevel >= DriverLogLevel_Error && logLevel <= DriverLogLevel_Trace) {
+        DriverLogSetLevel((EDriverLogLevel)logLevel);
+    }
+    const int32_t logRateLimit = vr::VRSettings()->GetInt32(k_pch_MyDriver_Section, k_pch_MyDriver_LogRateLimitPerSecond_Int32, &settingsError);
+    if (settingsError == vr::VRSettingsError_None && logRateLimit > 0) {
+        DriverLogSetRateLimit((uint32_t)logRateLimit);
+    }
+    DriverLogStart(); // Also flushes anything logged before Init, e.g. by HmdDriverFactory
+    DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::Init - Starting initialization");
 
     uint32_t trackedDeviceCount = vr::VRServerDriverHost()->GetTrackedDeviceCount();
-    VRDriverLog()->Log("MyTrackedDeviceProvider::Init - Total tracked devices found by OpenVR: " + std::to_string(trackedDeviceCount));
-
-    // Iterate through connected devices to find controllers
-    for (uint32_t i = 0; i < trackedDeviceCount; ++i) {
-        vr::PropertyContainerHandle_t container = vr::VRProperties()->TrackedDeviceToPropertyContainer(i);
+    DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::Init - Total tracked devices found by OpenVR: {}", trackedDeviceCount);
 
-        ETrackedPropertyError propError; // Renamed to avoid conflict
-        int32_t device_class = vr::VRProperties()->GetInt32Property(container, vr::Prop_DeviceClass_Int32, &propError);
+    m_registry.SetPredictionHorizon(ReadPosePredictionHorizonSeconds());
+    m_registry.SetChangeDetection(ReadPoseChangeDetectionSettings());
+    m_registry.SetPoseFilter(ReadPoseFilterSettings());
+    m_registry.SetUpdateScheduler(ReadUpdateSchedulerSettings());
+    const float fusionBlendMs = vr::VRSettings()->GetFloat(k_pch_MyDriver_Section, k_pch_MyDriver_FusionBlendMs_Float, &settingsError);
+    m_registry.SetFusionBlendSeconds(settingsError == vr::VRSettingsError_None && fusionBlendMs >= 0.f ? fusionBlendMs / 1000.0 : 0.1);
+    m_mirroredDevices.reserve(MirrorRegistry::k_unMaxSlots);
 
-        if (propError != vr::TrackedProp_Success) {
-            VRDriverLog()->Log("MyTrackedDeviceProvider::Init - Error getting DeviceClass for device index " + std::to_string(i) + ": " + std::to_string(propError));
-            continue;
-        }
+    // Class and role hint of every device we might mirror, from the host or from the pose source
+    m_discovery.Reset();
 
-        if (device_class == vr::TrackedDeviceClass_Controller) {
-            int32_t controller_role = vr::VRProperties()->GetInt32Property(container, vr::Prop_ControllerRoleHint_Int32, &propError);
+    char path[1024];
+    vr::VRSettings()->GetString(k_pch_MyDriver_Section, k_pch_MyDriver_ReplayPath_String, path, sizeof(path), &settingsError);
+    if (settingsError == vr::VRSettingsError_None && path[0] != '\0') {
+        const bool realTime = vr::VRSettings()->GetBool(k_pch_MyDriver_Section, k_pch_MyDriver_ReplayRealTime_Bool);
+        const bool loop = vr::VRSettings()->GetBool(k_pch_MyDriver_Section, k_pch_MyDriver_ReplayLoop_Bool);
+        m_replay.Open(path, realTime, loop);
+    }
 
-            if (propError != vr::TrackedProp_Success) {
-                VRDriverLog()->Log("MyTrackedDeviceProvider::Init - Error getting ControllerRoleHint for device index " + std::to_string(i) + ": " + std::to_string(propError));
-                continue;
+    // A replay wins over the configured source; an external source that can't be opened falls back to the host
+    m_pPoseSource = &m_hostSource;
+    if (m_replay.IsOpen()) {
+        m_pPoseSource = &m_replay;
+    } else {
+        const int32_t poseSource = vr::VRSettings()->GetInt32(k_pch_MyDriver_Section, k_pch_MyDriver_PoseSource_Int32, &settingsError);
+        if (settingsError == vr::VRSettingsError_None && (poseSource == vr::PoseSource_SharedMemory || poseSource == vr::PoseSource_Udp)) {
+            m_externalSource = vr::CreateExternalPoseSource((vr::EPoseSourceType)poseSource);
+            if (m_externalSource) {
+                m_pPoseSource = m_externalSource.get();
+            } else {
+                DRIVER_LOG_ERROR(DriverLogCategory_Provider, "MyTrackedDeviceProvider::Init - Pose source {} unavailable, mirroring the host's devices", poseSource);
             }
+        }
+    }
+    DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::Init - Pose source: {}", m_pPoseSource->GetName());
 
-            if (controller_role == vr::TrackedControllerRole_LeftHand) {
-                if (!left_controller_) { // Initialize only if not already done
-                    VRDriverLog()->Log("MyTrackedDeviceProvider::Init - Found Left Hand controller at OpenVR index: " + std::to_string(i));
-                    left_controller_ = std::make_unique<MyControllerDriver>();
-                    vr::EVRInitError addError = vr::VRServerDriverHost()->TrackedDeviceAdded("my_left_controller_serial", vr::TrackedDeviceClass_Controller, left_controller_.get());
-                    if (addError == vr::VRInitError_None) {
-                        VRDriverLog()->Log("MyTrackedDeviceProvider::Init - Successfully added left controller.");
-                        m_unLeftControllerDeviceIndex = i; // Store the device index
-                        left_controller_->SetPhysicalControllerIndex(i); // Set the physical index
-                    } else {
-                        VRDriverLog()->Log("MyTrackedDeviceProvider::Init - Error adding left controller: " + std::to_string(addError));
-                        left_controller_.reset(); // Nullify if not added
-                    }
-                }
-            } else if (controller_role == vr::TrackedControllerRole_RightHand) {
-                if (!right_controller_) { // Initialize only if not already done
-                    VRDriverLog()->Log("MyTrackedDeviceProvider::Init - Found Right Hand controller at OpenVR index: " + std::to_string(i));
-                    right_controller_ = std::make_unique<MyControllerDriver>();
-                    vr::EVRInitError addError = vr::VRServerDriverHost()->TrackedDeviceAdded("my_right_controller_serial", vr::TrackedDeviceClass_Controller, right_controller_.get());
-                    if (addError == vr::VRInitError_None) {
-                        VRDriverLog()->Log("MyTrackedDeviceProvider::Init - Successfully added right controller.");
-                        m_unRightControllerDeviceIndex = i; // Store the device index
-                        right_controller_->SetPhysicalControllerIndex(i); // Set the physical index
-                    } else {
-                        VRDriverLog()->Log("MyTrackedDeviceProvider::Init - Error adding right controller: " + std::to_string(addError));
-                        right_controller_.reset(); // Nullify if not added
-                    }
-                }
-            }
+    if (m_pPoseSource->ProvidesDevices()) {
+        // Mirror what was recorded, or what an external tracker has announced so far
+        SyncSourceDevices();
+    } else {
+        // Seed the cache with the devices already present; later arrivals come in through RunFrame's device events
+        for (uint32_t i = 0; i < trackedDeviceCount && i < vr::k_unMaxTrackedDeviceCount; ++i) {
+            m_discovery.RefreshDevice(i);
         }
     }
 
-    if (!left_controller_) {
-        VRDriverLog()->Log("MyTrackedDeviceProvider::Init - No physical left controller found/initialized.");
+    // Mirror every controller and generic tracker
+    for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i) {
+        MirrorDeviceIfNeeded(i);
+    }
+
+    vr::VRSettings()->GetString(k_pch_MyDriver_Section, k_pch_MyDriver_RecordPath_String, path, sizeof(path), &settingsError);
+    if (settingsError == vr::VRSettingsError_None && path[0] != '\0') {
+        // Devices hot-plugged after this point are not in the recording's header
+        m_recorder.Open(path, m_discovery.GetDeviceClasses(), m_discovery.GetControllerRoles());
+    }
+
+    vr::VRSettings()->GetString(k_pch_MyDriver_Section, k_pch_MyDriver_PoseExportName_String, path, sizeof(path), &settingsError);
+    if (settingsError == vr::VRSettingsError_None && path[0] != '\0' && m_exporter.Open(path)) {
+        m_registry.SetPoseExporter(&m_exporter);
+    }
+
+    if (m_unLeftControllerDeviceIndex == vr::k_unTrackedDeviceIndexInvalid) {
+        DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::Init - No physical left controller found/initialized.");
     }
-    if (!right_controller_) {
-        VRDriverLog()->Log("MyTrackedDeviceProvider::Init - No physical right controller found/initialized.");
+    if (m_unRightControllerDeviceIndex == vr::k_unTrackedDeviceIndexInvalid) {
+        DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::Init - No physical right controller found/initialized.");
     }
+    DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::Init - Mirroring {} device(s), pose conversion kernel: {}", m_registry.GetSlotCount(), GetPoseConversionKernelName());
 
-    VRDriverLog()->Log("MyTrackedDeviceProvider::Init - Finished initialization");
+    m_flTrackingThreadHz = vr::VRSettings()->GetFloat(k_pch_MyDriver_Section, k_pch_MyDriver_TrackingThreadHz_Float, &settingsError);
+    if (settingsError != vr::VRSettingsError_None || m_flTrackingThreadHz < 0.f) {
+        m_flTrackingThreadHz = 0.f;
+    }
+    StartTrackingThread();
+
+    DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::Init - Finished initialization");
     return vr::VRInitError_None;
 }
 
 void MyTrackedDeviceProvider::Cleanup()
 {
-    VRDriverLog()->Log("MyTrackedDeviceProvider::Cleanup - Called");
+    DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::Cleanup - Called");
+    StopTrackingThread(); // Must stop before the controllers and the driver context go away
+    m_recorder.Close();
+    m_replay.Close();
+    m_externalSource.reset(); // Stops its receive thread, if any
+    m_pPoseSource = &m_hostSource;
+    m_unSourceInputSeen.fill(0); // Versions of the source just destroyed
+    m_registry.SetPoseExporter(nullptr);
+    m_exporter.Close();
+    DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::Cleanup - Finished");
+    DriverLogStop(); // Flushes the queue while VRDriverLog is still valid
     VR_CLEANUP_SERVER_DRIVER_CONTEXT();
     // Cleanup your tracked devices here
     // unique_ptr will automatically clean up the controller objects
-    left_controller_.reset();
-    right_controller_.reset();
+    m_registry.Clear();
+    m_discovery.Reset();
+    m_mirroredDevices.clear();
+    m_unLeftControllerDeviceIndex = vr::k_unTrackedDeviceIndexInvalid;
+    m_unRightControllerDeviceIndex = vr::k_unTrackedDeviceIndexInvalid;
+    m_bStandby.store(false, std::memory_order_release); // A new session starts out sampling
     g_pMyDriverProvider = nullptr; // Explicitly nullify the global pointer
-    VRDriverLog()->Log("MyTrackedDeviceProvider::Cleanup - Finished");
 }
 
 const char * const *MyTrackedDeviceProvider::GetInterfaceVersions()
@@ -107,39 +170,387 @@ const char * const *MyTrackedDeviceProvider::GetInterfaceVersions()
     return versions;
 }
 
-// Define a preprocessor macro for verbose logging control, e.g., in a common header or at the top of the file
-// #define ENABLE_VERBOSE_RUNFRAME_LOGGING
-
 void MyTrackedDeviceProvider::RunFrame()
 {
-#ifdef ENABLE_VERBOSE_RUNFRAME_LOGGING
-    VRDriverLog()->Log("MyTrackedDeviceProvider::RunFrame - Called");
-#endif
-    // Update device poses or states here
-    if (left_controller_) {
-        left_controller_->RunFrame();
+    ScopedDriverTimer timer(DriverTimer_RunFrame);
+    DRIVER_LOG_TRACE(DriverLogCategory_Provider, "MyTrackedDeviceProvider::RunFrame - Called");
+    PollDeviceEvents(); // Hot-plug; a frame without events costs one PollNextEvent call
+    if (m_bStandby.load(std::memory_order_acquire)) {
+        return; // Parked: the mirrors already report not tracking, nothing to sample or submit until LeaveStandby
+    }
+    if (m_pPoseSource->ProvidesInput()) {
+        ExchangeSourceInput();
+    }
+    m_input.SubmitInputs(); // Only slots with newly published input, and only their changed values
+
+    if (m_registry.GetSlotCount() == 0) {
+        return; // Nothing to mirror, skip the host round-trip
+    }
+
+    if (m_flTrackingThreadHz > 0.f) {
+        // The tracking thread samples and converts; just hand the latest poses to the host. A mirror the
+        // host just activated shouldn't wait out the thread's dormant interval for its first pose.
+        if (m_bTrackingThreadDormant.load(std::memory_order_acquire) && m_registry.IsActivationPending()) {
+            WakeTrackingThread();
+        }
+        m_registry.SubmitPoses();
+        return;
     }
-    if (right_controller_) {
-        right_controller_->RunFrame();
+
+    // While every mirror is dormant (no valid pose for a while), only look for them coming back at the dormant interval
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const UpdateScheduler& scheduler = m_registry.GetUpdateScheduler();
+    if (scheduler.AreAllDormant() && !m_registry.IsActivationPending()) {
+        if (now < m_nextInlineSample) {
+            return;
+        }
+        m_nextInlineSample = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                       std::chrono::duration<double>(scheduler.GetSettings().flDormantSampleSeconds));
     }
-    // It might be useful to log if controllers are not present, but could be spammy.
-    // Example:
-    // if (!left_controller_ && !right_controller_) {
-    //     VRDriverLog()->Log("MyTrackedDeviceProvider::RunFrame - No controllers to update.");
-    // }
+
+    // Take a single snapshot of all raw poses for this frame and sweep every mirrored device over it
+    SampleRawPoses(m_rawPoses.data(), (uint32_t)m_rawPoses.size());
+    m_registry.UpdatePoses(m_rawPoses.data(), (uint32_t)m_rawPoses.size());
+    m_registry.SubmitPoses();
 }
 
 bool MyTrackedDeviceProvider::ShouldBlockStandbyMode()
 {
-    return false;
+    // Opt-in (blockStandbyWhileMoving): a mirror that is moving may be in use even if nothing touches
+    // the headset, e.g. a tracker worn by someone else. Motion is only known from live sweeps.
+    const UpdateScheduler& scheduler = m_registry.GetUpdateScheduler();
+    return scheduler.GetSettings().bBlockStandbyWhileMoving && !m_bStandby.load(std::memory_order_acquire) && scheduler.IsAnyMoving();
 }
 
 void MyTrackedDeviceProvider::EnterStandby()
 {
+    DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::EnterStandby - Parking pose sampling");
+    m_bStandby.store(true, std::memory_order_release);
+    StopTrackingThread();
+    m_registry.ClearMotion(); // Nothing sweeps until LeaveStandby, so the last sweep's motion would go stale
 }
 
 void MyTrackedDeviceProvider::LeaveStandby()
 {
+    DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::LeaveStandby - Resuming pose sampling");
+    m_bStandby.store(false, std::memory_order_release);
+    m_registry.LeaveStandby(); // The mirrors report their tracked poses again from the next frame
+    m_nextInlineSample = std::chrono::steady_clock::time_point(); // Sample on the very next frame
+    StartTrackingThread();
+}
+
+void MyTrackedDeviceProvider::SampleRawPoses(vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount)
+{
+    {
+        ScopedDriverTimer timer(DriverTimer_RawPoseFetch);
+        m_pPoseSource->Sample(pRawPoses, unRawPoseCount);
+    }
+
+    if (m_recorder.IsOpen()) {
+        m_recorder.Record(pRawPoses, unRawPoseCount);
+    }
+}
+
+void MyTrackedDeviceProvider::ExchangeSourceInput()
+{
+    const uint32_t slotCount = m_registry.GetSlotCount();
+    for (uint32_t slot = 0; slot < slotCount; ++slot) {
+        const uint32_t physicalIndex = m_registry.GetPhysicalIndex(slot);
+        MirrorInputState state;
+        if (m_pPoseSource->TakeInputState(physicalIndex, m_unSourceInputSeen[slot], state)) {
+            m_input.PublishInputState(slot, state);
+        }
+        MirrorHapticPulse pulse;
+        if (m_input.TakeHapticPulse(slot, m_unHapticPulseSeen[slot], pulse)) {
+            m_pPoseSource->SendHapticPulse(physicalIndex, pulse);
+        }
+    }
+}
+
+void MyTrackedDeviceProvider::PollDeviceEvents()
+{
+    bool deviceEvent = false;
+    vr::VREvent_t event;
+    while (vr::VRServerDriverHost()->PollNextEvent(&event, sizeof(event))) {
+        if (event.eventType == vr::VREvent_Input_HapticVibration) {
+            m_input.OnHapticEvent(event.data.hapticVibration); // Handed to whatever drives the physical device
+            continue;
+        }
+        if (m_pPoseSource->ProvidesDevices()) {
+            continue; // The mirrored devices come from the source, not from the live host
+        }
+
+        switch (event.eventType) {
+            case vr::VREvent_TrackedDeviceActivated:
+                OnDeviceActivated(event.trackedDeviceIndex);
+                deviceEvent = true;
+                break;
+            case vr::VREvent_TrackedDeviceDeactivated:
+                OnDeviceDeactivated(event.trackedDeviceIndex);
+                deviceEvent = true;
+                break;
+            case vr::VREvent_TrackedDeviceRoleChanged:
+                deviceEvent = true;
+                if (event.trackedDeviceIndex < vr::k_unMaxTrackedDeviceCount) {
+                    OnControllerRoleChanged(event.trackedDeviceIndex);
+                } else {
+                    // Broadcast without a device; re-check every controller we know of
+                    for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i) {
+                        if (m_discovery.GetDeviceClass(i) == vr::TrackedDeviceClass_Controller) {
+                            OnControllerRoleChanged(i);
+                        }
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (m_pPoseSource->ProvidesDevices()) {
+        if (m_registry.GetSlotCount() == 0) {
+            // Nothing samples while there is nothing to mirror, but a pull-based source only learns of devices when sampled
+            m_pPoseSource->Sample(m_rawPoses.data(), (uint32_t)m_rawPoses.size());
+        }
+        if (m_pPoseSource->GetDeviceChangeCount() != m_unSourceDeviceChangeCount) {
+            OnSourceDevicesChanged();
+            deviceEvent = true;
+        }
+    }
+
+    if (deviceEvent) {
+        // Something may be back to track; sample on the next frame or tick instead of after the dormant interval
+        m_nextInlineSample = std::chrono::steady_clock::time_point();
+        if (m_bTrackingThreadDormant.load(std::memory_order_acquire)) {
+            WakeTrackingThread();
+        }
+    }
+}
+
+void MyTrackedDeviceProvider::SyncSourceDevices()
+{
+    m_unSourceDeviceChangeCount = m_pPoseSource->GetDeviceChangeCount();
+    for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i) {
+        int32_t deviceClass;
+        int32_t controllerRole;
+        if (m_pPoseSource->GetDevice(i, deviceClass, controllerRole)) {
+            m_discovery.SetDevice(i, deviceClass, controllerRole);
+        }
+    }
+}
+
+void MyTrackedDeviceProvider::OnSourceDevicesChanged()
+{
+    const bool wasIdle = m_registry.GetSlotCount() == 0;
+    SyncSourceDevices();
+    for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i) {
+        if (MirrorDeviceIfNeeded(i)) {
+            DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::OnSourceDevicesChanged - {} source announced device index {}", m_pPoseSource->GetName(), i);
+        }
+    }
+    if (wasIdle && m_registry.GetSlotCount() > 0) {
+        StartTrackingThread(); // Init skipped it because there was nothing to track
+    }
+}
+
+bool MyTrackedDeviceProvider::IsOwnMirror(uint32_t unDeviceIndex) const
+{
+    // Our mirrors are tracked devices too, and their events come through the same queue
+    return m_registry.GetSlotForObjectId(unDeviceIndex) != MirrorRegistry::k_unInvalidSlot;
+}
+
+void MyTrackedDeviceProvider::OnDeviceActivated(uint32_t unDeviceIndex)
+{
+    if (unDeviceIndex >= vr::k_unMaxTrackedDeviceCount || IsOwnMirror(unDeviceIndex)) {
+        return;
+    }
+
+    m_discovery.RefreshDevice(unDeviceIndex);
+    const bool wasIdle = m_registry.GetSlotCount() == 0;
+    if (MirrorDeviceIfNeeded(unDeviceIndex)) {
+        DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::OnDeviceActivated - Hot-plugged device index {}", unDeviceIndex);
+        if (wasIdle) {
+            StartTrackingThread(); // Init skipped it because there was nothing to track
+        }
+    } else if (m_discovery.GetMirrorSlot(unDeviceIndex) != DeviceDiscovery::k_unNoSlot) {
+        DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::OnDeviceActivated - Device index {} is back (slot {})",
+                        unDeviceIndex, m_discovery.GetMirrorSlot(unDeviceIndex));
+    }
+}
+
+void MyTrackedDeviceProvider::OnDeviceDeactivated(uint32_t unDeviceIndex)
+{
+    if (unDeviceIndex >= vr::k_unMaxTrackedDeviceCount || IsOwnMirror(unDeviceIndex)) {
+        return;
+    }
+
+    // The mirror stays registered; the sweeps publish the out-of-range fallback until the device returns
+    const uint32_t slot = m_discovery.GetMirrorSlot(unDeviceIndex);
+    if (slot != DeviceDiscovery::k_unNoSlot) {
+        DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::OnDeviceDeactivated - Device index {} (slot {}) went away", unDeviceIndex, slot);
+    }
+    m_discovery.Invalidate(unDeviceIndex);
+}
+
+void MyTrackedDeviceProvider::OnControllerRoleChanged(uint32_t unDeviceIndex)
+{
+    if (IsOwnMirror(unDeviceIndex) || !m_discovery.RefreshDevice(unDeviceIndex)) {
+        return; // Ours, or nothing we cache changed
+    }
+
+    const int32_t role = m_discovery.GetControllerRole(unDeviceIndex);
+    const uint32_t slot = m_discovery.GetMirrorSlot(unDeviceIndex);
+    if (slot == DeviceDiscovery::k_unNoSlot) {
+        MirrorDeviceIfNeeded(unDeviceIndex); // Its role could not be read before
+        return;
+    }
+
+    DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::OnControllerRoleChanged - Device index {} (slot {}) is now role {}", unDeviceIndex, slot, role);
+    // A controller that changed hands no longer holds that hand, so the next controller of that hand gets its serial
+    if (unDeviceIndex == m_unLeftControllerDeviceIndex && role != vr::TrackedControllerRole_LeftHand) {
+        m_unLeftControllerDeviceIndex = vr::k_unTrackedDeviceIndexInvalid;
+    }
+    if (unDeviceIndex == m_unRightControllerDeviceIndex && role != vr::TrackedControllerRole_RightHand) {
+        m_unRightControllerDeviceIndex = vr::k_unTrackedDeviceIndexInvalid;
+    }
+    for (const std::unique_ptr<MyControllerDriver>& device : m_mirroredDevices) {
+        if (device->GetSlot() == slot) {
+            device->SetControllerRole(role);
+            break;
+        }
+    }
+}
+
+bool MyTrackedDeviceProvider::MirrorDeviceIfNeeded(uint32_t unPhysicalIndex)
+{
+    if (m_discovery.GetMirrorSlot(unPhysicalIndex) != DeviceDiscovery::k_unNoSlot) {
+        return false; // Already mirrored
+    }
+
+    const int32_t deviceClass = m_discovery.GetDeviceClass(unPhysicalIndex);
+    if (deviceClass == vr::TrackedDeviceClass_Controller) {
+        return AddMirroredDevice(unPhysicalIndex, vr::TrackedDeviceClass_Controller, m_discovery.GetControllerRole(unPhysicalIndex));
+    } else if (deviceClass == vr::TrackedDeviceClass_GenericTracker) {
+        return AddMirroredDevice(unPhysicalIndex, vr::TrackedDeviceClass_GenericTracker, vr::TrackedControllerRole_Invalid);
+    }
+    return false;
+}
+
+bool MyTrackedDeviceProvider::AddMirroredDevice(uint32_t unPhysicalIndex, vr::ETrackedDeviceClass eDeviceClass, int32_t nControllerRole)
+{
+    const uint32_t slot = m_registry.AddSlot(unPhysicalIndex);
+    if (slot == MirrorRegistry::k_unInvalidSlot) {
+        DRIVER_LOG_WARNING(DriverLogCategory_Provider, "MyTrackedDeviceProvider::AddMirroredDevice - Registry full, not mirroring device index {}", unPhysicalIndex);
+        return false;
+    }
+    m_discovery.SetMirrorSlot(unPhysicalIndex, slot); // Even if adding fails below, so later events don't retry and leak slots
+
+    // Keep the original serials for the first left/right controllers so existing bindings still apply
+    std::string serial;
+    bool isLeft = false;
+    bool isRight = false;
+    if (nControllerRole == vr::TrackedControllerRole_LeftHand && m_unLeftControllerDeviceIndex == vr::k_unTrackedDeviceIndexInvalid) {
+        serial = "my_left_controller_serial";
+        isLeft = true;
+    } else if (nControllerRole == vr::TrackedControllerRole_RightHand && m_unRightControllerDeviceIndex == vr::k_unTrackedDeviceIndexInvalid) {
+        serial = "my_right_controller_serial";
+        isRight = true;
+    } else {
+        serial = "my_mirror_" + std::to_string(unPhysicalIndex) + "_serial";
+    }
+
+    DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::AddMirroredDevice - Mirroring OpenVR index {} as {} (slot {})", unPhysicalIndex, serial, slot);
+    m_mirroredDevices.push_back(std::make_unique<MyControllerDriver>(&m_registry, eDeviceClass == vr::TrackedDeviceClass_Controller ? &m_input : nullptr, slot, serial.c_str(), nControllerRole));
+    vr::EVRInitError addError = vr::VRServerDriverHost()->TrackedDeviceAdded(serial.c_str(), eDeviceClass, m_mirroredDevices.back().get());
+    if (addError != vr::VRInitError_None) {
+        // The slot stays reserved but is never activated, so the sweeps skip it
+        DRIVER_LOG_ERROR(DriverLogCategory_Provider, "MyTrackedDeviceProvider::AddMirroredDevice - Error adding {}: {}", serial, addError);
+        m_mirroredDevices.pop_back();
+        return false;
+    }
+
+    if (isLeft) {
+        m_unLeftControllerDeviceIndex = unPhysicalIndex; // Store the device index
+    } else if (isRight) {
+        m_unRightControllerDeviceIndex = unPhysicalIndex;
+    }
+    return true;
+}
+
+void MyTrackedDeviceProvider::StartTrackingThread()
+{
+    if (m_flTrackingThreadHz <= 0.f || m_bTrackingThreadRunning.load(std::memory_order_acquire)) {
+        return; // Disabled, or already running
+    }
+    if (m_bStandby.load(std::memory_order_acquire)) {
+        return; // LeaveStandby starts it, e.g. after a device was hot-plugged during standby
+    }
+    if (m_registry.GetSlotCount() == 0) {
+        return; // Nothing to track
+    }
+
+    DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::StartTrackingThread - Starting tracking thread at {} Hz", m_flTrackingThreadHz);
+    {
+        std::lock_guard<std::mutex> lock(m_trackingWakeMutex);
+        m_bTrackingWakeRequested = false; // Left over from waking the previous thread
+    }
+    m_bTrackingThreadRunning.store(true, std::memory_order_release);
+    m_trackingThread = std::thread(&MyTrackedDeviceProvider::TrackingThreadMain, this);
+}
+
+void MyTrackedDeviceProvider::StopTrackingThread()
+{
+    m_bTrackingThreadRunning.store(false, std::memory_order_release);
+    WakeTrackingThread(); // Don't wait out a dormant interval
+    if (m_trackingThread.joinable()) {
+        m_trackingThread.join();
+        DRIVER_LOG_INFO(DriverLogCategory_Provider, "MyTrackedDeviceProvider::StopTrackingThread - Tracking thread stopped");
+    }
+}
+
+void MyTrackedDeviceProvider::TrackingThreadMain()
+{
+    const std::chrono::steady_clock::duration period =
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / m_flTrackingThreadHz));
+    const UpdateScheduler& scheduler = m_registry.GetUpdateScheduler();
+    const std::chrono::steady_clock::duration dormantPeriod = std::max(period,
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(scheduler.GetSettings().flDormantSampleSeconds)));
+    std::chrono::steady_clock::time_point nextTick = std::chrono::steady_clock::now();
+
+    while (m_bTrackingThreadRunning.load(std::memory_order_acquire)) {
+        SampleRawPoses(m_trackingThreadRawPoses.data(), (uint32_t)m_trackingThreadRawPoses.size());
+        m_registry.UpdatePoses(m_trackingThreadRawPoses.data(), (uint32_t)m_trackingThreadRawPoses.size());
+
+        // Slow down while no mirror has a valid pose; the first sweep that sees one makes it active again
+        const bool dormant = scheduler.AreAllDormant();
+        nextTick += dormant ? dormantPeriod : period;
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (nextTick < now) {
+            nextTick = now; // Fell behind; skip the missed ticks instead of bursting to catch up
+        }
+        if (!dormant) {
+            std::this_thread::sleep_until(nextTick);
+            continue;
+        }
+
+        // The long wait is interruptible: device events, activations and Stop sample again right away
+        std::unique_lock<std::mutex> lock(m_trackingWakeMutex);
+        m_bTrackingThreadDormant.store(true, std::memory_order_release);
+        if (m_trackingWake.wait_until(lock, nextTick, [this] { return m_bTrackingWakeRequested; })) {
+            nextTick = std::chrono::steady_clock::now();
+        }
+        m_bTrackingWakeRequested = false;
+        m_bTrackingThreadDormant.store(false, std::memory_order_release);
+    }
+}
+
+void MyTrackedDeviceProvider::WakeTrackingThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_trackingWakeMutex);
+        m_bTrackingWakeRequested = true;
+    }
+    m_trackingWake.notify_one();
 }
 
 } // namespace vr
@@ -158,17 +569,17 @@ HMD_DLL_EXPORT void *HmdDriverFactory(const char *pInterfaceName, int *pReturnCo
     if (0 == strcmp(vr::IServerTrackedDeviceProvider_Version, pInterfaceName))
     {
         if (!vr::g_pMyDriverProvider) { // Check if already instantiated
-            VRDriverLog()->Log("HmdDriverFactory - Creating new MyTrackedDeviceProvider instance.");
+            DRIVER_LOG_VERBOSE(vr::DriverLogCategory_Provider, "HmdDriverFactory - Creating new MyTrackedDeviceProvider instance.");
             vr::g_pMyDriverProvider = new vr::MyTrackedDeviceProvider();
         } else {
-            VRDriverLog()->Log("HmdDriverFactory - Returning existing MyTrackedDeviceProvider instance.");
+            DRIVER_LOG_VERBOSE(vr::DriverLogCategory_Provider, "HmdDriverFactory - Returning existing MyTrackedDeviceProvider instance.");
         }
         if (pReturnCode)
             *pReturnCode = vr::VRInitError_None; // Set to None explicitly on success
         return vr::g_pMyDriverProvider;
     }
 
-    VRDriverLog()->Log("HmdDriverFactory - Interface not found: " + std::string(pInterfaceName));
+    DRIVER_LOG_WARNING(vr::DriverLogCategory_Provider, "HmdDriverFactory - Interface not found: {}", pInterfaceName);
     if (pReturnCode)
         *pReturnCode = vr::VRInitError_Init_InterfaceNotFound;
 
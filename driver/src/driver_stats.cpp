@@ -0,0 +1,137 @@
+#include "driver_stats.h"
+
+#include <cstdarg>
+#include <cstdio>
+
+#if defined(_MSC_VER)
+#include <intrin.h> // For _BitScanReverse64
+#endif
+
+namespace vr {
+
+LatencyHistogram g_rgDriverTimers[DriverTimer_Count];
+
+static const char* const k_rgpchDriverTimerNames[DriverTimer_Count] = {
+    "run_frame",
+    "raw_pose_fetch",
+    "pose_conversion",
+    "pose_submit",
+};
+
+// Index of the highest set bit; unValue must be non-zero
+static uint32_t HighestBit(uint64_t unValue) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanReverse64(&index, unValue);
+  return (uint32_t)index;
+#else
+  return 63 - (uint32_t)__builtin_clzll(unValue);
+#endif
+}
+
+LatencyHistogram::LatencyHistogram() {
+  Reset();
+}
+
+uint32_t LatencyHistogram::BucketIndex(uint64_t unValue) {
+  if (unValue < k_unSubBuckets) {
+    return (uint32_t)unValue; // Exact below the first power of two
+  }
+  const uint32_t shift = HighestBit(unValue) - k_unSubBucketBits;
+  const uint32_t subBucket = (uint32_t)(unValue >> shift) & (k_unSubBuckets - 1);
+  return (shift + 1) * k_unSubBuckets + subBucket;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(uint32_t unIndex) {
+  if (unIndex < k_unSubBuckets) {
+    return unIndex;
+  }
+  const uint32_t shift = unIndex / k_unSubBuckets - 1;
+  const uint64_t subBucket = unIndex % k_unSubBuckets;
+  return ((k_unSubBuckets + subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t unNanoseconds) {
+  m_unBuckets[BucketIndex(unNanoseconds)].fetch_add(1, std::memory_order_relaxed);
+  m_unCount.fetch_add(1, std::memory_order_relaxed);
+  m_unSum.fetch_add(unNanoseconds, std::memory_order_relaxed);
+
+  uint64_t max = m_unMax.load(std::memory_order_relaxed);
+  while (unNanoseconds > max && !m_unMax.compare_exchange_weak(max, unNanoseconds, std::memory_order_relaxed)) {
+  }
+}
+
+void LatencyHistogram::Reset() {
+  for (uint32_t i = 0; i < k_unBucketCount; ++i) {
+    m_unBuckets[i].store(0, std::memory_order_relaxed);
+  }
+  m_unCount.store(0, std::memory_order_relaxed);
+  m_unSum.store(0, std::memory_order_relaxed);
+  m_unMax.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::GetPercentile(double flPercentile) const {
+  // Rank against the bucket totals rather than m_unCount, which may be a few samples ahead
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < k_unBucketCount; ++i) {
+    total += m_unBuckets[i].load(std::memory_order_relaxed);
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  uint64_t rank = (uint64_t)(flPercentile / 100.0 * (double)total + 0.5);
+  if (rank < 1) {
+    rank = 1;
+  } else if (rank > total) {
+    rank = total;
+  }
+
+  const uint64_t max = GetMax();
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < k_unBucketCount; ++i) {
+    seen += m_unBuckets[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      const uint64_t upper = BucketUpperBound(i);
+      return upper < max ? upper : max;
+    }
+  }
+  return max;
+}
+
+void ResetDriverTimers() {
+  for (uint32_t i = 0; i < DriverTimer_Count; ++i) {
+    g_rgDriverTimers[i].Reset();
+  }
+}
+
+size_t AppendJson(char* pchBuffer, size_t unSize, size_t unUsed, const char* pchFormat, ...) {
+  if (unUsed + 1 >= unSize) {
+    return unUsed;
+  }
+  va_list args;
+  va_start(args, pchFormat);
+  const int written = vsnprintf(pchBuffer + unUsed, unSize - unUsed, pchFormat, args);
+  va_end(args);
+  if (written < 0) {
+    return unUsed;
+  }
+  return (size_t)written < unSize - unUsed ? unUsed + (size_t)written : unSize - 1; // Truncated, buffer is now full
+}
+
+size_t AppendDriverTimersJson(char* pchBuffer, size_t unSize, size_t unUsed) {
+  unUsed = AppendJson(pchBuffer, unSize, unUsed, "{");
+  for (uint32_t i = 0; i < DriverTimer_Count; ++i) {
+    const LatencyHistogram& histogram = g_rgDriverTimers[i];
+    const uint64_t count = histogram.GetCount();
+    const double mean = count > 0 ? (double)histogram.GetSum() / (double)count : 0.0;
+    unUsed = AppendJson(pchBuffer, unSize, unUsed,
+                        "%s\"%s\":{\"count\":%llu,\"mean_us\":%.3f,\"p50_us\":%.3f,\"p90_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f}",
+                        i > 0 ? "," : "", k_rgpchDriverTimerNames[i], (unsigned long long)count, mean / 1000.0,
+                        histogram.GetPercentile(50.0) / 1000.0, histogram.GetPercentile(90.0) / 1000.0,
+                        histogram.GetPercentile(99.0) / 1000.0, histogram.GetMax() / 1000.0);
+  }
+  return AppendJson(pchBuffer, unSize, unUsed, "}");
+}
+
+}  // namespace vr
@@ -0,0 +1,560 @@
+#include "external_pose_source.h"
+#include "driver_log.h"
+#include "driver_settings.h"
+#include "pose_export.h" // For PoseExportNowNs, the clock both sides share
+
+#include <cmath>
+
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#endif
+
+namespace vr {
+
+static_assert(k_unExternalInputAxisCount == MirrorAxis_Count, "ExternalInputSample axes must match the mirror's input profile");
+static_assert(MirrorButton_Count <= 32, "ExternalInputSample buttons must fit unButtons");
+
+// Pose snapshot entry for an index the source knows nothing about
+static void SetDisconnected(vr::TrackedDevicePose_t& pose) {
+  memset(&pose, 0, sizeof(pose));
+  pose.mDeviceToAbsoluteTracking.m[0][0] = 1.f;
+  pose.mDeviceToAbsoluteTracking.m[1][1] = 1.f;
+  pose.mDeviceToAbsoluteTracking.m[2][2] = 1.f;
+  pose.eTrackingResult = vr::TrackingResult_Uninitialized;
+  pose.bPoseIsValid = false;
+  pose.bDeviceIsConnected = false;
+}
+
+// Rotation from a to b (b * conj(a)) as a rotation vector, in the tracking frame
+static void RotationVectorBetween(const double a[4], const double b[4], double out[3]) {
+  double w = b[0] * a[0] + b[1] * a[1] + b[2] * a[2] + b[3] * a[3];
+  double x = -b[0] * a[1] + b[1] * a[0] - b[2] * a[3] + b[3] * a[2];
+  double y = -b[0] * a[2] + b[1] * a[3] + b[2] * a[0] - b[3] * a[1];
+  double z = -b[0] * a[3] - b[1] * a[2] + b[2] * a[1] + b[3] * a[0];
+  if (w < 0.0) { // Shortest way round
+    w = -w; x = -x; y = -y; z = -z;
+  }
+  const double sinHalf = sqrt(x * x + y * y + z * z);
+  const double scale = sinHalf > 1e-12 ? 2.0 * atan2(sinHalf, w) / sinHalf : 2.0;
+  out[0] = x * scale;
+  out[1] = y * scale;
+  out[2] = z * scale;
+}
+
+ExternalPoseSource::ExternalPoseSource(double flDelaySeconds, double flStaleSeconds)
+    : m_nDelayNs((int64_t)(flDelaySeconds * 1e9)),
+      m_nStaleNs((int64_t)(flStaleSeconds * 1e9)),
+      m_unKnownDevices(0),
+      m_unDeviceChangeCount(0),
+      m_unRejectedCount(0) {
+  for (uint32_t i = 0; i < k_unExternalPoseMaxDevices; ++i) {
+    m_writerHistory[i].unCount = 0;
+    m_writerHistory[i].unNewest = 0;
+    m_nDeviceClass[i].store(vr::TrackedDeviceClass_Invalid, std::memory_order_relaxed);
+    m_nControllerRole[i].store(vr::TrackedControllerRole_Invalid, std::memory_order_relaxed);
+  }
+}
+
+bool ExternalPoseSource::GetDevice(uint32_t unIndex, int32_t& nDeviceClass, int32_t& nControllerRole) const {
+  if (unIndex >= k_unExternalPoseMaxDevices || !((m_unKnownDevices.load(std::memory_order_acquire) >> unIndex) & 1u)) {
+    return false;
+  }
+  nDeviceClass = m_nDeviceClass[unIndex].load(std::memory_order_relaxed);
+  nControllerRole = m_nControllerRole[unIndex].load(std::memory_order_relaxed);
+  return true;
+}
+
+void ExternalPoseSource::Push(const ExternalPoseSample& sample) {
+  const uint32_t index = sample.unDeviceIndex;
+  const double norm = sqrt(sample.rotation[0] * sample.rotation[0] + sample.rotation[1] * sample.rotation[1] +
+                           sample.rotation[2] * sample.rotation[2] + sample.rotation[3] * sample.rotation[3]);
+  if (index >= k_unExternalPoseMaxDevices || !(norm > 1e-6)) {
+    m_unRejectedCount.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  SampleHistory& history = m_writerHistory[index];
+  if (history.unCount > 0 && sample.nTimestampNs <= history.samples[history.unNewest].nTimestampNs) {
+    m_unRejectedCount.fetch_add(1, std::memory_order_relaxed); // Reordered or duplicated datagram
+    return;
+  }
+
+  history.unNewest = history.unCount > 0 ? (history.unNewest + 1) % k_unHistoryLength : 0;
+  ExternalPoseSample& stored = history.samples[history.unNewest];
+  stored = sample;
+  for (int k = 0; k < 4; ++k) {
+    stored.rotation[k] /= norm;
+  }
+  if (history.unCount < k_unHistoryLength) {
+    ++history.unCount;
+  }
+  m_history[index].Store(history);
+  if (!((m_unKnownDevices.load(std::memory_order_relaxed) >> index) & 1u)) {
+    m_unKnownDevices.fetch_or(1ull << index, std::memory_order_release); // Sample now sees it
+  }
+
+  if (sample.nDeviceClass != m_nDeviceClass[index].load(std::memory_order_relaxed) ||
+      sample.nControllerRole != m_nControllerRole[index].load(std::memory_order_relaxed)) {
+    m_nDeviceClass[index].store(sample.nDeviceClass, std::memory_order_relaxed);
+    m_nControllerRole[index].store(sample.nControllerRole, std::memory_order_relaxed);
+    m_unDeviceChangeCount.fetch_add(1, std::memory_order_release);
+  }
+}
+
+void ExternalPoseSource::PushInput(const ExternalInputSample& sample) {
+  if (sample.unDeviceIndex >= k_unExternalPoseMaxDevices) {
+    m_unRejectedCount.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  MirrorInputState state;
+  state.unButtons = sample.unButtons & ((1u << MirrorButton_Count) - 1);
+  for (uint32_t k = 0; k < MirrorAxis_Count; ++k) {
+    state.flAxes[k] = sample.flAxes[k];
+  }
+  state.sampleTime = std::chrono::steady_clock::time_point(
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(sample.nTimestampNs)));
+  m_inputState[sample.unDeviceIndex].Store(state);
+}
+
+bool ExternalPoseSource::TakeInputState(uint32_t unIndex, uint32_t& unLastSeen, MirrorInputState& outState) const {
+  if (unIndex >= k_unExternalPoseMaxDevices) {
+    return false;
+  }
+  const uint32_t version = m_inputState[unIndex].Version();
+  if (version == unLastSeen) {
+    return false;
+  }
+  outState = m_inputState[unIndex].Load();
+  unLastSeen = version;
+  return true;
+}
+
+void ExternalPoseSource::Sample(vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount) {
+  Poll();
+
+  const int64_t now = PoseExportNowNs();
+  const uint64_t known = m_unKnownDevices.load(std::memory_order_acquire);
+  for (uint32_t i = 0; i < unRawPoseCount; ++i) {
+    if (i < k_unExternalPoseMaxDevices && ((known >> i) & 1u)) {
+      ResolvePose(m_history[i].Load(), now, pRawPoses[i]);
+    } else {
+      SetDisconnected(pRawPoses[i]);
+    }
+  }
+}
+
+void ExternalPoseSource::ResolvePose(const SampleHistory& history, int64_t nNowNs, vr::TrackedDevicePose_t& outPose) const {
+  SetDisconnected(outPose);
+  const ExternalPoseSample& newest = history.samples[history.unNewest];
+  if (!(newest.unFlags & ExternalPose_Connected)) {
+    return;
+  }
+  outPose.bDeviceIsConnected = true;
+  if (!(newest.unFlags & ExternalPose_Valid) || nNowNs - newest.nTimestampNs > m_nStaleNs) {
+    outPose.eTrackingResult = vr::TrackingResult_Running_OutOfRange; // Lost, or the tracker stopped sending
+    return;
+  }
+
+  // Walk back from the newest sample to the pair bracketing the target time
+  const int64_t target = nNowNs - m_nDelayNs;
+  const ExternalPoseSample* pNewer = &newest;
+  const ExternalPoseSample* pOlder = nullptr;
+  if (target < newest.nTimestampNs) {
+    for (uint32_t k = 1; k < history.unCount; ++k) {
+      const ExternalPoseSample& candidate = history.samples[(history.unNewest + k_unHistoryLength - k) % k_unHistoryLength];
+      if (candidate.nTimestampNs <= target) {
+        pOlder = &candidate;
+        break;
+      }
+      pNewer = &candidate; // Target is older still; oldest sample is held if nothing brackets it
+    }
+  }
+  const ExternalPoseSample& a = pOlder ? *pOlder : *pNewer;
+  const ExternalPoseSample& b = *pNewer;
+  const double alpha = pOlder ? (double)(target - a.nTimestampNs) / (double)(b.nTimestampNs - a.nTimestampNs) : 0.0;
+
+  double position[3];
+  for (int k = 0; k < 3; ++k) {
+    position[k] = b.position[k] * alpha + a.position[k] * (1.0 - alpha);
+  }
+
+  // nlerp along the shorter arc; samples are close enough that it matches slerp to well under a degree
+  const double dot = a.rotation[0] * b.rotation[0] + a.rotation[1] * b.rotation[1] + a.rotation[2] * b.rotation[2] + a.rotation[3] * b.rotation[3];
+  const double sign = dot < 0.0 ? -1.0 : 1.0;
+  double q[4];
+  double norm = 0.0;
+  for (int k = 0; k < 4; ++k) {
+    q[k] = a.rotation[k] * (1.0 - alpha) + sign * b.rotation[k] * alpha;
+    norm += q[k] * q[k];
+  }
+  norm = sqrt(norm);
+  const double w = q[0] / norm, x = q[1] / norm, y = q[2] / norm, z = q[3] / norm;
+
+  float (*m)[4] = outPose.mDeviceToAbsoluteTracking.m;
+  m[0][0] = (float)(1.0 - 2.0 * (y * y + z * z)); m[0][1] = (float)(2.0 * (x * y - w * z));       m[0][2] = (float)(2.0 * (x * z + w * y));
+  m[1][0] = (float)(2.0 * (x * y + w * z));       m[1][1] = (float)(1.0 - 2.0 * (x * x + z * z)); m[1][2] = (float)(2.0 * (y * z - w * x));
+  m[2][0] = (float)(2.0 * (x * z - w * y));       m[2][1] = (float)(2.0 * (y * z + w * x));       m[2][2] = (float)(1.0 - 2.0 * (x * x + y * y));
+  m[0][3] = (float)position[0];
+  m[1][3] = (float)position[1];
+  m[2][3] = (float)position[2];
+
+  if ((a.unFlags & b.unFlags) & ExternalPose_HasVelocity) {
+    for (int k = 0; k < 3; ++k) {
+      outPose.vVelocity.v[k] = (float)(b.velocity[k] * alpha + a.velocity[k] * (1.0 - alpha));
+      outPose.vAngularVelocity.v[k] = (float)(b.angularVelocity[k] * alpha + a.angularVelocity[k] * (1.0 - alpha));
+    }
+  } else if (history.unCount >= 2) {
+    // Finite difference over the bracketing pair, or the newest two samples when holding one
+    const ExternalPoseSample& from = pOlder ? a : history.samples[(history.unNewest + k_unHistoryLength - 1) % k_unHistoryLength];
+    const ExternalPoseSample& to = pOlder ? b : newest;
+    const double dt = (double)(to.nTimestampNs - from.nTimestampNs) * 1e-9;
+    double angular[3];
+    RotationVectorBetween(from.rotation, to.rotation, angular);
+    for (int k = 0; k < 3; ++k) {
+      outPose.vVelocity.v[k] = (float)((to.position[k] - from.position[k]) / dt);
+      outPose.vAngularVelocity.v[k] = (float)(angular[k] / dt);
+    }
+  }
+
+  outPose.eTrackingResult = vr::TrackingResult_Running_OK;
+  outPose.bPoseIsValid = true;
+}
+
+// SharedMemoryPoseSource
+
+SharedMemoryPoseSource::SharedMemoryPoseSource(double flDelaySeconds, double flStaleSeconds)
+    : ExternalPoseSource(flDelaySeconds, flStaleSeconds),
+      m_pRing(nullptr),
+      m_unReadIndex(0),
+      m_unInputReadIndex(0),
+      m_unPendingHaptics(0)
+#if defined(_WIN32)
+      ,
+      m_hMapping(nullptr)
+#endif
+{
+}
+
+SharedMemoryPoseSource::~SharedMemoryPoseSource() {
+  Close();
+}
+
+bool SharedMemoryPoseSource::Open(const char* pchName) {
+  Close();
+  m_sName = pchName;
+  m_nextMapAttempt = std::chrono::steady_clock::now();
+  if (Map()) {
+    DRIVER_LOG_INFO(DriverLogCategory_Provider, "SharedMemoryPoseSource::Open - Reading external poses from {}", pchName);
+  } else {
+    DRIVER_LOG_INFO(DriverLogCategory_Provider, "SharedMemoryPoseSource::Open - Waiting for a tracker to create {}", pchName);
+  }
+  return true; // The tracker may come up later; Poll keeps looking
+}
+
+void SharedMemoryPoseSource::Close() {
+  Unmap();
+  m_sName.clear();
+}
+
+bool SharedMemoryPoseSource::Map() {
+  Unmap();
+#if defined(_WIN32)
+  HANDLE hMapping = OpenFileMappingA(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, m_sName[0] == '/' ? m_sName.c_str() + 1 : m_sName.c_str());
+  void* pView = hMapping ? MapViewOfFile(hMapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, sizeof(ExternalPoseRing)) : nullptr;
+  if (!pView) {
+    if (hMapping) {
+      CloseHandle(hMapping);
+    }
+    return false;
+  }
+  m_hMapping = hMapping;
+#else
+  const int fd = shm_open(m_sName.c_str(), O_RDWR, 0); // Writable for the haptic ring
+  if (fd < 0) {
+    return false;
+  }
+  void* pView = mmap(nullptr, sizeof(ExternalPoseRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd); // The mapping keeps the region alive
+  if (pView == MAP_FAILED) {
+    return false;
+  }
+#endif
+  m_pRing = static_cast<ExternalPoseRing*>(pView);
+
+  const ExternalPoseRingHeader& header = m_pRing->header;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (memcmp(header.rgchMagic, k_rgchExternalPoseRingMagic, sizeof(header.rgchMagic)) != 0 || header.unVersion != k_unExternalPoseVersion ||
+      header.unSampleSize != sizeof(ExternalPoseSample) || header.unCapacity != k_unExternalPoseRingCapacity) {
+    DRIVER_LOG_WARNING(DriverLogCategory_Provider, "SharedMemoryPoseSource::Map - {} is not a compatible pose ring", m_sName);
+    Unmap();
+    return false;
+  }
+
+  // Only samples written from now on; anything older would be stale anyway
+  m_unReadIndex = header.unWriteIndex.load(std::memory_order_acquire);
+  m_unInputReadIndex = header.unInputWriteIndex.load(std::memory_order_acquire);
+  return true;
+}
+
+void SharedMemoryPoseSource::Unmap() {
+  if (!m_pRing) {
+    return;
+  }
+#if defined(_WIN32)
+  UnmapViewOfFile(m_pRing);
+  CloseHandle(m_hMapping);
+  m_hMapping = nullptr;
+#else
+  munmap(m_pRing, sizeof(ExternalPoseRing));
+#endif
+  m_pRing = nullptr;
+}
+
+void SharedMemoryPoseSource::Poll() {
+  bool received = false;
+  if (m_pRing) {
+    ExternalPoseSample sample;
+    while (ExternalRingRead(m_pRing->header.unWriteIndex, m_pRing->entries, m_unReadIndex, sample)) {
+      Push(sample);
+      received = true;
+    }
+    ExternalInputSample input;
+    while (ExternalRingRead(m_pRing->header.unInputWriteIndex, m_pRing->inputEntries, m_unInputReadIndex, input)) {
+      PushInput(input);
+    }
+    FlushHapticPulses();
+  } else {
+    m_unPendingHaptics.store(0, std::memory_order_relaxed); // No tracker to play them on
+  }
+
+  const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (received) {
+    m_nextMapAttempt = now + std::chrono::seconds(1);
+    return;
+  }
+  // Nothing new. The tracker may not be up yet, or may have restarted on a fresh region.
+  if (!m_sName.empty() && now >= m_nextMapAttempt) {
+    m_nextMapAttempt = now + std::chrono::seconds(1);
+    const bool wasMapped = m_pRing != nullptr;
+    if (Map() && !wasMapped) {
+      DRIVER_LOG_INFO(DriverLogCategory_Provider, "SharedMemoryPoseSource::Poll - Tracker found, reading external poses from {}", m_sName);
+    }
+  }
+}
+
+void SharedMemoryPoseSource::SendHapticPulse(uint32_t unIndex, const MirrorHapticPulse& pulse) {
+  if (unIndex >= k_unExternalPoseMaxDevices) {
+    return;
+  }
+  m_pendingHaptic[unIndex].Store({unIndex, pulse.flDurationSeconds, pulse.flFrequency, pulse.flAmplitude, PoseExportNowNs()});
+  m_unPendingHaptics.fetch_or(1ull << unIndex, std::memory_order_release);
+}
+
+void SharedMemoryPoseSource::FlushHapticPulses() {
+  const uint64_t pending = m_unPendingHaptics.exchange(0, std::memory_order_acquire);
+  for (uint32_t index = 0; index < k_unExternalPoseMaxDevices && (pending >> index) != 0; ++index) {
+    if ((pending >> index) & 1u) {
+      ExternalRingAppend(m_pRing->header.unHapticWriteIndex, m_pRing->hapticEntries, m_pendingHaptic[index].Load());
+    }
+  }
+}
+
+// UdpPoseSource
+
+UdpPoseSource::UdpPoseSource(double flDelaySeconds, double flStaleSeconds)
+    : ExternalPoseSource(flDelaySeconds, flStaleSeconds),
+      m_socket(-1),
+      m_epoll(-1),
+      m_wakeEvent(-1),
+      m_unRejectedPackets(0),
+      m_unSender(0) {
+}
+
+UdpPoseSource::~UdpPoseSource() {
+  Close();
+}
+
+#if defined(__linux__)
+
+bool UdpPoseSource::Open(uint16_t unPort) {
+  Close();
+
+  m_socket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  m_epoll = epoll_create1(EPOLL_CLOEXEC);
+  m_wakeEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(unPort);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // Local trackers only
+  epoll_event socketEvent = {};
+  socketEvent.events = EPOLLIN;
+  socketEvent.data.fd = m_socket;
+  epoll_event wakeEvent = {};
+  wakeEvent.events = EPOLLIN;
+  wakeEvent.data.fd = m_wakeEvent;
+  if (m_socket < 0 || m_epoll < 0 || m_wakeEvent < 0 || bind(m_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+      epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_socket, &socketEvent) != 0 || epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeEvent, &wakeEvent) != 0) {
+    DRIVER_LOG_ERROR(DriverLogCategory_Provider, "UdpPoseSource::Open - Could not listen on 127.0.0.1:{}: errno {}", unPort, errno);
+    Close();
+    return false;
+  }
+
+  m_receiveThread = std::thread(&UdpPoseSource::ReceiveThreadMain, this);
+  DRIVER_LOG_INFO(DriverLogCategory_Provider, "UdpPoseSource::Open - Receiving external poses on 127.0.0.1:{}", unPort);
+  return true;
+}
+
+void UdpPoseSource::Close() {
+  if (m_receiveThread.joinable()) {
+    const uint64_t one = 1;
+    if (write(m_wakeEvent, &one, sizeof(one)) != (ssize_t)sizeof(one)) {
+      DRIVER_LOG_WARNING(DriverLogCategory_Provider, "UdpPoseSource::Close - Could not wake the receive thread: errno {}", errno);
+    }
+    m_receiveThread.join();
+  }
+  for (int* pFd : {&m_socket, &m_epoll, &m_wakeEvent}) {
+    if (*pFd >= 0) {
+      close(*pFd);
+      *pFd = -1;
+    }
+  }
+}
+
+void UdpPoseSource::ReceiveThreadMain() {
+  epoll_event events[2];
+  for (;;) {
+    const int ready = epoll_wait(m_epoll, events, 2, -1);
+    if (ready < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      DRIVER_LOG_ERROR(DriverLogCategory_Provider, "UdpPoseSource::ReceiveThreadMain - epoll_wait failed: errno {}", errno);
+      return;
+    }
+    for (int e = 0; e < ready; ++e) {
+      if (events[e].data.fd == m_wakeEvent) {
+        return; // Close
+      }
+    }
+
+    // Drain everything queued; the socket is non-blocking
+    for (;;) {
+      sockaddr_in sender = {};
+      socklen_t senderLength = sizeof(sender);
+      const ssize_t received = recvfrom(m_socket, m_packet, sizeof(m_packet), 0, reinterpret_cast<sockaddr*>(&sender), &senderLength);
+      if (received < 0) {
+        break; // EAGAIN, back to epoll
+      }
+      ExternalPosePacketHeader header;
+      if ((size_t)received < sizeof(header)) {
+        m_unRejectedPackets.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      memcpy(&header, m_packet, sizeof(header));
+      const size_t sampleSize = header.unPayload == ExternalPosePayload_Poses ? sizeof(ExternalPoseSample)
+                                : header.unPayload == ExternalPosePayload_Input ? sizeof(ExternalInputSample)
+                                                                                 : 0;
+      if (memcmp(header.rgchMagic, k_rgchExternalPosePacketMagic, sizeof(header.rgchMagic)) != 0 || header.unVersion != k_unExternalPoseVersion ||
+          sampleSize == 0 || header.unSampleCount > k_unExternalPoseMaxSamplesPerPacket ||
+          (size_t)received != sizeof(header) + header.unSampleCount * sampleSize) {
+        m_unRejectedPackets.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      m_unSender.store((uint64_t)ntohl(sender.sin_addr.s_addr) << 16 | ntohs(sender.sin_port), std::memory_order_relaxed);
+      for (uint32_t i = 0; i < header.unSampleCount; ++i) {
+        if (header.unPayload == ExternalPosePayload_Poses) {
+          ExternalPoseSample sample;
+          memcpy(&sample, m_packet + sizeof(header) + i * sampleSize, sizeof(sample));
+          Push(sample);
+        } else {
+          ExternalInputSample sample;
+          memcpy(&sample, m_packet + sizeof(header) + i * sampleSize, sizeof(sample));
+          PushInput(sample);
+        }
+      }
+    }
+  }
+}
+
+void UdpPoseSource::SendHapticPulse(uint32_t unIndex, const MirrorHapticPulse& pulse) {
+  const uint64_t sender = m_unSender.load(std::memory_order_relaxed);
+  if (sender == 0 || m_socket < 0) {
+    return; // Nobody to send it to yet
+  }
+  struct {
+    ExternalPosePacketHeader header;
+    ExternalHapticPulse pulse;
+  } packet;
+  memcpy(packet.header.rgchMagic, k_rgchExternalPosePacketMagic, sizeof(packet.header.rgchMagic));
+  packet.header.unVersion = k_unExternalPoseVersion;
+  packet.header.unSampleCount = 1;
+  packet.header.unPayload = ExternalPosePayload_Haptics;
+  packet.pulse = {unIndex, pulse.flDurationSeconds, pulse.flFrequency, pulse.flAmplitude, PoseExportNowNs()};
+  static_assert(sizeof(packet) == sizeof(ExternalPosePacketHeader) + sizeof(ExternalHapticPulse), "Haptic datagram must not be padded");
+
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons((uint16_t)(sender & 0xFFFF));
+  address.sin_addr.s_addr = htonl((uint32_t)(sender >> 16));
+  // Non-blocking; a full socket buffer drops the pulse rather than stall the frame
+  if (sendto(m_socket, &packet, sizeof(packet), 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != (ssize_t)sizeof(packet)) {
+    DRIVER_LOG_TRACE(DriverLogCategory_Provider, "UdpPoseSource::SendHapticPulse - Dropped a pulse for device {}: errno {}", unIndex, errno);
+  }
+}
+
+#else
+
+bool UdpPoseSource::Open(uint16_t unPort) {
+  DRIVER_LOG_ERROR(DriverLogCategory_Provider, "UdpPoseSource::Open - The UDP pose source is only available on Linux");
+  return false;
+}
+
+void UdpPoseSource::Close() {
+}
+
+void UdpPoseSource::ReceiveThreadMain() {
+}
+
+void UdpPoseSource::SendHapticPulse(uint32_t unIndex, const MirrorHapticPulse& pulse) {
+}
+
+#endif
+
+std::unique_ptr<IPoseSource> CreateExternalPoseSource(EPoseSourceType eType) {
+  vr::EVRSettingsError settingsError = vr::VRSettingsError_None;
+  float delayMs = vr::VRSettings()->GetFloat(k_pch_MyDriver_Section, k_pch_MyDriver_ExternalPoseDelayMs_Float, &settingsError);
+  if (settingsError != vr::VRSettingsError_None || delayMs < 0.f) {
+    delayMs = 0.f;
+  }
+  float staleMs = vr::VRSettings()->GetFloat(k_pch_MyDriver_Section, k_pch_MyDriver_ExternalPoseStaleMs_Float, &settingsError);
+  if (settingsError != vr::VRSettingsError_None || staleMs <= 0.f) {
+    staleMs = 100.f;
+  }
+
+  if (eType == PoseSource_SharedMemory) {
+    char name[256];
+    vr::VRSettings()->GetString(k_pch_MyDriver_Section, k_pch_MyDriver_ExternalPoseSharedMemoryName_String, name, sizeof(name), &settingsError);
+    if (settingsError != vr::VRSettingsError_None || name[0] == '\0') {
+      DRIVER_LOG_ERROR(DriverLogCategory_Provider, "CreateExternalPoseSource - No externalPoseSharedMemoryName set");
+      return nullptr;
+    }
+    std::unique_ptr<SharedMemoryPoseSource> source(new SharedMemoryPoseSource(delayMs * 1e-3, staleMs * 1e-3));
+    return source->Open(name) ? std::move(source) : nullptr;
+  }
+  if (eType == PoseSource_Udp) {
+    int32_t port = vr::VRSettings()->GetInt32(k_pch_MyDriver_Section, k_pch_MyDriver_ExternalPoseUdpPort_Int32, &settingsError);
+    if (settingsError != vr::VRSettingsError_None || port <= 0 || port > 65535) {
+      DRIVER_LOG_ERROR(DriverLogCategory_Provider, "CreateExternalPoseSource - Invalid externalPoseUdpPort");
+      return nullptr;
+    }
+    std::unique_ptr<UdpPoseSource> source(new UdpPoseSource(delayMs * 1e-3, staleMs * 1e-3));
+    return source->Open((uint16_t)port) ? std::move(source) : nullptr;
+  }
+  return nullptr;
+}
+
+}  // namespace vr
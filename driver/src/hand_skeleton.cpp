@@ -0,0 +1,416 @@
+#include "hand_skeleton.h"
+#include "input_mirror.h"
+#include "pose_conversion.h" // For CpuSupportsAvx
+
+#include <algorithm> // For std::max
+#include <cmath>
+
+// Same SIMD selection as pose_conversion.cpp: x86 only, AVX picked at runtime
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAND_SKELETON_SSE2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define HAND_SKELETON_AVX 1
+#define HAND_SKELETON_TARGET_AVX
+#elif defined(__GNUC__)
+#define HAND_SKELETON_AVX 1
+#define HAND_SKELETON_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+namespace vr {
+
+static_assert(sizeof(vr::VRBoneTransform_t) == 8 * sizeof(float), "The kernels write each bone as one row of 8 floats");
+static_assert(HandBone_Count <= k_unHandBoneLanes, "Bone tables are too short");
+
+// Reference poses
+
+namespace {
+
+struct ReferenceBone {
+  float position[3];
+  float rotation[4]; // w, x, y, z
+};
+
+// SteamVR's open hand and fist reference poses of "/skeleton/hand/left", parent-relative, as
+// IVRInput::GetSkeletalReferenceTransforms reports them for EVRSkeletalReferencePose_OpenHand and
+// _Fist. The aux bones are the distal joints in root space.
+const ReferenceBone k_rgLeftOpenHand[HandBone_Count] = {
+  {{0.000000f, 0.000000f, 0.000000f}, {1.000000f, 0.000000f, 0.000000f, 0.000000f}},
+  {{-0.034038f, 0.036503f, 0.164722f}, {-0.055147f, -0.078608f, -0.920279f, 0.379296f}},
+  {{-0.012083f, 0.028070f, 0.025050f}, {0.464112f, 0.567418f, 0.272106f, 0.623374f}},
+  {{0.040406f, 0.000000f, 0.000000f}, {0.994838f, 0.082939f, 0.019454f, 0.055130f}},
+  {{0.032517f, 0.000000f, 0.000000f}, {0.974793f, -0.003213f, 0.021867f, -0.222015f}},
+  {{0.030464f, 0.000000f, 0.000000f}, {1.000000f, 0.000000f, 0.000000f, 0.000000f}},
+  {{0.000632f, 0.026866f, 0.015002f}, {0.644251f, 0.421979f, -0.478202f, 0.422133f}},
+  {{0.074204f, -0.005002f, 0.000234f}, {0.995332f, 0.007007f, -0.039124f, 0.087949f}},
+  {{0.043930f, 0.000000f, 0.000000f}, {0.997891f, 0.045808f, 0.002142f, -0.045943f}},
+  {{0.028695f, 0.000000f, 0.000000f}, {0.999649f, 0.001850f, -0.022782f, -0.013409f}},
+  {{0.022821f, 0.000000f, 0.000000f}, {1.000000f, 0.000000f, 0.000000f, 0.000000f}},
+  {{0.002177f, 0.007120f, 0.016319f}, {0.546723f, 0.541276f, -0.442520f, 0.460749f}},
+  {{0.070953f, 0.000779f, 0.000997f}, {0.980294f, -0.167261f, -0.078959f, 0.069368f}},
+  {{0.043108f, 0.000000f, 0.000000f}, {0.997947f, 0.018493f, 0.013192f, 0.059886f}},
+  {{0.033266f, 0.000000f, 0.000000f}, {0.997394f, -0.003328f, -0.028225f, -0.066315f}},
+  {{0.025892f, 0.000000f, 0.000000f}, {0.999195f, 0.000000f, 0.000000f, 0.040126f}},
+  {{0.000513f, -0.006545f, 0.016348f}, {0.516692f, 0.550143f, -0.495548f, 0.429888f}},
+  {{0.065876f, 0.001786f, 0.000693f}, {0.990420f, -0.058696f, -0.101820f, 0.072495f}},
+  {{0.040697f, 0.000000f, 0.000000f}, {0.999545f, -0.002240f, 0.000004f, 0.030081f}},
+  {{0.028747f, 0.000000f, 0.000000f}, {0.999102f, -0.000721f, -0.012693f, 0.040420f}},
+  {{0.022430f, 0.000000f, 0.000000f}, {1.000000f, 0.000000f, 0.000000f, 0.000000f}},
+  {{-0.002478f, -0.018981f, 0.015214f}, {0.526918f, 0.523940f, -0.584025f, 0.326740f}},
+  {{0.062878f, 0.002844f, 0.000332f}, {0.986609f, -0.059615f, -0.135163f, 0.069132f}},
+  {{0.030220f, 0.000000f, 0.000000f}, {0.994317f, 0.001896f, -0.000132f, 0.106446f}},
+  {{0.018187f, 0.000000f, 0.000000f}, {0.995931f, -0.002010f, -0.052079f, -0.073526f}},
+  {{0.018018f, 0.000000f, 0.000000f}, {1.000000f, 0.000000f, 0.000000f, 0.000000f}},
+  {{-0.006059f, 0.056285f, 0.060064f}, {0.737238f, 0.202745f, 0.594267f, 0.249441f}},
+  {{-0.040416f, -0.043018f, 0.019345f}, {-0.290331f, 0.623527f, -0.663809f, -0.293734f}},
+  {{-0.039354f, -0.075674f, 0.047048f}, {-0.187047f, 0.678062f, -0.659285f, -0.265683f}},
+  {{-0.038340f, -0.090987f, 0.082579f}, {-0.183037f, 0.736793f, -0.634757f, -0.143936f}},
+  {{-0.031806f, -0.087214f, 0.121015f}, {-0.003659f, 0.758407f, -0.639342f, -0.126678f}},
+};
+
+const ReferenceBone k_rgLeftFist[HandBone_Count] = {
+  {{0.000000f, 0.000000f, 0.000000f}, {1.000000f, 0.000000f, 0.000000f, 0.000000f}},
+  {{-0.034038f, 0.036503f, 0.164722f}, {-0.055147f, -0.078608f, -0.920279f, 0.379296f}},
+  {{-0.016305f, 0.027529f, 0.017800f}, {0.225703f, 0.483332f, 0.126413f, 0.836342f}},
+  {{0.040406f, 0.000000f, 0.000000f}, {0.894335f, -0.013302f, -0.082902f, 0.439448f}},
+  {{0.032517f, 0.000000f, 0.000000f}, {0.842428f, 0.000655f, 0.001244f, 0.538807f}},
+  {{0.030464f, 0.000000f, 0.000000f}, {1.000000f, 0.000000f, 0.000000f, 0.000000f}},
+  {{0.003802f, 0.021514f, 0.012803f}, {0.617314f, 0.395175f, -0.510874f, 0.449185f}},
+  {{0.074204f, -0.005002f, 0.000234f}, {0.737291f, -0.032006f, -0.115013f, 0.664944f}},
+  {{0.043287f, 0.000000f, 0.000000f}, {0.611381f, 0.003287f, 0.003823f, 0.791320f}},
+  {{0.028275f, 0.000000f, 0.000000f}, {0.745389f, -0.000684f, -0.000945f, 0.666629f}},
+  {{0.022821f, 0.000000f, 0.000000f}, {1.000000f, 0.000000f, 0.000000f, 0.000000f}},
+  {{0.005787f, 0.006806f, 0.016534f}, {0.514203f, 0.522315f, -0.478348f, 0.483700f}},
+  {{0.070953f, 0.000779f, 0.000997f}, {0.723653f, -0.097901f, 0.048546f, 0.681458f}},
+  {{0.043108f, 0.000000f, 0.000000f}, {0.637464f, -0.002366f, -0.002831f, 0.770472f}},
+  {{0.033266f, 0.000000f, 0.000000f}, {0.658008f, 0.002610f, 0.003196f, 0.753000f}},
+  {{0.025892f, 0.000000f, 0.000000f}, {0.999195f, 0.000000f, 0.000000f, 0.040126f}},
+  {{0.004123f, -0.006858f, 0.016563f}, {0.489609f, 0.523374f, -0.520644f, 0.463997f}},
+  {{0.065876f, 0.001786f, 0.000693f}, {0.759970f, -0.055609f, 0.011571f, 0.647471f}},
+  {{0.040331f, 0.000000f, 0.000000f}, {0.664315f, 0.001595f, 0.001967f, 0.747449f}},
+  {{0.028489f, 0.000000f, 0.000000f}, {0.626957f, -0.002784f, -0.003234f, 0.779042f}},
+  {{0.022430f, 0.000000f, 0.000000f}, {1.000000f, 0.000000f, 0.000000f, 0.000000f}},
+  {{0.001131f, -0.019295f, 0.015429f}, {0.479766f, 0.477833f, -0.630198f, 0.379934f}},
+  {{0.062878f, 0.002844f, 0.000332f}, {0.827001f, 0.034282f, 0.003440f, 0.561144f}},
+  {{0.029874f, 0.000000f, 0.000000f}, {0.702185f, -0.006716f, -0.009289f, 0.711903f}},
+  {{0.017979f, 0.000000f, 0.000000f}, {0.676853f, 0.007956f, 0.009917f, 0.736009f}},
+  {{0.018018f, 0.000000f, 0.000000f}, {1.000000f, 0.000000f, 0.000000f, 0.000000f}},
+  {{0.019716f, 0.002802f, 0.093937f}, {0.377286f, -0.540831f, 0.150446f, -0.736562f}},
+  {{0.000171f, 0.016473f, 0.096515f}, {-0.006456f, 0.022747f, -0.932927f, -0.359287f}},
+  {{0.000448f, 0.001536f, 0.116543f}, {-0.039357f, 0.105143f, -0.928833f, -0.353079f}},
+  {{0.003949f, -0.014869f, 0.130608f}, {-0.055071f, 0.068695f, -0.944016f, -0.317933f}},
+  {{0.003263f, -0.034685f, 0.139926f}, {0.019690f, -0.100741f, -0.957331f, -0.270149f}},
+};
+
+void QuatMultiply(const float a[4], const float b[4], float out[4]) {
+  out[0] = a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3];
+  out[1] = a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2];
+  out[2] = a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1];
+  out[3] = a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0];
+}
+
+// Parent-relative bone of the right hand, from the same bone of the left hand. The right hand is
+// the left one mirrored through the root's YZ plane (M), and every frame below the wrist is also
+// turned half way about its own X (F), so each finger still extends along its bone's X axis:
+// - wrist, under the root: M L M
+// - metacarpals and aux bones, under the wrist or the root: M L M F
+// - phalanges and tips, under another finger bone: F M L M F, which only negates the position
+void MirrorToRightHand(uint32_t unBone, const ReferenceBone& left, ReferenceBone& outRight) {
+  const float* p = left.position;
+  const float* q = left.rotation;
+  const float mirrored[4] = {q[0], q[1], -q[2], -q[3]};
+  const float halfTurnX[4] = {0.f, 1.f, 0.f, 0.f};
+  outRight = left;
+  if (unBone == HandBone_Root) {
+    return;
+  }
+  if (unBone == HandBone_Wrist) {
+    outRight.position[0] = -p[0];
+    outRight.rotation[2] = mirrored[2], outRight.rotation[3] = mirrored[3];
+  } else if (unBone == HandBone_Thumb0 || unBone == HandBone_IndexFinger0 || unBone == HandBone_MiddleFinger0 || unBone == HandBone_RingFinger0 ||
+             unBone == HandBone_PinkyFinger0 || unBone >= HandBone_Aux_Thumb) {
+    outRight.position[0] = -p[0];
+    QuatMultiply(mirrored, halfTurnX, outRight.rotation);
+  } else {
+    outRight.position[0] = -p[0], outRight.position[1] = -p[1], outRight.position[2] = -p[2];
+  }
+}
+
+void BuildHandTable(HandBoneTable& table, bool bLeftHand, const ReferenceBone (&leftPose)[HandBone_Count]) {
+  for (uint32_t bone = 0; bone < k_unHandBoneLanes; ++bone) {
+    ReferenceBone reference = {{0.f, 0.f, 0.f}, {1.f, 0.f, 0.f, 0.f}}; // Padding stays identity
+    if (bone < HandBone_Count) {
+      if (bLeftHand) {
+        reference = leftPose[bone];
+      } else {
+        MirrorToRightHand(bone, leftPose[bone], reference);
+      }
+    }
+    // The table has six digits; renormalize so the open and fist ends of the blend are exact
+    const float* q = reference.rotation;
+    const float invNorm = 1.f / std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    for (int c = 0; c < 3; ++c) {
+      table.position[c][bone] = reference.position[c];
+    }
+    for (int c = 0; c < 4; ++c) {
+      table.rotation[c][bone] = q[c] * invNorm;
+    }
+  }
+}
+
+// The bones each finger's curl moves: metacarpal through tip, plus the aux bone
+struct FingerBones {
+  EHandBone eFirstBone;
+  EHandBone eLastBone;
+  EHandBone eAuxBone;
+};
+
+const FingerBones k_rgFingerBones[HandFinger_Count] = {
+  {HandBone_Thumb0, HandBone_Thumb3, HandBone_Aux_Thumb},
+  {HandBone_IndexFinger0, HandBone_IndexFinger4, HandBone_Aux_IndexFinger},
+  {HandBone_MiddleFinger0, HandBone_MiddleFinger4, HandBone_Aux_MiddleFinger},
+  {HandBone_RingFinger0, HandBone_RingFinger4, HandBone_Aux_RingFinger},
+  {HandBone_PinkyFinger0, HandBone_PinkyFinger4, HandBone_Aux_PinkyFinger},
+};
+
+HandSkeletonPoses BuildHandSkeletonPoses(bool bLeftHand) {
+  HandSkeletonPoses poses;
+  BuildHandTable(poses.open, bLeftHand, k_rgLeftOpenHand);
+  BuildHandTable(poses.closed, bLeftHand, k_rgLeftFist);
+
+  for (uint32_t bone = 0; bone < k_unHandBoneLanes; ++bone) {
+    const float dot = poses.open.rotation[0][bone] * poses.closed.rotation[0][bone] + poses.open.rotation[1][bone] * poses.closed.rotation[1][bone] +
+                      poses.open.rotation[2][bone] * poses.closed.rotation[2][bone] + poses.open.rotation[3][bone] * poses.closed.rotation[3][bone];
+    if (dot < 0.f) {
+      for (int i = 0; i < 4; ++i) {
+        poses.closed.rotation[i][bone] = -poses.closed.rotation[i][bone];
+      }
+    }
+    poses.finger[bone] = HandFinger_Count;
+  }
+  for (uint32_t finger = 0; finger < HandFinger_Count; ++finger) {
+    const FingerBones& bones = k_rgFingerBones[finger];
+    for (uint32_t bone = bones.eFirstBone; bone <= (uint32_t)bones.eLastBone; ++bone) {
+      poses.finger[bone] = (uint8_t)finger;
+    }
+    poses.finger[bones.eAuxBone] = (uint8_t)finger;
+  }
+  return poses;
+}
+
+}  // namespace
+
+const HandSkeletonPoses& GetHandSkeletonPoses(bool bLeftHand) {
+  static const HandSkeletonPoses left = BuildHandSkeletonPoses(true); // Built once, on first use
+  static const HandSkeletonPoses right = BuildHandSkeletonPoses(false);
+  return bLeftHand ? left : right;
+}
+
+void ComputeFingerCurls(const MirrorInputState& state, float flOutCurls[HandFinger_Count]) {
+  const uint32_t thumbControls = (1u << MirrorButton_AClick) | (1u << MirrorButton_ATouch) | (1u << MirrorButton_BClick) | (1u << MirrorButton_BTouch) |
+                                 (1u << MirrorButton_JoystickClick) | (1u << MirrorButton_JoystickTouch) |
+                                 (1u << MirrorButton_TrackpadClick) | (1u << MirrorButton_TrackpadTouch);
+  const bool triggerTouched = (state.unButtons & ((1u << MirrorButton_TriggerTouch) | (1u << MirrorButton_TriggerClick))) != 0;
+  const bool gripTouched = (state.unButtons & ((1u << MirrorButton_GripTouch) | (1u << MirrorButton_GripClick))) != 0;
+  const float grip = (state.unButtons & (1u << MirrorButton_GripClick)) ? 1.f : std::max(state.flAxes[MirrorAxis_GripValue], gripTouched ? 0.25f : 0.f);
+
+  // A finger resting on a touch sensor is slightly curled; lifting it off straightens it (pointing, thumbs up)
+  flOutCurls[HandFinger_Thumb] = (state.unButtons & thumbControls) ? 0.7f : 0.f;
+  flOutCurls[HandFinger_Index] = std::max(state.flAxes[MirrorAxis_TriggerValue], triggerTouched ? 0.25f : 0.f);
+  flOutCurls[HandFinger_Middle] = grip;
+  flOutCurls[HandFinger_Ring] = grip;
+  flOutCurls[HandFinger_Pinky] = grip;
+}
+
+// Blend kernels. Each bone is lerped/nlerped by its own curl t, then written as one
+// VRBoneTransform_t row {px, py, pz, 1, qw, qx, qy, qz}; the SIMD kernels build those rows by
+// transposing eight channel vectors.
+
+typedef void (*HandBlendKernel)(const HandSkeletonPoses& poses, const float* pflBoneCurl, vr::VRBoneTransform_t* pOutBones);
+
+static void BlendHandBones_Scalar(const HandSkeletonPoses& poses, const float* pflBoneCurl, vr::VRBoneTransform_t* pOutBones) {
+  for (uint32_t i = 0; i < k_unHandBoneLanes; ++i) {
+    const float t = pflBoneCurl[i], s = 1.f - t;
+    vr::VRBoneTransform_t& bone = pOutBones[i];
+    for (int c = 0; c < 3; ++c) {
+      bone.position.v[c] = s * poses.open.position[c][i] + t * poses.closed.position[c][i];
+    }
+    bone.position.v[3] = 1.f;
+
+    const float w = s * poses.open.rotation[0][i] + t * poses.closed.rotation[0][i];
+    const float x = s * poses.open.rotation[1][i] + t * poses.closed.rotation[1][i];
+    const float y = s * poses.open.rotation[2][i] + t * poses.closed.rotation[2][i];
+    const float z = s * poses.open.rotation[3][i] + t * poses.closed.rotation[3][i];
+    const float invNorm = 1.f / std::sqrt(w * w + x * x + y * y + z * z);
+    bone.orientation.w = w * invNorm;
+    bone.orientation.x = x * invNorm;
+    bone.orientation.y = y * invNorm;
+    bone.orientation.z = z * invNorm;
+  }
+}
+
+#ifdef HAND_SKELETON_SSE2
+static void BlendHandBones_SSE2(const HandSkeletonPoses& poses, const float* pflBoneCurl, vr::VRBoneTransform_t* pOutBones) {
+  const __m128 one = _mm_set1_ps(1.f);
+  for (uint32_t i = 0; i < k_unHandBoneLanes; i += 4) {
+    const __m128 t = _mm_loadu_ps(&pflBoneCurl[i]);
+    const __m128 s = _mm_sub_ps(one, t);
+    __m128 channel[8];
+    for (int c = 0; c < 3; ++c) {
+      channel[c] = _mm_add_ps(_mm_mul_ps(s, _mm_load_ps(&poses.open.position[c][i])), _mm_mul_ps(t, _mm_load_ps(&poses.closed.position[c][i])));
+    }
+    channel[3] = one;
+    for (int c = 0; c < 4; ++c) {
+      channel[4 + c] = _mm_add_ps(_mm_mul_ps(s, _mm_load_ps(&poses.open.rotation[c][i])), _mm_mul_ps(t, _mm_load_ps(&poses.closed.rotation[c][i])));
+    }
+    const __m128 norm2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(channel[4], channel[4]), _mm_mul_ps(channel[5], channel[5])),
+                                    _mm_add_ps(_mm_mul_ps(channel[6], channel[6]), _mm_mul_ps(channel[7], channel[7])));
+    const __m128 invNorm = _mm_div_ps(one, _mm_sqrt_ps(norm2));
+    for (int c = 4; c < 8; ++c) {
+      channel[c] = _mm_mul_ps(channel[c], invNorm);
+    }
+
+    // Two 4x4 transposes: positions, then orientations, one row per bone
+    _MM_TRANSPOSE4_PS(channel[0], channel[1], channel[2], channel[3]);
+    _MM_TRANSPOSE4_PS(channel[4], channel[5], channel[6], channel[7]);
+    for (int k = 0; k < 4; ++k) {
+      _mm_storeu_ps(pOutBones[i + k].position.v, channel[k]);
+      _mm_storeu_ps(&pOutBones[i + k].orientation.w, channel[4 + k]);
+    }
+  }
+}
+#endif // HAND_SKELETON_SSE2
+
+#ifdef HAND_SKELETON_AVX
+HAND_SKELETON_TARGET_AVX
+static void BlendHandBones_AVX(const HandSkeletonPoses& poses, const float* pflBoneCurl, vr::VRBoneTransform_t* pOutBones) {
+  const __m256 one = _mm256_set1_ps(1.f);
+  for (uint32_t i = 0; i < k_unHandBoneLanes; i += 8) {
+    const __m256 t = _mm256_loadu_ps(&pflBoneCurl[i]);
+    const __m256 s = _mm256_sub_ps(one, t);
+    __m256 r[8];
+    for (int c = 0; c < 3; ++c) {
+      r[c] = _mm256_add_ps(_mm256_mul_ps(s, _mm256_load_ps(&poses.open.position[c][i])), _mm256_mul_ps(t, _mm256_load_ps(&poses.closed.position[c][i])));
+    }
+    r[3] = one;
+    for (int c = 0; c < 4; ++c) {
+      r[4 + c] = _mm256_add_ps(_mm256_mul_ps(s, _mm256_load_ps(&poses.open.rotation[c][i])), _mm256_mul_ps(t, _mm256_load_ps(&poses.closed.rotation[c][i])));
+    }
+    const __m256 norm2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r[4], r[4]), _mm256_mul_ps(r[5], r[5])),
+                                       _mm256_add_ps(_mm256_mul_ps(r[6], r[6]), _mm256_mul_ps(r[7], r[7])));
+    const __m256 invNorm = _mm256_div_ps(one, _mm256_sqrt_ps(norm2));
+    for (int c = 4; c < 8; ++c) {
+      r[c] = _mm256_mul_ps(r[c], invNorm);
+    }
+
+    // 8x8 transpose: row k becomes bone i + k
+    const __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]), t1 = _mm256_unpackhi_ps(r[0], r[1]);
+    const __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]), t3 = _mm256_unpackhi_ps(r[2], r[3]);
+    const __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]), t5 = _mm256_unpackhi_ps(r[4], r[5]);
+    const __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]), t7 = _mm256_unpackhi_ps(r[6], r[7]);
+    const __m256 u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0)), u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0)), u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+    float* out = &pOutBones[i].position.v[0];
+    _mm256_storeu_ps(out + 0 * 8, _mm256_permute2f128_ps(u0, u4, 0x20));
+    _mm256_storeu_ps(out + 1 * 8, _mm256_permute2f128_ps(u1, u5, 0x20));
+    _mm256_storeu_ps(out + 2 * 8, _mm256_permute2f128_ps(u2, u6, 0x20));
+    _mm256_storeu_ps(out + 3 * 8, _mm256_permute2f128_ps(u3, u7, 0x20));
+    _mm256_storeu_ps(out + 4 * 8, _mm256_permute2f128_ps(u0, u4, 0x31));
+    _mm256_storeu_ps(out + 5 * 8, _mm256_permute2f128_ps(u1, u5, 0x31));
+    _mm256_storeu_ps(out + 6 * 8, _mm256_permute2f128_ps(u2, u6, 0x31));
+    _mm256_storeu_ps(out + 7 * 8, _mm256_permute2f128_ps(u3, u7, 0x31));
+  }
+}
+#endif // HAND_SKELETON_AVX
+
+struct HandBlendKernelChoice {
+  HandBlendKernel kernel;
+  const char* name;
+};
+
+static HandBlendKernelChoice SelectHandBlendKernel() {
+#ifdef HAND_SKELETON_AVX
+  if (CpuSupportsAvx()) {
+    return {BlendHandBones_AVX, "AVX"};
+  }
+#endif
+#ifdef HAND_SKELETON_SSE2
+  return {BlendHandBones_SSE2, "SSE2"};
+#else
+  return {BlendHandBones_Scalar, "Scalar"};
+#endif
+}
+
+static const HandBlendKernelChoice& GetHandBlendKernel() {
+  static const HandBlendKernelChoice choice = SelectHandBlendKernel(); // Resolved once, on first use
+  return choice;
+}
+
+const char* GetHandSkeletonKernelName() {
+  return GetHandBlendKernel().name;
+}
+
+// Spreads the five curls over the bone lanes; bones outside any finger blend at 0 (stay open)
+static void SpreadFingerCurls(const HandSkeletonPoses& poses, const float flCurls[HandFinger_Count], float* pflOutBoneCurl) {
+  float curls[HandFinger_Count + 1];
+  for (uint32_t finger = 0; finger < HandFinger_Count; ++finger) {
+    curls[finger] = std::min(std::max(flCurls[finger], 0.f), 1.f);
+  }
+  curls[HandFinger_Count] = 0.f;
+  for (uint32_t bone = 0; bone < k_unHandBoneLanes; ++bone) {
+    pflOutBoneCurl[bone] = curls[poses.finger[bone]];
+  }
+}
+
+void BlendHandSkeleton(const HandSkeletonPoses& poses, const float flCurls[HandFinger_Count], vr::VRBoneTransform_t* pOutBones) {
+  alignas(32) float boneCurl[k_unHandBoneLanes];
+  SpreadFingerCurls(poses, flCurls, boneCurl);
+  GetHandBlendKernel().kernel(poses, boneCurl, pOutBones);
+}
+
+bool IsHandSkeletonKernelSupported(EHandSkeletonKernel eKernel) {
+  switch (eKernel) {
+    case HandSkeletonKernel_Scalar:
+      return true;
+#ifdef HAND_SKELETON_SSE2
+    case HandSkeletonKernel_SSE2:
+      return true;
+#endif
+#ifdef HAND_SKELETON_AVX
+    case HandSkeletonKernel_AVX:
+      return CpuSupportsAvx();
+#endif
+    default:
+      return false;
+  }
+}
+
+bool BlendHandSkeletonWithKernel(EHandSkeletonKernel eKernel, const HandSkeletonPoses& poses, const float flCurls[HandFinger_Count],
+                                 vr::VRBoneTransform_t* pOutBones) {
+  if (!IsHandSkeletonKernelSupported(eKernel)) {
+    return false;
+  }
+  alignas(32) float boneCurl[k_unHandBoneLanes];
+  SpreadFingerCurls(poses, flCurls, boneCurl);
+  switch (eKernel) {
+#ifdef HAND_SKELETON_AVX
+    case HandSkeletonKernel_AVX:
+      BlendHandBones_AVX(poses, boneCurl, pOutBones);
+      break;
+#endif
+#ifdef HAND_SKELETON_SSE2
+    case HandSkeletonKernel_SSE2:
+      BlendHandBones_SSE2(poses, boneCurl, pOutBones);
+      break;
+#endif
+    default:
+      BlendHandBones_Scalar(poses, boneCurl, pOutBones);
+      break;
+  }
+  return true;
+}
+
+}  // namespace vr
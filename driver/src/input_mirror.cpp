@@ -0,0 +1,300 @@
+#include "input_mirror.h"
+#include "driver_log.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h> // For _BitScanForward
+#endif
+
+namespace vr {
+
+static const char* const k_rgButtonPaths[MirrorButton_Count] = {
+  "/input/system/click",
+  "/input/application_menu/click",
+  "/input/a/click",
+  "/input/a/touch",
+  "/input/b/click",
+  "/input/b/touch",
+  "/input/trigger/click",
+  "/input/trigger/touch",
+  "/input/grip/click",
+  "/input/grip/touch",
+  "/input/joystick/click",
+  "/input/joystick/touch",
+  "/input/trackpad/click",
+  "/input/trackpad/touch",
+};
+
+static const char* const k_rgAxisPaths[MirrorAxis_Count] = {
+  "/input/trigger/value",
+  "/input/grip/value",
+  "/input/joystick/x",
+  "/input/joystick/y",
+  "/input/trackpad/x",
+  "/input/trackpad/y",
+};
+
+static const vr::EVRScalarUnits k_rgAxisUnits[MirrorAxis_Count] = {
+  vr::VRScalarUnits_NormalizedOneSided,
+  vr::VRScalarUnits_NormalizedOneSided,
+  vr::VRScalarUnits_NormalizedTwoSided,
+  vr::VRScalarUnits_NormalizedTwoSided,
+  vr::VRScalarUnits_NormalizedTwoSided,
+  vr::VRScalarUnits_NormalizedTwoSided,
+};
+
+static_assert(MirrorButton_Count <= 32, "Button state is a 32-bit mask");
+static_assert(MirrorAxis_Count <= 32, "Axis changes are collected in a 32-bit mask");
+
+// Index of the lowest set bit; unBits must not be 0
+static inline uint32_t LowestSetBit(uint32_t unBits) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, unBits);
+  return (uint32_t)index;
+#else
+  return (uint32_t)__builtin_ctz(unBits);
+#endif
+}
+
+static MirrorInputState IdleInputState() {
+  MirrorInputState state;
+  state.unButtons = 0;
+  for (uint32_t axis = 0; axis < MirrorAxis_Count; ++axis) {
+    state.flAxes[axis] = 0.f;
+  }
+  state.sampleTime = std::chrono::steady_clock::time_point();
+  return state;
+}
+
+InputMirror::InputMirror() : m_unSlotLimit(0) {
+  for (uint32_t slot = 0; slot < k_unMaxSlots; ++slot) {
+    m_bCreated[slot] = false;
+    m_ulHaptic[slot] = vr::k_ulInvalidInputComponentHandle;
+    m_ulSkeleton[slot] = vr::k_ulInvalidInputComponentHandle;
+    m_bLeftHand[slot] = false;
+    for (uint32_t button = 0; button < MirrorButton_Count; ++button) {
+      m_ulButton[slot][button] = vr::k_ulInvalidInputComponentHandle;
+    }
+    for (uint32_t axis = 0; axis < MirrorAxis_Count; ++axis) {
+      m_ulAxis[slot][axis] = vr::k_ulInvalidInputComponentHandle;
+    }
+    m_submittedState[slot] = IdleInputState();
+    m_unSubmittedVersion[slot] = 0;
+  }
+  ResetCounters();
+}
+
+bool InputMirror::CreateComponents(uint32_t unSlot, vr::PropertyContainerHandle_t ulContainer, int32_t nControllerRole) {
+  if (unSlot >= k_unMaxSlots) {
+    return false;
+  }
+
+  uint32_t failures = 0;
+  for (uint32_t button = 0; button < MirrorButton_Count; ++button) {
+    const vr::EVRInputError error = vr::VRDriverInput()->CreateBooleanComponent(ulContainer, k_rgButtonPaths[button], &m_ulButton[unSlot][button]);
+    if (error != vr::VRInputError_None) {
+      DRIVER_LOG_WARNING(DriverLogCategory_Device, "InputMirror::CreateComponents - Error creating {} for slot {}: {}", k_rgButtonPaths[button], unSlot, error);
+      m_ulButton[unSlot][button] = vr::k_ulInvalidInputComponentHandle;
+      ++failures;
+    }
+  }
+  for (uint32_t axis = 0; axis < MirrorAxis_Count; ++axis) {
+    const vr::EVRInputError error = vr::VRDriverInput()->CreateScalarComponent(ulContainer, k_rgAxisPaths[axis], &m_ulAxis[unSlot][axis],
+                                                                             vr::VRScalarType_Absolute, k_rgAxisUnits[axis]);
+    if (error != vr::VRInputError_None) {
+      DRIVER_LOG_WARNING(DriverLogCategory_Device, "InputMirror::CreateComponents - Error creating {} for slot {}: {}", k_rgAxisPaths[axis], unSlot, error);
+      m_ulAxis[unSlot][axis] = vr::k_ulInvalidInputComponentHandle;
+      ++failures;
+    }
+  }
+  if (vr::VRDriverInput()->CreateHapticComponent(ulContainer, "/output/haptic", &m_ulHaptic[unSlot]) != vr::VRInputError_None) {
+    DRIVER_LOG_WARNING(DriverLogCategory_Device, "InputMirror::CreateComponents - Error creating /output/haptic for slot {}", unSlot);
+    m_ulHaptic[unSlot] = vr::k_ulInvalidInputComponentHandle;
+    ++failures;
+  }
+
+  m_ulSkeleton[unSlot] = vr::k_ulInvalidInputComponentHandle;
+  if (nControllerRole == vr::TrackedControllerRole_LeftHand || nControllerRole == vr::TrackedControllerRole_RightHand) {
+    const float openCurls[HandFinger_Count] = {}; // Start from the open hand so the host has a pose before the first input arrives
+    if (!CreateSkeleton(unSlot, ulContainer, nControllerRole == vr::TrackedControllerRole_LeftHand, openCurls)) {
+      ++failures;
+    }
+  }
+
+  // The host starts every component at false/0, so diff the first published state against that
+  m_submittedState[unSlot] = IdleInputState();
+  m_unSubmittedVersion[unSlot] = 0;
+  m_bCreated[unSlot] = true;
+  if (unSlot >= m_unSlotLimit) {
+    m_unSlotLimit = unSlot + 1;
+  }
+  return failures == 0;
+}
+
+bool InputMirror::SetHand(uint32_t unSlot, vr::PropertyContainerHandle_t ulContainer, int32_t nControllerRole) {
+  if (unSlot >= k_unMaxSlots || !m_bCreated[unSlot]) {
+    return false; // Not activated; the next activation creates the skeleton for the new role
+  }
+
+  const bool hand = nControllerRole == vr::TrackedControllerRole_LeftHand || nControllerRole == vr::TrackedControllerRole_RightHand;
+  const bool leftHand = nControllerRole == vr::TrackedControllerRole_LeftHand;
+  const bool hasSkeleton = m_ulSkeleton[unSlot] != vr::k_ulInvalidInputComponentHandle;
+  if (hasSkeleton == hand && (!hand || m_bLeftHand[unSlot] == leftHand)) {
+    return false; // Same hand as before
+  }
+
+  // The host has no way to remove a component, so the old skeleton is simply no longer updated
+  m_ulSkeleton[unSlot] = vr::k_ulInvalidInputComponentHandle;
+  if (!hand) {
+    DRIVER_LOG_INFO(DriverLogCategory_Device, "InputMirror::SetHand - Slot {} is no longer a hand, dropping its skeleton", unSlot);
+    return true;
+  }
+
+  // Pick up where the other hand left off, so the new skeleton matches the buttons already held
+  float curls[HandFinger_Count];
+  ComputeFingerCurls(m_submittedState[unSlot], curls);
+  CreateSkeleton(unSlot, ulContainer, leftHand, curls);
+  return true;
+}
+
+bool InputMirror::CreateSkeleton(uint32_t unSlot, vr::PropertyContainerHandle_t ulContainer, bool bLeftHand, const float flCurls[HandFinger_Count]) {
+  const vr::EVRInputError error = vr::VRDriverInput()->CreateSkeletonComponent(
+      ulContainer, bLeftHand ? "/input/skeleton/left" : "/input/skeleton/right", bLeftHand ? "/skeleton/hand/left" : "/skeleton/hand/right",
+      "/pose/raw", vr::VRSkeletalTracking_Estimated, nullptr, 0, &m_ulSkeleton[unSlot]);
+  if (error != vr::VRInputError_None) {
+    DRIVER_LOG_WARNING(DriverLogCategory_Device, "InputMirror::CreateSkeleton - Error creating the skeleton for slot {}: {}", unSlot, error);
+    m_ulSkeleton[unSlot] = vr::k_ulInvalidInputComponentHandle;
+    return false;
+  }
+
+  m_bLeftHand[unSlot] = bLeftHand;
+  SubmitSkeleton(unSlot, flCurls);
+  DRIVER_LOG_INFO(DriverLogCategory_Device, "InputMirror::CreateSkeleton - {} hand skeleton for slot {}, {} blend", bLeftHand ? "Left" : "Right",
+                  unSlot, GetHandSkeletonKernelName());
+  return true;
+}
+
+void InputMirror::ReleaseComponents(uint32_t unSlot) {
+  if (unSlot < k_unMaxSlots) {
+    m_bCreated[unSlot] = false;
+    m_ulHaptic[unSlot] = vr::k_ulInvalidInputComponentHandle;
+    m_ulSkeleton[unSlot] = vr::k_ulInvalidInputComponentHandle;
+  }
+}
+
+void InputMirror::PublishInputState(uint32_t unSlot, const MirrorInputState& state) {
+  if (unSlot < k_unMaxSlots) {
+    m_publishedState[unSlot].Store(state);
+  }
+}
+
+void InputMirror::SubmitInputs() {
+  const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+  for (uint32_t slot = 0; slot < m_unSlotLimit; ++slot) {
+    const uint32_t version = m_publishedState[slot].Version();
+    if (!m_bCreated[slot] || version == m_unSubmittedVersion[slot]) {
+      continue; // Nothing new since the last frame
+    }
+    m_unSubmittedVersion[slot] = version;
+
+    const MirrorInputState state = m_publishedState[slot].Load();
+    MirrorInputState& submitted = m_submittedState[slot];
+
+    // Tell the host how old the sample is, like the poses do
+    const double timeOffset = state.sampleTime == std::chrono::steady_clock::time_point()
+                                  ? 0.0
+                                  : -std::chrono::duration<double>(now - state.sampleTime).count();
+
+    uint32_t changedButtons = state.unButtons ^ submitted.unButtons;
+    uint32_t changedAxes = 0;
+    for (uint32_t axis = 0; axis < MirrorAxis_Count; ++axis) {
+      changedAxes |= (uint32_t)(state.flAxes[axis] != submitted.flAxes[axis]) << axis;
+    }
+
+    uint64_t updates = 0;
+    while (changedButtons) {
+      const uint32_t button = LowestSetBit(changedButtons);
+      changedButtons &= changedButtons - 1;
+      if (m_ulButton[slot][button] != vr::k_ulInvalidInputComponentHandle) {
+        vr::VRDriverInput()->UpdateBooleanComponent(m_ulButton[slot][button], (state.unButtons >> button) & 1u, timeOffset);
+        ++updates;
+      }
+    }
+    while (changedAxes) {
+      const uint32_t axis = LowestSetBit(changedAxes);
+      changedAxes &= changedAxes - 1;
+      if (m_ulAxis[slot][axis] != vr::k_ulInvalidInputComponentHandle) {
+        vr::VRDriverInput()->UpdateScalarComponent(m_ulAxis[slot][axis], state.flAxes[axis], timeOffset);
+        ++updates;
+      }
+    }
+
+    if (m_ulSkeleton[slot] != vr::k_ulInvalidInputComponentHandle) {
+      float curls[HandFinger_Count];
+      ComputeFingerCurls(state, curls);
+      bool curlsChanged = false;
+      for (uint32_t finger = 0; finger < HandFinger_Count; ++finger) {
+        curlsChanged |= curls[finger] != m_flSubmittedCurls[slot][finger];
+      }
+      if (curlsChanged) {
+        updates += SubmitSkeleton(slot, curls);
+      }
+    }
+
+    submitted = state;
+    if (updates) {
+      m_unUpdateCount[slot].fetch_add(updates, std::memory_order_relaxed);
+    }
+  }
+}
+
+uint64_t InputMirror::SubmitSkeleton(uint32_t unSlot, const float flCurls[HandFinger_Count]) {
+  BlendHandSkeleton(GetHandSkeletonPoses(m_bLeftHand[unSlot]), flCurls, m_skeletonBones);
+  for (uint32_t finger = 0; finger < HandFinger_Count; ++finger) {
+    m_flSubmittedCurls[unSlot][finger] = flCurls[finger];
+  }
+
+  // Curls come from the controller's own sensors, so the hand looks the same with or without it
+  vr::VRDriverInput()->UpdateSkeletonComponent(m_ulSkeleton[unSlot], vr::VRSkeletalMotionRange_WithController, m_skeletonBones, HandBone_Count);
+  vr::VRDriverInput()->UpdateSkeletonComponent(m_ulSkeleton[unSlot], vr::VRSkeletalMotionRange_WithoutController, m_skeletonBones, HandBone_Count);
+  return 2;
+}
+
+bool InputMirror::OnHapticEvent(const vr::VREvent_HapticVibration_t& haptic) {
+  if (haptic.componentHandle == vr::k_ulInvalidInputComponentHandle) {
+    return false;
+  }
+  for (uint32_t slot = 0; slot < m_unSlotLimit; ++slot) {
+    if (m_ulHaptic[slot] == haptic.componentHandle) {
+      m_hapticPulse[slot].Store({haptic.fDurationSeconds, haptic.fFrequency, haptic.fAmplitude});
+      m_unHapticCount[slot].fetch_add(1, std::memory_order_relaxed);
+      DRIVER_LOG_TRACE(DriverLogCategory_Device, "InputMirror::OnHapticEvent - Slot {}: {} s at {} Hz, amplitude {}",
+                       slot, haptic.fDurationSeconds, haptic.fFrequency, haptic.fAmplitude);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool InputMirror::TakeHapticPulse(uint32_t unSlot, uint32_t& unLastSeen, MirrorHapticPulse& outPulse) const {
+  if (unSlot >= k_unMaxSlots) {
+    return false;
+  }
+  const uint32_t version = m_hapticPulse[unSlot].Version();
+  if (version == unLastSeen) {
+    return false;
+  }
+  outPulse = m_hapticPulse[unSlot].Load();
+  unLastSeen = version;
+  return true;
+}
+
+void InputMirror::ResetCounters() {
+  for (uint32_t slot = 0; slot < k_unMaxSlots; ++slot) {
+    m_unUpdateCount[slot].store(0, std::memory_order_relaxed);
+    m_unHapticCount[slot].store(0, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace vr
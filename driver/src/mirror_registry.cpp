@@ -0,0 +1,415 @@
+#include "mirror_registry.h"
+#include "driver_log.h"
+#include "driver_stats.h"
+#include "pose_prediction.h"
+
+#include <type_traits> // For std::conditional
+
+namespace vr {
+
+// Resets a pose to the default disconnected state
+static void InitDisconnectedPose(vr::DriverPose_t& pose) {
+  pose.poseIsValid = false;
+  pose.result = vr::TrackingResult_Uninitialized;
+  pose.deviceIsConnected = false;
+
+  pose.qWorldFromDriverRotation = {1.0, 0.0, 0.0, 0.0};
+  pose.qDriverFromHeadRotation = {1.0, 0.0, 0.0, 0.0};
+
+  for (int i = 0; i < 3; ++i) {
+    pose.vecPosition[i] = 0.0;
+    pose.vecVelocity[i] = 0.0;
+    pose.vecAcceleration[i] = 0.0;
+    pose.vecAngularVelocity[i] = 0.0;
+    pose.vecAngularAcceleration[i] = 0.0;
+    pose.vecWorldFromDriverTranslation[i] = 0.0;
+    pose.vecDriverFromHeadTranslation[i] = 0.0;
+  }
+  pose.qRotation = {1.0, 0.0, 0.0, 0.0};
+  pose.poseTimeOffset = 0.0;
+  pose.willDriftInYaw = false;
+  pose.shouldApplyHeadModel = false;
+}
+
+MirrorRegistry::MirrorRegistry()
+    : m_unSlotCount(0),
+      m_flPredictionSeconds(0.0),
+      m_changeDetection(),
+      m_pExporter(nullptr) {
+  const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < k_unMaxSlots; ++i) {
+    m_unPhysicalIndex[i] = vr::k_unTrackedDeviceIndexInvalid;
+    m_unObjectId[i].store(vr::k_unTrackedDeviceIndexInvalid, std::memory_order_relaxed);
+    m_flags[i] = 0;
+    InitDisconnectedPose(m_lastPose[i]);
+    m_publishedPose[i].Store({m_lastPose[i], now});
+    m_submittedPose[i] = m_lastPose[i];
+    m_submitTime[i] = std::chrono::steady_clock::time_point();
+    m_unActivationCount[i].store(0, std::memory_order_relaxed);
+    m_unSweptActivationCount[i].store(0, std::memory_order_relaxed);
+    m_bStandby[i].store(false, std::memory_order_relaxed);
+  }
+  for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i) {
+    m_unSlotForObjectId[i] = k_unInvalidSlot;
+  }
+  ResetCounters();
+}
+
+uint32_t MirrorRegistry::AddSlot(uint32_t unPhysicalIndex) {
+  const uint32_t slot = m_unSlotCount.load(std::memory_order_relaxed);
+  if (slot >= k_unMaxSlots) {
+    return k_unInvalidSlot;
+  }
+  m_unPhysicalIndex[slot] = unPhysicalIndex;
+  m_flags[slot] = 0;
+  m_fusion.Bind(slot, unPhysicalIndex, nullptr, 0); // Unfused until its device reads a fusion section
+  InitDisconnectedPose(m_lastPose[slot]);
+  m_publishedPose[slot].Store({m_lastPose[slot], std::chrono::steady_clock::now()});
+  m_submittedPose[slot] = m_lastPose[slot];
+  m_submitTime[slot] = std::chrono::steady_clock::time_point(); // Never submitted, the first submission always goes out
+  m_unActivationCount[slot].store(0, std::memory_order_relaxed);
+  m_unSweptActivationCount[slot].store(0, std::memory_order_relaxed);
+  m_bStandby[slot].store(false, std::memory_order_relaxed);
+  m_unSentCount[slot].store(0, std::memory_order_relaxed);
+  m_unSuppressedCount[slot].store(0, std::memory_order_relaxed);
+  m_unFrameCount[slot].store(0, std::memory_order_relaxed);
+  m_unInvalidPoseCount[slot].store(0, std::memory_order_relaxed);
+  m_unDisconnectCount[slot].store(0, std::memory_order_relaxed);
+  m_unOutOfRangeCount[slot].store(0, std::memory_order_relaxed);
+  m_unSlotCount.store(slot + 1, std::memory_order_release); // Publish the slot to the sweeps last
+  return slot;
+}
+
+void MirrorRegistry::Clear() {
+  const uint32_t slotCount = GetSlotCount();
+  for (uint32_t slot = 0; slot < slotCount; ++slot) {
+    m_unObjectId[slot].store(vr::k_unTrackedDeviceIndexInvalid, std::memory_order_relaxed);
+    m_unPhysicalIndex[slot] = vr::k_unTrackedDeviceIndexInvalid;
+  }
+  for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i) {
+    m_unSlotForObjectId[i] = k_unInvalidSlot;
+  }
+  m_unSlotCount.store(0, std::memory_order_release);
+}
+
+void MirrorRegistry::ActivateSlot(uint32_t unSlot, uint32_t unObjectId, const DriverPoseCalibration& calibration) {
+  // m_lastPose, the published pose and the scheduler belong to the sweep, which may be running on the
+  // tracking thread right now; it applies the calibration and resets the slot on its next pass
+  m_pendingCalibration[unSlot].Store(calibration);
+  m_unActivationCount[unSlot].fetch_add(1, std::memory_order_release);
+  m_bStandby[unSlot].store(false, std::memory_order_release);
+  if (unObjectId < vr::k_unMaxTrackedDeviceCount) {
+    m_unSlotForObjectId[unObjectId] = unSlot;
+  }
+  m_unObjectId[unSlot].store(unObjectId, std::memory_order_release); // The sweeps pick the slot up from here on
+}
+
+bool MirrorRegistry::IsActivationPending() const {
+  const uint32_t slotCount = GetSlotCount();
+  for (uint32_t slot = 0; slot < slotCount; ++slot) {
+    if (m_unActivationCount[slot].load(std::memory_order_acquire) != m_unSweptActivationCount[slot].load(std::memory_order_acquire)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void MirrorRegistry::DeactivateSlot(uint32_t unSlot) {
+  const uint32_t objectId = m_unObjectId[unSlot].exchange(vr::k_unTrackedDeviceIndexInvalid, std::memory_order_acq_rel);
+  if (objectId < vr::k_unMaxTrackedDeviceCount) {
+    m_unSlotForObjectId[objectId] = k_unInvalidSlot;
+  }
+}
+
+void MirrorRegistry::SetPredictionHorizon(double flSeconds) {
+  m_flPredictionSeconds = flSeconds > 0.0 ? flSeconds : 0.0;
+}
+
+void MirrorRegistry::SetChangeDetection(const PoseChangeDetection& settings) {
+  m_changeDetection = settings;
+}
+
+void MirrorRegistry::SetPoseFilter(const PoseFilterSettings& settings) {
+  m_filters.Configure(settings);
+}
+
+MirrorSlotCounters MirrorRegistry::GetCounters(uint32_t unSlot) const {
+  MirrorSlotCounters counters;
+  counters.unFrames = m_unFrameCount[unSlot].load(std::memory_order_relaxed);
+  counters.unInvalidPoses = m_unInvalidPoseCount[unSlot].load(std::memory_order_relaxed);
+  counters.unDisconnects = m_unDisconnectCount[unSlot].load(std::memory_order_relaxed);
+  counters.unOutOfRange = m_unOutOfRangeCount[unSlot].load(std::memory_order_relaxed);
+  counters.unSent = m_unSentCount[unSlot].load(std::memory_order_relaxed);
+  counters.unSuppressed = m_unSuppressedCount[unSlot].load(std::memory_order_relaxed);
+  return counters;
+}
+
+void MirrorRegistry::ResetCounters() {
+  // The writers use fetch_add, so a reset racing a sweep loses at most that sweep's increments
+  for (uint32_t i = 0; i < k_unMaxSlots; ++i) {
+    m_unSentCount[i].store(0, std::memory_order_relaxed);
+    m_unSuppressedCount[i].store(0, std::memory_order_relaxed);
+    m_unFrameCount[i].store(0, std::memory_order_relaxed);
+    m_unInvalidPoseCount[i].store(0, std::memory_order_relaxed);
+    m_unDisconnectCount[i].store(0, std::memory_order_relaxed);
+    m_unOutOfRangeCount[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+// The pose should reflect that it's in standby: not tracking, but still connected
+static void ApplyStandby(vr::DriverPose_t& pose) {
+  pose.poseIsValid = false;
+  pose.result = vr::TrackingResult_Uninitialized;
+  pose.deviceIsConnected = true;
+  pose.poseTimeOffset = 0.0;
+}
+
+vr::DriverPose_t MirrorRegistry::GetPose(uint32_t unSlot) const {
+  vr::DriverPose_t pose = m_publishedPose[unSlot].Load().pose;
+  if (m_bStandby[unSlot].load(std::memory_order_acquire)) {
+    ApplyStandby(pose);
+  }
+  return pose;
+}
+
+void MirrorRegistry::EnterStandby(uint32_t unSlot) {
+  // Only a flag: the sweeps own the published poses and would overwrite a standby pose stored there
+  m_bStandby[unSlot].store(true, std::memory_order_release);
+
+  // It's good practice to also inform the host that the pose was updated due to standby.
+  const uint32_t objectId = GetObjectId(unSlot);
+  if (objectId != vr::k_unTrackedDeviceIndexInvalid) {
+    const vr::DriverPose_t standby = GetPose(unSlot);
+    vr::VRServerDriverHost()->TrackedDevicePoseUpdated(objectId, standby, sizeof(vr::DriverPose_t));
+  }
+}
+
+void MirrorRegistry::LeaveStandby() {
+  const uint32_t slotCount = GetSlotCount();
+  for (uint32_t slot = 0; slot < slotCount; ++slot) {
+    m_bStandby[slot].store(false, std::memory_order_release);
+  }
+}
+
+void MirrorRegistry::SubmitPoses() {
+  const uint32_t slotCount = GetSlotCount();
+  const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+  for (uint32_t slot = 0; slot < slotCount; ++slot) {
+    const uint32_t objectId = m_unObjectId[slot].load(std::memory_order_acquire);
+    if (objectId == vr::k_unTrackedDeviceIndexInvalid) {
+      continue; // Not activated yet
+    }
+    if (m_unActivationCount[slot].load(std::memory_order_acquire) != m_unSweptActivationCount[slot].load(std::memory_order_acquire)) {
+      continue; // Not swept since activation, the published pose doesn't carry the calibration yet
+    }
+
+    // Idle mirrors only refresh the host every keep-alive interval; motion makes them active again in the sweep that sees it
+    if (!m_scheduler.ShouldSubmit(slot, now, m_submitTime[slot])) {
+      m_unSuppressedCount[slot].fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+
+    PublishedPose published = m_publishedPose[slot].Load();
+    if (m_bStandby[slot].load(std::memory_order_acquire)) {
+      ApplyStandby(published.pose);
+    }
+
+    // Skip the IPC hop if the host would end up with the same pose it already has
+    if (m_changeDetection.bEnabled && m_submitTime[slot] != std::chrono::steady_clock::time_point() &&
+        std::chrono::duration<double>(now - m_submitTime[slot]).count() < m_changeDetection.flKeepAliveSeconds &&
+        !IsPoseChangeSignificant(m_submittedPose[slot], published.pose, m_changeDetection)) {
+      m_unSuppressedCount[slot].fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    m_submittedPose[slot] = published.pose;
+    m_submitTime[slot] = now;
+
+    // The pose may have been sampled on the tracking thread a little while ago; tell the host how old it is.
+    // A predicted pose already stands for the display time, so it keeps its zero offset.
+    if (m_flPredictionSeconds <= 0.0) {
+      published.pose.poseTimeOffset -= std::chrono::duration<double>(now - published.sampleTime).count();
+    }
+
+    {
+      ScopedDriverTimer timer(DriverTimer_PoseSubmit);
+      vr::VRServerDriverHost()->TrackedDevicePoseUpdated(objectId, published.pose, sizeof(vr::DriverPose_t));
+    }
+    m_unSentCount[slot].fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+template <class FilterPolicy, class PredictionPolicy, class SinkPolicy, class LogPolicy>
+void MirrorRegistry::Sweep(const vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount) {
+  const uint32_t slotCount = GetSlotCount();
+  const std::chrono::steady_clock::time_point sampleTime = std::chrono::steady_clock::now();
+
+  // Convert the whole snapshot in one batched pass; the sweep below only picks entries out of it
+  ConvertRawPoses(pRawPoses, unRawPoseCount, m_converted);
+
+  const double timeSeconds = std::chrono::duration<double>(sampleTime.time_since_epoch()).count();
+  const bool scheduling = m_scheduler.IsEnabled();
+  bool active[k_unMaxSlots]; // Activated this sweep
+  bool filter[k_unMaxSlots]; // Activated and holding a fresh valid pose
+  uint32_t activation[k_unMaxSlots]; // Activation count this sweep applied, 0 if it applied none
+
+  for (uint32_t slot = 0; slot < slotCount; ++slot) {
+    active[slot] = m_unObjectId[slot].load(std::memory_order_acquire) != vr::k_unTrackedDeviceIndexInvalid;
+    filter[slot] = false;
+    activation[slot] = 0;
+    if (!active[slot]) {
+      continue; // Not activated yet
+    }
+
+    const uint32_t physicalIndex = m_unPhysicalIndex[slot];
+    vr::DriverPose_t& pose = m_lastPose[slot];
+    uint8_t flags = 0;
+
+    // Pick up an activation handed over by ActivateSlot. The calibration goes into the working copy once;
+    // the sweeps never touch the offset fields, so every later pose carries it.
+    const uint32_t activationCount = m_unActivationCount[slot].load(std::memory_order_acquire);
+    if (activationCount != m_unSweptActivationCount[slot].load(std::memory_order_relaxed)) {
+      activation[slot] = activationCount;
+      ApplyPoseCalibration(pose, m_pendingCalibration[slot].Load());
+      m_scheduler.ResetSlot(slot, sampleTime); // Starts out active, so the first poses go out at full rate
+    }
+
+    // The raw poses are sampled once per frame (or tracking thread tick) by MyTrackedDeviceProvider and shared between slots
+    if (m_fusion.IsFused(slot)) {
+      bool connected = false;
+      if (m_fusion.Fuse(slot, pRawPoses, unRawPoseCount, m_converted, timeSeconds, pose, connected)) {
+        pose.poseTimeOffset = 0.f;
+        flags |= MirrorSlot_PoseValid;
+        filter[slot] = true;
+      } else if (connected) {
+        m_unInvalidPoseCount[slot].fetch_add(1, std::memory_order_relaxed);
+      }
+      if (connected) {
+        flags |= MirrorSlot_PhysicalConnected;
+      }
+    } else if (physicalIndex < unRawPoseCount && physicalIndex < PoseConversionBatch::k_unCapacity) {
+      const vr::TrackedDevicePose_t& physicalDevicePose = pRawPoses[physicalIndex];
+      if (physicalDevicePose.bDeviceIsConnected) {
+        flags |= MirrorSlot_PhysicalConnected;
+        if (!physicalDevicePose.bPoseIsValid) {
+          m_unInvalidPoseCount[slot].fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+
+      if (physicalDevicePose.bDeviceIsConnected && physicalDevicePose.bPoseIsValid) {
+        pose.poseIsValid = true;
+        pose.result = physicalDevicePose.eTrackingResult;
+        pose.deviceIsConnected = true; // Virtual device is active and reflecting a physical one
+
+        // Position, velocity and angular velocity
+        for (int i = 0; i < 3; ++i) {
+          pose.vecPosition[i] = m_converted.position[i][physicalIndex];
+          pose.vecVelocity[i] = m_converted.velocity[i][physicalIndex];
+          pose.vecAngularVelocity[i] = m_converted.angularVelocity[i][physicalIndex];
+        }
+
+        // Rotation
+        pose.qRotation.w = m_converted.rotation[0][physicalIndex];
+        pose.qRotation.x = m_converted.rotation[1][physicalIndex];
+        pose.qRotation.y = m_converted.rotation[2][physicalIndex];
+        pose.qRotation.z = m_converted.rotation[3][physicalIndex];
+
+        // Driver-specific pose parameters
+        pose.poseTimeOffset = 0.f; // The calibration offsets were set once on activation
+
+        flags |= MirrorSlot_PoseValid;
+        filter[slot] = true;
+      }
+    }
+
+    if (!(flags & MirrorSlot_PoseValid)) {
+      if (m_flags[slot] & MirrorSlot_PoseValid) { // Only log the transition, not every frame
+        LogPolicy::PoseLost(slot, physicalIndex);
+      }
+      pose.poseIsValid = false;
+      pose.result = vr::TrackingResult_Running_OutOfRange;
+      pose.deviceIsConnected = true; // Virtual device is still connected
+      m_unOutOfRangeCount[slot].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if ((m_flags[slot] & MirrorSlot_PhysicalConnected) && !(flags & MirrorSlot_PhysicalConnected)) {
+      m_unDisconnectCount[slot].fetch_add(1, std::memory_order_relaxed);
+    }
+    m_unFrameCount[slot].fetch_add(1, std::memory_order_relaxed);
+    m_flags[slot] = flags;
+
+    // Judge motion on the unfiltered pose, so a smoothing filter doesn't delay the wake-up
+    if (scheduling) {
+      m_scheduler.Update(slot, pose, sampleTime);
+    }
+  }
+  if (scheduling) {
+    m_scheduler.EndSweep();
+  }
+
+  // Smooth every valid pose in one pass over the filter bank
+  FilterPolicy::Apply(m_filters, m_lastPose, filter, slotCount, timeSeconds);
+
+  for (uint32_t slot = 0; slot < slotCount; ++slot) {
+    if (!active[slot]) {
+      continue;
+    }
+
+    // Optionally extrapolate ahead to hide the mirroring latency (zeroes poseTimeOffset and the accelerations).
+    // Works on a copy so the filters and the next sweep see the unpredicted pose.
+    PublishedPose published = {m_lastPose[slot], sampleTime};
+    if (filter[slot]) {
+      PredictionPolicy::Predict(published.pose, m_flPredictionSeconds);
+    }
+    m_publishedPose[slot].Store(published);
+    if (activation[slot] != 0) {
+      m_unSweptActivationCount[slot].store(activation[slot], std::memory_order_release); // SubmitPoses may send it from here on
+    }
+    SinkPolicy::Publish(m_pExporter, slot, m_unObjectId[slot].load(std::memory_order_relaxed), m_unPhysicalIndex[slot], published.pose, sampleTime);
+  }
+  SinkPolicy::EndFrame(m_pExporter, slotCount);
+}
+
+// Policies of one entry of k_rgSweeps
+template <uint32_t unStages>
+struct MirrorSweepStages {
+  typedef typename std::conditional<(unStages & MirrorSweepStage_Filter) != 0, PoseFilterBankPolicy, NoPoseFilterPolicy>::type Filter;
+  typedef typename std::conditional<(unStages & MirrorSweepStage_Prediction) != 0, HorizonPredictionPolicy, NoPredictionPolicy>::type Prediction;
+  typedef typename std::conditional<(unStages & MirrorSweepStage_Sink) != 0, PoseExportSinkPolicy, NoPoseSinkPolicy>::type Sink;
+  typedef typename std::conditional<(unStages & MirrorSweepStage_Log) != 0, DriverSweepLogPolicy, NoSweepLogPolicy>::type Log;
+};
+
+#define MIRROR_REGISTRY_SWEEP(stages)                                                                                         \
+  &MirrorRegistry::Sweep<MirrorSweepStages<stages>::Filter, MirrorSweepStages<stages>::Prediction, MirrorSweepStages<stages>::Sink, \
+                         MirrorSweepStages<stages>::Log>
+
+const MirrorRegistry::SweepFunction MirrorRegistry::k_rgSweeps[MirrorSweepStage_Combinations] = {
+  MIRROR_REGISTRY_SWEEP(0),  MIRROR_REGISTRY_SWEEP(1),  MIRROR_REGISTRY_SWEEP(2),  MIRROR_REGISTRY_SWEEP(3),
+  MIRROR_REGISTRY_SWEEP(4),  MIRROR_REGISTRY_SWEEP(5),  MIRROR_REGISTRY_SWEEP(6),  MIRROR_REGISTRY_SWEEP(7),
+  MIRROR_REGISTRY_SWEEP(8),  MIRROR_REGISTRY_SWEEP(9),  MIRROR_REGISTRY_SWEEP(10), MIRROR_REGISTRY_SWEEP(11),
+  MIRROR_REGISTRY_SWEEP(12), MIRROR_REGISTRY_SWEEP(13), MIRROR_REGISTRY_SWEEP(14), MIRROR_REGISTRY_SWEEP(15),
+};
+
+#undef MIRROR_REGISTRY_SWEEP
+
+void MirrorRegistry::UpdatePoses(const vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount) {
+  ScopedDriverTimer timer(DriverTimer_PoseConversion);
+
+  // Re-picked every sweep, so a log level changed at runtime takes effect on the next one
+  uint32_t stages = 0;
+  if (m_filters.GetMode() != PoseFilter_Off) {
+    stages |= MirrorSweepStage_Filter;
+  }
+  if (m_flPredictionSeconds > 0.0) {
+    stages |= MirrorSweepStage_Prediction;
+  }
+  if (m_pExporter) {
+    stages |= MirrorSweepStage_Sink;
+  }
+  if (DriverLogEnabled(DriverLogLevel_Verbose, DriverLogCategory_Pose)) {
+    stages |= MirrorSweepStage_Log;
+  }
+  (this->*k_rgSweeps[stages])(pRawPoses, unRawPoseCount);
+}
+
+}  // namespace vr
@@ -1,141 +1,96 @@
 #include "my_controller_driver.h"
-#include "vrcommon/shared/driverlog.h" // For VRDriverLog
-#include "vrcommon/shared/vrmath.h" // For HmdQuaternion_Init_FromMatrix and potentially other math utilities
-#include <string> // For std::to_string
-#include <vector> // For std::vector
-
-// Define a preprocessor macro for verbose logging control, e.g., in a common header or at the top of the file
-// #define ENABLE_VERBOSE_CONTROLLER_LOGGING
-// #define ENABLE_VERY_VERBOSE_CONTROLLER_LOGGING // For per-frame pose details
-
-#include <cmath> // For sqrt, used in manual quaternion conversion if needed
+#include "driver_log.h" // For DRIVER_LOG_*
+#include "driver_stats.h" // For the timer histograms
+#include "input_mirror.h"
+#include "mirror_registry.h"
+#include "pose_calibration.h"
+#include "pose_fusion.h"
+#include <cstdio> // For snprintf/sscanf
+#include <cstring> // For strcmp
 
 namespace vr {
 
-// Helper function to decompose HmdMatrix34_t into position and rotation components
-static void DecomposeHmdMatrix34IntoPose(const vr::HmdMatrix34_t& matrix, double outVecPosition[3], vr::HmdQuaternion_t& outQRotation) {
-    // Position
-    outVecPosition[0] = matrix.m[0][3];
-    outVecPosition[1] = matrix.m[1][3];
-    outVecPosition[2] = matrix.m[2][3];
-
-    // Rotation
-    // Try using HmdQuaternion_Init_FromMatrix first, as it's expected from vrmath.h
-    outQRotation = HmdQuaternion_Init_FromMatrix(matrix);
-
-    // Manual implementation as a fallback (example, would need to be uncommented and HmdQuaternion_Init_FromMatrix call removed if it's not available)
-    /*
-    VRDriverLog()->Log("DecomposeHmdMatrix34IntoPose - Using manual matrix to quaternion conversion."); // Log if manual path is taken
-    double trace = matrix.m[0][0] + matrix.m[1][1] + matrix.m[2][2];
-    if (trace > 0.0) {
-        double s = 0.5 / sqrt(trace + 1.0);
-        outQRotation.w = 0.25 / s;
-        outQRotation.x = (matrix.m[2][1] - matrix.m[1][2]) * s;
-        outQRotation.y = (matrix.m[0][2] - matrix.m[2][0]) * s;
-        outQRotation.z = (matrix.m[1][0] - matrix.m[0][1]) * s;
-    } else {
-        if (matrix.m[0][0] > matrix.m[1][1] && matrix.m[0][0] > matrix.m[2][2]) {
-            double s = 2.0 * sqrt(1.0 + matrix.m[0][0] - matrix.m[1][1] - matrix.m[2][2]);
-            outQRotation.w = (matrix.m[2][1] - matrix.m[1][2]) / s;
-            outQRotation.x = 0.25 * s;
-            outQRotation.y = (matrix.m[0][1] + matrix.m[1][0]) / s;
-            outQRotation.z = (matrix.m[0][2] + matrix.m[2][0]) / s;
-        } else if (matrix.m[1][1] > matrix.m[2][2]) {
-            double s = 2.0 * sqrt(1.0 + matrix.m[1][1] - matrix.m[0][0] - matrix.m[2][2]);
-            outQRotation.w = (matrix.m[0][2] - matrix.m[2][0]) / s;
-            outQRotation.x = (matrix.m[0][1] + matrix.m[1][0]) / s;
-            outQRotation.y = 0.25 * s;
-            outQRotation.z = (matrix.m[1][2] + matrix.m[2][1]) / s;
-        } else {
-            double s = 2.0 * sqrt(1.0 + matrix.m[2][2] - matrix.m[0][0] - matrix.m[1][1]);
-            outQRotation.w = (matrix.m[1][0] - matrix.m[0][1]) / s;
-            outQRotation.x = (matrix.m[0][2] + matrix.m[2][0]) / s;
-            outQRotation.y = (matrix.m[1][2] + matrix.m[2][1]) / s;
-            outQRotation.z = 0.25 * s;
-        }
-    }
-    // Normalize quaternion if necessary (HmdQuaternion_Init_FromMatrix should handle this)
-    // double norm = sqrt(outQRotation.x * outQRotation.x + outQRotation.y * outQRotation.y + outQRotation.z * outQRotation.z + outQRotation.w * outQRotation.w);
-    // if (norm > 0) {
-    //    outQRotation.x /= norm; outQRotation.y /= norm; outQRotation.z /= norm; outQRotation.w /= norm;
-    // }
-    */
-}
-
-MyControllerDriver::MyControllerDriver()
+MyControllerDriver::MyControllerDriver(MirrorRegistry* pRegistry, InputMirror* pInput, uint32_t unSlot, const char* pchSerial, int32_t nControllerRole)
     : m_unObjectId(vr::k_unTrackedDeviceIndexInvalid),
-      m_unPhysicalControllerIndex(vr::k_unTrackedDeviceIndexInvalid) {
-#ifdef ENABLE_VERBOSE_CONTROLLER_LOGGING
-  VRDriverLog()->Log("MyControllerDriver::MyControllerDriver - Constructor called.");
-#endif
-  // Initialize m_lastPose to a default disconnected state
-  m_lastPose.poseIsValid = false;
-  m_lastPose.result = vr::TrackingResult_Uninitialized;
-  m_lastPose.deviceIsConnected = false; // Initially false
-
-  m_lastPose.qWorldFromDriverRotation = {1.0, 0.0, 0.0, 0.0};
-  m_lastPose.qDriverFromHeadRotation = {1.0, 0.0, 0.0, 0.0};
-
-  for (int i = 0; i < 3; ++i) {
-    m_lastPose.vecPosition[i] = 0.0;
-    m_lastPose.vecVelocity[i] = 0.0;
-    m_lastPose.vecAcceleration[i] = 0.0;
-    m_lastPose.vecAngularVelocity[i] = 0.0;
-    m_lastPose.vecAngularAcceleration[i] = 0.0;
-    m_lastPose.vecWorldFromDriverTranslation[i] = 0.0;
-  }
-  m_lastPose.qRotation = {1.0, 0.0, 0.0, 0.0};
-  m_lastPose.poseTimeOffset = 0.0;
-  // m_lastPose.willDriftInYaw = false; // Already defaults to false
-  // m_lastPose.shouldApplyHeadModel = false; // Already defaults to false
+      m_pRegistry(pRegistry),
+      m_pInput(pInput),
+      m_unSlot(unSlot),
+      m_sSerial(pchSerial),
+      m_nControllerRole(nControllerRole) {
+  DRIVER_LOG_VERBOSE(DriverLogCategory_Device, "MyControllerDriver::MyControllerDriver - Constructor called for slot {}", unSlot);
 }
 
 MyControllerDriver::~MyControllerDriver() {
-#ifdef ENABLE_VERBOSE_CONTROLLER_LOGGING
-    VRDriverLog()->Log("MyControllerDriver::~MyControllerDriver - Destructor for ObjectId: " + std::to_string(m_unObjectId));
-#endif
-}
-
-void MyControllerDriver::SetPhysicalControllerIndex(uint32_t index) {
-    VRDriverLog()->Log("MyControllerDriver::SetPhysicalControllerIndex - ObjectId: " + std::to_string(m_unObjectId) + ", PhysicalIndex: " + std::to_string(index));
-    m_unPhysicalControllerIndex = index;
+  DRIVER_LOG_VERBOSE(DriverLogCategory_Device, "MyControllerDriver::~MyControllerDriver - Destructor for ObjectId: {}", m_unObjectId);
 }
 
 vr::EVRInitError MyControllerDriver::Activate(uint32_t unObjectId) {
-  VRDriverLog()->Log("MyControllerDriver::Activate - Activating controller with ObjectId: " + std::to_string(unObjectId));
+  DRIVER_LOG_INFO(DriverLogCategory_Device, "MyControllerDriver::Activate - Activating controller with ObjectId: {}", unObjectId);
   m_unObjectId = unObjectId;
 
-  // Initialize properties or query them from the physical device if necessary
-  // Example: vr::VRProperties()->SetStringProperty(m_ulPropertyContainer, Prop_SerialNumber_String, "my-virtual-controller-123");
-  // Check errors for property settings.
+  // Input components need a profile for SteamVR to bind them; create them once, the handles live in m_pInput
+  if (m_pInput) {
+    vr::PropertyContainerHandle_t container = vr::VRProperties()->TrackedDeviceToPropertyContainer(m_unObjectId);
+    vr::VRProperties()->SetStringProperty(container, vr::Prop_ControllerType_String, "mydriver_mirror");
+    vr::VRProperties()->SetStringProperty(container, vr::Prop_InputProfilePath_String, "{mydriver}/input/mirror_controller_profile.json");
+    vr::VRProperties()->SetInt32Property(container, vr::Prop_ControllerRoleHint_Int32, m_nControllerRole); // SetControllerRole keeps it current
+    if (!m_pInput->CreateComponents(m_unSlot, container, m_nControllerRole)) {
+      DRIVER_LOG_WARNING(DriverLogCategory_Device, "MyControllerDriver::Activate - Some input components for ObjectId {} could not be created", m_unObjectId);
+    }
+  }
+
+  // Fixed offsets for this device, handed to the host inside every pose from here on
+  const DriverPoseCalibration calibration = ReadDeviceCalibration(m_sSerial.c_str());
+  if (!IsIdentityPoseCalibration(calibration)) {
+    DRIVER_LOG_INFO(DriverLogCategory_Device, "MyControllerDriver::Activate - Applying calibration for {}: worldFromDriver t=({}, {}, {}), driverFromHead t=({}, {}, {})",
+                    m_sSerial.c_str(), calibration.worldFromDriver.vecTranslation[0], calibration.worldFromDriver.vecTranslation[1],
+                    calibration.worldFromDriver.vecTranslation[2], calibration.driverFromHead.vecTranslation[0],
+                    calibration.driverFromHead.vecTranslation[1], calibration.driverFromHead.vecTranslation[2]);
+  }
+
+  // Other physical devices rigidly attached to this one, e.g. a tracker mounted on the controller
+  PoseFusionSource fusionSources[k_unMaxPoseFusionSources - 1];
+  const uint32_t fusionSourceCount = ReadDeviceFusionSources(m_sSerial.c_str(), fusionSources, k_unMaxPoseFusionSources - 1);
+  for (uint32_t i = 0; i < fusionSourceCount; ++i) {
+    DRIVER_LOG_INFO(DriverLogCategory_Device, "MyControllerDriver::Activate - Fusing device index {} into {}, offset t=({}, {}, {})",
+                    fusionSources[i].unPhysicalIndex, m_sSerial.c_str(), fusionSources[i].offset.vecTranslation[0],
+                    fusionSources[i].offset.vecTranslation[1], fusionSources[i].offset.vecTranslation[2]);
+  }
+  m_pRegistry->SetFusionSources(m_unSlot, fusionSources, fusionSourceCount);
 
-  // When the device is activated, it's considered connected from the driver's perspective.
-  // The actual tracking state (poseIsValid, result) will be updated in RunFrame.
-  m_lastPose.deviceIsConnected = true;
+  // The slot joins the registry's per-frame sweeps from here on
+  m_pRegistry->ActivateSlot(m_unSlot, m_unObjectId, calibration);
 
-  VRDriverLog()->Log("MyControllerDriver::Activate - Controller activated with ObjectId: " + std::to_string(m_unObjectId));
+  DRIVER_LOG_INFO(DriverLogCategory_Device, "MyControllerDriver::Activate - Controller activated with ObjectId: {}", m_unObjectId);
   return vr::VRInitError_None;
 }
 
 void MyControllerDriver::Deactivate() {
-  VRDriverLog()->Log("MyControllerDriver::Deactivate - Deactivating controller with ObjectId: " + std::to_string(m_unObjectId));
+  DRIVER_LOG_INFO(DriverLogCategory_Device, "MyControllerDriver::Deactivate - Deactivating controller with ObjectId: {}", m_unObjectId);
   // Clean up resources, if any were allocated in Activate or during operation
+  m_pRegistry->DeactivateSlot(m_unSlot);
+  if (m_pInput) {
+    m_pInput->ReleaseComponents(m_unSlot);
+  }
   m_unObjectId = vr::k_unTrackedDeviceIndexInvalid; // Mark as invalid
 }
 
 void MyControllerDriver::EnterStandby() {
-  VRDriverLog()->Log("MyControllerDriver::EnterStandby - Controller with ObjectId: " + std::to_string(m_unObjectId) + " entering standby.");
+  DRIVER_LOG_INFO(DriverLogCategory_Device, "MyControllerDriver::EnterStandby - Controller with ObjectId: {} entering standby.", m_unObjectId);
   // For a controller, this might mean reducing update rates or preparing for power saving.
-  // The pose should reflect that it's in standby (e.g., poseIsValid = false, result = TrackingResult_Uninitialized).
-  m_lastPose.poseIsValid = false;
-  m_lastPose.result = vr::TrackingResult_Uninitialized;
-  // Keep deviceIsConnected true if it's just standby, or false if it should appear disconnected.
-  // Let's assume it remains connected but not tracking.
-  m_lastPose.deviceIsConnected = true;
+  m_pRegistry->EnterStandby(m_unSlot);
+}
+
+void MyControllerDriver::SetControllerRole(int32_t nControllerRole) {
+  m_nControllerRole = nControllerRole;
+  if (m_unObjectId == vr::k_unTrackedDeviceIndexInvalid) {
+    return; // Activate picks the role up
+  }
 
-  // It's good practice to also inform the host that the pose was updated due to standby.
-  if (m_unObjectId != vr::k_unTrackedDeviceIndexInvalid) {
-      vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_unObjectId, m_lastPose, sizeof(vr::DriverPose_t));
+  vr::PropertyContainerHandle_t container = vr::VRProperties()->TrackedDeviceToPropertyContainer(m_unObjectId);
+  vr::VRProperties()->SetInt32Property(container, vr::Prop_ControllerRoleHint_Int32, nControllerRole);
+  if (m_pInput && m_pInput->SetHand(m_unSlot, container, nControllerRole)) {
+    DRIVER_LOG_INFO(DriverLogCategory_Device, "MyControllerDriver::SetControllerRole - Skeleton of ObjectId {} follows role {}", m_unObjectId, nControllerRole);
   }
 }
 
@@ -146,119 +101,110 @@ void* MyControllerDriver::GetComponent(const char* pchComponentNameAndVersion) {
 
 void MyControllerDriver::DebugRequest(const char* pchRequest, char* pchResponseBuffer, uint32_t unResponseBufferSize) {
   // Handle debug requests
-  if (unResponseBufferSize > 0) {
-    pchResponseBuffer[0] = '\0';
+  if (unResponseBufferSize == 0) {
+    return;
   }
-}
-
-vr::DriverPose_t MyControllerDriver::GetPose() {
-#ifdef ENABLE_VERBOSE_CONTROLLER_LOGGING
-    VRDriverLog()->Log("MyControllerDriver::GetPose - Called for ObjectId: " + std::to_string(m_unObjectId));
-#endif
-  return m_lastPose;
-}
-
-void MyControllerDriver::RunFrame() {
-#ifdef ENABLE_VERBOSE_CONTROLLER_LOGGING
-    if (m_unObjectId != vr::k_unTrackedDeviceIndexInvalid) { // Avoid logging if not yet activated
-        VRDriverLog()->Log("MyControllerDriver::RunFrame - Called for ObjectId: " + std::to_string(m_unObjectId));
+  pchResponseBuffer[0] = '\0';
+
+  if (pchRequest && strcmp(pchRequest, "submit_counters") == 0) {
+    // How many pose updates went to the host vs. were skipped by change detection
+    snprintf(pchResponseBuffer, unResponseBufferSize, "{\"sent\":%llu,\"suppressed\":%llu}",
+             (unsigned long long)m_pRegistry->GetSentCount(m_unSlot), (unsigned long long)m_pRegistry->GetSuppressedCount(m_unSlot));
+  } else if (pchRequest && strcmp(pchRequest, "stats") == 0) {
+    // Driver-wide hot-path timings plus this device's counters
+    const MirrorSlotCounters counters = m_pRegistry->GetCounters(m_unSlot);
+    size_t used = AppendJson(pchResponseBuffer, unResponseBufferSize, 0, "{\"timers\":");
+    used = AppendDriverTimersJson(pchResponseBuffer, unResponseBufferSize, used);
+    used = AppendJson(pchResponseBuffer, unResponseBufferSize, used,
+                      ",\"device\":{\"slot\":%u,\"physical_index\":%u,\"frames\":%llu,\"invalid_poses\":%llu,\"disconnects\":%llu,"
+                      "\"out_of_range\":%llu,\"sent\":%llu,\"suppressed\":%llu,\"input_updates\":%llu,\"haptics\":%llu,\"activity\":%d}}",
+                      m_unSlot, m_pRegistry->GetPhysicalIndex(m_unSlot), (unsigned long long)counters.unFrames,
+                      (unsigned long long)counters.unInvalidPoses, (unsigned long long)counters.unDisconnects,
+                      (unsigned long long)counters.unOutOfRange, (unsigned long long)counters.unSent, (unsigned long long)counters.unSuppressed,
+                      (unsigned long long)(m_pInput ? m_pInput->GetUpdateCount(m_unSlot) : 0),
+                      (unsigned long long)(m_pInput ? m_pInput->GetHapticCount(m_unSlot) : 0),
+                      (int)m_pRegistry->GetUpdateScheduler().GetActivity(m_unSlot));
+  } else if (pchRequest && strcmp(pchRequest, "reset_stats") == 0) {
+    // Clears the timers and the counters of every device, not just this one
+    ResetDriverTimers();
+    m_pRegistry->ResetCounters();
+    if (m_pInput) {
+      m_pInput->ResetCounters();
     }
-#endif
-
-  if (m_unObjectId == vr::k_unTrackedDeviceIndexInvalid) {
-    return; // Not activated yet
-  }
-
-  bool physical_pose_retrieved = false;
-
-#ifdef ENABLE_VERY_VERBOSE_CONTROLLER_LOGGING
-  VRDriverLog()->Log("MyControllerDriver::RunFrame - Calling GetRawTrackedDevicePoses for ObjectId: " + std::to_string(m_unObjectId));
-#endif
-  // Use GetRawTrackedDevicePoses
-  std::vector<vr::TrackedDevicePose_t> vecPoseBuffer(vr::k_unMaxTrackedDeviceCount);
-  vr::VRServerDriverHost()->GetRawTrackedDevicePoses(0.f, vecPoseBuffer.data(), (uint32_t)vecPoseBuffer.size());
-
-  if (m_unPhysicalControllerIndex != vr::k_unTrackedDeviceIndexInvalid && m_unPhysicalControllerIndex < vr::k_unMaxTrackedDeviceCount) {
-    const vr::TrackedDevicePose_t& physicalDevicePose = vecPoseBuffer[m_unPhysicalControllerIndex];
-
-    if (!physicalDevicePose.bDeviceIsConnected) {
-#ifdef ENABLE_VERY_VERBOSE_CONTROLLER_LOGGING
-        VRDriverLog()->Log("MyControllerDriver::RunFrame - Physical controller (idx " + std::to_string(m_unPhysicalControllerIndex) + ") for ObjectId: " + std::to_string(m_unObjectId) + " reported bDeviceIsConnected=false.");
-#endif
+    snprintf(pchResponseBuffer, unResponseBufferSize, "{\"reset\":true}");
+  } else if (pchRequest && m_pInput && strncmp(pchRequest, "input ", 6) == 0) {
+    // "input <button mask> [axis values...]" publishes an input state as if the physical device had, for checking bindings
+    static_assert(MirrorAxis_Count == 6, "Update the format below");
+    MirrorInputState state = {};
+    float* axes = state.flAxes;
+    if (sscanf(pchRequest + 6, "%x %f %f %f %f %f %f", &state.unButtons, &axes[0], &axes[1], &axes[2], &axes[3], &axes[4], &axes[5]) >= 1) {
+      state.sampleTime = std::chrono::steady_clock::now();
+      m_pInput->PublishInputState(m_unSlot, state);
     }
-    if (!physicalDevicePose.bPoseIsValid) {
-#ifdef ENABLE_VERY_VERBOSE_CONTROLLER_LOGGING
-        VRDriverLog()->Log("MyControllerDriver::RunFrame - Physical controller (idx " + std::to_string(m_unPhysicalControllerIndex) + ") for ObjectId: " + std::to_string(m_unObjectId) + " reported bPoseIsValid=false.");
-#endif
+    snprintf(pchResponseBuffer, unResponseBufferSize, "{\"buttons\":%u,\"updates\":%llu}", state.unButtons,
+             (unsigned long long)m_pInput->GetUpdateCount(m_unSlot));
+  } else if (pchRequest && strncmp(pchRequest, "solve_calibration ", 18) == 0) {
+    // "solve_calibration <mount|world> <reference index> <recording path>" fits this device's offset against a
+    // reference device from a recordPath recording, stores it in the calibration section and applies it
+    char kind[8] = {};
+    uint32_t referenceIndex = vr::k_unTrackedDeviceIndexInvalid;
+    int pathStart = 0;
+    PoseOffset offset;
+    double rmsPosition = 0.0;
+    double rmsRotation = 0.0;
+    if (sscanf(pchRequest + 18, "%7s %u %n", kind, &referenceIndex, &pathStart) < 2 || pathStart == 0 ||
+        (strcmp(kind, "mount") != 0 && strcmp(kind, "world") != 0)) {
+      snprintf(pchResponseBuffer, unResponseBufferSize, "{\"solved\":false,\"error\":\"usage: solve_calibration <mount|world> <reference index> <recording path>\"}");
+      return;
+    }
+    const bool worldFromDriver = strcmp(kind, "world") == 0;
+    if (!SolveOffsetFromRecording(pchRequest + 18 + pathStart, m_pRegistry->GetPhysicalIndex(m_unSlot), referenceIndex, worldFromDriver, offset,
+                                  &rmsPosition, &rmsRotation)) {
+      snprintf(pchResponseBuffer, unResponseBufferSize, "{\"solved\":false,\"error\":\"no usable pose pairs\"}");
+      return;
     }
 
-    if (physicalDevicePose.bDeviceIsConnected && physicalDevicePose.bPoseIsValid) {
-#ifdef ENABLE_VERY_VERBOSE_CONTROLLER_LOGGING // Changed to VERY_VERBOSE for this level of detail
-      VRDriverLog()->Log("MyControllerDriver::RunFrame - Successfully updated m_lastPose from physical controller (idx " + std::to_string(m_unPhysicalControllerIndex) + ") for ObjectId: " + std::to_string(m_unObjectId));
-#endif
-      m_lastPose.poseIsValid = physicalDevicePose.bPoseIsValid;
-      m_lastPose.result = physicalDevicePose.eTrackingResult;
-      m_lastPose.deviceIsConnected = true; // Virtual device is active and reflecting a physical one
-
-      // Decompose matrix into position and rotation
-      DecomposeHmdMatrix34IntoPose(physicalDevicePose.mDeviceToAbsoluteTracking, m_lastPose.vecPosition, m_lastPose.qRotation);
-
-      // Velocity
-      m_lastPose.vecVelocity[0] = physicalDevicePose.vVelocity.v[0];
-      m_lastPose.vecVelocity[1] = physicalDevicePose.vVelocity.v[1];
-      m_lastPose.vecVelocity[2] = physicalDevicePose.vVelocity.v[2];
-
-      // Angular Velocity
-      m_lastPose.vecAngularVelocity[0] = physicalDevicePose.vAngularVelocity.v[0];
-      m_lastPose.vecAngularVelocity[1] = physicalDevicePose.vAngularVelocity.v[1];
-      m_lastPose.vecAngularVelocity[2] = physicalDevicePose.vAngularVelocity.v[2];
-
-      // Driver-specific pose parameters
-      m_lastPose.poseTimeOffset = 0.f;
-      m_lastPose.qWorldFromDriverRotation = {1.0, 0.0, 0.0, 0.0};
-      m_lastPose.vecWorldFromDriverTranslation[0] = 0.0;
-      m_lastPose.vecWorldFromDriverTranslation[1] = 0.0;
-      m_lastPose.vecWorldFromDriverTranslation[2] = 0.0;
-      m_lastPose.qDriverFromHeadRotation = {1.0, 0.0, 0.0, 0.0};
-
-      physical_pose_retrieved = true;
+    // Stored like a hand-written calibration, so it also applies from the next activation on
+    WriteDeviceCalibrationOffset(m_sSerial.c_str(), worldFromDriver, offset);
+    if (m_unObjectId != vr::k_unTrackedDeviceIndexInvalid) {
+      m_pRegistry->ActivateSlot(m_unSlot, m_unObjectId, ReadDeviceCalibration(m_sSerial.c_str()));
     }
-  } else { // m_unPhysicalControllerIndex is invalid or out of bounds
-#ifdef ENABLE_VERBOSE_CONTROLLER_LOGGING
-    if (m_unObjectId != vr::k_unTrackedDeviceIndexInvalid) { // Should always be valid here
-      if (m_unPhysicalControllerIndex == vr::k_unTrackedDeviceIndexInvalid) {
-        // This case is normal if no physical controller is assigned.
-        // Might be too spammy to log every frame, consider logging it once or less frequently.
-        // For now, let's make it very verbose or remove for this specific sub-condition.
-#ifdef ENABLE_VERY_VERBOSE_CONTROLLER_LOGGING
-        VRDriverLog()->Log("MyControllerDriver::RunFrame - ObjectId: " + std::to_string(m_unObjectId) + " has no valid physical controller index assigned.");
-#endif
-      } else { // Index is out of bounds
-        VRDriverLog()->Log("MyControllerDriver::RunFrame - ObjectId: " + std::to_string(m_unObjectId) + " - m_unPhysicalControllerIndex " + std::to_string(m_unPhysicalControllerIndex) + " is out of bounds. Cannot use physical pose.");
+    DRIVER_LOG_INFO(DriverLogCategory_Device, "MyControllerDriver::DebugRequest - Solved {} of {}: t=({}, {}, {}), rms {} m / {} rad",
+                    worldFromDriver ? "worldFromDriver" : "driverFromHead", m_sSerial.c_str(), offset.vecTranslation[0], offset.vecTranslation[1],
+                    offset.vecTranslation[2], rmsPosition, rmsRotation);
+    snprintf(pchResponseBuffer, unResponseBufferSize,
+             "{\"solved\":true,\"rotation\":[%.9g,%.9g,%.9g,%.9g],\"translation\":[%.9g,%.9g,%.9g],\"rms_position\":%.9g,\"rms_rotation\":%.9g}",
+             offset.qRotation.w, offset.qRotation.x, offset.qRotation.y, offset.qRotation.z, offset.vecTranslation[0], offset.vecTranslation[1],
+             offset.vecTranslation[2], rmsPosition, rmsRotation);
+  } else if (pchRequest && strncmp(pchRequest, "log_level", 9) == 0) {
+    // "log_level <0-4>" changes the driver log verbosity of every category at runtime, "log_level <category> <0-4>"
+    // that of one category, and "log_level" alone just reports
+    char categoryName[32];
+    int level = 0;
+    EDriverLogCategory category;
+    if (sscanf(pchRequest + 9, "%d", &level) == 1) {
+      if (level >= DriverLogLevel_Error && level <= DriverLogLevel_Trace) {
+        DriverLogSetLevel((EDriverLogLevel)level);
       }
+    } else if (sscanf(pchRequest + 9, "%31s %d", categoryName, &level) == 2 && DriverLogFindCategory(categoryName, category) &&
+               level >= DriverLogLevel_Error && level <= DriverLogLevel_Trace) {
+      DriverLogSetCategoryLevel(category, (EDriverLogLevel)level);
     }
-#endif
-  }
 
-  if (!physical_pose_retrieved) {
-#ifdef ENABLE_VERBOSE_CONTROLLER_LOGGING
-    // Differentiate message based on why pose wasn't retrieved
-    if (m_unPhysicalControllerIndex != vr::k_unTrackedDeviceIndexInvalid && m_unPhysicalControllerIndex < vr::k_unMaxTrackedDeviceCount) {
-        // We had a valid index, but the pose from it was not usable (disconnected or invalid)
-        VRDriverLog()->Log("MyControllerDriver::RunFrame - ObjectId: " + std::to_string(m_unObjectId) + " - Physical controller (idx " + std::to_string(m_unPhysicalControllerIndex) + ") data not used (e.g., disconnected or pose invalid). Falling back to out_of_range pose for virtual controller.");
-    } else {
-        // The physical index itself was the problem (either k_unTrackedDeviceIndexInvalid or out of bounds)
-        // This case is already logged above, so a more generic fallback message here.
-        VRDriverLog()->Log("MyControllerDriver::RunFrame - ObjectId: " + std::to_string(m_unObjectId) + " - No valid physical pose retrieved. Falling back to out_of_range pose for virtual controller.");
+    int written = snprintf(pchResponseBuffer, unResponseBufferSize, "{\"levels\":{");
+    for (uint32_t i = 0; i < DriverLogCategory_Count && written > 0 && (uint32_t)written < unResponseBufferSize; ++i) {
+      written += snprintf(pchResponseBuffer + written, unResponseBufferSize - written, "%s\"%s\":%u", i > 0 ? "," : "",
+                          DriverLogGetCategoryName((EDriverLogCategory)i), (unsigned)g_rgDriverLogLevel[i].load(std::memory_order_relaxed));
+    }
+    if (written > 0 && (uint32_t)written < unResponseBufferSize) {
+      snprintf(pchResponseBuffer + written, unResponseBufferSize - written, "},\"dropped\":%llu}", (unsigned long long)DriverLogGetDroppedCount());
     }
-#endif
-    m_lastPose.poseIsValid = false;
-    m_lastPose.result = vr::TrackingResult_Running_OutOfRange;
-    m_lastPose.deviceIsConnected = true; // Virtual device is still connected
   }
+}
 
-
-  vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_unObjectId, m_lastPose, sizeof(vr::DriverPose_t));
+vr::DriverPose_t MyControllerDriver::GetPose() {
+  DRIVER_LOG_TRACE(DriverLogCategory_Device, "MyControllerDriver::GetPose - Called for ObjectId: {}", m_unObjectId);
+  return m_pRegistry->GetPose(m_unSlot);
 }
 
 }  // namespace vr
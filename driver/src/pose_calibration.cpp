@@ -0,0 +1,328 @@
+#include "pose_calibration.h"
+#include "driver_log.h"
+#include "driver_settings.h"
+#include "pose_conversion.h"
+#include "pose_recording.h"
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vr {
+
+PoseOffset IdentityPoseOffset() {
+  PoseOffset offset;
+  offset.qRotation = {1.0, 0.0, 0.0, 0.0};
+  offset.vecTranslation[0] = 0.0;
+  offset.vecTranslation[1] = 0.0;
+  offset.vecTranslation[2] = 0.0;
+  return offset;
+}
+
+DriverPoseCalibration IdentityPoseCalibration() {
+  return {IdentityPoseOffset(), IdentityPoseOffset()};
+}
+
+static bool IsIdentityPoseOffset(const PoseOffset& offset) {
+  return offset.qRotation.w == 1.0 && offset.qRotation.x == 0.0 && offset.qRotation.y == 0.0 && offset.qRotation.z == 0.0 &&
+         offset.vecTranslation[0] == 0.0 && offset.vecTranslation[1] == 0.0 && offset.vecTranslation[2] == 0.0;
+}
+
+bool IsIdentityPoseCalibration(const DriverPoseCalibration& calibration) {
+  return IsIdentityPoseOffset(calibration.worldFromDriver) && IsIdentityPoseOffset(calibration.driverFromHead);
+}
+
+void ReadPoseOffset(const char* pchSection, const char* pchRotationKey, const char* pchTranslationKey, PoseOffset& offset) {
+  char rotationText[128];
+  char translationText[128];
+  vr::EVRSettingsError rotationError = vr::VRSettingsError_None;
+  vr::EVRSettingsError translationError = vr::VRSettingsError_None;
+  vr::VRSettings()->GetString(pchSection, pchRotationKey, rotationText, sizeof(rotationText), &rotationError);
+  vr::VRSettings()->GetString(pchSection, pchTranslationKey, translationText, sizeof(translationText), &translationError);
+
+  PoseOffset parsed = IdentityPoseOffset();
+  const bool hasRotation = rotationError == vr::VRSettingsError_None && rotationText[0] != '\0';
+  const bool hasTranslation = translationError == vr::VRSettingsError_None && translationText[0] != '\0';
+  if (hasRotation && sscanf(rotationText, "%lf %lf %lf %lf", &parsed.qRotation.w, &parsed.qRotation.x, &parsed.qRotation.y, &parsed.qRotation.z) != 4) {
+    DRIVER_LOG_WARNING(DriverLogCategory_Device, "ReadPoseOffset - Ignoring malformed {} in {}", pchRotationKey, pchSection);
+    return;
+  }
+  if (hasTranslation && sscanf(translationText, "%lf %lf %lf", &parsed.vecTranslation[0], &parsed.vecTranslation[1], &parsed.vecTranslation[2]) != 3) {
+    DRIVER_LOG_WARNING(DriverLogCategory_Device, "ReadPoseOffset - Ignoring malformed {} in {}", pchTranslationKey, pchSection);
+    return;
+  }
+
+  const double norm = sqrt(parsed.qRotation.w * parsed.qRotation.w + parsed.qRotation.x * parsed.qRotation.x +
+                           parsed.qRotation.y * parsed.qRotation.y + parsed.qRotation.z * parsed.qRotation.z);
+  if (norm < 1e-6) {
+    DRIVER_LOG_WARNING(DriverLogCategory_Device, "ReadPoseOffset - Ignoring zero rotation {} in {}", pchRotationKey, pchSection);
+    return;
+  }
+  parsed.qRotation.w /= norm;
+  parsed.qRotation.x /= norm;
+  parsed.qRotation.y /= norm;
+  parsed.qRotation.z /= norm;
+  offset = parsed;
+}
+
+DriverPoseCalibration ReadDeviceCalibration(const char* pchSerial) {
+  DriverPoseCalibration calibration = IdentityPoseCalibration();
+  const std::string section = std::string(k_pch_MyDriver_CalibrationSectionPrefix) + pchSerial;
+  ReadPoseOffset(section.c_str(), k_pch_MyDriver_Calibration_WorldFromDriverRotation_String,
+                 k_pch_MyDriver_Calibration_WorldFromDriverTranslation_String, calibration.worldFromDriver);
+  ReadPoseOffset(section.c_str(), k_pch_MyDriver_Calibration_DriverFromHeadRotation_String,
+                 k_pch_MyDriver_Calibration_DriverFromHeadTranslation_String, calibration.driverFromHead);
+  return calibration;
+}
+
+void WriteDeviceCalibrationOffset(const char* pchSerial, bool bWorldFromDriver, const PoseOffset& offset) {
+  const std::string section = std::string(k_pch_MyDriver_CalibrationSectionPrefix) + pchSerial;
+  char rotationText[128];
+  char translationText[128];
+  snprintf(rotationText, sizeof(rotationText), "%.9g %.9g %.9g %.9g", offset.qRotation.w, offset.qRotation.x, offset.qRotation.y, offset.qRotation.z);
+  snprintf(translationText, sizeof(translationText), "%.9g %.9g %.9g", offset.vecTranslation[0], offset.vecTranslation[1], offset.vecTranslation[2]);
+  vr::VRSettings()->SetString(section.c_str(), bWorldFromDriver ? k_pch_MyDriver_Calibration_WorldFromDriverRotation_String
+                                                                : k_pch_MyDriver_Calibration_DriverFromHeadRotation_String, rotationText);
+  vr::VRSettings()->SetString(section.c_str(), bWorldFromDriver ? k_pch_MyDriver_Calibration_WorldFromDriverTranslation_String
+                                                                : k_pch_MyDriver_Calibration_DriverFromHeadTranslation_String, translationText);
+}
+
+void ApplyPoseCalibration(vr::DriverPose_t& pose, const DriverPoseCalibration& calibration) {
+  pose.qWorldFromDriverRotation = calibration.worldFromDriver.qRotation;
+  pose.qDriverFromHeadRotation = calibration.driverFromHead.qRotation;
+  for (int i = 0; i < 3; ++i) {
+    pose.vecWorldFromDriverTranslation[i] = calibration.worldFromDriver.vecTranslation[i];
+    pose.vecDriverFromHeadTranslation[i] = calibration.driverFromHead.vecTranslation[i];
+  }
+}
+
+// Solver
+
+namespace {
+
+enum EOffsetKind {
+  Offset_DriverFromHead, // reference = device * X
+  Offset_WorldFromDriver, // reference = X * device
+};
+
+void QuatMultiply(const double a[4], const double b[4], double out[4]) {
+  out[0] = a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3];
+  out[1] = a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2];
+  out[2] = a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1];
+  out[3] = a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0];
+}
+
+void QuatRotateVector(const double q[4], const double v[3], double out[3]) {
+  // v + 2w (u x v) + 2 u x (u x v), u = (x, y, z)
+  const double cx = q[2] * v[2] - q[3] * v[1];
+  const double cy = q[3] * v[0] - q[1] * v[2];
+  const double cz = q[1] * v[1] - q[2] * v[0];
+  out[0] = v[0] + 2.0 * (q[0] * cx + q[2] * cz - q[3] * cy);
+  out[1] = v[1] + 2.0 * (q[0] * cy + q[3] * cx - q[1] * cz);
+  out[2] = v[2] + 2.0 * (q[0] * cz + q[1] * cy - q[2] * cx);
+}
+
+// One usable pose pair, converted to doubles
+struct PosePair {
+  double deviceRotation[4];
+  double devicePosition[3];
+  double referenceRotation[4];
+  double referencePosition[3];
+};
+
+// Calls visit(pair) for every pair where both poses are valid, converting in PoseConversionBatch-sized chunks
+template <typename Visitor>
+uint32_t ForEachPosePair(const vr::TrackedDevicePose_t* pDevicePoses, const vr::TrackedDevicePose_t* pReferencePoses, uint32_t unCount, Visitor visit) {
+  // Per call, so concurrent solves don't share scratch; on the heap, as it's too big for the stack of a host callback.
+  // Solving is offline, so the allocation doesn't matter.
+  const std::unique_ptr<PoseConversionBatch[]> batches(new PoseConversionBatch[2]);
+  PoseConversionBatch& deviceBatch = batches[0];
+  PoseConversionBatch& referenceBatch = batches[1];
+  uint32_t used = 0;
+  for (uint32_t start = 0; start < unCount; start += PoseConversionBatch::k_unCapacity) {
+    const uint32_t chunk = unCount - start < PoseConversionBatch::k_unCapacity ? unCount - start : PoseConversionBatch::k_unCapacity;
+    ConvertRawPoses(pDevicePoses + start, chunk, deviceBatch);
+    ConvertRawPoses(pReferencePoses + start, chunk, referenceBatch);
+    for (uint32_t i = 0; i < chunk; ++i) {
+      if (!pDevicePoses[start + i].bPoseIsValid || !pReferencePoses[start + i].bPoseIsValid) {
+        continue;
+      }
+      PosePair pair;
+      for (int k = 0; k < 4; ++k) {
+        pair.deviceRotation[k] = deviceBatch.rotation[k][i];
+        pair.referenceRotation[k] = referenceBatch.rotation[k][i];
+      }
+      for (int k = 0; k < 3; ++k) {
+        pair.devicePosition[k] = deviceBatch.position[k][i];
+        pair.referencePosition[k] = referenceBatch.position[k][i];
+      }
+      visit(pair);
+      ++used;
+    }
+  }
+  return used;
+}
+
+// Rotation sample of one pair: conj(device) * reference, or reference * conj(device)
+void PairRotation(const PosePair& pair, EOffsetKind eKind, double out[4]) {
+  const double deviceConj[4] = {pair.deviceRotation[0], -pair.deviceRotation[1], -pair.deviceRotation[2], -pair.deviceRotation[3]};
+  if (eKind == Offset_DriverFromHead) {
+    QuatMultiply(deviceConj, pair.referenceRotation, out);
+  } else {
+    QuatMultiply(pair.referenceRotation, deviceConj, out);
+  }
+}
+
+// Translation sample of one pair, given the solved rotation
+void PairTranslation(const PosePair& pair, EOffsetKind eKind, const double rotation[4], double out[3]) {
+  if (eKind == Offset_DriverFromHead) {
+    // Reference position relative to the device, in the device's frame
+    const double deviceConj[4] = {pair.deviceRotation[0], -pair.deviceRotation[1], -pair.deviceRotation[2], -pair.deviceRotation[3]};
+    const double delta[3] = {pair.referencePosition[0] - pair.devicePosition[0], pair.referencePosition[1] - pair.devicePosition[1],
+                             pair.referencePosition[2] - pair.devicePosition[2]};
+    QuatRotateVector(deviceConj, delta, out);
+  } else {
+    double rotated[3];
+    QuatRotateVector(rotation, pair.devicePosition, rotated);
+    for (int k = 0; k < 3; ++k) {
+      out[k] = pair.referencePosition[k] - rotated[k];
+    }
+  }
+}
+
+bool SolveOffset(const vr::TrackedDevicePose_t* pDevicePoses, const vr::TrackedDevicePose_t* pReferencePoses, uint32_t unCount, EOffsetKind eKind,
+                 PoseOffset& outOffset, double* pflRmsPositionError, double* pflRmsRotationError) {
+  // Rotation: principal eigenvector of sum(q q^T), which is sign-agnostic (q and -q are the same rotation)
+  double scatter[4][4] = {};
+  double seed[4] = {1.0, 0.0, 0.0, 0.0};
+  const uint32_t used = ForEachPosePair(pDevicePoses, pReferencePoses, unCount, [&](const PosePair& pair) {
+    double q[4];
+    PairRotation(pair, eKind, q);
+    for (int r = 0; r < 4; ++r) {
+      for (int c = 0; c < 4; ++c) {
+        scatter[r][c] += q[r] * q[c];
+      }
+    }
+    seed[0] = q[0]; seed[1] = q[1]; seed[2] = q[2]; seed[3] = q[3];
+  });
+  if (used == 0) {
+    return false;
+  }
+
+  double rotation[4] = {seed[0], seed[1], seed[2], seed[3]};
+  for (int iteration = 0; iteration < 100; ++iteration) {
+    double next[4];
+    double norm = 0.0;
+    for (int r = 0; r < 4; ++r) {
+      next[r] = scatter[r][0] * rotation[0] + scatter[r][1] * rotation[1] + scatter[r][2] * rotation[2] + scatter[r][3] * rotation[3];
+      norm += next[r] * next[r];
+    }
+    norm = sqrt(norm);
+    for (int r = 0; r < 4; ++r) {
+      rotation[r] = next[r] / norm;
+    }
+  }
+  if (rotation[0] < 0.0) {
+    rotation[0] = -rotation[0]; rotation[1] = -rotation[1]; rotation[2] = -rotation[2]; rotation[3] = -rotation[3];
+  }
+
+  // Translation: mean of the per-pair samples
+  double translation[3] = {};
+  ForEachPosePair(pDevicePoses, pReferencePoses, unCount, [&](const PosePair& pair) {
+    double t[3];
+    PairTranslation(pair, eKind, rotation, t);
+    translation[0] += t[0]; translation[1] += t[1]; translation[2] += t[2];
+  });
+  for (int k = 0; k < 3; ++k) {
+    translation[k] /= used;
+  }
+
+  // Residuals of the reference predicted through the fitted offset
+  if (pflRmsPositionError || pflRmsRotationError) {
+    double positionSq = 0.0;
+    double rotationSq = 0.0;
+    ForEachPosePair(pDevicePoses, pReferencePoses, unCount, [&](const PosePair& pair) {
+      double predictedRotation[4];
+      double predictedPosition[3];
+      if (eKind == Offset_DriverFromHead) {
+        QuatMultiply(pair.deviceRotation, rotation, predictedRotation);
+        QuatRotateVector(pair.deviceRotation, translation, predictedPosition);
+        for (int k = 0; k < 3; ++k) {
+          predictedPosition[k] += pair.devicePosition[k];
+        }
+      } else {
+        QuatMultiply(rotation, pair.deviceRotation, predictedRotation);
+        QuatRotateVector(rotation, pair.devicePosition, predictedPosition);
+        for (int k = 0; k < 3; ++k) {
+          predictedPosition[k] += translation[k];
+        }
+      }
+      for (int k = 0; k < 3; ++k) {
+        const double d = predictedPosition[k] - pair.referencePosition[k];
+        positionSq += d * d;
+      }
+      double dot = fabs(predictedRotation[0] * pair.referenceRotation[0] + predictedRotation[1] * pair.referenceRotation[1] +
+                        predictedRotation[2] * pair.referenceRotation[2] + predictedRotation[3] * pair.referenceRotation[3]);
+      dot = dot > 1.0 ? 1.0 : dot;
+      const double angle = 2.0 * acos(dot);
+      rotationSq += angle * angle;
+    });
+    if (pflRmsPositionError) {
+      *pflRmsPositionError = sqrt(positionSq / used);
+    }
+    if (pflRmsRotationError) {
+      *pflRmsRotationError = sqrt(rotationSq / used);
+    }
+  }
+
+  outOffset.qRotation = {rotation[0], rotation[1], rotation[2], rotation[3]};
+  outOffset.vecTranslation[0] = translation[0];
+  outOffset.vecTranslation[1] = translation[1];
+  outOffset.vecTranslation[2] = translation[2];
+  return true;
+}
+
+}  // namespace
+
+bool SolveDriverFromHeadOffset(const vr::TrackedDevicePose_t* pDevicePoses, const vr::TrackedDevicePose_t* pReferencePoses, uint32_t unCount,
+                               PoseOffset& outOffset, double* pflRmsPositionError, double* pflRmsRotationError) {
+  return SolveOffset(pDevicePoses, pReferencePoses, unCount, Offset_DriverFromHead, outOffset, pflRmsPositionError, pflRmsRotationError);
+}
+
+bool SolveWorldFromDriverOffset(const vr::TrackedDevicePose_t* pDevicePoses, const vr::TrackedDevicePose_t* pReferencePoses, uint32_t unCount,
+                                PoseOffset& outOffset, double* pflRmsPositionError, double* pflRmsRotationError) {
+  return SolveOffset(pDevicePoses, pReferencePoses, unCount, Offset_WorldFromDriver, outOffset, pflRmsPositionError, pflRmsRotationError);
+}
+
+bool SolveOffsetFromRecording(const char* pchRecordingPath, uint32_t unDeviceIndex, uint32_t unReferenceIndex, bool bWorldFromDriver,
+                              PoseOffset& outOffset, double* pflRmsPositionError, double* pflRmsRotationError) {
+  if (unDeviceIndex >= vr::k_unMaxTrackedDeviceCount || unReferenceIndex >= vr::k_unMaxTrackedDeviceCount) {
+    return false;
+  }
+  PoseReplay replay;
+  if (!replay.Open(pchRecordingPath, false, false)) {
+    return false;
+  }
+
+  // Offline, so the pairs are simply gathered up front
+  const uint32_t frameCount = replay.GetFrameCount();
+  std::vector<vr::TrackedDevicePose_t> devicePoses(frameCount);
+  std::vector<vr::TrackedDevicePose_t> referencePoses(frameCount);
+  std::vector<vr::TrackedDevicePose_t> frame(vr::k_unMaxTrackedDeviceCount);
+  for (uint32_t i = 0; i < frameCount; ++i) {
+    replay.Read(frame.data(), vr::k_unMaxTrackedDeviceCount);
+    devicePoses[i] = frame[unDeviceIndex];
+    referencePoses[i] = frame[unReferenceIndex];
+  }
+
+  const bool solved = SolveOffset(devicePoses.data(), referencePoses.data(), frameCount, bWorldFromDriver ? Offset_WorldFromDriver : Offset_DriverFromHead,
+                                  outOffset, pflRmsPositionError, pflRmsRotationError);
+  DRIVER_LOG_INFO(DriverLogCategory_Recording, "SolveOffsetFromRecording - {} of device index {} against {} from {} frames of {}: {}",
+                  bWorldFromDriver ? "worldFromDriver" : "driverFromHead", unDeviceIndex, unReferenceIndex, frameCount, pchRecordingPath,
+                  solved ? "solved" : "no usable pairs");
+  return solved;
+}
+
+}  // namespace vr
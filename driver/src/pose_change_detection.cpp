@@ -0,0 +1,79 @@
+#include "pose_change_detection.h"
+#include "driver_log.h"
+#include "driver_settings.h"
+
+#include <cmath>
+
+namespace vr {
+
+PoseChangeDetection ReadPoseChangeDetectionSettings() {
+  PoseChangeDetection settings;
+  vr::EVRSettingsError settingsError = vr::VRSettingsError_None;
+
+  settings.bEnabled = vr::VRSettings()->GetBool(k_pch_MyDriver_Section, k_pch_MyDriver_SuppressUnchangedPoses_Bool, &settingsError);
+  if (settingsError != vr::VRSettingsError_None) {
+    settings.bEnabled = false;
+  }
+
+  float positionEpsilonMm = vr::VRSettings()->GetFloat(k_pch_MyDriver_Section, k_pch_MyDriver_ChangePositionEpsilonMm_Float, &settingsError);
+  if (settingsError != vr::VRSettingsError_None || positionEpsilonMm < 0.f) {
+    positionEpsilonMm = 0.1f;
+  }
+  float rotationEpsilonDeg = vr::VRSettings()->GetFloat(k_pch_MyDriver_Section, k_pch_MyDriver_ChangeRotationEpsilonDeg_Float, &settingsError);
+  if (settingsError != vr::VRSettingsError_None || rotationEpsilonDeg < 0.f) {
+    rotationEpsilonDeg = 0.05f;
+  }
+  float keepAliveMs = vr::VRSettings()->GetFloat(k_pch_MyDriver_Section, k_pch_MyDriver_PoseKeepAliveMs_Float, &settingsError);
+  if (settingsError != vr::VRSettingsError_None || keepAliveMs < 0.f) {
+    keepAliveMs = 250.f;
+  }
+
+  settings.flPositionEpsilon = positionEpsilonMm / 1000.0;
+  settings.flRotationEpsilon = rotationEpsilonDeg * 3.14159265358979323846 / 180.0;
+  settings.flKeepAliveSeconds = keepAliveMs / 1000.0;
+  settings.flPositionEpsilonSq = settings.flPositionEpsilon * settings.flPositionEpsilon;
+  settings.flCosHalfRotationEpsilon = cos(0.5 * settings.flRotationEpsilon);
+
+  DRIVER_LOG_INFO(DriverLogCategory_Provider, "ReadPoseChangeDetectionSettings - Enabled: {}, position epsilon: {} mm, rotation epsilon: {} deg, keep-alive: {} ms",
+                  settings.bEnabled, positionEpsilonMm, rotationEpsilonDeg, keepAliveMs);
+  return settings;
+}
+
+bool IsPoseChangeSignificant(const vr::DriverPose_t& last, const vr::DriverPose_t& next, const PoseChangeDetection& settings) {
+  // Any tracking state transition always goes out
+  if (last.poseIsValid != next.poseIsValid || last.result != next.result || last.deviceIsConnected != next.deviceIsConnected) {
+    return true;
+  }
+  if (!next.poseIsValid) {
+    return false; // Still not tracking; the host ignores the position anyway
+  }
+
+  const double dx = next.vecPosition[0] - last.vecPosition[0];
+  const double dy = next.vecPosition[1] - last.vecPosition[1];
+  const double dz = next.vecPosition[2] - last.vecPosition[2];
+  if (dx * dx + dy * dy + dz * dz > settings.flPositionEpsilonSq) {
+    return true;
+  }
+
+  // |q1 . q2| = cos(angle / 2), with q and -q being the same rotation
+  const double dot = fabs(next.qRotation.w * last.qRotation.w + next.qRotation.x * last.qRotation.x +
+                          next.qRotation.y * last.qRotation.y + next.qRotation.z * last.qRotation.z);
+  if (dot < settings.flCosHalfRotationEpsilon) {
+    return true;
+  }
+
+  // The host extrapolates the last submitted pose along its velocities. Only coast on it if that
+  // drift stays inside the epsilons until the next keep-alive.
+  const double t2 = settings.flKeepAliveSeconds * settings.flKeepAliveSeconds;
+  const double* v = last.vecVelocity;
+  if ((v[0] * v[0] + v[1] * v[1] + v[2] * v[2]) * t2 > settings.flPositionEpsilonSq) {
+    return true;
+  }
+  const double* w = last.vecAngularVelocity;
+  if ((w[0] * w[0] + w[1] * w[1] + w[2] * w[2]) * t2 > settings.flRotationEpsilon * settings.flRotationEpsilon) {
+    return true;
+  }
+  return false;
+}
+
+}  // namespace vr
@@ -0,0 +1,271 @@
+#include "pose_conversion.h"
+
+#include <algorithm> // For std::max
+#include <cmath>
+
+// SIMD paths are x86 only; everything else uses the scalar kernel
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define POSE_CONVERSION_SSE2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h> // For __cpuid/_xgetbv
+#define POSE_CONVERSION_AVX 1
+#define POSE_CONVERSION_TARGET_AVX
+#elif defined(__GNUC__)
+#define POSE_CONVERSION_AVX 1
+#define POSE_CONVERSION_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+namespace vr {
+
+// All kernels use the same branch-free form of Shepperd's method. The four diagonal combinations
+// t0..t3 are 4w^2, 4x^2, 4y^2 and 4z^2; the largest one picks the numerically safe candidate
+// quaternion, which is selected with masks instead of the usual if/else chain. The result is
+// flipped into the w >= 0 hemisphere and normalized.
+//
+// Matrix element layout in PoseConversionBatch::matrix: 0=m00 1=m01 2=m02 3=m10 4=m11 5=m12 6=m20 7=m21 8=m22
+
+typedef void (*RotationKernel)(PoseConversionBatch& batch);
+
+static void ConvertRotations_Scalar(PoseConversionBatch& batch) {
+  for (uint32_t i = 0; i < PoseConversionBatch::k_unCapacity; ++i) {
+    const float m00 = batch.matrix[0][i], m01 = batch.matrix[1][i], m02 = batch.matrix[2][i];
+    const float m10 = batch.matrix[3][i], m11 = batch.matrix[4][i], m12 = batch.matrix[5][i];
+    const float m20 = batch.matrix[6][i], m21 = batch.matrix[7][i], m22 = batch.matrix[8][i];
+
+    const float t0 = 1.f + m00 + m11 + m22;
+    const float t1 = 1.f + m00 - m11 - m22;
+    const float t2 = 1.f - m00 + m11 - m22;
+    const float t3 = 1.f - m00 - m11 + m22;
+    const float ax = m21 - m12, ay = m02 - m20, az = m10 - m01;
+    const float sxy = m01 + m10, sxz = m02 + m20, syz = m12 + m21;
+
+    // Start from the z candidate and let each larger diagonal term take over
+    float best = t3, w = az, x = sxz, y = syz, z = t3;
+    bool take = t2 > best;
+    best = take ? t2 : best; w = take ? ay : w; x = take ? sxy : x; y = take ? t2 : y; z = take ? syz : z;
+    take = t1 > best;
+    best = take ? t1 : best; w = take ? ax : w; x = take ? t1 : x; y = take ? sxy : y; z = take ? sxz : z;
+    take = t0 > best;
+    best = take ? t0 : best; w = take ? t0 : w; x = take ? ax : x; y = take ? ay : y; z = take ? az : z;
+
+    float scale = 0.5f / std::sqrt(std::max(best, 1e-12f));
+    scale = std::copysign(scale, w); // w >= 0
+    w *= scale; x *= scale; y *= scale; z *= scale;
+
+    const float invNorm = 1.f / std::sqrt(w * w + x * x + y * y + z * z);
+    batch.rotation[0][i] = w * invNorm;
+    batch.rotation[1][i] = x * invNorm;
+    batch.rotation[2][i] = y * invNorm;
+    batch.rotation[3][i] = z * invNorm;
+  }
+}
+
+#ifdef POSE_CONVERSION_SSE2
+static inline __m128 Select_SSE2(__m128 mask, __m128 a, __m128 b) { // mask ? a : b
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static void ConvertRotations_SSE2(PoseConversionBatch& batch) {
+  const __m128 one = _mm_set1_ps(1.f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 epsilon = _mm_set1_ps(1e-12f);
+  const __m128 signBit = _mm_set1_ps(-0.f);
+
+  for (uint32_t i = 0; i < PoseConversionBatch::k_unCapacity; i += 4) {
+    const __m128 m00 = _mm_load_ps(&batch.matrix[0][i]), m01 = _mm_load_ps(&batch.matrix[1][i]), m02 = _mm_load_ps(&batch.matrix[2][i]);
+    const __m128 m10 = _mm_load_ps(&batch.matrix[3][i]), m11 = _mm_load_ps(&batch.matrix[4][i]), m12 = _mm_load_ps(&batch.matrix[5][i]);
+    const __m128 m20 = _mm_load_ps(&batch.matrix[6][i]), m21 = _mm_load_ps(&batch.matrix[7][i]), m22 = _mm_load_ps(&batch.matrix[8][i]);
+
+    const __m128 t0 = _mm_add_ps(_mm_add_ps(one, m00), _mm_add_ps(m11, m22));
+    const __m128 t1 = _mm_sub_ps(_mm_add_ps(one, m00), _mm_add_ps(m11, m22));
+    const __m128 t2 = _mm_sub_ps(_mm_add_ps(one, m11), _mm_add_ps(m00, m22));
+    const __m128 t3 = _mm_sub_ps(_mm_add_ps(one, m22), _mm_add_ps(m00, m11));
+    const __m128 ax = _mm_sub_ps(m21, m12), ay = _mm_sub_ps(m02, m20), az = _mm_sub_ps(m10, m01);
+    const __m128 sxy = _mm_add_ps(m01, m10), sxz = _mm_add_ps(m02, m20), syz = _mm_add_ps(m12, m21);
+
+    __m128 best = t3, w = az, x = sxz, y = syz, z = t3;
+    __m128 take = _mm_cmpgt_ps(t2, best);
+    best = Select_SSE2(take, t2, best); w = Select_SSE2(take, ay, w); x = Select_SSE2(take, sxy, x); y = Select_SSE2(take, t2, y); z = Select_SSE2(take, syz, z);
+    take = _mm_cmpgt_ps(t1, best);
+    best = Select_SSE2(take, t1, best); w = Select_SSE2(take, ax, w); x = Select_SSE2(take, t1, x); y = Select_SSE2(take, sxy, y); z = Select_SSE2(take, sxz, z);
+    take = _mm_cmpgt_ps(t0, best);
+    best = Select_SSE2(take, t0, best); w = Select_SSE2(take, t0, w); x = Select_SSE2(take, ax, x); y = Select_SSE2(take, ay, y); z = Select_SSE2(take, az, z);
+
+    __m128 scale = _mm_div_ps(half, _mm_sqrt_ps(_mm_max_ps(best, epsilon)));
+    scale = _mm_xor_ps(scale, _mm_and_ps(w, signBit)); // w >= 0
+    w = _mm_mul_ps(w, scale); x = _mm_mul_ps(x, scale); y = _mm_mul_ps(y, scale); z = _mm_mul_ps(z, scale);
+
+    const __m128 norm2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w, w), _mm_mul_ps(x, x)), _mm_add_ps(_mm_mul_ps(y, y), _mm_mul_ps(z, z)));
+    const __m128 invNorm = _mm_div_ps(one, _mm_sqrt_ps(norm2));
+    _mm_store_ps(&batch.rotation[0][i], _mm_mul_ps(w, invNorm));
+    _mm_store_ps(&batch.rotation[1][i], _mm_mul_ps(x, invNorm));
+    _mm_store_ps(&batch.rotation[2][i], _mm_mul_ps(y, invNorm));
+    _mm_store_ps(&batch.rotation[3][i], _mm_mul_ps(z, invNorm));
+  }
+}
+#endif // POSE_CONVERSION_SSE2
+
+#ifdef POSE_CONVERSION_AVX
+POSE_CONVERSION_TARGET_AVX
+static void ConvertRotations_AVX(PoseConversionBatch& batch) {
+  const __m256 one = _mm256_set1_ps(1.f);
+  const __m256 half = _mm256_set1_ps(0.5f);
+  const __m256 epsilon = _mm256_set1_ps(1e-12f);
+  const __m256 signBit = _mm256_set1_ps(-0.f);
+
+  for (uint32_t i = 0; i < PoseConversionBatch::k_unCapacity; i += 8) {
+    const __m256 m00 = _mm256_load_ps(&batch.matrix[0][i]), m01 = _mm256_load_ps(&batch.matrix[1][i]), m02 = _mm256_load_ps(&batch.matrix[2][i]);
+    const __m256 m10 = _mm256_load_ps(&batch.matrix[3][i]), m11 = _mm256_load_ps(&batch.matrix[4][i]), m12 = _mm256_load_ps(&batch.matrix[5][i]);
+    const __m256 m20 = _mm256_load_ps(&batch.matrix[6][i]), m21 = _mm256_load_ps(&batch.matrix[7][i]), m22 = _mm256_load_ps(&batch.matrix[8][i]);
+
+    const __m256 t0 = _mm256_add_ps(_mm256_add_ps(one, m00), _mm256_add_ps(m11, m22));
+    const __m256 t1 = _mm256_sub_ps(_mm256_add_ps(one, m00), _mm256_add_ps(m11, m22));
+    const __m256 t2 = _mm256_sub_ps(_mm256_add_ps(one, m11), _mm256_add_ps(m00, m22));
+    const __m256 t3 = _mm256_sub_ps(_mm256_add_ps(one, m22), _mm256_add_ps(m00, m11));
+    const __m256 ax = _mm256_sub_ps(m21, m12), ay = _mm256_sub_ps(m02, m20), az = _mm256_sub_ps(m10, m01);
+    const __m256 sxy = _mm256_add_ps(m01, m10), sxz = _mm256_add_ps(m02, m20), syz = _mm256_add_ps(m12, m21);
+
+    // _mm256_blendv_ps(b, a, mask) == mask ? a : b
+    __m256 best = t3, w = az, x = sxz, y = syz, z = t3;
+    __m256 take = _mm256_cmp_ps(t2, best, _CMP_GT_OQ);
+    best = _mm256_blendv_ps(best, t2, take); w = _mm256_blendv_ps(w, ay, take); x = _mm256_blendv_ps(x, sxy, take); y = _mm256_blendv_ps(y, t2, take); z = _mm256_blendv_ps(z, syz, take);
+    take = _mm256_cmp_ps(t1, best, _CMP_GT_OQ);
+    best = _mm256_blendv_ps(best, t1, take); w = _mm256_blendv_ps(w, ax, take); x = _mm256_blendv_ps(x, t1, take); y = _mm256_blendv_ps(y, sxy, take); z = _mm256_blendv_ps(z, sxz, take);
+    take = _mm256_cmp_ps(t0, best, _CMP_GT_OQ);
+    best = _mm256_blendv_ps(best, t0, take); w = _mm256_blendv_ps(w, t0, take); x = _mm256_blendv_ps(x, ax, take); y = _mm256_blendv_ps(y, ay, take); z = _mm256_blendv_ps(z, az, take);
+
+    __m256 scale = _mm256_div_ps(half, _mm256_sqrt_ps(_mm256_max_ps(best, epsilon)));
+    scale = _mm256_xor_ps(scale, _mm256_and_ps(w, signBit)); // w >= 0
+    w = _mm256_mul_ps(w, scale); x = _mm256_mul_ps(x, scale); y = _mm256_mul_ps(y, scale); z = _mm256_mul_ps(z, scale);
+
+    const __m256 norm2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(w, w), _mm256_mul_ps(x, x)), _mm256_add_ps(_mm256_mul_ps(y, y), _mm256_mul_ps(z, z)));
+    const __m256 invNorm = _mm256_div_ps(one, _mm256_sqrt_ps(norm2));
+    _mm256_store_ps(&batch.rotation[0][i], _mm256_mul_ps(w, invNorm));
+    _mm256_store_ps(&batch.rotation[1][i], _mm256_mul_ps(x, invNorm));
+    _mm256_store_ps(&batch.rotation[2][i], _mm256_mul_ps(y, invNorm));
+    _mm256_store_ps(&batch.rotation[3][i], _mm256_mul_ps(z, invNorm));
+  }
+}
+
+bool CpuSupportsAvx() {
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6; // OS saves the YMM state
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx") != 0;
+#endif
+}
+#else
+bool CpuSupportsAvx() {
+  return false;
+}
+#endif // POSE_CONVERSION_AVX
+
+struct RotationKernelChoice {
+  RotationKernel kernel;
+  const char* name;
+};
+
+static RotationKernelChoice SelectRotationKernel() {
+#ifdef POSE_CONVERSION_AVX
+  if (CpuSupportsAvx()) {
+    return {ConvertRotations_AVX, "AVX"};
+  }
+#endif
+#ifdef POSE_CONVERSION_SSE2
+  return {ConvertRotations_SSE2, "SSE2"};
+#else
+  return {ConvertRotations_Scalar, "Scalar"};
+#endif
+}
+
+static const RotationKernelChoice& GetRotationKernel() {
+  static const RotationKernelChoice choice = SelectRotationKernel(); // Resolved once, on first use
+  return choice;
+}
+
+const char* GetPoseConversionKernelName() {
+  return GetRotationKernel().name;
+}
+
+// Transposes the AoS snapshot into the batch's arrays; translation and velocities are plain copies
+static void TransposeRawPoses(const vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount, PoseConversionBatch& outBatch) {
+  const uint32_t count = unRawPoseCount < PoseConversionBatch::k_unCapacity ? unRawPoseCount : PoseConversionBatch::k_unCapacity;
+
+  for (uint32_t i = 0; i < count; ++i) {
+    const vr::TrackedDevicePose_t& raw = pRawPoses[i];
+    const vr::HmdMatrix34_t& m = raw.mDeviceToAbsoluteTracking;
+    for (int row = 0; row < 3; ++row) {
+      outBatch.matrix[row * 3 + 0][i] = m.m[row][0];
+      outBatch.matrix[row * 3 + 1][i] = m.m[row][1];
+      outBatch.matrix[row * 3 + 2][i] = m.m[row][2];
+      outBatch.position[row][i] = m.m[row][3];
+      outBatch.velocity[row][i] = raw.vVelocity.v[row];
+      outBatch.angularVelocity[row][i] = raw.vAngularVelocity.v[row];
+    }
+  }
+  for (uint32_t i = count; i < PoseConversionBatch::k_unCapacity; ++i) {
+    for (int row = 0; row < 3; ++row) {
+      outBatch.matrix[row * 3 + 0][i] = row == 0 ? 1.f : 0.f;
+      outBatch.matrix[row * 3 + 1][i] = row == 1 ? 1.f : 0.f;
+      outBatch.matrix[row * 3 + 2][i] = row == 2 ? 1.f : 0.f;
+      outBatch.position[row][i] = 0.f;
+      outBatch.velocity[row][i] = 0.f;
+      outBatch.angularVelocity[row][i] = 0.f;
+    }
+  }
+}
+
+void ConvertRawPoses(const vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount, PoseConversionBatch& outBatch) {
+  TransposeRawPoses(pRawPoses, unRawPoseCount, outBatch);
+  GetRotationKernel().kernel(outBatch);
+}
+
+bool IsPoseConversionKernelSupported(EPoseConversionKernel eKernel) {
+  switch (eKernel) {
+    case PoseConversionKernel_Scalar:
+      return true;
+#ifdef POSE_CONVERSION_SSE2
+    case PoseConversionKernel_SSE2:
+      return true;
+#endif
+#ifdef POSE_CONVERSION_AVX
+    case PoseConversionKernel_AVX:
+      return CpuSupportsAvx();
+#endif
+    default:
+      return false;
+  }
+}
+
+bool ConvertRawPosesWithKernel(EPoseConversionKernel eKernel, const vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount,
+                               PoseConversionBatch& outBatch) {
+  if (!IsPoseConversionKernelSupported(eKernel)) {
+    return false;
+  }
+  TransposeRawPoses(pRawPoses, unRawPoseCount, outBatch);
+  switch (eKernel) {
+#ifdef POSE_CONVERSION_AVX
+    case PoseConversionKernel_AVX:
+      ConvertRotations_AVX(outBatch);
+      break;
+#endif
+#ifdef POSE_CONVERSION_SSE2
+    case PoseConversionKernel_SSE2:
+      ConvertRotations_SSE2(outBatch);
+      break;
+#endif
+    default:
+      ConvertRotations_Scalar(outBatch);
+      break;
+  }
+  return true;
+}
+
+}  // namespace vr
@@ -0,0 +1,119 @@
+#include "pose_exporter.h"
+#include "driver_log.h"
+
+#include <new>
+
+namespace vr {
+
+PoseExporter::PoseExporter()
+    : m_pRegion(nullptr),
+      m_unFrame(0)
+#if defined(_WIN32)
+      ,
+      m_hMapping(nullptr)
+#endif
+{
+}
+
+PoseExporter::~PoseExporter() {
+  Close();
+}
+
+bool PoseExporter::Open(const char* pchName) {
+  Close();
+
+#if defined(_WIN32)
+  const char* pchMappingName = pchName[0] == '/' ? pchName + 1 : pchName;
+  HANDLE hMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)sizeof(PoseExportRegion), pchMappingName);
+  void* pView = hMapping ? MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(PoseExportRegion)) : nullptr;
+  if (!pView) {
+    if (hMapping) {
+      CloseHandle(hMapping);
+    }
+    DRIVER_LOG_ERROR(DriverLogCategory_Provider, "PoseExporter::Open - Could not create shared memory {}", pchName);
+    return false;
+  }
+  m_hMapping = hMapping;
+#else
+  shm_unlink(pchName); // A region left by a crashed session may have an older layout
+  const int fd = shm_open(pchName, O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0 || ftruncate(fd, (off_t)sizeof(PoseExportRegion)) != 0) {
+    if (fd >= 0) {
+      close(fd);
+      shm_unlink(pchName);
+    }
+    DRIVER_LOG_ERROR(DriverLogCategory_Provider, "PoseExporter::Open - Could not create shared memory {}", pchName);
+    return false;
+  }
+  void* pView = mmap(nullptr, sizeof(PoseExportRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd); // The mapping keeps the region alive
+  if (pView == MAP_FAILED) {
+    shm_unlink(pchName);
+    DRIVER_LOG_ERROR(DriverLogCategory_Provider, "PoseExporter::Open - Could not map shared memory {}", pchName);
+    return false;
+  }
+#endif
+
+  // The region starts zeroed; construct the atomics in place and publish the header last
+  m_pRegion = static_cast<PoseExportRegion*>(pView);
+  PoseExportHeader& header = m_pRegion->header;
+  header.unVersion = k_unPoseExportVersion;
+  header.unSlotSize = sizeof(PoseExportSlot);
+  header.unMaxSlots = k_unPoseExportMaxSlots;
+  new (&header.unSlotCount) std::atomic<uint32_t>(0);
+  new (&header.unFrameCount) std::atomic<uint64_t>(0);
+  for (uint32_t slot = 0; slot < k_unPoseExportMaxSlots; ++slot) {
+    new (&m_pRegion->slots[slot].unSequence) std::atomic<uint32_t>(0);
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(header.rgchMagic, k_rgchPoseExportMagic, sizeof(header.rgchMagic));
+
+  m_sName = pchName;
+  m_unFrame = 0;
+  DRIVER_LOG_INFO(DriverLogCategory_Provider, "PoseExporter::Open - Exporting mirrored poses to shared memory {} ({} bytes)", pchName, sizeof(PoseExportRegion));
+  return true;
+}
+
+void PoseExporter::Close() {
+  if (!m_pRegion) {
+    return;
+  }
+#if defined(_WIN32)
+  UnmapViewOfFile(m_pRegion);
+  CloseHandle(m_hMapping); // The mapping goes away with its last handle
+  m_hMapping = nullptr;
+#else
+  munmap(m_pRegion, sizeof(PoseExportRegion));
+  shm_unlink(m_sName.c_str()); // Readers that still have it mapped keep their view
+#endif
+  m_pRegion = nullptr;
+  m_sName.clear();
+}
+
+void PoseExporter::PublishSlot(uint32_t unSlot, uint32_t unObjectId, uint32_t unPhysicalIndex, const vr::DriverPose_t& pose,
+                               std::chrono::steady_clock::time_point sampleTime) {
+  if (unSlot >= k_unPoseExportMaxSlots) {
+    return;
+  }
+  PoseExportSlot& slot = m_pRegion->slots[unSlot];
+  const uint32_t seq = slot.unSequence.load(std::memory_order_relaxed);
+  slot.unSequence.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.unObjectId = unObjectId;
+  slot.unPhysicalIndex = unPhysicalIndex;
+  slot.unFrame = m_unFrame;
+  slot.nSampleTimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(sampleTime.time_since_epoch()).count();
+  slot.nPublishTimeNs = PoseExportNowNs();
+  memcpy(&slot.pose, &pose, sizeof(vr::DriverPose_t));
+  slot.unSequence.store(seq + 2, std::memory_order_release);
+}
+
+void PoseExporter::EndFrame(uint32_t unSlotCount) {
+  PoseExportHeader& header = m_pRegion->header;
+  if (unSlotCount > header.unSlotCount.load(std::memory_order_relaxed)) {
+    header.unSlotCount.store(unSlotCount, std::memory_order_release);
+  }
+  header.unFrameCount.store(++m_unFrame, std::memory_order_release);
+}
+
+}  // namespace vr
@@ -0,0 +1,252 @@
+#include "pose_filter.h"
+#include "driver_log.h"
+#include "driver_settings.h"
+
+#include <cmath>
+
+namespace vr {
+
+// A gap longer than this (tracking loss, standby, a stalled thread) restarts the filter
+static const double k_flMaxFilterGapSeconds = 0.25;
+
+static const double k_flPi = 3.14159265358979323846;
+
+static double ReadPositiveFloat(const char* pchKey, double flDefault) {
+  vr::EVRSettingsError settingsError = vr::VRSettingsError_None;
+  const float value = vr::VRSettings()->GetFloat(k_pch_MyDriver_Section, pchKey, &settingsError);
+  return settingsError == vr::VRSettingsError_None && value > 0.f ? value : flDefault;
+}
+
+PoseFilterSettings ReadPoseFilterSettings() {
+  PoseFilterSettings settings;
+  vr::EVRSettingsError settingsError = vr::VRSettingsError_None;
+
+  const int32_t mode = vr::VRSettings()->GetInt32(k_pch_MyDriver_Section, k_pch_MyDriver_PoseFilterMode_Int32, &settingsError);
+  settings.eMode = settingsError == vr::VRSettingsError_None && mode >= PoseFilter_Off && mode <= PoseFilter_Kalman ? (EPoseFilterMode)mode : PoseFilter_Off;
+
+  settings.flOneEuroMinCutoffHz = ReadPositiveFloat(k_pch_MyDriver_OneEuroMinCutoffHz_Float, 1.0);
+  settings.flOneEuroPositionBeta = ReadPositiveFloat(k_pch_MyDriver_OneEuroPositionBeta_Float, 100.0);
+  settings.flOneEuroRotationBeta = ReadPositiveFloat(k_pch_MyDriver_OneEuroRotationBeta_Float, 10.0);
+  settings.flOneEuroDerivativeCutoffHz = ReadPositiveFloat(k_pch_MyDriver_OneEuroDerivativeCutoffHz_Float, 1.0);
+
+  settings.flKalmanPositionProcessNoise = ReadPositiveFloat(k_pch_MyDriver_KalmanPositionProcessNoise_Float, 1.0);
+  settings.flKalmanPositionMeasurementNoise = ReadPositiveFloat(k_pch_MyDriver_KalmanPositionMeasurementNoiseMm_Float, 1.0) / 1000.0;
+  settings.flKalmanRotationProcessNoise = ReadPositiveFloat(k_pch_MyDriver_KalmanRotationProcessNoise_Float, 10.0);
+  settings.flKalmanRotationMeasurementNoise = ReadPositiveFloat(k_pch_MyDriver_KalmanRotationMeasurementNoiseDeg_Float, 0.5) * k_flPi / 180.0;
+
+  DRIVER_LOG_INFO(DriverLogCategory_Provider, "ReadPoseFilterSettings - Mode: {}", (int32_t)settings.eMode);
+  return settings;
+}
+
+// Quaternion helpers (w x y z in plain arrays)
+
+static void QuatMultiply(const double a[4], const double b[4], double out[4]) {
+  out[0] = a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3];
+  out[1] = a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2];
+  out[2] = a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1];
+  out[3] = a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0];
+}
+
+// Rotation vector (axis * angle) of the rotation taking from to to, in tracking space: log(to * conj(from))
+static void QuatDifference(const double from[4], const double to[4], double outRotationVector[3]) {
+  const double fromConj[4] = {from[0], -from[1], -from[2], -from[3]};
+  double d[4];
+  QuatMultiply(to, fromConj, d);
+  if (d[0] < 0.0) { // Shortest path
+    d[0] = -d[0]; d[1] = -d[1]; d[2] = -d[2]; d[3] = -d[3];
+  }
+  const double sinHalf = sqrt(d[1] * d[1] + d[2] * d[2] + d[3] * d[3]);
+  // 2 * atan2(sinHalf, cosHalf) / sinHalf, with the small-angle limit of 2
+  const double scale = sinHalf > 1e-9 ? 2.0 * atan2(sinHalf, d[0]) / sinHalf : 2.0;
+  outRotationVector[0] = d[1] * scale;
+  outRotationVector[1] = d[2] * scale;
+  outRotationVector[2] = d[3] * scale;
+}
+
+// q = exp(rotationVector) * q, renormalized
+static void QuatRotate(double q[4], const double rotationVector[3]) {
+  const double angle = sqrt(rotationVector[0] * rotationVector[0] + rotationVector[1] * rotationVector[1] + rotationVector[2] * rotationVector[2]);
+  if (angle < 1e-12) {
+    return;
+  }
+  const double s = sin(0.5 * angle) / angle;
+  const double d[4] = {cos(0.5 * angle), rotationVector[0] * s, rotationVector[1] * s, rotationVector[2] * s};
+  double r[4];
+  QuatMultiply(d, q, r);
+  const double norm = sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3]);
+  for (int i = 0; i < 4; ++i) {
+    q[i] = r[i] / norm;
+  }
+}
+
+// Smoothing factor of a first-order low-pass with cutoff flCutoffHz sampled every flDt seconds
+static double LowPassAlpha(double flCutoffHz, double flDt) {
+  const double tau = 1.0 / (2.0 * k_flPi * flCutoffHz);
+  return 1.0 / (1.0 + tau / flDt);
+}
+
+PoseFilterBank::PoseFilterBank() {
+  PoseFilterSettings off = {};
+  off.eMode = PoseFilter_Off;
+  Configure(off);
+}
+
+void PoseFilterBank::Configure(const PoseFilterSettings& settings) {
+  m_settings = settings;
+  for (uint32_t slot = 0; slot < k_unMaxSlots; ++slot) {
+    m_bInitialized[slot] = false;
+  }
+}
+
+void PoseFilterBank::Restart(const vr::DriverPose_t& pose, uint32_t unSlot) {
+  for (int i = 0; i < 3; ++i) {
+    m_flPosition[i][unSlot] = pose.vecPosition[i];
+    m_flVelocity[i][unSlot] = m_settings.eMode == PoseFilter_Kalman ? pose.vecVelocity[i] : 0.0;
+    m_flAngularVelocity[i][unSlot] = m_settings.eMode == PoseFilter_Kalman ? pose.vecAngularVelocity[i] : 0.0;
+
+    // Start as certain as one measurement, with a loose rate
+    m_flPositionCov[0][i][unSlot] = m_settings.flKalmanPositionMeasurementNoise * m_settings.flKalmanPositionMeasurementNoise;
+    m_flPositionCov[1][i][unSlot] = 0.0;
+    m_flPositionCov[2][i][unSlot] = 1.0;
+    m_flRotationCov[0][i][unSlot] = m_settings.flKalmanRotationMeasurementNoise * m_settings.flKalmanRotationMeasurementNoise;
+    m_flRotationCov[1][i][unSlot] = 0.0;
+    m_flRotationCov[2][i][unSlot] = 10.0;
+  }
+  m_flRotation[0][unSlot] = pose.qRotation.w;
+  m_flRotation[1][unSlot] = pose.qRotation.x;
+  m_flRotation[2][unSlot] = pose.qRotation.y;
+  m_flRotation[3][unSlot] = pose.qRotation.z;
+  m_bInitialized[unSlot] = true;
+}
+
+void PoseFilterBank::Apply(vr::DriverPose_t* pPoses, const bool* pbFilter, uint32_t unSlotCount, double flTimeSeconds) {
+  if (m_settings.eMode == PoseFilter_Off) {
+    return;
+  }
+
+  for (uint32_t slot = 0; slot < unSlotCount; ++slot) {
+    if (!pbFilter[slot]) {
+      m_bInitialized[slot] = false;
+      continue;
+    }
+
+    const double dt = flTimeSeconds - m_flLastTime[slot];
+    m_flLastTime[slot] = flTimeSeconds;
+    if (!m_bInitialized[slot] || dt > k_flMaxFilterGapSeconds) {
+      Restart(pPoses[slot], slot);
+      continue; // The first sample passes through
+    }
+    if (dt <= 0.0) {
+      continue; // Same sample time as the last call, nothing new to filter
+    }
+
+    if (m_settings.eMode == PoseFilter_OneEuro) {
+      ApplyOneEuro(pPoses[slot], slot, dt);
+    } else {
+      ApplyKalman(pPoses[slot], slot, dt);
+    }
+  }
+}
+
+void PoseFilterBank::ApplyOneEuro(vr::DriverPose_t& pose, uint32_t unSlot, double flDt) {
+  const double derivativeAlpha = LowPassAlpha(m_settings.flOneEuroDerivativeCutoffHz, flDt);
+
+  // Position: low-pass the speed, then low-pass the position with a cutoff that rises with it
+  double speedSq = 0.0;
+  for (int i = 0; i < 3; ++i) {
+    const double rate = (pose.vecPosition[i] - m_flPosition[i][unSlot]) / flDt;
+    m_flVelocity[i][unSlot] += derivativeAlpha * (rate - m_flVelocity[i][unSlot]);
+    speedSq += m_flVelocity[i][unSlot] * m_flVelocity[i][unSlot];
+  }
+  const double positionAlpha = LowPassAlpha(m_settings.flOneEuroMinCutoffHz + m_settings.flOneEuroPositionBeta * sqrt(speedSq), flDt);
+  for (int i = 0; i < 3; ++i) {
+    m_flPosition[i][unSlot] += positionAlpha * (pose.vecPosition[i] - m_flPosition[i][unSlot]);
+    pose.vecPosition[i] = m_flPosition[i][unSlot];
+  }
+
+  // Rotation: the same on the manifold, with the rotation vector from the filtered to the raw rotation
+  double filtered[4] = {m_flRotation[0][unSlot], m_flRotation[1][unSlot], m_flRotation[2][unSlot], m_flRotation[3][unSlot]};
+  const double raw[4] = {pose.qRotation.w, pose.qRotation.x, pose.qRotation.y, pose.qRotation.z};
+  double error[3];
+  QuatDifference(filtered, raw, error);
+
+  double angularSpeedSq = 0.0;
+  for (int i = 0; i < 3; ++i) {
+    m_flAngularVelocity[i][unSlot] += derivativeAlpha * (error[i] / flDt - m_flAngularVelocity[i][unSlot]);
+    angularSpeedSq += m_flAngularVelocity[i][unSlot] * m_flAngularVelocity[i][unSlot];
+  }
+  const double rotationAlpha = LowPassAlpha(m_settings.flOneEuroMinCutoffHz + m_settings.flOneEuroRotationBeta * sqrt(angularSpeedSq), flDt);
+  for (int i = 0; i < 3; ++i) {
+    error[i] *= rotationAlpha; // Slerp by rotationAlpha
+  }
+  QuatRotate(filtered, error);
+
+  for (int i = 0; i < 4; ++i) {
+    m_flRotation[i][unSlot] = filtered[i];
+  }
+  pose.qRotation = {filtered[0], filtered[1], filtered[2], filtered[3]};
+}
+
+// One constant-velocity Kalman step on a single axis, in error-state form: the caller has already
+// advanced the value by rate * dt and passes the innovation (measurement minus that prediction).
+// Propagates and corrects the covariance (P00, P01, P11), corrects rate in place and returns the
+// correction to add to the predicted value.
+static inline double KalmanAxisStep(double innovation, double dt, double processNoise, double measurementVariance, double& rate, double& p00, double& p01, double& p11) {
+  // Predict: P = F P F' + Q with F = [1 dt; 0 1] and Q for white-noise acceleration
+  const double predicted00 = p00 + dt * (2.0 * p01 + dt * p11) + processNoise * dt * dt * dt / 3.0;
+  const double predicted01 = p01 + dt * p11 + processNoise * dt * dt / 2.0;
+  const double predicted11 = p11 + processNoise * dt;
+
+  // Update with H = [1 0]
+  const double s = predicted00 + measurementVariance;
+  const double k0 = predicted00 / s;
+  const double k1 = predicted01 / s;
+  p00 = (1.0 - k0) * predicted00;
+  p01 = (1.0 - k0) * predicted01;
+  p11 = predicted11 - k1 * predicted01;
+
+  rate += k1 * innovation;
+  return k0 * innovation;
+}
+
+void PoseFilterBank::ApplyKalman(vr::DriverPose_t& pose, uint32_t unSlot, double flDt) {
+  const double positionVariance = m_settings.flKalmanPositionMeasurementNoise * m_settings.flKalmanPositionMeasurementNoise;
+  for (int i = 0; i < 3; ++i) {
+    double& position = m_flPosition[i][unSlot];
+    double& velocity = m_flVelocity[i][unSlot];
+    position += velocity * flDt;
+    position += KalmanAxisStep(pose.vecPosition[i] - position, flDt, m_settings.flKalmanPositionProcessNoise, positionVariance, velocity,
+                               m_flPositionCov[0][i][unSlot], m_flPositionCov[1][i][unSlot], m_flPositionCov[2][i][unSlot]);
+    pose.vecPosition[i] = position;
+    pose.vecVelocity[i] = velocity;
+  }
+
+  // Rotation: error-state form. Predict the rotation with the angular velocity state, measure the
+  // rotation vector from prediction to raw sample, and run the same per-axis step on it.
+  double rotation[4] = {m_flRotation[0][unSlot], m_flRotation[1][unSlot], m_flRotation[2][unSlot], m_flRotation[3][unSlot]};
+  double predictedDelta[3];
+  for (int i = 0; i < 3; ++i) {
+    predictedDelta[i] = m_flAngularVelocity[i][unSlot] * flDt;
+  }
+  QuatRotate(rotation, predictedDelta);
+
+  const double raw[4] = {pose.qRotation.w, pose.qRotation.x, pose.qRotation.y, pose.qRotation.z};
+  double innovation[3];
+  QuatDifference(rotation, raw, innovation);
+
+  const double rotationVariance = m_settings.flKalmanRotationMeasurementNoise * m_settings.flKalmanRotationMeasurementNoise;
+  double correction[3];
+  for (int i = 0; i < 3; ++i) {
+    correction[i] = KalmanAxisStep(innovation[i], flDt, m_settings.flKalmanRotationProcessNoise, rotationVariance, m_flAngularVelocity[i][unSlot],
+                                   m_flRotationCov[0][i][unSlot], m_flRotationCov[1][i][unSlot], m_flRotationCov[2][i][unSlot]);
+    pose.vecAngularVelocity[i] = m_flAngularVelocity[i][unSlot];
+  }
+  QuatRotate(rotation, correction);
+
+  for (int i = 0; i < 4; ++i) {
+    m_flRotation[i][unSlot] = rotation[i];
+  }
+  pose.qRotation = {rotation[0], rotation[1], rotation[2], rotation[3]};
+}
+
+}  // namespace vr
@@ -0,0 +1,280 @@
+#include "pose_fusion.h"
+#include "driver_log.h"
+#include "driver_settings.h"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+namespace vr {
+
+uint32_t ReadDeviceFusionSources(const char* pchSerial, PoseFusionSource* pSources, uint32_t unMaxSources) {
+  const std::string section = std::string(k_pch_MyDriver_FusionSectionPrefix) + pchSerial;
+  uint32_t count = 0;
+  for (uint32_t source = 1; source < k_unMaxPoseFusionSources && count < unMaxSources; ++source) {
+    char indexKey[32];
+    char rotationKey[32];
+    char translationKey[32];
+    snprintf(indexKey, sizeof(indexKey), k_pch_MyDriver_Fusion_SourceIndex_Int32Format, source);
+    snprintf(rotationKey, sizeof(rotationKey), k_pch_MyDriver_Fusion_SourceRotation_StringFormat, source);
+    snprintf(translationKey, sizeof(translationKey), k_pch_MyDriver_Fusion_SourceTranslation_StringFormat, source);
+
+    vr::EVRSettingsError settingsError = vr::VRSettingsError_None;
+    const int32_t index = vr::VRSettings()->GetInt32(section.c_str(), indexKey, &settingsError);
+    if (settingsError != vr::VRSettingsError_None || index < 0) {
+      continue; // Unset
+    }
+    if (index >= (int32_t)vr::k_unMaxTrackedDeviceCount) {
+      DRIVER_LOG_WARNING(DriverLogCategory_Device, "ReadDeviceFusionSources - Ignoring out-of-range {} {} in {}", indexKey, index, section.c_str());
+      continue;
+    }
+
+    PoseFusionSource& out = pSources[count++];
+    out.unPhysicalIndex = (uint32_t)index;
+    out.offset = IdentityPoseOffset();
+    ReadPoseOffset(section.c_str(), rotationKey, translationKey, out.offset);
+  }
+  return count;
+}
+
+// How much a valid source counts for its tracking state. Far apart on purpose: a source that is
+// properly tracked should take over almost completely from one that is coasting.
+static double TrackingResultWeight(vr::ETrackingResult eResult) {
+  switch (eResult) {
+    case vr::TrackingResult_Running_OK:
+      return 1.0;
+    case vr::TrackingResult_Calibrating_InProgress:
+      return 0.25;
+    default: // Fallback_RotationOnly (IMU only, e.g. an occluded controller), the out-of-range states, anything unknown
+      return 0.01;
+  }
+}
+
+PoseFusionBank::PoseFusionBank() : m_flBlendSeconds(0.1) {
+  for (uint32_t slot = 0; slot < k_unMaxSlots; ++slot) {
+    Bind(slot, vr::k_unTrackedDeviceIndexInvalid, nullptr, 0);
+  }
+}
+
+void PoseFusionBank::Bind(uint32_t unSlot, uint32_t unPrimaryIndex, const PoseFusionSource* pExtras, uint32_t unExtraCount) {
+  if (unSlot >= k_unMaxSlots) {
+    return;
+  }
+  if (unExtraCount > k_unMaxPoseFusionSources - 1) {
+    unExtraCount = k_unMaxPoseFusionSources - 1;
+  }
+
+  m_unSourceCount[unSlot] = 1 + unExtraCount;
+  for (uint32_t source = 0; source < k_unMaxPoseFusionSources; ++source) {
+    const PoseOffset offset = source > 0 && source <= unExtraCount ? pExtras[source - 1].offset : IdentityPoseOffset();
+    m_unSourceIndex[source][unSlot] = source == 0 ? unPrimaryIndex
+                                      : source <= unExtraCount ? pExtras[source - 1].unPhysicalIndex
+                                                               : vr::k_unTrackedDeviceIndexInvalid;
+    m_flOffsetRotation[source][0][unSlot] = offset.qRotation.w;
+    m_flOffsetRotation[source][1][unSlot] = offset.qRotation.x;
+    m_flOffsetRotation[source][2][unSlot] = offset.qRotation.y;
+    m_flOffsetRotation[source][3][unSlot] = offset.qRotation.z;
+    for (int i = 0; i < 3; ++i) {
+      m_flOffsetTranslation[source][i][unSlot] = offset.vecTranslation[i];
+    }
+    m_flWeight[source][unSlot] = 0.0;
+  }
+
+  m_unContributing[unSlot] = 0;
+  m_flLastTime[unSlot] = 0.0;
+  m_bHasOutput[unSlot] = false;
+  for (int i = 0; i < 3; ++i) {
+    m_flOutputPosition[i][unSlot] = 0.0;
+    m_flCorrectionPosition[i][unSlot] = 0.0;
+  }
+  m_flOutputRotation[0][unSlot] = 1.0;
+  m_flCorrectionRotation[0][unSlot] = 1.0;
+  for (int i = 1; i < 4; ++i) {
+    m_flOutputRotation[i][unSlot] = 0.0;
+    m_flCorrectionRotation[i][unSlot] = 0.0;
+  }
+  m_unDominant[unSlot] = 0;
+}
+
+bool PoseFusionBank::Fuse(uint32_t unSlot, const vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount, const PoseConversionBatch& converted,
+                          double flTimeSeconds, vr::DriverPose_t& pose, bool& bOutConnected) {
+  const uint32_t sourceCount = m_unSourceCount[unSlot];
+  const double dt = m_bHasOutput[unSlot] ? flTimeSeconds - m_flLastTime[unSlot] : 0.0;
+  m_flLastTime[unSlot] = flTimeSeconds;
+  const double fade = m_flBlendSeconds <= 0.0 ? 1.0 : dt > 0.0 ? 1.0 - exp(-dt / m_flBlendSeconds) : 0.0;
+
+  // Pass 1: which sources are usable, and their faded shares of the average. Shares rather than
+  // raw weights are faded, so a strong source coming back ramps in over the blend time instead of
+  // taking over at once. Invalid sources drop out immediately.
+  double target[k_unMaxPoseFusionSources];
+  double targetTotal = 0.0;
+  uint32_t contributing = 0;
+  bOutConnected = false;
+  for (uint32_t source = 0; source < sourceCount; ++source) {
+    const uint32_t index = m_unSourceIndex[source][unSlot];
+    target[source] = 0.0;
+    if (index < unRawPoseCount && index < PoseConversionBatch::k_unCapacity) {
+      const vr::TrackedDevicePose_t& raw = pRawPoses[index];
+      bOutConnected |= raw.bDeviceIsConnected;
+      if (raw.bDeviceIsConnected && raw.bPoseIsValid) {
+        target[source] = TrackingResultWeight(raw.eTrackingResult);
+        targetTotal += target[source];
+        contributing |= 1u << source;
+      }
+    }
+  }
+  double total = 0.0;
+  for (uint32_t source = 0; source < sourceCount; ++source) {
+    double& share = m_flWeight[source][unSlot];
+    share = target[source] > 0.0 ? share + fade * (target[source] / targetTotal - share) : 0.0;
+    total += share;
+  }
+
+  if (!contributing) {
+    // Nothing to fuse; the next valid sample starts over without a handover
+    for (uint32_t source = 0; source < sourceCount; ++source) {
+      m_flWeight[source][unSlot] = 0.0;
+    }
+    m_unContributing[unSlot] = 0;
+    m_bHasOutput[unSlot] = false;
+    return false;
+  }
+  if (total < 1e-6) {
+    // Only sources that just became usable, e.g. on the first frame: nothing to fade from
+    total = 1.0;
+    for (uint32_t source = 0; source < sourceCount; ++source) {
+      m_flWeight[source][unSlot] = target[source] / targetTotal;
+    }
+  }
+
+  // Pass 2: move every usable source into the mirror's frame (mirror = source * offset) and average
+  double position[3] = {0.0, 0.0, 0.0};
+  double rotation[4] = {0.0, 0.0, 0.0, 0.0};
+  double velocity[3] = {0.0, 0.0, 0.0};
+  double angularVelocity[3] = {0.0, 0.0, 0.0};
+  uint32_t dominant = 0;
+  double dominantWeight = -1.0;
+  bool hasReference = false;
+  double reference[4];
+  for (uint32_t source = 0; source < sourceCount; ++source) {
+    const double weight = m_flWeight[source][unSlot] / total;
+    if (!(contributing & (1u << source)) || weight <= 0.0) {
+      continue;
+    }
+    if (weight > dominantWeight) {
+      dominantWeight = weight;
+      dominant = source;
+    }
+
+    const uint32_t index = m_unSourceIndex[source][unSlot];
+    const double qw = converted.rotation[0][index], qx = converted.rotation[1][index], qy = converted.rotation[2][index], qz = converted.rotation[3][index];
+    const double ow = m_flOffsetRotation[source][0][unSlot], ox = m_flOffsetRotation[source][1][unSlot];
+    const double oy = m_flOffsetRotation[source][2][unSlot], oz = m_flOffsetRotation[source][3][unSlot];
+
+    // Offset translation in tracking space: R(q) t = t + 2w (u x t) + 2 u x (u x t)
+    const double tx = m_flOffsetTranslation[source][0][unSlot], ty = m_flOffsetTranslation[source][1][unSlot], tz = m_flOffsetTranslation[source][2][unSlot];
+    const double cx = qy * tz - qz * ty, cy = qz * tx - qx * tz, cz = qx * ty - qy * tx;
+    const double arm[3] = {tx + 2.0 * (qw * cx + qy * cz - qz * cy), ty + 2.0 * (qw * cy + qz * cx - qx * cz), tz + 2.0 * (qw * cz + qx * cy - qy * cx)};
+
+    double q[4] = {qw * ow - qx * ox - qy * oy - qz * oz, qw * ox + qx * ow + qy * oz - qz * oy,
+                   qw * oy - qx * oz + qy * ow + qz * ox, qw * oz + qx * oy - qy * ox + qz * ow};
+    if (!hasReference) {
+      reference[0] = q[0], reference[1] = q[1], reference[2] = q[2], reference[3] = q[3];
+      hasReference = true;
+    } else if (q[0] * reference[0] + q[1] * reference[1] + q[2] * reference[2] + q[3] * reference[3] < 0.0) {
+      q[0] = -q[0], q[1] = -q[1], q[2] = -q[2], q[3] = -q[3]; // Same hemisphere, or the average cancels out
+    }
+
+    const double w[3] = {converted.angularVelocity[0][index], converted.angularVelocity[1][index], converted.angularVelocity[2][index]};
+    const double tangential[3] = {w[1] * arm[2] - w[2] * arm[1], w[2] * arm[0] - w[0] * arm[2], w[0] * arm[1] - w[1] * arm[0]};
+    for (int i = 0; i < 3; ++i) {
+      position[i] += weight * (converted.position[i][index] + arm[i]);
+      velocity[i] += weight * (converted.velocity[i][index] + tangential[i]);
+      angularVelocity[i] += weight * w[i];
+    }
+    for (int i = 0; i < 4; ++i) {
+      rotation[i] += weight * q[i];
+    }
+  }
+  const double rotationNorm = sqrt(rotation[0] * rotation[0] + rotation[1] * rotation[1] + rotation[2] * rotation[2] + rotation[3] * rotation[3]);
+  for (int i = 0; i < 4; ++i) {
+    rotation[i] /= rotationNorm;
+  }
+
+  // Handover: when a source drops out, hold the output where it was and let the difference decay
+  double correction[7];                 // x y z, then w x y z
+  for (int i = 0; i < 3; ++i) {
+    correction[i] = m_flCorrectionPosition[i][unSlot];
+  }
+  for (int i = 0; i < 4; ++i) {
+    correction[3 + i] = m_flCorrectionRotation[i][unSlot];
+  }
+  if (m_bHasOutput[unSlot] && (m_unContributing[unSlot] & ~contributing)) {
+    for (int i = 0; i < 3; ++i) {
+      correction[i] = m_flOutputPosition[i][unSlot] - position[i];
+    }
+    // Rotation correction = last output * conj(fused), applied on the left
+    const double o[4] = {m_flOutputRotation[0][unSlot], m_flOutputRotation[1][unSlot], m_flOutputRotation[2][unSlot], m_flOutputRotation[3][unSlot]};
+    const double* r = rotation;
+    const double c[4] = {o[0] * r[0] + o[1] * r[1] + o[2] * r[2] + o[3] * r[3], -o[0] * r[1] + o[1] * r[0] - o[2] * r[3] + o[3] * r[2],
+                         -o[0] * r[2] + o[1] * r[3] + o[2] * r[0] - o[3] * r[1], -o[0] * r[3] - o[1] * r[2] + o[2] * r[1] + o[3] * r[0]};
+    const double sign = c[0] < 0.0 ? -1.0 : 1.0;
+    for (int i = 0; i < 4; ++i) {
+      correction[3 + i] = sign * c[i];
+    }
+    DRIVER_LOG_VERBOSE(DriverLogCategory_Pose, "PoseFusionBank::Fuse - Slot {} lost source mask {}, blending over {} mm", unSlot,
+                       m_unContributing[unSlot] & ~contributing,
+                       1000.0 * sqrt(correction[0] * correction[0] + correction[1] * correction[1] + correction[2] * correction[2]));
+  } else {
+    // Decay toward no correction: scale the translation, nlerp the rotation toward identity
+    const double keep = 1.0 - fade;
+    for (int i = 0; i < 3; ++i) {
+      correction[i] *= keep;
+    }
+    correction[3] = keep * correction[3] + fade;
+    for (int i = 4; i < 7; ++i) {
+      correction[i] *= keep;
+    }
+    const double norm = sqrt(correction[3] * correction[3] + correction[4] * correction[4] + correction[5] * correction[5] + correction[6] * correction[6]);
+    for (int i = 3; i < 7; ++i) {
+      correction[i] /= norm;
+    }
+  }
+  for (int i = 0; i < 3; ++i) {
+    m_flCorrectionPosition[i][unSlot] = correction[i];
+  }
+  for (int i = 0; i < 4; ++i) {
+    m_flCorrectionRotation[i][unSlot] = correction[3 + i];
+  }
+
+  const double cw = correction[3], cx = correction[4], cy = correction[5], cz = correction[6];
+  const double output[4] = {cw * rotation[0] - cx * rotation[1] - cy * rotation[2] - cz * rotation[3],
+                            cw * rotation[1] + cx * rotation[0] + cy * rotation[3] - cz * rotation[2],
+                            cw * rotation[2] - cx * rotation[3] + cy * rotation[0] + cz * rotation[1],
+                            cw * rotation[3] + cx * rotation[2] - cy * rotation[1] + cz * rotation[0]};
+
+  for (int i = 0; i < 3; ++i) {
+    pose.vecPosition[i] = position[i] + correction[i];
+    pose.vecVelocity[i] = velocity[i];
+    pose.vecAngularVelocity[i] = angularVelocity[i];
+    m_flOutputPosition[i][unSlot] = pose.vecPosition[i];
+  }
+  pose.qRotation.w = output[0];
+  pose.qRotation.x = output[1];
+  pose.qRotation.y = output[2];
+  pose.qRotation.z = output[3];
+  for (int i = 0; i < 4; ++i) {
+    m_flOutputRotation[i][unSlot] = output[i];
+  }
+
+  pose.poseIsValid = true;
+  pose.result = pRawPoses[m_unSourceIndex[dominant][unSlot]].eTrackingResult;
+  pose.deviceIsConnected = true;
+
+  m_unContributing[unSlot] = contributing;
+  m_bHasOutput[unSlot] = true;
+  m_unDominant[unSlot] = dominant;
+  return true;
+}
+
+}  // namespace vr
@@ -0,0 +1,80 @@
+#include "pose_prediction.h"
+#include "driver_log.h"
+#include "driver_settings.h"
+
+#include <cmath>
+
+namespace vr {
+
+double ReadPosePredictionHorizonSeconds() {
+  vr::EVRSettingsError settingsError = vr::VRSettingsError_None;
+  int32_t mode = vr::VRSettings()->GetInt32(k_pch_MyDriver_Section, k_pch_MyDriver_PredictionMode_Int32, &settingsError);
+  if (settingsError != vr::VRSettingsError_None) {
+    mode = PosePrediction_Off;
+  }
+
+  double horizon = 0.0;
+  if (mode == PosePrediction_FixedHorizon) {
+    float horizonMs = vr::VRSettings()->GetFloat(k_pch_MyDriver_Section, k_pch_MyDriver_PredictionHorizonMs_Float, &settingsError);
+    if (settingsError == vr::VRSettingsError_None && horizonMs > 0.f) {
+      horizon = horizonMs / 1000.0;
+    }
+  } else if (mode == PosePrediction_DisplayTime) {
+    vr::PropertyContainerHandle_t hmdContainer = vr::VRProperties()->TrackedDeviceToPropertyContainer(vr::k_unTrackedDeviceIndex_Hmd);
+    vr::ETrackedPropertyError propError = vr::TrackedProp_Success;
+    float displayFrequency = vr::VRProperties()->GetFloatProperty(hmdContainer, vr::Prop_DisplayFrequency_Float, &propError);
+    if (propError != vr::TrackedProp_Success || displayFrequency <= 0.f) {
+      displayFrequency = 90.f; // Reasonable default if the HMD doesn't report it
+    }
+    float vsyncToPhotons = vr::VRProperties()->GetFloatProperty(hmdContainer, vr::Prop_SecondsFromVsyncToPhotons_Float, &propError);
+    if (propError != vr::TrackedProp_Success || vsyncToPhotons < 0.f) {
+      vsyncToPhotons = 0.f;
+    }
+    horizon = 1.0 / displayFrequency + vsyncToPhotons;
+  }
+
+  DRIVER_LOG_INFO(DriverLogCategory_Provider, "ReadPosePredictionHorizonSeconds - Mode: {}, horizon: {} ms", mode, horizon * 1000.0);
+  return horizon;
+}
+
+void PredictDriverPose(vr::DriverPose_t& pose, double flSecondsAhead) {
+  // Position: linear extrapolation
+  for (int i = 0; i < 3; ++i) {
+    pose.vecPosition[i] += pose.vecVelocity[i] * flSecondsAhead;
+  }
+
+  // Rotation: integrate the angular velocity into a delta quaternion and pre-multiply,
+  // since the raw angular velocity is expressed in tracking space
+  const double wx = pose.vecAngularVelocity[0];
+  const double wy = pose.vecAngularVelocity[1];
+  const double wz = pose.vecAngularVelocity[2];
+  const double speed = sqrt(wx * wx + wy * wy + wz * wz);
+  if (speed > 1e-9) {
+    const double halfAngle = 0.5 * speed * flSecondsAhead;
+    const double s = sin(halfAngle) / speed;
+    const vr::HmdQuaternion_t d = {cos(halfAngle), wx * s, wy * s, wz * s};
+    const vr::HmdQuaternion_t q = pose.qRotation;
+
+    vr::HmdQuaternion_t r;
+    r.w = d.w * q.w - d.x * q.x - d.y * q.y - d.z * q.z;
+    r.x = d.w * q.x + d.x * q.w + d.y * q.z - d.z * q.y;
+    r.y = d.w * q.y - d.x * q.z + d.y * q.w + d.z * q.x;
+    r.z = d.w * q.z + d.x * q.y - d.y * q.x + d.z * q.w;
+
+    const double norm = sqrt(r.w * r.w + r.x * r.x + r.y * r.y + r.z * r.z);
+    if (norm > 0.0) {
+      r.w /= norm; r.x /= norm; r.y /= norm; r.z /= norm;
+    }
+    pose.qRotation = r;
+  }
+
+  // Constant velocity model: velocities carry over unchanged, accelerations are zero.
+  // The extrapolated pose is the one to show now, so the host must not shift it again.
+  for (int i = 0; i < 3; ++i) {
+    pose.vecAcceleration[i] = 0.0;
+    pose.vecAngularAcceleration[i] = 0.0;
+  }
+  pose.poseTimeOffset = 0.0;
+}
+
+}  // namespace vr
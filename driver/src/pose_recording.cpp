@@ -0,0 +1,320 @@
+#include "pose_recording.h"
+#include "driver_log.h"
+
+#include <cstring>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vr {
+
+// PoseRecorder
+
+PoseRecorder::PoseRecorder()
+    : m_pFile(nullptr),
+      m_unWriteIndex(0),
+      m_unReadIndex(0),
+      m_unDroppedFrames(0),
+      m_bFlushThreadRunning(false) {}
+
+PoseRecorder::~PoseRecorder() {
+  Close();
+}
+
+bool PoseRecorder::Open(const char* pchPath, const int32_t* pDeviceClasses, const int32_t* pControllerRoles) {
+  Close();
+
+  m_pFile = fopen(pchPath, "wb");
+  if (!m_pFile) {
+    DRIVER_LOG_ERROR(DriverLogCategory_Recording, "PoseRecorder::Open - Could not open {} for writing", pchPath);
+    return false;
+  }
+
+  PoseRecordingHeader header;
+  memcpy(header.rgchMagic, k_rgchPoseRecordingMagic, sizeof(header.rgchMagic));
+  header.unVersion = k_unPoseRecordingVersion;
+  header.unPoseSize = sizeof(vr::TrackedDevicePose_t);
+  header.unMaxPoses = vr::k_unMaxTrackedDeviceCount;
+  memcpy(header.nDeviceClass, pDeviceClasses, sizeof(header.nDeviceClass));
+  memcpy(header.nControllerRole, pControllerRoles, sizeof(header.nControllerRole));
+  if (fwrite(&header, sizeof(header), 1, m_pFile) != 1) {
+    DRIVER_LOG_ERROR(DriverLogCategory_Recording, "PoseRecorder::Open - Could not write header to {}", pchPath);
+    fclose(m_pFile);
+    m_pFile = nullptr;
+    return false;
+  }
+
+  if (!m_ring) {
+    m_ring.reset(new RingFrame[k_unRingFrames]);
+  }
+  m_unWriteIndex.store(0, std::memory_order_relaxed);
+  m_unReadIndex.store(0, std::memory_order_relaxed);
+  m_unDroppedFrames.store(0, std::memory_order_relaxed);
+  m_startTime = std::chrono::steady_clock::now();
+
+  m_bFlushThreadRunning.store(true, std::memory_order_release);
+  m_flushThread = std::thread(&PoseRecorder::FlushThreadMain, this);
+
+  DRIVER_LOG_INFO(DriverLogCategory_Recording, "PoseRecorder::Open - Recording raw poses to {}", pchPath);
+  return true;
+}
+
+void PoseRecorder::Close() {
+  m_bFlushThreadRunning.store(false, std::memory_order_release);
+  if (m_flushThread.joinable()) {
+    m_flushThread.join();
+  }
+  if (m_pFile) {
+    FlushPending(); // Whatever Record() queued after the thread's last pass
+    fclose(m_pFile);
+    m_pFile = nullptr;
+    DRIVER_LOG_INFO(DriverLogCategory_Recording, "PoseRecorder::Close - Recording closed, dropped frames: {}", GetDroppedFrameCount());
+  }
+}
+
+void PoseRecorder::Record(const vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount) {
+  const uint64_t writeIndex = m_unWriteIndex.load(std::memory_order_relaxed);
+  if (writeIndex - m_unReadIndex.load(std::memory_order_acquire) >= k_unRingFrames) {
+    m_unDroppedFrames.store(m_unDroppedFrames.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return; // Writer is behind; never wait for it
+  }
+
+  // Only keep poses up to the highest connected index
+  uint32_t poseCount = unRawPoseCount < vr::k_unMaxTrackedDeviceCount ? unRawPoseCount : vr::k_unMaxTrackedDeviceCount;
+  while (poseCount > 0 && !pRawPoses[poseCount - 1].bDeviceIsConnected) {
+    --poseCount;
+  }
+
+  RingFrame& frame = m_ring[writeIndex % k_unRingFrames];
+  frame.header.flTimestamp = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+  frame.header.unPoseCount = poseCount;
+  frame.header.unReserved = 0;
+  memcpy(frame.poses, pRawPoses, poseCount * sizeof(vr::TrackedDevicePose_t));
+
+  m_unWriteIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+void PoseRecorder::FlushPending() {
+  uint64_t readIndex = m_unReadIndex.load(std::memory_order_relaxed);
+  const uint64_t writeIndex = m_unWriteIndex.load(std::memory_order_acquire);
+  if (readIndex == writeIndex) {
+    return;
+  }
+  for (; readIndex < writeIndex; ++readIndex) {
+    const RingFrame& frame = m_ring[readIndex % k_unRingFrames];
+    fwrite(&frame.header, sizeof(frame.header), 1, m_pFile);
+    fwrite(frame.poses, sizeof(vr::TrackedDevicePose_t), frame.header.unPoseCount, m_pFile);
+  }
+  m_unReadIndex.store(readIndex, std::memory_order_release);
+  fflush(m_pFile);
+}
+
+void PoseRecorder::FlushThreadMain() {
+  while (m_bFlushThreadRunning.load(std::memory_order_acquire)) {
+    FlushPending();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+// PoseReplay
+
+PoseReplay::PoseReplay()
+    : m_pData(nullptr),
+      m_unSize(0),
+      m_unFirstFrameOffset(0),
+      m_unFrameOffset(0),
+      m_bRealTime(false),
+      m_bLoop(false),
+      m_bStarted(false)
+#if defined(_WIN32)
+      ,
+      m_hFile(INVALID_HANDLE_VALUE),
+      m_hMapping(nullptr)
+#endif
+{
+}
+
+PoseReplay::~PoseReplay() {
+  Close();
+}
+
+bool PoseReplay::Open(const char* pchPath, bool bRealTime, bool bLoop) {
+  Close();
+
+#if defined(_WIN32)
+  HANDLE hFile = CreateFileA(pchPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  LARGE_INTEGER fileSize;
+  if (hFile == INVALID_HANDLE_VALUE || !GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(PoseRecordingHeader)) {
+    if (hFile != INVALID_HANDLE_VALUE) {
+      CloseHandle(hFile);
+    }
+    DRIVER_LOG_ERROR(DriverLogCategory_Recording, "PoseReplay::Open - Could not open {}", pchPath);
+    return false;
+  }
+  HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  const void* pView = hMapping ? MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (!pView) {
+    if (hMapping) {
+      CloseHandle(hMapping);
+    }
+    CloseHandle(hFile);
+    DRIVER_LOG_ERROR(DriverLogCategory_Recording, "PoseReplay::Open - Could not map {}", pchPath);
+    return false;
+  }
+  m_hFile = hFile;
+  m_hMapping = hMapping;
+  m_pData = static_cast<const uint8_t*>(pView);
+  m_unSize = (size_t)fileSize.QuadPart;
+#else
+  const int fd = open(pchPath, O_RDONLY);
+  struct stat fileStat;
+  if (fd < 0 || fstat(fd, &fileStat) != 0 || fileStat.st_size < (off_t)sizeof(PoseRecordingHeader)) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    DRIVER_LOG_ERROR(DriverLogCategory_Recording, "PoseReplay::Open - Could not open {}", pchPath);
+    return false;
+  }
+  void* pView = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // The mapping keeps the file alive
+  if (pView == MAP_FAILED) {
+    DRIVER_LOG_ERROR(DriverLogCategory_Recording, "PoseReplay::Open - Could not map {}", pchPath);
+    return false;
+  }
+  m_pData = static_cast<const uint8_t*>(pView);
+  m_unSize = (size_t)fileStat.st_size;
+#endif
+
+  const PoseRecordingHeader& header = GetHeader();
+  if (memcmp(header.rgchMagic, k_rgchPoseRecordingMagic, sizeof(header.rgchMagic)) != 0 ||
+      header.unVersion != k_unPoseRecordingVersion ||
+      header.unPoseSize != sizeof(vr::TrackedDevicePose_t) ||
+      header.unMaxPoses != vr::k_unMaxTrackedDeviceCount) {
+    DRIVER_LOG_ERROR(DriverLogCategory_Recording, "PoseReplay::Open - {} is not a compatible pose recording", pchPath);
+    Close();
+    return false;
+  }
+
+  m_unFirstFrameOffset = sizeof(PoseRecordingHeader);
+  m_unFrameOffset = m_unFirstFrameOffset;
+  m_bRealTime = bRealTime;
+  m_bLoop = bLoop;
+  m_bStarted = false;
+
+  DRIVER_LOG_INFO(DriverLogCategory_Recording, "PoseReplay::Open - Replaying raw poses from {} (real time: {}, loop: {})", pchPath, bRealTime, bLoop);
+  return true;
+}
+
+void PoseReplay::Close() {
+  if (!m_pData) {
+    return;
+  }
+#if defined(_WIN32)
+  UnmapViewOfFile(m_pData);
+  CloseHandle(m_hMapping);
+  CloseHandle(m_hFile);
+  m_hMapping = nullptr;
+  m_hFile = INVALID_HANDLE_VALUE;
+#else
+  munmap(const_cast<uint8_t*>(m_pData), m_unSize);
+#endif
+  m_pData = nullptr;
+  m_unSize = 0;
+}
+
+size_t PoseReplay::FrameSizeAt(size_t unOffset) const {
+  if (unOffset > m_unSize || m_unSize - unOffset < sizeof(PoseRecordingFrameHeader)) {
+    return 0;
+  }
+  PoseRecordingFrameHeader frameHeader;
+  memcpy(&frameHeader, m_pData + unOffset, sizeof(frameHeader)); // The mapping gives no alignment guarantees past the header
+  if (frameHeader.unPoseCount > vr::k_unMaxTrackedDeviceCount) {
+    return 0;
+  }
+  const size_t frameSize = sizeof(PoseRecordingFrameHeader) + frameHeader.unPoseCount * sizeof(vr::TrackedDevicePose_t);
+  return m_unSize - unOffset >= frameSize ? frameSize : 0;
+}
+
+double PoseReplay::FrameTimestampAt(size_t unOffset) const {
+  PoseRecordingFrameHeader frameHeader;
+  memcpy(&frameHeader, m_pData + unOffset, sizeof(frameHeader));
+  return frameHeader.flTimestamp;
+}
+
+uint32_t PoseReplay::GetFrameCount() const {
+  if (!IsOpen()) {
+    return 0;
+  }
+  uint32_t count = 0;
+  for (size_t offset = m_unFirstFrameOffset, size = FrameSizeAt(offset); size != 0; offset += size, size = FrameSizeAt(offset)) {
+    ++count;
+  }
+  return count;
+}
+
+void PoseReplay::Read(vr::TrackedDevicePose_t* pRawPoses, uint32_t unRawPoseCount) {
+  memset(pRawPoses, 0, unRawPoseCount * sizeof(vr::TrackedDevicePose_t)); // Anything not in the frame is disconnected
+
+  if (FrameSizeAt(m_unFirstFrameOffset) == 0) {
+    return; // Empty recording
+  }
+
+  const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (!m_bStarted) {
+    m_startTime = now;
+    m_bStarted = true;
+  }
+
+  // In real time, skip ahead to the newest frame whose timestamp has passed
+  if (m_bRealTime) {
+    const double elapsed = std::chrono::duration<double>(now - m_startTime).count() + FrameTimestampAt(m_unFirstFrameOffset);
+    for (;;) {
+      const size_t nextOffset = m_unFrameOffset + FrameSizeAt(m_unFrameOffset);
+      if (FrameSizeAt(nextOffset) == 0) {
+        if (m_bLoop && elapsed > FrameTimestampAt(m_unFrameOffset)) {
+          m_unFrameOffset = m_unFirstFrameOffset;
+          m_startTime = now;
+        }
+        break;
+      }
+      if (FrameTimestampAt(nextOffset) > elapsed) {
+        break;
+      }
+      m_unFrameOffset = nextOffset;
+    }
+  }
+
+  const size_t frameSize = FrameSizeAt(m_unFrameOffset);
+  PoseRecordingFrameHeader frameHeader;
+  memcpy(&frameHeader, m_pData + m_unFrameOffset, sizeof(frameHeader));
+  const uint32_t poseCount = frameHeader.unPoseCount < unRawPoseCount ? frameHeader.unPoseCount : unRawPoseCount;
+  memcpy(pRawPoses, m_pData + m_unFrameOffset + sizeof(frameHeader), poseCount * sizeof(vr::TrackedDevicePose_t));
+
+  // As fast as possible: one frame per call
+  if (!m_bRealTime) {
+    const size_t nextOffset = m_unFrameOffset + frameSize;
+    if (FrameSizeAt(nextOffset) != 0) {
+      m_unFrameOffset = nextOffset;
+    } else if (m_bLoop) {
+      m_unFrameOffset = m_unFirstFrameOffset;
+    }
+  }
+}
+
+bool PoseReplay::GetDevice(uint32_t unIndex, int32_t& nDeviceClass, int32_t& nControllerRole) const {
+  if (!IsOpen() || unIndex >= vr::k_unMaxTrackedDeviceCount) {
+    return false;
+  }
+  nDeviceClass = GetHeader().nDeviceClass[unIndex];
+  nControllerRole = GetHeader().nControllerRole[unIndex];
+  return true;
+}
+
+}  // namespace vr
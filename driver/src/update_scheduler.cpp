@@ -0,0 +1,146 @@
+#include "update_scheduler.h"
+#include "driver_log.h"
+#include "driver_settings.h"
+
+#include <cmath>
+
+namespace vr {
+
+UpdateSchedulerSettings ReadUpdateSchedulerSettings() {
+  UpdateSchedulerSettings settings;
+  vr::EVRSettingsError settingsError = vr::VRSettingsError_None;
+
+  settings.bEnabled = vr::VRSettings()->GetBool(k_pch_MyDriver_Section, k_pch_MyDriver_AdaptiveUpdateRate_Bool, &settingsError);
+  if (settingsError != vr::VRSettingsError_None) {
+    settings.bEnabled = false;
+  }
+
+  float idleAfterMs = vr::VRSettings()->GetFloat(k_pch_MyDriver_Section, k_pch_MyDriver_IdleAfterMs_Float, &settingsError);
+  if (settingsError != vr::VRSettingsError_None || idleAfterMs < 0.f) {
+    idleAfterMs = 2000.f;
+  }
+  float idleKeepAliveMs = vr::VRSettings()->GetFloat(k_pch_MyDriver_Section, k_pch_MyDriver_IdleKeepAliveMs_Float, &settingsError);
+  if (settingsError != vr::VRSettingsError_None || idleKeepAliveMs < 0.f) {
+    idleKeepAliveMs = 1000.f;
+  }
+  float dormantSampleIntervalMs = vr::VRSettings()->GetFloat(k_pch_MyDriver_Section, k_pch_MyDriver_DormantSampleIntervalMs_Float, &settingsError);
+  if (settingsError != vr::VRSettingsError_None || dormantSampleIntervalMs < 0.f) {
+    dormantSampleIntervalMs = 100.f;
+  }
+  float motionPositionMm = vr::VRSettings()->GetFloat(k_pch_MyDriver_Section, k_pch_MyDriver_MotionPositionMm_Float, &settingsError);
+  if (settingsError != vr::VRSettingsError_None || motionPositionMm < 0.f) {
+    motionPositionMm = 2.f;
+  }
+  float motionRotationDeg = vr::VRSettings()->GetFloat(k_pch_MyDriver_Section, k_pch_MyDriver_MotionRotationDeg_Float, &settingsError);
+  if (settingsError != vr::VRSettingsError_None || motionRotationDeg < 0.f) {
+    motionRotationDeg = 1.f;
+  }
+  settings.bBlockStandbyWhileMoving = vr::VRSettings()->GetBool(k_pch_MyDriver_Section, k_pch_MyDriver_BlockStandbyWhileMoving_Bool, &settingsError);
+  if (settingsError != vr::VRSettingsError_None) {
+    settings.bBlockStandbyWhileMoving = false;
+  }
+
+  settings.flIdleAfterSeconds = idleAfterMs / 1000.0;
+  settings.flIdleKeepAliveSeconds = idleKeepAliveMs / 1000.0;
+  settings.flDormantSampleSeconds = dormantSampleIntervalMs / 1000.0;
+  settings.flMotionPositionEpsilon = motionPositionMm / 1000.0;
+  settings.flMotionRotationEpsilon = motionRotationDeg * 3.14159265358979323846 / 180.0;
+  settings.flMotionPositionEpsilonSq = settings.flMotionPositionEpsilon * settings.flMotionPositionEpsilon;
+  settings.flMotionCosHalfRotationEpsilon = cos(0.5 * settings.flMotionRotationEpsilon);
+
+  DRIVER_LOG_INFO(DriverLogCategory_Provider, "ReadUpdateSchedulerSettings - Enabled: {}, idle after: {} ms, idle keep-alive: {} ms, dormant sampling: {} ms, motion: {} mm / {} deg, block standby: {}",
+                  settings.bEnabled, idleAfterMs, idleKeepAliveMs, dormantSampleIntervalMs, motionPositionMm, motionRotationDeg,
+                  settings.bBlockStandbyWhileMoving);
+  return settings;
+}
+
+UpdateScheduler::UpdateScheduler()
+    : m_unUpdatedCount(0),
+      m_unDormantCount(0),
+      m_unMovingCount(0),
+      m_bAllDormant(false),
+      m_bAnyMoving(false) {
+  m_settings = UpdateSchedulerSettings();
+  m_settings.bEnabled = false;
+  const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  for (uint32_t slot = 0; slot < k_unMaxSlots; ++slot) {
+    ResetSlot(slot, now);
+  }
+}
+
+void UpdateScheduler::Configure(const UpdateSchedulerSettings& settings) {
+  m_settings = settings;
+}
+
+void UpdateScheduler::ResetSlot(uint32_t unSlot, std::chrono::steady_clock::time_point now) {
+  if (unSlot >= k_unMaxSlots) {
+    return;
+  }
+  for (int i = 0; i < 3; ++i) {
+    m_flReferencePosition[i][unSlot] = 0.0;
+  }
+  m_flReferenceRotation[0][unSlot] = 1.0;
+  m_flReferenceRotation[1][unSlot] = 0.0;
+  m_flReferenceRotation[2][unSlot] = 0.0;
+  m_flReferenceRotation[3][unSlot] = 0.0;
+  m_bReferenceValid[unSlot] = false;
+  m_lastActive[unSlot] = now;
+  m_activity[unSlot].store(MirrorActivity_Active, std::memory_order_relaxed);
+}
+
+EMirrorActivity UpdateScheduler::Update(uint32_t unSlot, const vr::DriverPose_t& pose, std::chrono::steady_clock::time_point now) {
+  if (!m_settings.bEnabled) {
+    return MirrorActivity_Active;
+  }
+
+  // Gaining or losing tracking is a change the host must see right away, just like motion
+  const bool valid = pose.poseIsValid;
+  bool wake = valid != m_bReferenceValid[unSlot];
+  if (valid && !wake) {
+    const double dx = pose.vecPosition[0] - m_flReferencePosition[0][unSlot];
+    const double dy = pose.vecPosition[1] - m_flReferencePosition[1][unSlot];
+    const double dz = pose.vecPosition[2] - m_flReferencePosition[2][unSlot];
+    const double dot = pose.qRotation.w * m_flReferenceRotation[0][unSlot] + pose.qRotation.x * m_flReferenceRotation[1][unSlot] +
+                       pose.qRotation.y * m_flReferenceRotation[2][unSlot] + pose.qRotation.z * m_flReferenceRotation[3][unSlot];
+    wake = dx * dx + dy * dy + dz * dz > m_settings.flMotionPositionEpsilonSq || fabs(dot) < m_settings.flMotionCosHalfRotationEpsilon;
+  }
+
+  if (wake) {
+    // Measure the next motion from here, so slow drift below the epsilon per sweep still adds up
+    for (int i = 0; i < 3; ++i) {
+      m_flReferencePosition[i][unSlot] = pose.vecPosition[i];
+    }
+    m_flReferenceRotation[0][unSlot] = pose.qRotation.w;
+    m_flReferenceRotation[1][unSlot] = pose.qRotation.x;
+    m_flReferenceRotation[2][unSlot] = pose.qRotation.y;
+    m_flReferenceRotation[3][unSlot] = pose.qRotation.z;
+    m_bReferenceValid[unSlot] = valid;
+    m_lastActive[unSlot] = now;
+  }
+
+  EMirrorActivity activity = MirrorActivity_Active;
+  if (std::chrono::duration<double>(now - m_lastActive[unSlot]).count() >= m_settings.flIdleAfterSeconds) {
+    activity = valid ? MirrorActivity_Stationary : MirrorActivity_Dormant;
+  }
+
+  const EMirrorActivity previous = (EMirrorActivity)m_activity[unSlot].load(std::memory_order_relaxed);
+  if (activity != previous) {
+    DRIVER_LOG_VERBOSE(DriverLogCategory_Pose, "UpdateScheduler::Update - Slot {} went from activity {} to {}", unSlot, previous, activity);
+    m_activity[unSlot].store(activity, std::memory_order_relaxed);
+  }
+
+  ++m_unUpdatedCount;
+  m_unDormantCount += activity == MirrorActivity_Dormant;
+  m_unMovingCount += activity == MirrorActivity_Active && valid;
+  return activity;
+}
+
+void UpdateScheduler::EndSweep() {
+  m_bAllDormant.store(m_settings.bEnabled && m_unUpdatedCount > 0 && m_unDormantCount == m_unUpdatedCount, std::memory_order_relaxed);
+  m_bAnyMoving.store(m_unMovingCount > 0, std::memory_order_relaxed);
+  m_unUpdatedCount = 0;
+  m_unDormantCount = 0;
+  m_unMovingCount = 0;
+}
+
+}  // namespace vr
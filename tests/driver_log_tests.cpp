@@ -0,0 +1,93 @@
+#include "harness/harness.h"
+#include "harness/provider_fixture.h"
+#include "driver_log.h"
+
+#include <cstring>
+
+using harness::ProviderFixture;
+
+namespace {
+
+// The log configuration is process-wide; put the defaults back whatever a test changed
+struct ScopedLogDefaults {
+  ~ScopedLogDefaults() {
+    vr::DriverLogSetLevel(vr::DriverLogLevel_Info);
+    vr::DriverLogSetRateLimit(50);
+  }
+};
+
+uint32_t CountLines(const std::vector<std::string>& lines, const std::string& sText) {
+  uint32_t count = 0;
+  for (const std::string& line : lines) {
+    if (line.find(sText) != std::string::npos) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+}  // namespace
+
+HARNESS_TEST(driver_log, ErrorsAndWarningsAreNotRateLimited) {
+  ScopedLogDefaults defaults;
+  ProviderFixture fixture;
+  fixture.SetSetting("logRateLimitPerSecond", 5.f);
+  fixture.AddDevices(1);
+  fixture.Init();
+
+  for (int i = 0; i < 40; ++i) {
+    DRIVER_LOG_ERROR(vr::DriverLogCategory_Recording, "rate test error {}", i);
+    DRIVER_LOG_WARNING(vr::DriverLogCategory_Recording, "rate test warning {}", i);
+    DRIVER_LOG_INFO(vr::DriverLogCategory_Recording, "rate test info {}", i);
+  }
+  fixture.Shutdown(); // Drains the ring
+
+  const std::vector<std::string> lines = fixture.Context().Log().GetLines();
+  CHECK_EQ(CountLines(lines, "[ERROR][recording] rate test error"), 40u);
+  CHECK_EQ(CountLines(lines, "[WARN][recording] rate test warning"), 40u);
+  const uint32_t infos = CountLines(lines, "[INFO][recording] rate test info");
+  CHECK(infos <= 10); // At most 5, or 10 if a new one-second window started mid-loop
+  CHECK_EQ(CountLines(lines, "[WARN][recording] " + std::to_string(40 - infos) + " log record(s) suppressed"), 1u);
+}
+
+HARNESS_TEST(driver_log, LinesStartWithTheirTimestamp) {
+  ScopedLogDefaults defaults;
+  ProviderFixture fixture;
+  fixture.AddDevices(1);
+  fixture.Init();
+  DRIVER_LOG_WARNING(vr::DriverLogCategory_Device, "timestamp test {}", 1); // Not rate limited, whatever ran before
+  fixture.Shutdown();
+
+  bool found = false;
+  for (const std::string& line : fixture.Context().Log().GetLines()) {
+    double seconds = -1.0;
+    char level[16];
+    CHECK_EQ(sscanf(line.c_str(), "[%lf][%15[A-Z]]", &seconds, level), 2);
+    CHECK(seconds >= 0.0);
+    found = found || line.find("[WARN][device] timestamp test 1") != std::string::npos;
+  }
+  CHECK(found);
+}
+
+HARNESS_TEST(driver_log, LogLevelReportsEveryCategory) {
+  ScopedLogDefaults defaults;
+  ProviderFixture fixture;
+  fixture.AddDevices(1);
+  fixture.Init();
+  const uint32_t mirror = fixture.GetMirror("my_left_controller_serial");
+
+  std::string response = fixture.DebugRequest(mirror, "log_level");
+  CHECK(response.find("\"levels\":{\"provider\":2,\"device\":2,\"pose\":2,\"recording\":2}") != std::string::npos);
+
+  response = fixture.DebugRequest(mirror, "log_level pose 4");
+  CHECK(response.find("\"levels\":{\"provider\":2,\"device\":2,\"pose\":4,\"recording\":2}") != std::string::npos);
+  CHECK(vr::DriverLogEnabled(vr::DriverLogLevel_Trace, vr::DriverLogCategory_Pose));
+  CHECK(!vr::DriverLogEnabled(vr::DriverLogLevel_Verbose, vr::DriverLogCategory_Provider));
+
+  response = fixture.DebugRequest(mirror, "log_level 1");
+  CHECK(response.find("\"levels\":{\"provider\":1,\"device\":1,\"pose\":1,\"recording\":1}") != std::string::npos);
+  CHECK(response.find("\"dropped\":") != std::string::npos);
+
+  response = fixture.DebugRequest(mirror, "log_level nonsense 3"); // Unknown category, nothing changes
+  CHECK(response.find("\"levels\":{\"provider\":1,\"device\":1,\"pose\":1,\"recording\":1}") != std::string::npos);
+}
@@ -0,0 +1,67 @@
+#include "harness/harness.h"
+#include "driver_stats.h"
+
+#include <atomic>
+#include <thread>
+
+namespace {
+
+double NsPerCall(int64_t nStart, uint32_t unCalls) {
+  return (double)(harness::NowNs() - nStart) / unCalls;
+}
+
+}  // namespace
+
+// What the always-on instrumentation costs the hot path
+HARNESS_BENCH(driver_stats, Timers) {
+  const uint32_t calls = harness::IsQuickRun() ? 10000 : 5000000;
+  static vr::LatencyHistogram histogram;
+
+  histogram.Reset();
+  int64_t start = harness::NowNs();
+  for (uint32_t i = 0; i < calls; ++i) {
+    histogram.Record(1000 + (i & 4095));
+  }
+  printf("  LatencyHistogram::Record        %6.1f ns/call\n", NsPerCall(start, calls));
+
+  start = harness::NowNs();
+  for (uint32_t i = 0; i < calls; ++i) {
+    vr::ScopedDriverTimer timer(vr::DriverTimer_PoseSubmit);
+  }
+  printf("  ScopedDriverTimer (empty scope) %6.1f ns/call\n", NsPerCall(start, calls));
+
+  start = harness::NowNs();
+  for (uint32_t i = 0; i < calls; ++i) {
+    harness::DoNotOptimize(std::chrono::steady_clock::now());
+  }
+  printf("  steady_clock::now               %6.1f ns/call\n", NsPerCall(start, calls));
+
+  // Several threads recording into one histogram, as the tracking thread and the host thread may
+  for (uint32_t threads : {2u, 4u}) {
+    histogram.Reset();
+    std::atomic<int64_t> totalNs(0);
+    std::vector<std::thread> writers;
+    for (uint32_t t = 0; t < threads; ++t) {
+      writers.emplace_back([&totalNs, calls] {
+        const int64_t threadStart = harness::NowNs();
+        for (uint32_t i = 0; i < calls; ++i) {
+          histogram.Record(1000 + (i & 4095));
+        }
+        totalNs.fetch_add(harness::NowNs() - threadStart);
+      });
+    }
+    for (std::thread& writer : writers) {
+      writer.join();
+    }
+    printf("  Record, %u threads contended    %6.1f ns/call\n", threads, (double)totalNs.load() / threads / calls);
+  }
+
+  const uint32_t reads = harness::IsQuickRun() ? 100 : 100000;
+  start = harness::NowNs();
+  uint64_t sink = 0;
+  for (uint32_t i = 0; i < reads; ++i) {
+    sink += histogram.GetPercentile(99.0);
+  }
+  harness::DoNotOptimize(sink);
+  printf("  GetPercentile                   %6.1f ns/call\n", NsPerCall(start, reads));
+}
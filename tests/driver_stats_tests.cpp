@@ -0,0 +1,118 @@
+#include "harness/harness.h"
+#include "harness/provider_fixture.h"
+#include "driver_stats.h"
+
+#include <random>
+#include <thread>
+
+using harness::ProviderFixture;
+
+namespace {
+
+// The histogram's own rank rule (nearest rank, rounded) over exact sorted samples
+uint64_t ExactPercentile(const std::vector<uint64_t>& sorted, double flPercentile) {
+  uint64_t rank = (uint64_t)(flPercentile / 100.0 * (double)sorted.size() + 0.5);
+  rank = std::max<uint64_t>(1, std::min<uint64_t>(rank, sorted.size()));
+  return sorted[rank - 1];
+}
+
+}  // namespace
+
+HARNESS_TEST(driver_stats, SmallValuesAreExact) {
+  static vr::LatencyHistogram histogram;
+  histogram.Reset();
+  for (uint64_t value = 0; value < vr::LatencyHistogram::k_unSubBuckets; ++value) {
+    histogram.Record(value);
+  }
+  CHECK_EQ(histogram.GetCount(), 8u);
+  CHECK_EQ(histogram.GetSum(), 28u);
+  CHECK_EQ(histogram.GetMax(), 7u);
+  CHECK_EQ(histogram.GetPercentile(50.0), 3u);
+  CHECK_EQ(histogram.GetPercentile(100.0), 7u);
+  CHECK_EQ(histogram.GetPercentile(0.0), 0u);
+}
+
+HARNESS_TEST(driver_stats, PercentilesAreWithinOneSubBucket) {
+  // Latency-like data: log-normal around 20 us with a long tail, plus a few multi-millisecond outliers
+  static vr::LatencyHistogram histogram;
+  std::mt19937_64 random(42);
+  std::lognormal_distribution<double> latency(std::log(20000.0), 0.8);
+  for (int run = 0; run < 5; ++run) {
+    histogram.Reset();
+    std::vector<uint64_t> samples;
+    for (int i = 0; i < 20000; ++i) {
+      samples.push_back(i % 997 == 0 ? 5000000 + i : (uint64_t)latency(random));
+      histogram.Record(samples.back());
+    }
+    std::sort(samples.begin(), samples.end());
+    for (double percentile : {1.0, 10.0, 50.0, 90.0, 99.0, 99.9, 100.0}) {
+      const double exact = (double)ExactPercentile(samples, percentile);
+      const double reported = (double)histogram.GetPercentile(percentile);
+      CHECK(reported >= exact); // Upper bucket edge
+      CHECK(reported <= exact * (1.0 + 1.0 / vr::LatencyHistogram::k_unSubBuckets));
+    }
+    CHECK_EQ(histogram.GetMax(), samples.back());
+    CHECK_EQ(histogram.GetPercentile(100.0), samples.back());
+  }
+}
+
+HARNESS_TEST(driver_stats, HandlesTheWholeRange) {
+  static vr::LatencyHistogram histogram;
+  histogram.Reset();
+  for (uint32_t bit = 0; bit < 64; ++bit) {
+    const uint64_t power = 1ull << bit;
+    histogram.Record(power);
+    histogram.Record(power - 1);
+    histogram.Record(power | (power >> 1));
+  }
+  histogram.Record(~0ull);
+  CHECK_EQ(histogram.GetCount(), 64u * 3 + 1);
+  CHECK_EQ(histogram.GetMax(), ~0ull);
+  CHECK_EQ(histogram.GetPercentile(100.0), ~0ull);
+  CHECK(histogram.GetPercentile(1.0) <= 2u);
+}
+
+HARNESS_TEST(driver_stats, ConcurrentRecordsAreAllCounted) {
+  static vr::LatencyHistogram histogram;
+  histogram.Reset();
+  const uint32_t threads = 4;
+  const uint32_t perThread = 100000;
+  std::vector<std::thread> writers;
+  for (uint32_t t = 0; t < threads; ++t) {
+    writers.emplace_back([t] {
+      for (uint32_t i = 0; i < perThread; ++i) {
+        histogram.Record(1000 * (t + 1));
+      }
+    });
+  }
+  for (std::thread& writer : writers) {
+    writer.join();
+  }
+  CHECK_EQ(histogram.GetCount(), (uint64_t)threads * perThread);
+  CHECK_EQ(histogram.GetSum(), (uint64_t)perThread * 1000 * (1 + 2 + 3 + 4));
+  CHECK_EQ(histogram.GetMax(), 4000u);
+  CHECK_EQ(histogram.GetPercentile(25.0), 1023u); // Upper edge of 1000's bucket [960, 1023]
+}
+
+HARNESS_TEST(driver_stats, StatsRequestReportsEveryTimer) {
+  vr::ResetDriverTimers();
+  ProviderFixture fixture;
+  fixture.AddDevices(2);
+  fixture.Init();
+  fixture.RunFrames(30);
+  CHECK_EQ(vr::g_rgDriverTimers[vr::DriverTimer_RunFrame].GetCount(), 30u);
+  CHECK_EQ(vr::g_rgDriverTimers[vr::DriverTimer_RawPoseFetch].GetCount(), 30u);
+  CHECK_EQ(vr::g_rgDriverTimers[vr::DriverTimer_PoseSubmit].GetCount(), 60u); // One per TrackedDevicePoseUpdated
+
+  const uint32_t mirror = fixture.GetMirror("my_left_controller_serial");
+  std::string response = fixture.DebugRequest(mirror, "stats");
+  for (const char* timer : {"\"run_frame\":{\"count\":30", "\"raw_pose_fetch\":{\"count\":30", "\"pose_conversion\":{\"count\":30",
+                            "\"pose_submit\":{\"count\":60", "\"frames\":30", "\"sent\":30"}) {
+    CHECK(response.find(timer) != std::string::npos);
+  }
+
+  fixture.DebugRequest(mirror, "reset_stats");
+  CHECK_EQ(vr::g_rgDriverTimers[vr::DriverTimer_RunFrame].GetCount(), 0u);
+  response = fixture.DebugRequest(mirror, "stats");
+  CHECK(response.find("\"run_frame\":{\"count\":0") != std::string::npos);
+}
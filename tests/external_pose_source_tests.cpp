@@ -0,0 +1,416 @@
+#include "harness/harness.h"
+#include "harness/provider_fixture.h"
+#include "driver_settings.h"
+#include "external_pose_protocol.h"
+#include "external_pose_source.h"
+#include "hand_skeleton.h"
+#include "pose_export.h"
+#include "pose_source.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#endif
+
+using harness::ProviderFixture;
+
+namespace {
+
+// A tracked, connected left hand controller at the origin, measured now
+vr::ExternalPoseSample ControllerSample(uint32_t unDeviceIndex) {
+  vr::ExternalPoseSample sample = {};
+  sample.unDeviceIndex = unDeviceIndex;
+  sample.unFlags = vr::ExternalPose_Connected | vr::ExternalPose_Valid;
+  sample.nDeviceClass = vr::TrackedDeviceClass_Controller;
+  sample.nControllerRole = vr::TrackedControllerRole_LeftHand;
+  sample.nTimestampNs = vr::PoseExportNowNs();
+  sample.position[1] = 1.0;
+  sample.rotation[0] = 1.0;
+  return sample;
+}
+
+// Trigger fully pulled and touched, grip half way
+vr::ExternalInputSample TriggerPulledSample(uint32_t unDeviceIndex) {
+  vr::ExternalInputSample sample = {};
+  sample.unDeviceIndex = unDeviceIndex;
+  sample.unButtons = (1u << vr::MirrorButton_TriggerClick) | (1u << vr::MirrorButton_TriggerTouch);
+  sample.flAxes[vr::MirrorAxis_TriggerValue] = 1.f;
+  sample.flAxes[vr::MirrorAxis_GripValue] = 0.5f;
+  sample.nTimestampNs = vr::PoseExportNowNs();
+  return sample;
+}
+
+// Runs frames until a mirror with the serial exists, giving a receive thread time to deliver
+uint32_t WaitForMirror(ProviderFixture& fixture, const char* pchSerial) {
+  for (int frame = 0; frame < 500; ++frame) {
+    fixture.RunFrames(1);
+    const uint32_t mirror = fixture.GetMirror(pchSerial);
+    if (mirror != vr::k_unTrackedDeviceIndexInvalid) {
+      return mirror;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return vr::k_unTrackedDeviceIndexInvalid;
+}
+
+// Runs frames until a component has been updated unUpdates times
+bool WaitForUpdates(ProviderFixture& fixture, vr::VRInputComponentHandle_t ulComponent, uint64_t unUpdates) {
+  for (int frame = 0; frame < 500; ++frame) {
+    fixture.RunFrames(1);
+    if (fixture.Context().Input().Get(ulComponent).unUpdates >= unUpdates) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return false;
+}
+
+void CheckTriggerPulled(ProviderFixture& fixture, vr::PropertyContainerHandle_t ulContainer) {
+  harness::ScriptedDriverInput& input = fixture.Context().Input();
+  CHECK(input.Get(input.Find(ulContainer, "/input/trigger/click")).bValue);
+  CHECK(input.Get(input.Find(ulContainer, "/input/trigger/touch")).bValue);
+  CHECK(!input.Get(input.Find(ulContainer, "/input/grip/click")).bValue);
+  CHECK_NEAR(input.Get(input.Find(ulContainer, "/input/trigger/value")).flValue, 1.0, 1e-6);
+  CHECK_NEAR(input.Get(input.Find(ulContainer, "/input/grip/value")).flValue, 0.5, 1e-6);
+
+  // The same state curls the left hand's skeleton: index closed, the other three fingers half way
+  const vr::VRInputComponentHandle_t skeleton = input.Find(ulContainer, "/input/skeleton/left");
+  CHECK(skeleton != vr::k_ulInvalidInputComponentHandle);
+  const float curls[vr::HandFinger_Count] = {0.f, 1.f, 0.5f, 0.5f, 0.5f};
+  alignas(32) vr::VRBoneTransform_t expected[vr::k_unHandBoneLanes];
+  vr::BlendHandSkeleton(vr::GetHandSkeletonPoses(true), curls, expected);
+  for (uint32_t bone = 0; bone < vr::HandBone_Count; ++bone) {
+    const vr::VRBoneTransform_t& submitted = input.Get(skeleton).bones[vr::VRSkeletalMotionRange_WithController][bone];
+    for (int k = 0; k < 3; ++k) {
+      CHECK_NEAR(submitted.position.v[k], expected[bone].position.v[k], 1e-6);
+    }
+    CHECK_NEAR(submitted.orientation.w, expected[bone].orientation.w, 1e-6);
+    CHECK_NEAR(submitted.orientation.z, expected[bone].orientation.z, 1e-6);
+  }
+}
+
+#if defined(__linux__)
+
+// The tracker's end of the UDP source: a loopback socket on an ephemeral port
+class LoopbackTracker {
+ public:
+  LoopbackTracker() : m_socket(socket(AF_INET, SOCK_DGRAM, 0)) {
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(m_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+  }
+  ~LoopbackTracker() { close(m_socket); }
+
+  template <typename T>
+  void Send(uint16_t unPort, vr::EExternalPosePayload ePayload, const T& sample) {
+    unsigned char packet[sizeof(vr::ExternalPosePacketHeader) + sizeof(T)];
+    vr::ExternalPosePacketHeader header;
+    memcpy(header.rgchMagic, vr::k_rgchExternalPosePacketMagic, sizeof(header.rgchMagic));
+    header.unVersion = vr::k_unExternalPoseVersion;
+    header.unSampleCount = 1;
+    header.unPayload = ePayload;
+    memcpy(packet, &header, sizeof(header));
+    memcpy(packet + sizeof(header), &sample, sizeof(sample));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(unPort);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sendto(m_socket, packet, sizeof(packet), 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+  }
+
+  // Waits up to a second for a datagram; returns its size, or -1
+  ssize_t Receive(void* pBuffer, size_t unSize) {
+    pollfd descriptor = {m_socket, POLLIN, 0};
+    if (poll(&descriptor, 1, 1000) != 1) {
+      return -1;
+    }
+    return recv(m_socket, pBuffer, unSize, 0);
+  }
+
+ private:
+  int m_socket;
+};
+
+// A port nothing is listening on right now
+uint16_t FindFreeUdpPort() {
+  const int probe = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t length = sizeof(address);
+  bind(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+  getsockname(probe, reinterpret_cast<sockaddr*>(&address), &length);
+  close(probe);
+  return ntohs(address.sin_port);
+}
+
+#endif
+
+}  // namespace
+
+#if defined(__linux__)
+
+HARNESS_TEST(external_pose_source, UdpInputReachesTheMirrorAndHapticsComeBack) {
+  const uint16_t port = FindFreeUdpPort();
+  ProviderFixture fixture;
+  fixture.SetSetting(vr::k_pch_MyDriver_PoseSource_Int32, (float)vr::PoseSource_Udp);
+  fixture.SetSetting(vr::k_pch_MyDriver_ExternalPoseUdpPort_Int32, (float)port);
+  fixture.Init();
+
+  LoopbackTracker tracker;
+  tracker.Send(port, vr::ExternalPosePayload_Poses, ControllerSample(5));
+  const uint32_t mirror = WaitForMirror(fixture, "my_left_controller_serial");
+  CHECK(mirror != vr::k_unTrackedDeviceIndexInvalid);
+  const vr::PropertyContainerHandle_t container = fixture.Context().Properties().TrackedDeviceToPropertyContainer(mirror);
+  harness::ScriptedDriverInput& input = fixture.Context().Input();
+  const vr::VRInputComponentHandle_t trigger = input.Find(container, "/input/trigger/value");
+  CHECK(trigger != vr::k_ulInvalidInputComponentHandle);
+
+  tracker.Send(port, vr::ExternalPosePayload_Input, TriggerPulledSample(5));
+  CHECK(WaitForUpdates(fixture, trigger, 1));
+  CheckTriggerPulled(fixture, container);
+
+  // A game vibrates the mirror; the pulse goes back to the tracker, addressed to its device 5
+  fixture.Host().QueueHapticEvent(container, input.Find(container, "/output/haptic"), 0.25f, 160.f, 0.75f);
+  fixture.RunFrames(1);
+  unsigned char packet[256];
+  const ssize_t received = tracker.Receive(packet, sizeof(packet));
+  CHECK_EQ(received, (ssize_t)(sizeof(vr::ExternalPosePacketHeader) + sizeof(vr::ExternalHapticPulse)));
+  if (received == (ssize_t)(sizeof(vr::ExternalPosePacketHeader) + sizeof(vr::ExternalHapticPulse))) {
+    vr::ExternalPosePacketHeader header;
+    vr::ExternalHapticPulse pulse;
+    memcpy(&header, packet, sizeof(header));
+    memcpy(&pulse, packet + sizeof(header), sizeof(pulse));
+    CHECK(memcmp(header.rgchMagic, vr::k_rgchExternalPosePacketMagic, sizeof(header.rgchMagic)) == 0);
+    CHECK_EQ(header.unPayload, (uint32_t)vr::ExternalPosePayload_Haptics);
+    CHECK_EQ(header.unSampleCount, 1u);
+    CHECK_EQ(pulse.unDeviceIndex, 5u);
+    CHECK_NEAR(pulse.flDurationSeconds, 0.25, 1e-6);
+    CHECK_NEAR(pulse.flFrequency, 160.0, 1e-6);
+    CHECK_NEAR(pulse.flAmplitude, 0.75, 1e-6);
+  }
+
+  // Nothing new published, nothing resent
+  const uint64_t updates = input.Get(trigger).unUpdates;
+  fixture.RunFrames(5);
+  CHECK_EQ(input.Get(trigger).unUpdates, updates);
+}
+
+#endif
+
+HARNESS_TEST(external_pose_source, SharedMemoryInputReachesTheMirrorAndHapticsComeBack) {
+  const std::string name = "/mydriver_input_test_" + std::to_string(getpid());
+  vr::ExternalPoseRingWriter writer;
+  CHECK(writer.Open(name.c_str()));
+
+  ProviderFixture fixture;
+  fixture.SetSetting(vr::k_pch_MyDriver_PoseSource_Int32, (float)vr::PoseSource_SharedMemory);
+  fixture.SetSetting(vr::k_pch_MyDriver_ExternalPoseSharedMemoryName_String, name.c_str());
+  fixture.Init();
+
+  writer.Write(ControllerSample(3));
+  const uint32_t mirror = WaitForMirror(fixture, "my_left_controller_serial");
+  CHECK(mirror != vr::k_unTrackedDeviceIndexInvalid);
+  const vr::PropertyContainerHandle_t container = fixture.Context().Properties().TrackedDeviceToPropertyContainer(mirror);
+  harness::ScriptedDriverInput& input = fixture.Context().Input();
+  const vr::VRInputComponentHandle_t trigger = input.Find(container, "/input/trigger/value");
+
+  writer.Write(ControllerSample(3));
+  writer.WriteInput(TriggerPulledSample(3));
+  CHECK(WaitForUpdates(fixture, trigger, 1));
+  CheckTriggerPulled(fixture, container);
+
+  vr::ExternalHapticPulse pulse;
+  CHECK(!writer.ReadHapticPulse(pulse));
+  fixture.Host().QueueHapticEvent(container, input.Find(container, "/output/haptic"), 0.1f, 320.f, 0.5f);
+  writer.Write(ControllerSample(3)); // Keeps the mirror tracked, so the frame samples and flushes the pulse
+  fixture.RunFrames(1);
+  CHECK(writer.ReadHapticPulse(pulse));
+  CHECK_EQ(pulse.unDeviceIndex, 3u);
+  CHECK_NEAR(pulse.flDurationSeconds, 0.1, 1e-6);
+  CHECK_NEAR(pulse.flFrequency, 320.0, 1e-6);
+  CHECK_NEAR(pulse.flAmplitude, 0.5, 1e-6);
+  CHECK(!writer.ReadHapticPulse(pulse));
+}
+
+// The sources on their own, fed by a local sender
+
+namespace {
+
+// A tracked device at (x, 1, 0) with identity rotation, measured nTimestampNs
+vr::ExternalPoseSample TrackerSample(uint32_t unDeviceIndex, double flX, int64_t nTimestampNs) {
+  vr::ExternalPoseSample sample = ControllerSample(unDeviceIndex);
+  sample.nDeviceClass = vr::TrackedDeviceClass_GenericTracker;
+  sample.nControllerRole = vr::TrackedControllerRole_Invalid;
+  sample.nTimestampNs = nTimestampNs;
+  sample.position[0] = flX;
+  return sample;
+}
+
+// Samples until unIndex has a pose whose x is at least flMinX, for up to a second
+bool SampleUntil(vr::IPoseSource& source, uint32_t unIndex, double flMinX, vr::TrackedDevicePose_t (&poses)[vr::k_unMaxTrackedDeviceCount]) {
+  for (int attempt = 0; attempt < 1000; ++attempt) {
+    source.Sample(poses, vr::k_unMaxTrackedDeviceCount);
+    if (poses[unIndex].bPoseIsValid && poses[unIndex].mDeviceToAbsoluteTracking.m[0][3] >= flMinX) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return false;
+}
+
+const int64_t k_nMs = 1000000;
+
+}  // namespace
+
+// With a 50 ms delay, a pose is evaluated half way between samples 100 ms apart, plus the time the test takes
+HARNESS_TEST(external_pose_source, SharedMemoryInterpolatesBetweenSamples) {
+  const std::string name = "/mydriver_pose_test_" + std::to_string(getpid());
+  vr::ExternalPoseRingWriter writer;
+  CHECK(writer.Open(name.c_str()));
+  vr::SharedMemoryPoseSource source(0.050, 1.0);
+  CHECK(source.Open(name.c_str()));
+
+  const int64_t now = vr::PoseExportNowNs();
+  writer.Write(TrackerSample(7, 0.0, now - 100 * k_nMs));
+  writer.Write(TrackerSample(7, 1.0, now));
+  vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+  source.Sample(poses, vr::k_unMaxTrackedDeviceCount);
+  const double elapsed = (double)(vr::PoseExportNowNs() - now) / (100 * k_nMs);
+
+  CHECK(poses[7].bPoseIsValid);
+  CHECK_EQ(poses[7].eTrackingResult, vr::TrackingResult_Running_OK);
+  const double x = poses[7].mDeviceToAbsoluteTracking.m[0][3];
+  CHECK(x >= 0.5 - 1e-6 && x <= 0.5 + elapsed + 1e-6);
+  CHECK_NEAR(poses[7].mDeviceToAbsoluteTracking.m[1][3], 1.0, 1e-6);
+  CHECK_NEAR(poses[7].vVelocity.v[0], 10.0, 1e-3); // Derived from the pair: 1 m in 100 ms
+  CHECK(!poses[6].bDeviceIsConnected);
+
+  int32_t deviceClass = 0;
+  int32_t role = 0;
+  CHECK(source.GetDevice(7, deviceClass, role));
+  CHECK_EQ(deviceClass, (int32_t)vr::TrackedDeviceClass_GenericTracker);
+  CHECK(!source.GetDevice(6, deviceClass, role));
+}
+
+HARNESS_TEST(external_pose_source, SharedMemoryReportsStaleDevicesOutOfRange) {
+  const std::string name = "/mydriver_stale_test_" + std::to_string(getpid());
+  vr::ExternalPoseRingWriter writer;
+  CHECK(writer.Open(name.c_str()));
+  vr::SharedMemoryPoseSource source(0.0, 0.1);
+  CHECK(source.Open(name.c_str()));
+
+  writer.Write(TrackerSample(2, 0.5, vr::PoseExportNowNs() - 200 * k_nMs)); // The tracker stopped sending 200 ms ago
+  vr::ExternalPoseSample lost = TrackerSample(3, 0.5, vr::PoseExportNowNs());
+  lost.unFlags = vr::ExternalPose_Connected; // Tracker says it lost the device
+  writer.Write(lost);
+  vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+  source.Sample(poses, vr::k_unMaxTrackedDeviceCount);
+  for (uint32_t index : {2u, 3u}) {
+    CHECK(poses[index].bDeviceIsConnected);
+    CHECK(!poses[index].bPoseIsValid);
+    CHECK_EQ(poses[index].eTrackingResult, vr::TrackingResult_Running_OutOfRange);
+  }
+
+  writer.Write(TrackerSample(2, 0.5, vr::PoseExportNowNs()));
+  source.Sample(poses, vr::k_unMaxTrackedDeviceCount);
+  CHECK(poses[2].bPoseIsValid);
+}
+
+// The driver may come up first; the ring is picked up once the tracker creates it (looked up
+// again at most once a second, the first time on the first Sample after Open)
+HARNESS_TEST(external_pose_source, SharedMemoryWaitsForALateTracker) {
+  const std::string name = "/mydriver_late_test_" + std::to_string(getpid());
+  vr::SharedMemoryPoseSource source(0.0, 1.0);
+  CHECK(source.Open(name.c_str())); // Nothing to map yet, but the source is usable
+
+  vr::ExternalPoseRingWriter writer;
+  CHECK(writer.Open(name.c_str()));
+  vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+  source.Sample(poses, vr::k_unMaxTrackedDeviceCount); // Finds the ring
+  CHECK(!poses[1].bDeviceIsConnected);
+  writer.Write(TrackerSample(1, 0.25, vr::PoseExportNowNs()));
+  source.Sample(poses, vr::k_unMaxTrackedDeviceCount);
+  CHECK(poses[1].bPoseIsValid);
+  CHECK_NEAR(poses[1].mDeviceToAbsoluteTracking.m[0][3], 0.25, 1e-6);
+}
+
+#if defined(__linux__)
+
+HARNESS_TEST(external_pose_source, UdpInterpolatesBetweenSamples) {
+  const uint16_t port = FindFreeUdpPort();
+  vr::UdpPoseSource source(0.050, 1.0);
+  CHECK(source.Open(port));
+
+  LoopbackTracker tracker;
+  const int64_t now = vr::PoseExportNowNs();
+  tracker.Send(port, vr::ExternalPosePayload_Poses, TrackerSample(4, 0.0, now - 100 * k_nMs));
+  tracker.Send(port, vr::ExternalPosePayload_Poses, TrackerSample(4, 1.0, now));
+  vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+  CHECK(SampleUntil(source, 4, 0.5 - 1e-6, poses)); // Until the second datagram is in
+  const double elapsed = (double)(vr::PoseExportNowNs() - now) / (100 * k_nMs);
+  const double x = poses[4].mDeviceToAbsoluteTracking.m[0][3];
+  CHECK(x <= 0.5 + elapsed + 1e-6);
+  CHECK_NEAR(poses[4].vVelocity.v[0], 10.0, 1e-3);
+}
+
+HARNESS_TEST(external_pose_source, UdpDropsBadDatagramsAndReorderedSamples) {
+  const uint16_t port = FindFreeUdpPort();
+  vr::UdpPoseSource source(0.0, 1.0);
+  CHECK(source.Open(port));
+
+  LoopbackTracker tracker;
+  const int64_t now = vr::PoseExportNowNs();
+  tracker.Send(port, vr::ExternalPosePayload_Poses, TrackerSample(9, 0.75, now));
+  tracker.Send(port, vr::ExternalPosePayload_Poses, TrackerSample(9, 0.0, now - 10 * k_nMs)); // Arrives late
+  tracker.Send(port, vr::ExternalPosePayload_Haptics, TrackerSample(9, 0.0, now)); // Only the driver sends haptics
+  tracker.Send(port, vr::ExternalPosePayload_Input, TrackerSample(9, 0.0, now)); // Size doesn't match the payload
+  vr::ExternalPoseSample unnormalized = TrackerSample(9, 0.0, now + k_nMs);
+  unnormalized.rotation[0] = 0.0;
+  tracker.Send(port, vr::ExternalPosePayload_Poses, unnormalized);
+
+  for (int attempt = 0; attempt < 1000 && (source.GetRejectedPacketCount() < 2 || source.GetRejectedCount() < 2); ++attempt) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  CHECK_EQ(source.GetRejectedPacketCount(), 2u);
+  CHECK_EQ(source.GetRejectedCount(), 2u);
+  vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+  source.Sample(poses, vr::k_unMaxTrackedDeviceCount);
+  CHECK(poses[9].bPoseIsValid);
+  CHECK_NEAR(poses[9].mDeviceToAbsoluteTracking.m[0][3], 0.75, 1e-6);
+}
+
+// End to end: a tracker sending over UDP becomes a mirror that follows it
+HARNESS_TEST(external_pose_source, UdpTrackerIsMirrored) {
+  const uint16_t port = FindFreeUdpPort();
+  ProviderFixture fixture;
+  fixture.SetSetting(vr::k_pch_MyDriver_PoseSource_Int32, (float)vr::PoseSource_Udp);
+  fixture.SetSetting(vr::k_pch_MyDriver_ExternalPoseUdpPort_Int32, (float)port);
+  fixture.Init();
+
+  LoopbackTracker tracker;
+  tracker.Send(port, vr::ExternalPosePayload_Poses, TrackerSample(6, 0.3, vr::PoseExportNowNs()));
+  const uint32_t mirror = WaitForMirror(fixture, "my_mirror_6_serial");
+  CHECK(mirror != vr::k_unTrackedDeviceIndexInvalid);
+
+  tracker.Send(port, vr::ExternalPosePayload_Poses, TrackerSample(6, 0.4, vr::PoseExportNowNs()));
+  bool followed = false;
+  for (int frame = 0; frame < 500 && !followed; ++frame) {
+    fixture.RunFrames(1);
+    const vr::DriverPose_t& pose = fixture.Host().GetLastPose(mirror);
+    followed = pose.poseIsValid && std::fabs(pose.vecPosition[0] - 0.4) < 1e-6;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  CHECK(followed);
+}
+
+#endif
@@ -0,0 +1,36 @@
+#include "harness/harness.h"
+#include "hand_skeleton.h"
+
+// One whole-hand blend (curl spread plus kernel) per kernel, with the curls changing every call. A blend
+// is well under the clock's resolution here, so each sample times a batch of them.
+HARNESS_BENCH(hand_skeleton, BlendHandSkeleton) {
+  const uint32_t iterations = harness::IsQuickRun() ? 100 : 20000;
+  const uint32_t batch = 64;
+  const vr::HandSkeletonPoses& poses = vr::GetHandSkeletonPoses(false);
+  alignas(32) static vr::VRBoneTransform_t bones[vr::k_unHandBoneLanes];
+
+  printf("  Picked kernel: %s\n", vr::GetHandSkeletonKernelName());
+  const vr::EHandSkeletonKernel kernels[] = {vr::HandSkeletonKernel_Scalar, vr::HandSkeletonKernel_SSE2, vr::HandSkeletonKernel_AVX};
+  const char* const names[] = {"Scalar", "SSE2", "AVX"};
+  for (int kernel = 0; kernel < 3; ++kernel) {
+    if (!vr::IsHandSkeletonKernelSupported(kernels[kernel])) {
+      printf("  %-7s not supported here\n", names[kernel]);
+      continue;
+    }
+    harness::LatencySamples samples(iterations);
+    const uint64_t allocations = harness::GetAllocationCount();
+    for (uint32_t i = 0; i < iterations; ++i) {
+      const int64_t start = harness::NowNs();
+      for (uint32_t blend = 0; blend < batch; ++blend) {
+        const float curl = blend / (float)(batch - 1);
+        const float curls[vr::HandFinger_Count] = {curl, 1.f - curl, curl, curl, 0.5f * curl};
+        vr::BlendHandSkeletonWithKernel(kernels[kernel], poses, curls, bones);
+        harness::DoNotOptimize(bones);
+      }
+      samples.Add(harness::NowNs() - start);
+    }
+    printf("  %-7s bones=%u  p50=%6.1f ns  p99=%6.1f ns  mean=%6.1f ns per hand  allocations=%llu\n", names[kernel], (uint32_t)vr::HandBone_Count,
+           (double)samples.Percentile(50) / batch, (double)samples.Percentile(99) / batch, samples.Mean() / batch,
+           (unsigned long long)(harness::GetAllocationCount() - allocations));
+  }
+}
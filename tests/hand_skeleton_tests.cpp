@@ -0,0 +1,156 @@
+#include "harness/harness.h"
+#include "hand_skeleton.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+// Parent of every bone in SteamVR's hand skeleton
+const uint32_t k_rgunBoneParent[vr::HandBone_Count] = {
+  0, 0, // Root (none), wrist
+  1, 2, 3, 4, // Thumb
+  1, 6, 7, 8, 9, // Index
+  1, 11, 12, 13, 14, // Middle
+  1, 16, 17, 18, 19, // Ring
+  1, 21, 22, 23, 24, // Pinky
+  0, 0, 0, 0, 0, // Aux, in root space
+};
+
+// Distal joint of each finger, which its aux bone copies
+const uint32_t k_rgunDistalBone[vr::HandFinger_Count] = {vr::HandBone_Thumb2, vr::HandBone_IndexFinger3, vr::HandBone_MiddleFinger3,
+                                                          vr::HandBone_RingFinger3, vr::HandBone_PinkyFinger3};
+const uint32_t k_rgunTipBone[vr::HandFinger_Count] = {vr::HandBone_Thumb3, vr::HandBone_IndexFinger4, vr::HandBone_MiddleFinger4,
+                                                       vr::HandBone_RingFinger4, vr::HandBone_PinkyFinger4};
+
+struct ModelBone {
+  double position[3];
+  double rotation[4]; // w, x, y, z
+};
+
+void QuatMultiply(const double a[4], const double b[4], double out[4]) {
+  out[0] = a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3];
+  out[1] = a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2];
+  out[2] = a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1];
+  out[3] = a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0];
+}
+
+// Chains the parent-relative bones into root space
+void ToModelSpace(const vr::VRBoneTransform_t* pBones, ModelBone* pOut) {
+  for (uint32_t bone = 0; bone < vr::HandBone_Count; ++bone) {
+    const vr::VRBoneTransform_t& local = pBones[bone];
+    const double position[4] = {0.0, local.position.v[0], local.position.v[1], local.position.v[2]};
+    const double rotation[4] = {local.orientation.w, local.orientation.x, local.orientation.y, local.orientation.z};
+    if (bone == vr::HandBone_Root) {
+      pOut[bone] = {{position[1], position[2], position[3]}, {rotation[0], rotation[1], rotation[2], rotation[3]}};
+      continue;
+    }
+    const ModelBone& parent = pOut[k_rgunBoneParent[bone]];
+    const double conj[4] = {parent.rotation[0], -parent.rotation[1], -parent.rotation[2], -parent.rotation[3]};
+    double qp[4];
+    double rotated[4];
+    QuatMultiply(parent.rotation, position, qp);
+    QuatMultiply(qp, conj, rotated);
+    for (int k = 0; k < 3; ++k) {
+      pOut[bone].position[k] = parent.position[k] + rotated[k + 1];
+    }
+    QuatMultiply(parent.rotation, rotation, pOut[bone].rotation);
+  }
+}
+
+double Distance(const double a[3], const double b[3]) {
+  return std::sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+}
+
+}  // namespace
+
+// The blend ends are SteamVR's open hand and fist: every finger closes toward the wrist, the aux
+// bones stay on the distal joints, and the right hand is the left one mirrored
+HARNESS_TEST(hand_skeleton, ReferencePosesCurlTheFingersAndMirrorBetweenHands) {
+  const float open[vr::HandFinger_Count] = {0.f, 0.f, 0.f, 0.f, 0.f};
+  const float fist[vr::HandFinger_Count] = {1.f, 1.f, 1.f, 1.f, 1.f};
+  alignas(32) vr::VRBoneTransform_t bones[vr::k_unHandBoneLanes];
+  ModelBone model[2][2][vr::HandBone_Count]; // [left hand][fist]
+
+  for (int left = 0; left < 2; ++left) {
+    for (int closed = 0; closed < 2; ++closed) {
+      vr::BlendHandSkeleton(vr::GetHandSkeletonPoses(left != 0), closed ? fist : open, bones);
+      for (uint32_t bone = 0; bone < vr::HandBone_Count; ++bone) {
+        const vr::HmdQuaternionf_t& q = bones[bone].orientation;
+        CHECK_NEAR(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z, 1.0, 1e-6);
+        CHECK_EQ(bones[bone].position.v[3], 1.f);
+      }
+      ToModelSpace(bones, model[left][closed]);
+
+      for (uint32_t finger = 0; finger < vr::HandFinger_Count; ++finger) {
+        const ModelBone& aux = model[left][closed][vr::HandBone_Aux_Thumb + finger];
+        const ModelBone& distal = model[left][closed][k_rgunDistalBone[finger]];
+        for (int k = 0; k < 3; ++k) {
+          CHECK_NEAR(aux.position[k], distal.position[k], 1e-4);
+        }
+      }
+    }
+
+    const ModelBone* wrist = &model[left][0][vr::HandBone_Wrist];
+    for (uint32_t finger = 0; finger < vr::HandFinger_Count; ++finger) {
+      const double openReach = Distance(model[left][0][k_rgunTipBone[finger]].position, wrist->position);
+      const double fistReach = Distance(model[left][1][k_rgunTipBone[finger]].position, wrist->position);
+      CHECK(fistReach < openReach - 0.04);
+    }
+  }
+
+  for (int closed = 0; closed < 2; ++closed) {
+    for (uint32_t bone = 0; bone < vr::HandBone_Count; ++bone) {
+      CHECK_NEAR(model[0][closed][bone].position[0], -model[1][closed][bone].position[0], 1e-5);
+      CHECK_NEAR(model[0][closed][bone].position[1], model[1][closed][bone].position[1], 1e-5);
+      CHECK_NEAR(model[0][closed][bone].position[2], model[1][closed][bone].position[2], 1e-5);
+    }
+  }
+}
+
+HARNESS_TEST(hand_skeleton, CurlsPickTheirFingersBones) {
+  const vr::HandSkeletonPoses& poses = vr::GetHandSkeletonPoses(false);
+  const float curls[vr::HandFinger_Count] = {0.f, 1.f, 0.f, 0.f, 0.f}; // Pointing
+  alignas(32) vr::VRBoneTransform_t bones[vr::k_unHandBoneLanes];
+  vr::BlendHandSkeleton(poses, curls, bones);
+  for (uint32_t bone = 0; bone < vr::HandBone_Count; ++bone) {
+    const vr::HandBoneTable& expected = poses.finger[bone] == vr::HandFinger_Index ? poses.closed : poses.open;
+    for (int k = 0; k < 3; ++k) {
+      CHECK_NEAR(bones[bone].position.v[k], expected.position[k][bone], 1e-6);
+    }
+    CHECK_NEAR(bones[bone].orientation.w, expected.rotation[0][bone], 1e-6);
+    CHECK_NEAR(bones[bone].orientation.x, expected.rotation[1][bone], 1e-6);
+    CHECK_NEAR(bones[bone].orientation.y, expected.rotation[2][bone], 1e-6);
+    CHECK_NEAR(bones[bone].orientation.z, expected.rotation[3][bone], 1e-6);
+  }
+}
+
+HARNESS_TEST(hand_skeleton, SimdKernelsAgreeWithScalar) {
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> curl(-0.2f, 1.2f); // Also past the ends, which the blend clamps
+  alignas(32) vr::VRBoneTransform_t scalar[vr::k_unHandBoneLanes];
+  alignas(32) vr::VRBoneTransform_t simd[vr::k_unHandBoneLanes];
+  double maxError = 0.0;
+  for (uint32_t set = 0; set < 2000; ++set) {
+    float curls[vr::HandFinger_Count];
+    for (uint32_t finger = 0; finger < vr::HandFinger_Count; ++finger) {
+      curls[finger] = curl(rng);
+    }
+    const vr::HandSkeletonPoses& poses = vr::GetHandSkeletonPoses((set & 1) != 0);
+    CHECK(vr::BlendHandSkeletonWithKernel(vr::HandSkeletonKernel_Scalar, poses, curls, scalar));
+    for (vr::EHandSkeletonKernel kernel : {vr::HandSkeletonKernel_SSE2, vr::HandSkeletonKernel_AVX}) {
+      if (!vr::BlendHandSkeletonWithKernel(kernel, poses, curls, simd)) {
+        continue;
+      }
+      for (uint32_t bone = 0; bone < vr::HandBone_Count; ++bone) {
+        const float* a = &scalar[bone].position.v[0];
+        const float* b = &simd[bone].position.v[0];
+        for (int k = 0; k < 8; ++k) {
+          maxError = std::max(maxError, (double)std::fabs(a[k] - b[k]));
+        }
+      }
+    }
+  }
+  CHECK(maxError < 5e-7); // Same operations in the same order; the SIMD sqrt and divide are correctly rounded too
+}
@@ -0,0 +1,5 @@
+#include "harness.h"
+
+int main(int argc, char** argv) {
+  return harness::RunRegistered(argc, argv, true);
+}
@@ -0,0 +1,152 @@
+#include "harness.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace harness {
+
+namespace {
+
+thread_local uint64_t g_unAllocations = 0; // Per thread, so background threads (log writer, receive threads) don't show up
+
+std::vector<TestCase>& Registry() {
+  static std::vector<TestCase> tests;
+  return tests;
+}
+
+bool g_bQuick = false;
+uint32_t g_unFailures = 0;
+
+}  // namespace
+
+Registrar::Registrar(const char* pchSuite, const char* pchName, TestFunction pfn, bool bBenchmark) {
+  Registry().push_back({pchSuite, pchName, pfn, bBenchmark});
+}
+
+bool IsQuickRun() {
+  return g_bQuick;
+}
+
+void ReportFailure(const char* pchFile, int nLine, const char* pchExpression, double flActual, double flExpected) {
+  ++g_unFailures;
+  if (std::isnan(flActual) && std::isnan(flExpected)) {
+    printf("  %s:%d: CHECK(%s) failed\n", pchFile, nLine, pchExpression);
+  } else {
+    printf("  %s:%d: CHECK(%s) failed: %.9g vs %.9g\n", pchFile, nLine, pchExpression, flActual, flExpected);
+  }
+}
+
+uint64_t GetAllocationCount() {
+  return g_unAllocations;
+}
+
+int RunRegistered(int argc, char** argv, bool bBenchmarks) {
+  const char* pchSuite = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--quick") == 0) {
+      g_bQuick = true;
+    } else {
+      pchSuite = argv[i];
+    }
+  }
+
+  uint32_t run = 0;
+  uint32_t failed = 0;
+  for (const TestCase& test : Registry()) {
+    if (test.bBenchmark != bBenchmarks || (pchSuite && strcmp(pchSuite, test.pchSuite) != 0)) {
+      continue;
+    }
+    printf("[ RUN  ] %s.%s\n", test.pchSuite, test.pchName);
+    fflush(stdout);
+    const uint32_t failuresBefore = g_unFailures;
+    test.pfn();
+    ++run;
+    if (g_unFailures != failuresBefore) {
+      ++failed;
+      printf("[ FAIL ] %s.%s\n", test.pchSuite, test.pchName);
+    } else {
+      printf("[  OK  ] %s.%s\n", test.pchSuite, test.pchName);
+    }
+    fflush(stdout);
+  }
+
+  if (run == 0) {
+    printf("No %s matched %s\n", bBenchmarks ? "benchmarks" : "tests", pchSuite ? pchSuite : "(all)");
+    return 1;
+  }
+  printf("%u run, %u failed\n", run, failed);
+  return failed == 0 ? 0 : 1;
+}
+
+}  // namespace harness
+
+// Counting replacements of the global allocation functions; the aligned and nothrow forms
+// forward here, and every delete form frees with free()
+
+void* operator new(std::size_t unSize) {
+  ++harness::g_unAllocations;
+  void* p = malloc(unSize ? unSize : 1);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void* operator new[](std::size_t unSize) {
+  return operator new(unSize);
+}
+
+void* operator new(std::size_t unSize, const std::nothrow_t&) noexcept {
+  ++harness::g_unAllocations;
+  return malloc(unSize ? unSize : 1);
+}
+
+void* operator new[](std::size_t unSize, const std::nothrow_t& tag) noexcept {
+  return operator new(unSize, tag);
+}
+
+void* operator new(std::size_t unSize, std::align_val_t alignment) {
+  ++harness::g_unAllocations;
+  void* p = nullptr;
+  if (posix_memalign(&p, std::max(sizeof(void*), (size_t)alignment), unSize ? unSize : 1) != 0) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void* operator new[](std::size_t unSize, std::align_val_t alignment) {
+  return operator new(unSize, alignment);
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+  free(p);
+}
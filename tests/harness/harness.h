@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Minimal test and benchmark runner for the headless harness. Tests and benchmarks register
+// themselves by suite; tests/CMakeLists.txt adds one ctest entry per suite.
+//
+//   HARNESS_TEST(pose_prediction, ExtrapolatesLinearMotion) {
+//     CHECK_NEAR(predicted, expected, 1e-6);
+//   }
+//
+// A failed CHECK reports and returns from the test, so later checks may assume earlier ones held.
+
+namespace harness {
+
+typedef void (*TestFunction)();
+
+struct TestCase {
+  const char* pchSuite;
+  const char* pchName;
+  TestFunction pfn;
+  bool bBenchmark;
+};
+
+// Registration, from the HARNESS_TEST/HARNESS_BENCH statics
+struct Registrar {
+  Registrar(const char* pchSuite, const char* pchName, TestFunction pfn, bool bBenchmark);
+};
+
+// Runs every test (or benchmark) whose suite matches the first argument, or all of them without one.
+// Benchmarks take "--quick" for a short smoke run. Returns the process exit code.
+int RunRegistered(int argc, char** argv, bool bBenchmarks);
+
+// True while running benchmarks with --quick; benchmarks scale their iteration counts down
+bool IsQuickRun();
+
+// Records a failed check for the current test
+void ReportFailure(const char* pchFile, int nLine, const char* pchExpression, double flActual, double flExpected);
+
+// Heap allocations (operator new calls) made by the calling thread so far
+uint64_t GetAllocationCount();
+
+inline int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Latency samples of one measurement, preallocated so recording never allocates
+class LatencySamples {
+ public:
+  explicit LatencySamples(size_t unCapacity) { m_samples.reserve(unCapacity); }
+  void Add(int64_t nNs) {
+    if (m_samples.size() < m_samples.capacity()) {
+      m_samples.push_back(nNs);
+    }
+  }
+  size_t GetCount() const { return m_samples.size(); }
+  // Nearest-rank percentile, 0..100; sorts the samples
+  int64_t Percentile(double flPercent) {
+    if (m_samples.empty()) {
+      return 0;
+    }
+    std::sort(m_samples.begin(), m_samples.end());
+    const size_t rank = (size_t)std::ceil(flPercent / 100.0 * m_samples.size());
+    return m_samples[rank > 0 ? rank - 1 : 0];
+  }
+  double Mean() const {
+    double sum = 0.0;
+    for (int64_t sample : m_samples) {
+      sum += (double)sample;
+    }
+    return m_samples.empty() ? 0.0 : sum / m_samples.size();
+  }
+
+ private:
+  std::vector<int64_t> m_samples;
+};
+
+// Keeps a computed value alive so the optimizer can't drop the work that produced it
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+}  // namespace harness
+
+#define HARNESS_REGISTER(suite, name, bench)                                                              \
+  static void suite##_##name();                                                                           \
+  static ::harness::Registrar s_registrar_##suite##_##name(#suite, #name, &suite##_##name, bench);        \
+  static void suite##_##name()
+
+#define HARNESS_TEST(suite, name) HARNESS_REGISTER(suite, name, false)
+#define HARNESS_BENCH(suite, name) HARNESS_REGISTER(suite, name, true)
+
+#define CHECK(expression)                                                                \
+  do {                                                                                   \
+    if (!(expression)) {                                                                 \
+      ::harness::ReportFailure(__FILE__, __LINE__, #expression, NAN, NAN);               \
+      return;                                                                            \
+    }                                                                                    \
+  } while (0)
+
+#define CHECK_EQ(actual, expected)                                                                        \
+  do {                                                                                                    \
+    const auto checkActual = (actual);                                                                    \
+    const auto checkExpected = (expected);                                                                \
+    if (!(checkActual == checkExpected)) {                                                                \
+      ::harness::ReportFailure(__FILE__, __LINE__, #actual " == " #expected, (double)checkActual, (double)checkExpected); \
+      return;                                                                                             \
+    }                                                                                                     \
+  } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                                           \
+  do {                                                                                                    \
+    const double checkActual = (double)(actual);                                                          \
+    const double checkExpected = (double)(expected);                                                      \
+    if (!(std::fabs(checkActual - checkExpected) <= (tolerance))) {                                       \
+      ::harness::ReportFailure(__FILE__, __LINE__, #actual " ~= " #expected, checkActual, checkExpected); \
+      return;                                                                                             \
+    }                                                                                                     \
+  } while (0)
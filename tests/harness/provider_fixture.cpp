@@ -0,0 +1,77 @@
+#include "provider_fixture.h"
+#include "driver_settings.h"
+
+#include <string>
+
+namespace harness {
+
+ProviderFixture::ProviderFixture()
+    : m_pContext(new ScriptedDriverContext()),
+      m_pProvider(new vr::MyTrackedDeviceProvider()),
+      m_bInitialized(false) {
+}
+
+ProviderFixture::~ProviderFixture() {
+  Shutdown();
+}
+
+void ProviderFixture::AddDevices(uint32_t unCount) {
+  ScriptedServerDriverHost& host = Host();
+  if (host.GetPhysicalCount() == 0) {
+    host.AddPhysicalDevice(vr::TrackedDeviceClass_HMD, vr::TrackedControllerRole_Invalid, "hmd");
+  }
+  for (uint32_t i = 0; i < unCount; ++i) {
+    const std::string serial = "physical_" + std::to_string(host.GetPhysicalCount());
+    if (i == 0) {
+      host.AddPhysicalDevice(vr::TrackedDeviceClass_Controller, vr::TrackedControllerRole_LeftHand, serial.c_str());
+    } else if (i == 1) {
+      host.AddPhysicalDevice(vr::TrackedDeviceClass_Controller, vr::TrackedControllerRole_RightHand, serial.c_str());
+    } else {
+      host.AddPhysicalDevice(vr::TrackedDeviceClass_GenericTracker, vr::TrackedControllerRole_Invalid, serial.c_str());
+    }
+  }
+}
+
+void ProviderFixture::SetSetting(const char* pchKey, float flValue) {
+  m_pContext->Settings().SetFloat(vr::k_pch_MyDriver_Section, pchKey, flValue);
+}
+
+void ProviderFixture::SetSetting(const char* pchKey, const char* pchValue) {
+  m_pContext->Settings().SetString(vr::k_pch_MyDriver_Section, pchKey, pchValue);
+}
+
+vr::EVRInitError ProviderFixture::Init() {
+  const vr::EVRInitError error = InitProvider();
+  Host().ActivatePendingDevices();
+  return error;
+}
+
+vr::EVRInitError ProviderFixture::InitProvider() {
+  m_bInitialized = true; // Cleanup also undoes a failed Init, e.g. stops the log writer
+  return m_pProvider->Init(m_pContext.get());
+}
+
+void ProviderFixture::RunFrames(uint32_t unCount, double flFrameSeconds) {
+  for (uint32_t i = 0; i < unCount; ++i) {
+    m_pContext->AdvanceTime(flFrameSeconds);
+    m_pProvider->RunFrame();
+    Host().ActivatePendingDevices();
+  }
+}
+
+void ProviderFixture::Shutdown() {
+  if (!m_bInitialized) {
+    return;
+  }
+  Host().DeactivateDevices();
+  m_pProvider->Cleanup();
+  m_bInitialized = false;
+}
+
+std::string ProviderFixture::DebugRequest(uint32_t unObjectId, const char* pchRequest) {
+  char response[4096];
+  Host().GetAddedDriver(unObjectId)->DebugRequest(pchRequest, response, sizeof(response));
+  return response;
+}
+
+}  // namespace harness
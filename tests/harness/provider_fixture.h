@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+
+#include "driver_main.h"
+#include "scripted_driver_context.h"
+
+namespace harness {
+
+// One MyTrackedDeviceProvider on its own ScriptedDriverContext, driven the way vrserver drives it:
+// Init, host-side activation of whatever the driver added, RunFrame per frame, then deactivation
+// and Cleanup. Settings and physical devices are set up on Context() before Init.
+class ProviderFixture {
+ public:
+  ProviderFixture();
+  ~ProviderFixture();
+
+  ScriptedDriverContext& Context() { return *m_pContext; }
+  ScriptedServerDriverHost& Host() { return m_pContext->Host(); }
+  vr::MyTrackedDeviceProvider& Provider() { return *m_pProvider; }
+
+  // An HMD at index 0 plus unCount mirrorable devices: a left and a right hand controller, then generic trackers
+  void AddDevices(uint32_t unCount);
+  // Sets a driver_mydriver setting
+  void SetSetting(const char* pchKey, float flValue);
+  void SetSetting(const char* pchKey, const char* pchValue);
+
+  // Init, then activates the mirrors it added
+  vr::EVRInitError Init();
+  // Init alone, for timing it apart from the activation; Shutdown still runs Cleanup
+  vr::EVRInitError InitProvider();
+  // Advances the script clock by flFrameSeconds and runs one frame, unCount times. Activates any mirror
+  // added by the frame (hot-plug) before the next one.
+  void RunFrames(uint32_t unCount, double flFrameSeconds = 1.0 / 90.0);
+  // Deactivates the mirrors and runs Cleanup; also done by the destructor
+  void Shutdown();
+
+  // Object id of the mirror added with a serial, k_unTrackedDeviceIndexInvalid if none
+  uint32_t GetMirror(const char* pchSerial) const { return m_pContext->Host().FindObjectId(pchSerial); }
+  // Sends a DebugRequest to a mirror and returns the response
+  std::string DebugRequest(uint32_t unObjectId, const char* pchRequest);
+
+ private:
+  std::unique_ptr<ScriptedDriverContext> m_pContext;
+  std::unique_ptr<vr::MyTrackedDeviceProvider> m_pProvider;
+  bool m_bInitialized;
+};
+
+}  // namespace harness
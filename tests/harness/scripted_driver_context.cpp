@@ -0,0 +1,543 @@
+#include "scripted_driver_context.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace harness {
+
+void SetRawPose(vr::TrackedDevicePose_t& outPose, const double position[3], const double rotation[4]) {
+  const double w = rotation[0], x = rotation[1], y = rotation[2], z = rotation[3];
+  float (*m)[4] = outPose.mDeviceToAbsoluteTracking.m;
+  m[0][0] = (float)(1.0 - 2.0 * (y * y + z * z)); m[0][1] = (float)(2.0 * (x * y - w * z));       m[0][2] = (float)(2.0 * (x * z + w * y));
+  m[1][0] = (float)(2.0 * (x * y + w * z));       m[1][1] = (float)(1.0 - 2.0 * (x * x + z * z)); m[1][2] = (float)(2.0 * (y * z - w * x));
+  m[2][0] = (float)(2.0 * (x * z - w * y));       m[2][1] = (float)(2.0 * (y * z + w * x));       m[2][2] = (float)(1.0 - 2.0 * (x * x + y * y));
+  for (int k = 0; k < 3; ++k) {
+    m[k][3] = (float)position[k];
+    outPose.vVelocity.v[k] = 0.f;
+    outPose.vAngularVelocity.v[k] = 0.f;
+  }
+  outPose.eTrackingResult = vr::TrackingResult_Running_OK;
+  outPose.bPoseIsValid = true;
+  outPose.bDeviceIsConnected = true;
+}
+
+void CirclePoseScript(uint32_t unDeviceIndex, double flTimeSeconds, vr::TrackedDevicePose_t& outPose) {
+  // 10 cm circle at 0.5 Hz around a per-device center, yawing at 1 rad/s
+  const double radius = 0.1;
+  const double omega = M_PI;
+  const double phase = omega * flTimeSeconds + unDeviceIndex;
+  const double position[3] = {0.3 * unDeviceIndex + radius * cos(phase), 1.0 + radius * sin(phase), -0.5};
+  const double yaw = flTimeSeconds + 0.1 * unDeviceIndex;
+  const double rotation[4] = {cos(yaw / 2.0), 0.0, sin(yaw / 2.0), 0.0};
+  SetRawPose(outPose, position, rotation);
+  outPose.vVelocity.v[0] = (float)(-radius * omega * sin(phase));
+  outPose.vVelocity.v[1] = (float)(radius * omega * cos(phase));
+  outPose.vAngularVelocity.v[1] = 1.f;
+}
+
+static void SetDisconnectedRawPose(vr::TrackedDevicePose_t& outPose) {
+  memset(&outPose, 0, sizeof(outPose));
+  outPose.eTrackingResult = vr::TrackingResult_Uninitialized;
+}
+
+// ScriptedServerDriverHost
+
+ScriptedServerDriverHost::ScriptedServerDriverHost(ScriptedDriverContext* pContext)
+    : m_pContext(pContext),
+      m_poseScript(&CirclePoseScript),
+      m_unDeviceCount(0),
+      m_unAddedCount(0),
+      m_bRecordHistory(false),
+      m_unRawPoseRequests(0) {
+  for (uint32_t i = 0; i < k_unMaxDevices; ++i) {
+    m_bConnected[i].store(false, std::memory_order_relaxed);
+    m_pDrivers[i] = nullptr;
+    m_unPoseUpdates[i] = 0;
+    memset(&m_lastPose[i], 0, sizeof(m_lastPose[i]));
+  }
+}
+
+uint32_t ScriptedServerDriverHost::AddPhysicalDevice(vr::ETrackedDeviceClass eClass, int32_t nControllerRole, const char* pchSerial) {
+  if (m_unDeviceCount >= k_unMaxDevices) {
+    return vr::k_unTrackedDeviceIndexInvalid;
+  }
+  const uint32_t index = m_unDeviceCount.load(std::memory_order_relaxed);
+  m_sSerials[index] = pchSerial;
+  m_bConnected[index].store(true, std::memory_order_relaxed);
+  ScriptedProperties& properties = m_pContext->Properties();
+  properties.SetInt32(index, vr::Prop_DeviceClass_Int32, eClass);
+  properties.SetString(index, vr::Prop_SerialNumber_String, pchSerial);
+  if (eClass == vr::TrackedDeviceClass_Controller) {
+    properties.SetInt32(index, vr::Prop_ControllerRoleHint_Int32, nControllerRole);
+  }
+  m_unDeviceCount.store(index + 1, std::memory_order_release);
+  return index;
+}
+
+void ScriptedServerDriverHost::SetDeviceConnected(uint32_t unDeviceIndex, bool bConnected) {
+  m_bConnected[unDeviceIndex].store(bConnected, std::memory_order_release);
+}
+
+uint32_t ScriptedServerDriverHost::ActivatePendingDevices() {
+  std::vector<uint32_t> pending;
+  pending.swap(m_pendingActivation);
+  for (uint32_t objectId : pending) {
+    m_pDrivers[objectId]->Activate(objectId);
+    QueueEvent(vr::VREvent_TrackedDeviceActivated, objectId);
+  }
+  return (uint32_t)pending.size();
+}
+
+void ScriptedServerDriverHost::DeactivateDevices() {
+  for (uint32_t i = 0; i < m_unDeviceCount; ++i) {
+    if (m_pDrivers[i]) {
+      m_pDrivers[i]->Deactivate();
+      m_pDrivers[i] = nullptr; // The provider destroys it in Cleanup
+    }
+  }
+  m_pendingActivation.clear();
+}
+
+void ScriptedServerDriverHost::QueueEvent(uint32_t unEventType, uint32_t unDeviceIndex) {
+  vr::VREvent_t event;
+  memset(&event, 0, sizeof(event));
+  event.eventType = unEventType;
+  event.trackedDeviceIndex = unDeviceIndex;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_events.push_back(event);
+}
+
+void ScriptedServerDriverHost::QueueHapticEvent(vr::PropertyContainerHandle_t ulContainer, vr::VRInputComponentHandle_t ulComponent, float flDuration,
+                                                float flFrequency, float flAmplitude) {
+  vr::VREvent_t event;
+  memset(&event, 0, sizeof(event));
+  event.eventType = vr::VREvent_Input_HapticVibration;
+  event.trackedDeviceIndex = vr::k_unTrackedDeviceIndexInvalid;
+  event.data.hapticVibration.containerHandle = ulContainer;
+  event.data.hapticVibration.componentHandle = ulComponent;
+  event.data.hapticVibration.fDurationSeconds = flDuration;
+  event.data.hapticVibration.fFrequency = flFrequency;
+  event.data.hapticVibration.fAmplitude = flAmplitude;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_events.push_back(event);
+}
+
+uint32_t ScriptedServerDriverHost::FindObjectId(const char* pchSerial) const {
+  for (uint32_t i = 0; i < m_unDeviceCount; ++i) {
+    if (m_pDrivers[i] && m_sSerials[i] == pchSerial) {
+      return i;
+    }
+  }
+  return vr::k_unTrackedDeviceIndexInvalid;
+}
+
+uint64_t ScriptedServerDriverHost::GetTotalPoseUpdateCount() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < k_unMaxDevices; ++i) {
+    total += m_unPoseUpdates[i];
+  }
+  return total;
+}
+
+void ScriptedServerDriverHost::RecordPoseHistory(size_t unCapacity) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_poseHistory.clear();
+  m_poseHistory.reserve(unCapacity);
+  m_bRecordHistory = unCapacity > 0;
+}
+
+void ScriptedServerDriverHost::ClearPoseUpdates() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (uint32_t i = 0; i < k_unMaxDevices; ++i) {
+    m_unPoseUpdates[i] = 0;
+  }
+  m_poseHistory.clear();
+}
+
+vr::EVRInitError ScriptedServerDriverHost::TrackedDeviceAdded(const char* pchDeviceSerialNumber, vr::ETrackedDeviceClass eDeviceClass,
+                                                              vr::ITrackedDeviceServerDriver* pDriver) {
+  if (m_unDeviceCount >= k_unMaxDevices || !pDriver) {
+    return vr::VRInitError_Driver_Failed;
+  }
+  const uint32_t objectId = m_unDeviceCount.load(std::memory_order_relaxed);
+  ++m_unAddedCount;
+  m_pDrivers[objectId] = pDriver;
+  m_sSerials[objectId] = pchDeviceSerialNumber;
+  m_pContext->Properties().SetInt32(objectId, vr::Prop_DeviceClass_Int32, eDeviceClass);
+  m_pContext->Properties().SetString(objectId, vr::Prop_SerialNumber_String, pchDeviceSerialNumber);
+  m_unDeviceCount.store(objectId + 1, std::memory_order_release);
+  m_pendingActivation.push_back(objectId); // Activated by the "server" later, never from inside this call
+  return vr::VRInitError_None;
+}
+
+void ScriptedServerDriverHost::TrackedDevicePoseUpdated(uint32_t unWhichDevice, const vr::DriverPose_t& newPose, uint32_t unPoseStructSize) {
+  if (unWhichDevice >= k_unMaxDevices || unPoseStructSize != sizeof(vr::DriverPose_t)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_unPoseUpdates[unWhichDevice];
+  m_lastPose[unWhichDevice] = newPose;
+  if (m_bRecordHistory && m_poseHistory.size() < m_poseHistory.capacity()) {
+    m_poseHistory.push_back({unWhichDevice, newPose, m_pContext->GetTime()});
+  }
+}
+
+bool ScriptedServerDriverHost::PollNextEvent(vr::VREvent_t* pEvent, uint32_t uncbVREvent) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_events.empty() || uncbVREvent != sizeof(vr::VREvent_t)) {
+    return false;
+  }
+  *pEvent = m_events.front();
+  m_events.pop_front();
+  return true;
+}
+
+void ScriptedServerDriverHost::GetRawTrackedDevicePoses(float fPredictedSecondsFromNow, vr::TrackedDevicePose_t* pTrackedDevicePoseArray,
+                                                        uint32_t unTrackedDevicePoseArrayCount) {
+  m_unRawPoseRequests.fetch_add(1, std::memory_order_relaxed);
+  const double time = m_pContext->GetTime() + fPredictedSecondsFromNow;
+  const uint32_t deviceCount = m_unDeviceCount.load(std::memory_order_acquire);
+  for (uint32_t i = 0; i < unTrackedDevicePoseArrayCount; ++i) {
+    if (i < deviceCount && !m_pDrivers[i] && m_bConnected[i].load(std::memory_order_acquire)) {
+      m_poseScript(i, time, pTrackedDevicePoseArray[i]);
+    } else {
+      SetDisconnectedRawPose(pTrackedDevicePoseArray[i]); // Unused index, switched off, or one of the driver's own
+    }
+  }
+}
+
+// ScriptedSettings
+
+const char* ScriptedSettings::GetSettingsErrorNameFromEnum(vr::EVRSettingsError eError) {
+  return eError == vr::VRSettingsError_None ? "None" : "UnsetSettingHasNoDefault";
+}
+
+const ScriptedSettings::Value* ScriptedSettings::Find(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError) const {
+  auto section = m_sections.find(pchSection);
+  const Value* pValue = nullptr;
+  if (section != m_sections.end()) {
+    auto key = section->second.find(pchSettingsKey);
+    if (key != section->second.end()) {
+      pValue = &key->second;
+    }
+  }
+  if (peError) {
+    *peError = pValue ? vr::VRSettingsError_None : vr::VRSettingsError_UnsetSettingHasNoDefault;
+  }
+  return pValue;
+}
+
+void ScriptedSettings::Set(const char* pchSection, const char* pchSettingsKey, double flNumber, const char* pchText, vr::EVRSettingsError* peError) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Value& value = m_sections[pchSection][pchSettingsKey];
+  value.flNumber = flNumber;
+  value.sText = pchText ? pchText : std::to_string(flNumber);
+  if (peError) {
+    *peError = vr::VRSettingsError_None;
+  }
+}
+
+void ScriptedSettings::SetBool(const char* pchSection, const char* pchSettingsKey, bool bValue, vr::EVRSettingsError* peError) {
+  Set(pchSection, pchSettingsKey, bValue ? 1.0 : 0.0, bValue ? "true" : "false", peError);
+}
+
+void ScriptedSettings::SetInt32(const char* pchSection, const char* pchSettingsKey, int32_t nValue, vr::EVRSettingsError* peError) {
+  Set(pchSection, pchSettingsKey, nValue, nullptr, peError);
+}
+
+void ScriptedSettings::SetFloat(const char* pchSection, const char* pchSettingsKey, float flValue, vr::EVRSettingsError* peError) {
+  Set(pchSection, pchSettingsKey, flValue, nullptr, peError);
+}
+
+void ScriptedSettings::SetString(const char* pchSection, const char* pchSettingsKey, const char* pchValue, vr::EVRSettingsError* peError) {
+  Set(pchSection, pchSettingsKey, atof(pchValue), pchValue, peError);
+}
+
+bool ScriptedSettings::GetBool(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const Value* pValue = Find(pchSection, pchSettingsKey, peError);
+  return pValue && pValue->flNumber != 0.0;
+}
+
+int32_t ScriptedSettings::GetInt32(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const Value* pValue = Find(pchSection, pchSettingsKey, peError);
+  return pValue ? (int32_t)pValue->flNumber : 0;
+}
+
+float ScriptedSettings::GetFloat(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const Value* pValue = Find(pchSection, pchSettingsKey, peError);
+  return pValue ? (float)pValue->flNumber : 0.f;
+}
+
+void ScriptedSettings::GetString(const char* pchSection, const char* pchSettingsKey, char* pchValue, uint32_t unValueLen, vr::EVRSettingsError* peError) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const Value* pValue = Find(pchSection, pchSettingsKey, peError);
+  if (unValueLen > 0) {
+    snprintf(pchValue, unValueLen, "%s", pValue ? pValue->sText.c_str() : "");
+  }
+}
+
+void ScriptedSettings::RemoveSection(const char* pchSection, vr::EVRSettingsError* peError) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_sections.erase(pchSection);
+  if (peError) {
+    *peError = vr::VRSettingsError_None;
+  }
+}
+
+void ScriptedSettings::RemoveKeyInSection(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto section = m_sections.find(pchSection);
+  if (section != m_sections.end()) {
+    section->second.erase(pchSettingsKey);
+  }
+  if (peError) {
+    *peError = vr::VRSettingsError_None;
+  }
+}
+
+// ScriptedProperties
+
+void ScriptedProperties::Write(vr::PropertyContainerHandle_t ulContainer, vr::ETrackedDeviceProperty prop, vr::PropertyTypeTag_t unTag,
+                               const void* pvData, uint32_t unSize) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Value& value = m_values[std::make_pair(ulContainer, (int32_t)prop)];
+  value.unTag = unTag;
+  value.bytes.assign(static_cast<const uint8_t*>(pvData), static_cast<const uint8_t*>(pvData) + unSize);
+}
+
+void ScriptedProperties::SetInt32(uint32_t unDeviceIndex, vr::ETrackedDeviceProperty prop, int32_t nValue) {
+  Write(TrackedDeviceToPropertyContainer(unDeviceIndex), prop, vr::k_unInt32PropertyTag, &nValue, sizeof(nValue));
+}
+
+void ScriptedProperties::SetString(uint32_t unDeviceIndex, vr::ETrackedDeviceProperty prop, const char* pchValue) {
+  Write(TrackedDeviceToPropertyContainer(unDeviceIndex), prop, vr::k_unStringPropertyTag, pchValue, (uint32_t)strlen(pchValue) + 1);
+}
+
+bool ScriptedProperties::GetInt32(uint32_t unDeviceIndex, vr::ETrackedDeviceProperty prop, int32_t& outValue) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_values.find(std::make_pair((vr::PropertyContainerHandle_t)unDeviceIndex + 1, (int32_t)prop));
+  if (it == m_values.end() || it->second.unTag != vr::k_unInt32PropertyTag) {
+    return false;
+  }
+  memcpy(&outValue, it->second.bytes.data(), sizeof(outValue));
+  return true;
+}
+
+std::string ScriptedProperties::GetString(uint32_t unDeviceIndex, vr::ETrackedDeviceProperty prop) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_values.find(std::make_pair((vr::PropertyContainerHandle_t)unDeviceIndex + 1, (int32_t)prop));
+  if (it == m_values.end() || it->second.unTag != vr::k_unStringPropertyTag) {
+    return std::string();
+  }
+  return std::string(reinterpret_cast<const char*>(it->second.bytes.data()));
+}
+
+vr::ETrackedPropertyError ScriptedProperties::ReadPropertyBatch(vr::PropertyContainerHandle_t ulContainerHandle, vr::PropertyRead_t* pBatch,
+                                                                uint32_t unBatchEntryCount) {
+  if (ulContainerHandle == vr::k_ulInvalidPropertyContainer) {
+    return vr::TrackedProp_InvalidContainer;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (uint32_t i = 0; i < unBatchEntryCount; ++i) {
+    vr::PropertyRead_t& read = pBatch[i];
+    auto it = m_values.find(std::make_pair(ulContainerHandle, (int32_t)read.prop));
+    if (it == m_values.end()) {
+      read.unTag = vr::k_unInvalidPropertyTag;
+      read.unRequiredBufferSize = 0;
+      read.eError = vr::TrackedProp_ValueNotProvidedByDevice;
+      continue;
+    }
+    read.unTag = it->second.unTag;
+    read.unRequiredBufferSize = (uint32_t)it->second.bytes.size();
+    if (read.unBufferSize < read.unRequiredBufferSize) {
+      read.eError = vr::TrackedProp_BufferTooSmall;
+      continue;
+    }
+    memcpy(read.pvBuffer, it->second.bytes.data(), it->second.bytes.size());
+    read.eError = vr::TrackedProp_Success;
+  }
+  return vr::TrackedProp_Success;
+}
+
+vr::ETrackedPropertyError ScriptedProperties::WritePropertyBatch(vr::PropertyContainerHandle_t ulContainerHandle, vr::PropertyWrite_t* pBatch,
+                                                                 uint32_t unBatchEntryCount) {
+  if (ulContainerHandle == vr::k_ulInvalidPropertyContainer) {
+    return vr::TrackedProp_InvalidContainer;
+  }
+  for (uint32_t i = 0; i < unBatchEntryCount; ++i) {
+    vr::PropertyWrite_t& write = pBatch[i];
+    if (write.writeType == vr::PropertyWrite_Set) {
+      Write(ulContainerHandle, write.prop, write.unTag, write.pvBuffer, write.unBufferSize);
+    } else {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_values.erase(std::make_pair(ulContainerHandle, (int32_t)write.prop));
+    }
+    write.eError = vr::TrackedProp_Success;
+  }
+  return vr::TrackedProp_Success;
+}
+
+vr::PropertyContainerHandle_t ScriptedProperties::TrackedDeviceToPropertyContainer(vr::TrackedDeviceIndex_t nDevice) {
+  return nDevice < vr::k_unMaxTrackedDeviceCount ? (vr::PropertyContainerHandle_t)nDevice + 1 : vr::k_ulInvalidPropertyContainer;
+}
+
+// ScriptedDriverLog
+
+void ScriptedDriverLog::Log(const char* pchLogMessage) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_lines.emplace_back(pchLogMessage);
+}
+
+std::vector<std::string> ScriptedDriverLog::GetLines() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_lines;
+}
+
+bool ScriptedDriverLog::Contains(const char* pchText) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (const std::string& line : m_lines) {
+    if (line.find(pchText) != std::string::npos) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ScriptedDriverLog::Clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_lines.clear();
+}
+
+// ScriptedDriverInput
+
+ScriptedDriverInput::ScriptedDriverInput() : m_components(k_unMaxComponents), m_unComponentCount(0) {
+}
+
+vr::EVRInputError ScriptedDriverInput::Create(vr::PropertyContainerHandle_t ulContainer, const char* pchName, EComponentType eType,
+                                              vr::VRInputComponentHandle_t* pHandle) {
+  if (m_unComponentCount >= k_unMaxComponents) {
+    *pHandle = vr::k_ulInvalidInputComponentHandle;
+    return vr::VRInputError_InvalidHandle;
+  }
+  Component& component = m_components[m_unComponentCount++];
+  component.ulContainer = ulContainer;
+  component.sName = pchName;
+  component.eType = eType;
+  component.bValue = false;
+  component.flValue = 0.f;
+  component.unUpdates = 0;
+  component.unBoneCount = 0;
+  *pHandle = m_unComponentCount; // Index + 1, so 0 stays invalid
+  return vr::VRInputError_None;
+}
+
+ScriptedDriverInput::Component* ScriptedDriverInput::Lookup(vr::VRInputComponentHandle_t ulHandle, EComponentType eType) {
+  if (ulHandle == vr::k_ulInvalidInputComponentHandle || ulHandle > m_unComponentCount || m_components[ulHandle - 1].eType != eType) {
+    return nullptr;
+  }
+  return &m_components[ulHandle - 1];
+}
+
+vr::VRInputComponentHandle_t ScriptedDriverInput::Find(vr::PropertyContainerHandle_t ulContainer, const char* pchName) const {
+  for (size_t i = m_unComponentCount; i-- > 0;) { // Newest first, in case a container was reused
+    if (m_components[i].ulContainer == ulContainer && m_components[i].sName == pchName) {
+      return i + 1;
+    }
+  }
+  return vr::k_ulInvalidInputComponentHandle;
+}
+
+uint64_t ScriptedDriverInput::GetTotalUpdateCount() const {
+  uint64_t total = 0;
+  for (size_t i = 0; i < m_unComponentCount; ++i) {
+    total += m_components[i].unUpdates;
+  }
+  return total;
+}
+
+vr::EVRInputError ScriptedDriverInput::CreateBooleanComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle) {
+  return Create(ulContainer, pchName, Component_Boolean, pHandle);
+}
+
+vr::EVRInputError ScriptedDriverInput::UpdateBooleanComponent(vr::VRInputComponentHandle_t ulComponent, bool bNewValue, double fTimeOffset) {
+  Component* pComponent = Lookup(ulComponent, Component_Boolean);
+  if (!pComponent) {
+    return vr::VRInputError_InvalidHandle;
+  }
+  pComponent->bValue = bNewValue;
+  ++pComponent->unUpdates;
+  return vr::VRInputError_None;
+}
+
+vr::EVRInputError ScriptedDriverInput::CreateScalarComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle,
+                                                             vr::EVRScalarType eType, vr::EVRScalarUnits eUnits) {
+  return Create(ulContainer, pchName, Component_Scalar, pHandle);
+}
+
+vr::EVRInputError ScriptedDriverInput::UpdateScalarComponent(vr::VRInputComponentHandle_t ulComponent, float fNewValue, double fTimeOffset) {
+  Component* pComponent = Lookup(ulComponent, Component_Scalar);
+  if (!pComponent) {
+    return vr::VRInputError_InvalidHandle;
+  }
+  pComponent->flValue = fNewValue;
+  ++pComponent->unUpdates;
+  return vr::VRInputError_None;
+}
+
+vr::EVRInputError ScriptedDriverInput::CreateHapticComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle) {
+  return Create(ulContainer, pchName, Component_Haptic, pHandle);
+}
+
+vr::EVRInputError ScriptedDriverInput::CreateSkeletonComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, const char* pchSkeletonPath,
+                                                               const char* pchBasePosePath, vr::EVRSkeletalTrackingLevel eSkeletalTrackingLevel,
+                                                               const vr::VRBoneTransform_t* pGripLimitTransforms, uint32_t unGripLimitTransformCount,
+                                                               vr::VRInputComponentHandle_t* pHandle) {
+  return Create(ulContainer, pchName, Component_Skeleton, pHandle);
+}
+
+vr::EVRInputError ScriptedDriverInput::UpdateSkeletonComponent(vr::VRInputComponentHandle_t ulComponent, vr::EVRSkeletalMotionRange eMotionRange,
+                                                               const vr::VRBoneTransform_t* pTransforms, uint32_t unTransformCount) {
+  Component* pComponent = Lookup(ulComponent, Component_Skeleton);
+  const uint32_t capacity = sizeof(pComponent->bones[0]) / sizeof(pComponent->bones[0][0]);
+  if (!pComponent || unTransformCount > capacity || (eMotionRange != vr::VRSkeletalMotionRange_WithController && eMotionRange != vr::VRSkeletalMotionRange_WithoutController)) {
+    return vr::VRInputError_InvalidHandle;
+  }
+  memcpy(pComponent->bones[eMotionRange], pTransforms, unTransformCount * sizeof(vr::VRBoneTransform_t));
+  pComponent->unBoneCount = unTransformCount;
+  ++pComponent->unUpdates;
+  return vr::VRInputError_None;
+}
+
+// ScriptedDriverContext
+
+ScriptedDriverContext::ScriptedDriverContext() : m_host(this), m_flTime(0.0), m_unMissingInterfaces(0) {
+}
+
+void* ScriptedDriverContext::GetGenericInterface(const char* pchInterfaceVersion, vr::EVRInitError* peError) {
+  void* pInterface = nullptr;
+  if (strcmp(pchInterfaceVersion, vr::IVRServerDriverHost_Version) == 0) {
+    pInterface = static_cast<vr::IVRServerDriverHost*>(&m_host);
+  } else if (strcmp(pchInterfaceVersion, vr::IVRSettings_Version) == 0) {
+    pInterface = static_cast<vr::IVRSettings*>(&m_settings);
+  } else if (strcmp(pchInterfaceVersion, vr::IVRProperties_Version) == 0) {
+    pInterface = static_cast<vr::IVRProperties*>(&m_properties);
+  } else if (strcmp(pchInterfaceVersion, vr::IVRDriverLog_Version) == 0) {
+    pInterface = static_cast<vr::IVRDriverLog*>(&m_log);
+  } else if (strcmp(pchInterfaceVersion, vr::IVRDriverInput_Version) == 0) {
+    pInterface = static_cast<vr::IVRDriverInput*>(&m_input);
+  } else {
+    ++m_unMissingInterfaces;
+  }
+  if (peError) {
+    *peError = pInterface ? vr::VRInitError_None : vr::VRInitError_Init_InterfaceNotFound;
+  }
+  return pInterface;
+}
+
+}  // namespace harness
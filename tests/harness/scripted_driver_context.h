@@ -0,0 +1,262 @@
+#pragma once
+
+#include <openvr_driver.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace harness {
+
+// Stand-in for the server the driver talks to. IVRDriverContext is the only way in to
+// IVRServerDriverHost, IVRSettings, IVRProperties, IVRDriverLog and IVRDriverInput, so handing a
+// ScriptedDriverContext to MyTrackedDeviceProvider::Init runs the real driver code headless.
+//
+// The host side is scripted: physical devices are added up front, their raw poses come from a
+// pose script evaluated at the context's clock, events are queued by the test, and everything the
+// driver sends back (pose updates, properties, input component updates, log lines) is recorded.
+// The hot paths (GetRawTrackedDevicePoses, PollNextEvent on an empty queue, TrackedDevicePoseUpdated,
+// the Update*Component calls) never allocate, so allocation counts taken around RunFrame are the driver's.
+class ScriptedDriverContext;
+
+// Evaluates the raw pose of a physical device at a script time in seconds
+typedef std::function<void(uint32_t unDeviceIndex, double flTimeSeconds, vr::TrackedDevicePose_t& outPose)> PoseScript;
+
+// A tracked pose moving on a small circle, different per device, with matching velocities
+void CirclePoseScript(uint32_t unDeviceIndex, double flTimeSeconds, vr::TrackedDevicePose_t& outPose);
+
+// Fills a valid, connected raw pose from a position and a w, x, y, z rotation
+void SetRawPose(vr::TrackedDevicePose_t& outPose, const double position[3], const double rotation[4]);
+
+class ScriptedServerDriverHost : public vr::IVRServerDriverHost {
+ public:
+  static const uint32_t k_unMaxDevices = vr::k_unMaxTrackedDeviceCount;
+
+  // One TrackedDevicePoseUpdated call
+  struct PoseUpdate {
+    uint32_t unObjectId;
+    vr::DriverPose_t pose;
+    double flScriptTime; // Context clock when the host received it
+  };
+
+  explicit ScriptedServerDriverHost(ScriptedDriverContext* pContext);
+
+  // Adds a physical device the driver finds at Init (or through the next device event). Returns its index.
+  uint32_t AddPhysicalDevice(vr::ETrackedDeviceClass eClass, int32_t nControllerRole, const char* pchSerial);
+  // Marks a physical device connected or not; a disconnected device reports invalid poses
+  void SetDeviceConnected(uint32_t unDeviceIndex, bool bConnected);
+  void SetPoseScript(PoseScript script) { m_poseScript = std::move(script); }
+
+  // Host-side activation of the devices the driver added, as vrserver does after TrackedDeviceAdded.
+  // Also queues a VREvent_TrackedDeviceActivated for each, like the real host. Returns how many were activated.
+  uint32_t ActivatePendingDevices();
+  // Deactivates every added device, as vrserver does before the provider's Cleanup
+  void DeactivateDevices();
+
+  void QueueEvent(uint32_t unEventType, uint32_t unDeviceIndex);
+  void QueueHapticEvent(vr::PropertyContainerHandle_t ulContainer, vr::VRInputComponentHandle_t ulComponent, float flDuration, float flFrequency, float flAmplitude);
+
+  // Driver-added devices
+  uint32_t GetAddedCount() const { return m_unAddedCount; }
+  bool IsAdded(uint32_t unObjectId) const { return unObjectId < m_unDeviceCount && m_pDrivers[unObjectId] != nullptr; }
+  vr::ITrackedDeviceServerDriver* GetAddedDriver(uint32_t unObjectId) const { return m_pDrivers[unObjectId]; }
+  const std::string& GetAddedSerial(uint32_t unObjectId) const { return m_sSerials[unObjectId]; }
+  uint32_t FindObjectId(const char* pchSerial) const; // k_unTrackedDeviceIndexInvalid if not added
+  uint32_t GetPhysicalCount() const { return m_unDeviceCount - m_unAddedCount; }
+
+  // Pose updates the driver sent
+  uint64_t GetPoseUpdateCount(uint32_t unObjectId) const { return m_unPoseUpdates[unObjectId]; }
+  uint64_t GetTotalPoseUpdateCount() const;
+  const vr::DriverPose_t& GetLastPose(uint32_t unObjectId) const { return m_lastPose[unObjectId]; }
+  // Every update in order, when enabled; keeps up to unCapacity entries, allocated here
+  void RecordPoseHistory(size_t unCapacity);
+  const std::vector<PoseUpdate>& GetPoseHistory() const { return m_poseHistory; }
+  void ClearPoseUpdates();
+
+  uint64_t GetRawPoseRequestCount() const { return m_unRawPoseRequests.load(std::memory_order_relaxed); }
+
+  // vr::IVRServerDriverHost
+  vr::EVRInitError TrackedDeviceAdded(const char* pchDeviceSerialNumber, vr::ETrackedDeviceClass eDeviceClass, vr::ITrackedDeviceServerDriver* pDriver) override;
+  void TrackedDevicePoseUpdated(uint32_t unWhichDevice, const vr::DriverPose_t& newPose, uint32_t unPoseStructSize) override;
+  void VsyncEvent(double vsyncTimeOffsetSeconds) override {}
+  void VendorSpecificEvent(uint32_t unWhichDevice, vr::EVREventType eventType, const vr::VREvent_Data_t& eventData, double eventTimeOffset) override {}
+  bool IsExiting() override { return false; }
+  bool PollNextEvent(vr::VREvent_t* pEvent, uint32_t uncbVREvent) override;
+  void GetRawTrackedDevicePoses(float fPredictedSecondsFromNow, vr::TrackedDevicePose_t* pTrackedDevicePoseArray, uint32_t unTrackedDevicePoseArrayCount) override;
+  void RequestRestart(const char* pchLocalizedReason, const char* pchExecutablePath, const char* pchArguments, const char* pchWorkingDirectory) override {}
+  uint32_t GetFrameTimings(vr::Compositor_FrameTiming* pTiming, uint32_t nFrames) override { return 0; }
+  void SetDisplayEyeToHead(uint32_t unWhichDevice, const vr::HmdMatrix34_t& eyeToHeadLeft, const vr::HmdMatrix34_t& eyeToHeadRight) override {}
+  void SetDisplayProjectionRaw(uint32_t unWhichDevice, const vr::HmdRect2_t& eyeLeft, const vr::HmdRect2_t& eyeRight) override {}
+  void SetRecommendedRenderTargetSize(uint32_t unWhichDevice, uint32_t nWidth, uint32_t nHeight) override {}
+  uint32_t GetTrackedDeviceCount() override { return m_unDeviceCount; }
+
+ private:
+  ScriptedDriverContext* m_pContext;
+  PoseScript m_poseScript;
+
+  // Physical and driver-added devices share one index space, in the order they were added. The count is
+  // bumped only once the new index is filled in, since a tracking thread may be sampling meanwhile.
+  std::atomic<uint32_t> m_unDeviceCount;
+  uint32_t m_unAddedCount;
+  std::atomic<bool> m_bConnected[k_unMaxDevices]; // Physical devices only
+  vr::ITrackedDeviceServerDriver* m_pDrivers[k_unMaxDevices]; // nullptr for physical devices
+  std::string m_sSerials[k_unMaxDevices];
+  std::vector<uint32_t> m_pendingActivation;
+
+  mutable std::mutex m_mutex; // Pose updates and events; the tracking thread may call in concurrently
+  uint64_t m_unPoseUpdates[k_unMaxDevices];
+  vr::DriverPose_t m_lastPose[k_unMaxDevices];
+  bool m_bRecordHistory;
+  std::vector<PoseUpdate> m_poseHistory;
+  std::deque<vr::VREvent_t> m_events;
+
+  std::atomic<uint64_t> m_unRawPoseRequests;
+};
+
+// In-memory settings store. Unset keys report VRSettingsError_UnsetSettingHasNoDefault, so the driver
+// falls back to its built-in defaults exactly as it does for keys missing from default.vrsettings.
+class ScriptedSettings : public vr::IVRSettings {
+ public:
+  const char* GetSettingsErrorNameFromEnum(vr::EVRSettingsError eError) override;
+  void SetBool(const char* pchSection, const char* pchSettingsKey, bool bValue, vr::EVRSettingsError* peError = nullptr) override;
+  void SetInt32(const char* pchSection, const char* pchSettingsKey, int32_t nValue, vr::EVRSettingsError* peError = nullptr) override;
+  void SetFloat(const char* pchSection, const char* pchSettingsKey, float flValue, vr::EVRSettingsError* peError = nullptr) override;
+  void SetString(const char* pchSection, const char* pchSettingsKey, const char* pchValue, vr::EVRSettingsError* peError = nullptr) override;
+  bool GetBool(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError = nullptr) override;
+  int32_t GetInt32(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError = nullptr) override;
+  float GetFloat(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError = nullptr) override;
+  void GetString(const char* pchSection, const char* pchSettingsKey, char* pchValue, uint32_t unValueLen, vr::EVRSettingsError* peError = nullptr) override;
+  void RemoveSection(const char* pchSection, vr::EVRSettingsError* peError = nullptr) override;
+  void RemoveKeyInSection(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError = nullptr) override;
+
+ private:
+  struct Value {
+    double flNumber;
+    std::string sText;
+  };
+  const Value* Find(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError) const;
+  void Set(const char* pchSection, const char* pchSettingsKey, double flNumber, const char* pchText, vr::EVRSettingsError* peError);
+
+  mutable std::mutex m_mutex;
+  std::map<std::string, std::map<std::string, Value>> m_sections;
+};
+
+// Property containers are device index + 1. Values keep the type tag they were written with.
+class ScriptedProperties : public vr::IVRProperties {
+ public:
+  void SetInt32(uint32_t unDeviceIndex, vr::ETrackedDeviceProperty prop, int32_t nValue);
+  void SetString(uint32_t unDeviceIndex, vr::ETrackedDeviceProperty prop, const char* pchValue);
+  bool GetInt32(uint32_t unDeviceIndex, vr::ETrackedDeviceProperty prop, int32_t& outValue) const;
+  std::string GetString(uint32_t unDeviceIndex, vr::ETrackedDeviceProperty prop) const;
+
+  vr::ETrackedPropertyError ReadPropertyBatch(vr::PropertyContainerHandle_t ulContainerHandle, vr::PropertyRead_t* pBatch, uint32_t unBatchEntryCount) override;
+  vr::ETrackedPropertyError WritePropertyBatch(vr::PropertyContainerHandle_t ulContainerHandle, vr::PropertyWrite_t* pBatch, uint32_t unBatchEntryCount) override;
+  const char* GetPropErrorNameFromEnum(vr::ETrackedPropertyError error) override { return "TrackedPropertyError"; }
+  vr::PropertyContainerHandle_t TrackedDeviceToPropertyContainer(vr::TrackedDeviceIndex_t nDevice) override;
+
+ private:
+  struct Value {
+    vr::PropertyTypeTag_t unTag;
+    std::vector<uint8_t> bytes;
+  };
+  void Write(vr::PropertyContainerHandle_t ulContainer, vr::ETrackedDeviceProperty prop, vr::PropertyTypeTag_t unTag, const void* pvData, uint32_t unSize);
+
+  mutable std::mutex m_mutex;
+  std::map<std::pair<vr::PropertyContainerHandle_t, int32_t>, Value> m_values;
+};
+
+// Collects the formatted lines the driver's log writer thread hands over
+class ScriptedDriverLog : public vr::IVRDriverLog {
+ public:
+  void Log(const char* pchLogMessage) override;
+
+  std::vector<std::string> GetLines() const;
+  bool Contains(const char* pchText) const;
+  void Clear();
+
+ private:
+  mutable std::mutex m_mutex;
+  std::vector<std::string> m_lines;
+};
+
+// Input components by handle (index + 1), with the last value and update count of each
+class ScriptedDriverInput : public vr::IVRDriverInput {
+ public:
+  enum EComponentType { Component_Boolean, Component_Scalar, Component_Haptic, Component_Skeleton };
+
+  struct Component {
+    vr::PropertyContainerHandle_t ulContainer;
+    std::string sName;
+    EComponentType eType;
+    bool bValue;
+    float flValue;
+    uint64_t unUpdates;
+    vr::VRBoneTransform_t bones[2][31]; // Skeletons, per EVRSkeletalMotionRange
+    uint32_t unBoneCount;
+  };
+
+  ScriptedDriverInput();
+
+  // Handle of a component by container and name, k_ulInvalidInputComponentHandle if never created
+  vr::VRInputComponentHandle_t Find(vr::PropertyContainerHandle_t ulContainer, const char* pchName) const;
+  const Component& Get(vr::VRInputComponentHandle_t ulHandle) const { return m_components[ulHandle - 1]; }
+  uint64_t GetTotalUpdateCount() const;
+  size_t GetComponentCount() const { return m_unComponentCount; }
+
+  vr::EVRInputError CreateBooleanComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle) override;
+  vr::EVRInputError UpdateBooleanComponent(vr::VRInputComponentHandle_t ulComponent, bool bNewValue, double fTimeOffset) override;
+  vr::EVRInputError CreateScalarComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle,
+                                          vr::EVRScalarType eType, vr::EVRScalarUnits eUnits) override;
+  vr::EVRInputError UpdateScalarComponent(vr::VRInputComponentHandle_t ulComponent, float fNewValue, double fTimeOffset) override;
+  vr::EVRInputError CreateHapticComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle) override;
+  vr::EVRInputError CreateSkeletonComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, const char* pchSkeletonPath,
+                                            const char* pchBasePosePath, vr::EVRSkeletalTrackingLevel eSkeletalTrackingLevel,
+                                            const vr::VRBoneTransform_t* pGripLimitTransforms, uint32_t unGripLimitTransformCount,
+                                            vr::VRInputComponentHandle_t* pHandle) override;
+  vr::EVRInputError UpdateSkeletonComponent(vr::VRInputComponentHandle_t ulComponent, vr::EVRSkeletalMotionRange eMotionRange,
+                                            const vr::VRBoneTransform_t* pTransforms, uint32_t unTransformCount) override;
+
+ private:
+  static const size_t k_unMaxComponents = 2048; // Preallocated so updates never reallocate
+  vr::EVRInputError Create(vr::PropertyContainerHandle_t ulContainer, const char* pchName, EComponentType eType, vr::VRInputComponentHandle_t* pHandle);
+  Component* Lookup(vr::VRInputComponentHandle_t ulHandle, EComponentType eType);
+
+  std::vector<Component> m_components;
+  size_t m_unComponentCount;
+};
+
+class ScriptedDriverContext : public vr::IVRDriverContext {
+ public:
+  ScriptedDriverContext();
+
+  ScriptedServerDriverHost& Host() { return m_host; }
+  ScriptedSettings& Settings() { return m_settings; }
+  ScriptedProperties& Properties() { return m_properties; }
+  ScriptedDriverLog& Log() { return m_log; }
+  ScriptedDriverInput& Input() { return m_input; }
+
+  // Script clock, seconds; drives the pose script. Advanced by the test, never by wall time.
+  double GetTime() const { return m_flTime.load(std::memory_order_acquire); }
+  void SetTime(double flSeconds) { m_flTime.store(flSeconds, std::memory_order_release); }
+  void AdvanceTime(double flSeconds) { SetTime(GetTime() + flSeconds); }
+
+  // Interfaces the driver asked for that the context doesn't serve
+  uint32_t GetMissingInterfaceCount() const { return m_unMissingInterfaces; }
+
+  void* GetGenericInterface(const char* pchInterfaceVersion, vr::EVRInitError* peError = nullptr) override;
+  vr::DriverHandle_t GetDriverHandle() override { return 1; }
+
+ private:
+  ScriptedServerDriverHost m_host;
+  ScriptedSettings m_settings;
+  ScriptedProperties m_properties;
+  ScriptedDriverLog m_log;
+  ScriptedDriverInput m_input;
+  std::atomic<double> m_flTime;
+  uint32_t m_unMissingInterfaces;
+};
+
+}  // namespace harness
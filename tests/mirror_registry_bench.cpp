@@ -0,0 +1,70 @@
+#include "harness/harness.h"
+#include "harness/provider_fixture.h"
+#include "driver_log.h"
+#include "driver_stats.h"
+
+#include <string>
+
+using harness::ProviderFixture;
+
+namespace {
+
+// One settings combination; each enables the matching stage of the sweep (see mirror_sweep_policies.h)
+struct SweepConfig {
+  const char* pchName;
+  bool bFilter;
+  bool bPrediction;
+  bool bExport;
+  bool bLog;
+};
+
+const SweepConfig k_rgSweepConfigs[] = {
+  {"default", false, false, false, false},
+  {"log", false, false, false, true},
+  {"export", false, false, true, false},
+  {"predict", false, true, false, false},
+  {"filter", true, false, false, false},
+  {"all", true, true, true, true},
+};
+
+}  // namespace
+
+// MirrorRegistry::UpdatePoses (the DriverTimer_PoseConversion timer) per enabled stage, inline sampling with
+// every device moving. The default settings run the instantiation without any optional stage, so each row
+// below "default" is work the default configuration does not do.
+HARNESS_BENCH(mirror_registry, UpdatePoses) {
+  const uint32_t frames = harness::IsQuickRun() ? 200 : 20000;
+  const std::string exportName = "/mydriver_sweep_bench_" + std::to_string(getpid());
+
+  for (uint32_t devices : {4u, 31u}) {
+    for (const SweepConfig& config : k_rgSweepConfigs) {
+      ProviderFixture fixture;
+      fixture.AddDevices(devices);
+      if (config.bFilter) {
+        fixture.SetSetting("poseFilterMode", 1.f); // One Euro
+      }
+      if (config.bPrediction) {
+        fixture.SetSetting("predictionMode", 1.f);
+      }
+      if (config.bExport) {
+        fixture.SetSetting("poseExportName", exportName.c_str());
+      }
+      if (config.bLog) {
+        fixture.SetSetting("logLevel", (float)vr::DriverLogLevel_Verbose);
+      }
+      fixture.Init();
+      fixture.RunFrames(100); // Warm-up; also drains the activation events
+
+      vr::ResetDriverTimers();
+      const uint64_t allocations = harness::GetAllocationCount();
+      fixture.RunFrames(frames);
+      const uint64_t sweepAllocations = harness::GetAllocationCount() - allocations;
+      const vr::LatencyHistogram& sweeps = vr::g_rgDriverTimers[vr::DriverTimer_PoseConversion];
+      const double mean = (double)sweeps.GetSum() / sweeps.GetCount();
+      printf("  %-7s devices=%-2u p50=%7llu ns  p99=%7llu ns  mean=%8.1f ns  (%.1f ns/device)  allocations=%llu\n", config.pchName, devices,
+             (unsigned long long)sweeps.GetPercentile(50), (unsigned long long)sweeps.GetPercentile(99), mean, mean / devices,
+             (unsigned long long)sweepAllocations);
+      fixture.Shutdown();
+    }
+  }
+}
@@ -0,0 +1,355 @@
+#include "harness/harness.h"
+#include "harness/provider_fixture.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+using harness::ProviderFixture;
+
+namespace {
+
+void SetCalibration(ProviderFixture& fixture, const char* pchSerial, const char* pchTranslation) {
+  const std::string section = std::string("driver_mydriver_calibration_") + pchSerial;
+  fixture.Context().Settings().SetString(section.c_str(), "worldFromDriverTranslation", pchTranslation);
+}
+
+// Runs frames until the mirror has had unCount more pose updates, giving the tracking thread real time to sweep
+bool RunFramesUntilUpdates(ProviderFixture& fixture, uint32_t unObjectId, uint64_t unCount) {
+  const uint64_t target = fixture.Host().GetPoseUpdateCount(unObjectId) + unCount;
+  for (int attempt = 0; attempt < 2000; ++attempt) {
+    fixture.RunFrames(1);
+    if (fixture.Host().GetPoseUpdateCount(unObjectId) >= target) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return false;
+}
+
+// Holds the left controller (physical index 1) still, optionally reporting a velocity; the rest circle
+void HoldControllerStill(ProviderFixture& fixture, const float* pflVelocity) {
+  fixture.Host().SetPoseScript([pflVelocity](uint32_t unDeviceIndex, double flTimeSeconds, vr::TrackedDevicePose_t& outPose) {
+    if (unDeviceIndex != 1) {
+      harness::CirclePoseScript(unDeviceIndex, flTimeSeconds, outPose);
+      return;
+    }
+    const double position[3] = {0.0, 1.0, -0.5};
+    const double rotation[4] = {1.0, 0.0, 0.0, 0.0};
+    harness::SetRawPose(outPose, position, rotation);
+    if (pflVelocity) {
+      for (int i = 0; i < 3; ++i) {
+        outPose.vVelocity.v[i] = pflVelocity[i];
+      }
+    }
+  });
+}
+
+std::string SubmitCounters(uint64_t unSent, uint64_t unSuppressed) {
+  return "{\"sent\":" + std::to_string(unSent) + ",\"suppressed\":" + std::to_string(unSuppressed) + "}";
+}
+
+}  // namespace
+
+HARNESS_TEST(mirror_registry, CalibrationIsInTheFirstSubmittedPose) {
+  ProviderFixture fixture;
+  SetCalibration(fixture, "my_mirror_3_serial", "0.5 -1 2");
+  fixture.AddDevices(3);
+  fixture.Init();
+  const uint32_t tracker = fixture.GetMirror("my_mirror_3_serial");
+  CHECK_EQ(fixture.Host().GetPoseUpdateCount(tracker), 0u);
+
+  fixture.RunFrames(1);
+  CHECK_EQ(fixture.Host().GetPoseUpdateCount(tracker), 1u);
+  const vr::DriverPose_t& pose = fixture.Host().GetLastPose(tracker);
+  CHECK_EQ(pose.vecWorldFromDriverTranslation[0], 0.5);
+  CHECK_EQ(pose.vecWorldFromDriverTranslation[1], -1.0);
+  CHECK_EQ(pose.vecWorldFromDriverTranslation[2], 2.0);
+}
+
+HARNESS_TEST(mirror_registry, CalibrationIsInTheFirstSubmittedPoseWithTrackingThread) {
+  ProviderFixture fixture;
+  fixture.SetSetting("trackingThreadHz", 500.f);
+  SetCalibration(fixture, "my_mirror_3_serial", "0.5 -1 2");
+  fixture.AddDevices(3);
+  fixture.Init();
+  const uint32_t tracker = fixture.GetMirror("my_mirror_3_serial");
+
+  // Reactivate while the tracking thread keeps sweeping; every first pose after an activation must carry the offsets
+  for (int cycle = 0; cycle < 20; ++cycle) {
+    CHECK(RunFramesUntilUpdates(fixture, tracker, 1));
+    const vr::DriverPose_t pose = fixture.Host().GetLastPose(tracker);
+    CHECK_EQ(pose.vecWorldFromDriverTranslation[0], 0.5);
+    CHECK_EQ(pose.vecWorldFromDriverTranslation[2], 2.0);
+    fixture.Host().GetAddedDriver(tracker)->Deactivate();
+    fixture.Host().GetAddedDriver(tracker)->Activate(tracker);
+  }
+}
+
+// suppressUnchangedPoses skips a pose the host already has, but re-sends it every poseKeepAliveMs. The
+// keep-alive runs on the steady clock, so this waits out real time.
+HARNESS_TEST(mirror_registry, UnchangedPoseIsOnlySentOnKeepAlive) {
+  ProviderFixture fixture;
+  fixture.SetSetting("suppressUnchangedPoses", 1.f);
+  fixture.SetSetting("poseKeepAliveMs", 100.f);
+  fixture.AddDevices(1);
+  HoldControllerStill(fixture, nullptr);
+  fixture.Init();
+  const uint32_t controller = fixture.GetMirror("my_left_controller_serial");
+  fixture.RunFrames(1);
+  CHECK_EQ(fixture.Host().GetPoseUpdateCount(controller), 1u);
+  CHECK(fixture.DebugRequest(controller, "submit_counters") == SubmitCounters(1, 0));
+
+  // Inside the keep-alive window nothing goes out
+  int64_t sent = harness::NowNs();
+  fixture.RunFrames(5);
+  if (harness::NowNs() - sent < 100000000) {
+    CHECK_EQ(fixture.Host().GetPoseUpdateCount(controller), 1u);
+    CHECK(fixture.DebugRequest(controller, "submit_counters") == SubmitCounters(1, 5));
+  }
+
+  // Once it has elapsed, the next frame re-sends the same pose, and the window starts over
+  std::this_thread::sleep_for(std::chrono::milliseconds(110));
+  const uint64_t before = fixture.Host().GetPoseUpdateCount(controller);
+  fixture.RunFrames(1);
+  sent = harness::NowNs();
+  CHECK_EQ(fixture.Host().GetPoseUpdateCount(controller), before + 1);
+  CHECK_NEAR(fixture.Host().GetLastPose(controller).vecPosition[1], 1.0, 1e-6);
+  fixture.RunFrames(3);
+  if (harness::NowNs() - sent < 100000000) {
+    CHECK_EQ(fixture.Host().GetPoseUpdateCount(controller), before + 1);
+  }
+
+  // Over a longer stretch: one submission per interval, and the counters account for every frame
+  const int64_t start = harness::NowNs();
+  uint32_t frames = 10; // Run so far
+  while (harness::NowNs() - start < 350000000) {
+    fixture.RunFrames(1);
+    ++frames;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  const uint64_t elapsedMs = (uint64_t)(harness::NowNs() - start) / 1000000;
+  const uint64_t updates = fixture.Host().GetPoseUpdateCount(controller);
+  CHECK(updates - (before + 1) >= 2);
+  CHECK(updates - (before + 1) <= elapsedMs / 100 + 1);
+  CHECK(fixture.DebugRequest(controller, "submit_counters") == SubmitCounters(updates, frames - updates));
+}
+
+HARNESS_TEST(mirror_registry, DisconnectIsSentInsideTheKeepAliveWindow) {
+  ProviderFixture fixture;
+  fixture.SetSetting("suppressUnchangedPoses", 1.f);
+  fixture.SetSetting("poseKeepAliveMs", 60000.f);
+  fixture.AddDevices(1);
+  HoldControllerStill(fixture, nullptr);
+  fixture.Init();
+  const uint32_t controller = fixture.GetMirror("my_left_controller_serial");
+  fixture.RunFrames(3);
+  CHECK_EQ(fixture.Host().GetPoseUpdateCount(controller), 1u);
+
+  fixture.Host().SetDeviceConnected(1, false);
+  fixture.RunFrames(1);
+  CHECK_EQ(fixture.Host().GetPoseUpdateCount(controller), 2u);
+  CHECK(!fixture.Host().GetLastPose(controller).poseIsValid);
+  fixture.RunFrames(3); // Staying disconnected is no change
+  CHECK_EQ(fixture.Host().GetPoseUpdateCount(controller), 2u);
+
+  fixture.Host().SetDeviceConnected(1, true);
+  fixture.RunFrames(1);
+  CHECK_EQ(fixture.Host().GetPoseUpdateCount(controller), 3u);
+  CHECK(fixture.Host().GetLastPose(controller).poseIsValid);
+  CHECK(fixture.DebugRequest(controller, "submit_counters") == SubmitCounters(3, 5));
+}
+
+// The host extrapolates the last pose along its velocity, so a pose that hasn't moved yet but would drift
+// past the epsilon before the next keep-alive must still go out every frame
+HARNESS_TEST(mirror_registry, MovingPoseIsNotSuppressed) {
+  ProviderFixture fixture;
+  fixture.SetSetting("suppressUnchangedPoses", 1.f);
+  fixture.SetSetting("poseKeepAliveMs", 60000.f);
+  fixture.AddDevices(1);
+  const float velocity[3] = {0.f, 0.f, 0.01f}; // 1 cm/s
+  HoldControllerStill(fixture, velocity);
+  fixture.Init();
+  const uint32_t controller = fixture.GetMirror("my_left_controller_serial");
+  fixture.RunFrames(10);
+  CHECK_EQ(fixture.Host().GetPoseUpdateCount(controller), 10u);
+  CHECK_NEAR(fixture.Host().GetLastPose(controller).vecVelocity[2], 0.01, 1e-6);
+  CHECK(fixture.DebugRequest(controller, "submit_counters") == SubmitCounters(10, 0));
+}
+
+HARNESS_TEST(mirror_registry, StandbyLastsUntilTheProviderLeavesIt) {
+  ProviderFixture fixture;
+  fixture.AddDevices(3);
+  fixture.Init();
+  fixture.RunFrames(2);
+  const uint32_t tracker = fixture.GetMirror("my_mirror_3_serial");
+
+  const uint64_t before = fixture.Host().GetPoseUpdateCount(tracker);
+  fixture.Host().GetAddedDriver(tracker)->EnterStandby();
+  CHECK_EQ(fixture.Host().GetPoseUpdateCount(tracker), before + 1); // Sent right away
+  CHECK(!fixture.Host().GetLastPose(tracker).poseIsValid);
+
+  // The sweeps keep running underneath, but must not bring the tracked pose back
+  fixture.RunFrames(5);
+  CHECK(!fixture.Host().GetLastPose(tracker).poseIsValid);
+  CHECK_EQ(fixture.Host().GetLastPose(tracker).result, vr::TrackingResult_Uninitialized);
+  CHECK(fixture.Host().GetLastPose(tracker).deviceIsConnected);
+
+  fixture.Provider().EnterStandby();
+  fixture.Provider().LeaveStandby();
+  fixture.RunFrames(1);
+  CHECK(fixture.Host().GetLastPose(tracker).poseIsValid);
+  CHECK_EQ(fixture.Host().GetLastPose(tracker).result, vr::TrackingResult_Running_OK);
+}
+
+HARNESS_TEST(mirror_registry, StandbyLastsWithTrackingThread) {
+  ProviderFixture fixture;
+  fixture.SetSetting("trackingThreadHz", 500.f);
+  fixture.AddDevices(3);
+  fixture.Init();
+  const uint32_t tracker = fixture.GetMirror("my_mirror_3_serial");
+  CHECK(RunFramesUntilUpdates(fixture, tracker, 1));
+
+  fixture.Host().GetAddedDriver(tracker)->EnterStandby();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20)); // About ten sweeps
+  fixture.RunFrames(5);
+  CHECK(!fixture.Host().GetLastPose(tracker).poseIsValid);
+  CHECK_EQ(fixture.Host().GetLastPose(tracker).result, vr::TrackingResult_Uninitialized);
+
+  fixture.Provider().EnterStandby();
+  fixture.Provider().LeaveStandby();
+  CHECK(RunFramesUntilUpdates(fixture, tracker, 1));
+  CHECK(fixture.Host().GetLastPose(tracker).poseIsValid);
+}
+
+HARNESS_TEST(mirror_registry, StandbyIsOnlyBlockedWhenOptedIn) {
+  for (bool optIn : {false, true}) {
+    ProviderFixture fixture;
+    fixture.SetSetting("adaptiveUpdateRate", 1.f);
+    fixture.SetSetting("blockStandbyWhileMoving", optIn ? 1.f : 0.f);
+    fixture.AddDevices(3); // Every device moves along its circle
+    fixture.Init();
+    fixture.RunFrames(5);
+    CHECK_EQ(fixture.Provider().ShouldBlockStandbyMode(), optIn);
+
+    // Nothing sweeps in standby, so the motion seen before it no longer counts
+    fixture.Provider().EnterStandby();
+    CHECK(!fixture.Provider().ShouldBlockStandbyMode());
+    fixture.RunFrames(5);
+    CHECK(!fixture.Provider().ShouldBlockStandbyMode());
+
+    fixture.Provider().LeaveStandby();
+    fixture.RunFrames(2);
+    CHECK_EQ(fixture.Provider().ShouldBlockStandbyMode(), optIn);
+  }
+}
+
+HARNESS_TEST(mirror_registry, StandbyEndsWithTheSession) {
+  ProviderFixture fixture;
+  fixture.AddDevices(1);
+  fixture.Init();
+  fixture.RunFrames(2);
+  fixture.Provider().EnterStandby();
+  fixture.Shutdown(); // vrserver may unload the driver without leaving standby first
+
+  fixture.Init();
+  const uint32_t controller = fixture.GetMirror("my_left_controller_serial");
+  const uint64_t before = fixture.Host().GetPoseUpdateCount(controller);
+  fixture.RunFrames(3);
+  CHECK_EQ(fixture.Host().GetPoseUpdateCount(controller), before + 3);
+  CHECK(fixture.Host().GetLastPose(controller).poseIsValid);
+}
+
+// A still mirror drops to keep-alive submissions once idle, and is back to one per frame on the first
+// sweep that sees it move. The scheduler runs on the steady clock, so this waits out real time.
+HARNESS_TEST(mirror_registry, StillDeviceDropsToKeepAliveUntilItMoves) {
+  ProviderFixture fixture;
+  fixture.SetSetting("adaptiveUpdateRate", 1.f);
+  fixture.SetSetting("idleAfterMs", 20.f);
+  fixture.SetSetting("idleKeepAliveMs", 100.f);
+  fixture.AddDevices(1);
+  bool moving = false;
+  uint32_t moves = 0;
+  fixture.Host().SetPoseScript([&](uint32_t unDeviceIndex, double flTimeSeconds, vr::TrackedDevicePose_t& outPose) {
+    if (unDeviceIndex != 1) {
+      harness::CirclePoseScript(unDeviceIndex, flTimeSeconds, outPose);
+      return;
+    }
+    const double position[3] = {moving ? 0.01 * ++moves : 0.0, 1.0, -0.5}; // One centimetre per sample
+    const double rotation[4] = {1.0, 0.0, 0.0, 0.0};
+    harness::SetRawPose(outPose, position, rotation);
+  });
+  fixture.Init();
+  const uint32_t controller = fixture.GetMirror("my_left_controller_serial");
+
+  // Still active: every frame goes out until idleAfterMs has passed
+  uint64_t before = fixture.Host().GetPoseUpdateCount(controller);
+  fixture.RunFrames(3);
+  CHECK_EQ(fixture.Host().GetPoseUpdateCount(controller), before + 3);
+
+  for (int frame = 0; frame < 2000 && fixture.DebugRequest(controller, "stats").find("\"activity\":1") == std::string::npos; ++frame) {
+    fixture.RunFrames(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  CHECK(fixture.DebugRequest(controller, "stats").find("\"activity\":1") != std::string::npos);
+
+  // Stationary: one submission per keep-alive interval, however many frames run
+  before = fixture.Host().GetPoseUpdateCount(controller);
+  const int64_t start = harness::NowNs();
+  uint32_t frames = 0;
+  while (harness::NowNs() - start < 350000000) {
+    fixture.RunFrames(1);
+    ++frames;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  const uint64_t elapsedMs = (uint64_t)(harness::NowNs() - start) / 1000000;
+  const uint64_t keepAlives = fixture.Host().GetPoseUpdateCount(controller) - before;
+  CHECK(keepAlives >= 2);
+  CHECK(keepAlives <= elapsedMs / 100 + 1);
+  CHECK(keepAlives < frames / 10);
+
+  // Moving: the sweep that sees the motion submits, and so does every frame after it
+  moving = true;
+  before = fixture.Host().GetPoseUpdateCount(controller);
+  fixture.RunFrames(1);
+  CHECK_EQ(fixture.Host().GetPoseUpdateCount(controller), before + 1);
+  CHECK_NEAR(fixture.Host().GetLastPose(controller).vecPosition[0], 0.01, 1e-9);
+  fixture.RunFrames(10);
+  CHECK_EQ(fixture.Host().GetPoseUpdateCount(controller), before + 11);
+  CHECK(fixture.DebugRequest(controller, "stats").find("\"activity\":0") != std::string::npos);
+}
+
+// With every mirror dormant the tracking thread samples once a minute here, but stopping it and
+// device events must not wait for that
+HARNESS_TEST(mirror_registry, DormantTrackingThreadWakesForStopAndDeviceEvents) {
+  ProviderFixture fixture;
+  fixture.SetSetting("trackingThreadHz", 500.f);
+  fixture.SetSetting("adaptiveUpdateRate", 1.f);
+  fixture.SetSetting("idleAfterMs", 1.f);
+  fixture.SetSetting("dormantSampleIntervalMs", 60000.f);
+  fixture.AddDevices(1);
+  fixture.Host().SetDeviceConnected(1, false);
+  fixture.Init();
+  const uint32_t controller = fixture.GetMirror("my_left_controller_serial");
+  for (int frame = 0; frame < 2000 && fixture.DebugRequest(controller, "stats").find("\"activity\":2") == std::string::npos; ++frame) {
+    fixture.RunFrames(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  CHECK(fixture.DebugRequest(controller, "stats").find("\"activity\":2") != std::string::npos);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10)); // Into the long wait
+
+  const int64_t start = harness::NowNs();
+  fixture.Provider().EnterStandby(); // Stops the thread
+  CHECK(harness::NowNs() - start < 1000000000);
+  fixture.Provider().LeaveStandby();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  const uint32_t index = fixture.Host().AddPhysicalDevice(vr::TrackedDeviceClass_GenericTracker, vr::TrackedControllerRole_Invalid, "late_tracker");
+  fixture.Host().QueueEvent(vr::VREvent_TrackedDeviceActivated, index);
+  fixture.RunFrames(1);
+  const std::string serial = "my_mirror_" + std::to_string(index) + "_serial";
+  const uint32_t tracker = fixture.GetMirror(serial.c_str());
+  CHECK(tracker != vr::k_unTrackedDeviceIndexInvalid);
+  CHECK(RunFramesUntilUpdates(fixture, tracker, 1)); // Within two seconds, not a minute
+  CHECK(fixture.Host().GetLastPose(tracker).poseIsValid);
+}
@@ -0,0 +1,218 @@
+#include "harness/harness.h"
+#include "harness/provider_fixture.h"
+#include "pose_calibration.h"
+#include "pose_recording.h"
+
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using harness::ProviderFixture;
+
+namespace {
+
+void QuatMultiply(const double a[4], const double b[4], double out[4]) {
+  out[0] = a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3];
+  out[1] = a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2];
+  out[2] = a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1];
+  out[3] = a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0];
+}
+
+void QuatRotateVector(const double q[4], const double v[3], double out[3]) {
+  const double p[4] = {0.0, v[0], v[1], v[2]};
+  const double conj[4] = {q[0], -q[1], -q[2], -q[3]};
+  double qp[4];
+  double rotated[4];
+  QuatMultiply(q, p, qp);
+  QuatMultiply(qp, conj, rotated);
+  out[0] = rotated[1], out[1] = rotated[2], out[2] = rotated[3];
+}
+
+void RandomRotation(std::mt19937& rng, double out[4]) {
+  std::normal_distribution<double> gaussian(0.0, 1.0);
+  double norm = 0.0;
+  for (int i = 0; i < 4; ++i) {
+    out[i] = gaussian(rng);
+    norm += out[i] * out[i];
+  }
+  norm = sqrt(norm);
+  for (int i = 0; i < 4; ++i) {
+    out[i] /= norm;
+  }
+}
+
+// The known offsets the tests try to recover: about 40 degrees, a few centimeters
+const double k_rgOffsetRotation[4] = {0.9394131, 0.2417729, 0.1611819, -0.1818496};
+const double k_rgOffsetTranslation[3] = {0.031, -0.045, 0.082};
+
+// Poses of a device moving through random orientations, and of a reference rigidly mounted on it
+// (reference = device * offset) or seen from another tracking space (reference = offset * device)
+void MovingPair(std::mt19937& rng, bool bWorldFromDriver, double flNoise, vr::TrackedDevicePose_t& outDevice, vr::TrackedDevicePose_t& outReference) {
+  std::uniform_real_distribution<double> position(-1.0, 1.0);
+  std::normal_distribution<double> noise(0.0, flNoise);
+  double rotation[4];
+  RandomRotation(rng, rotation);
+  const double devicePosition[3] = {position(rng), 1.0 + 0.5 * position(rng), position(rng)};
+  harness::SetRawPose(outDevice, devicePosition, rotation);
+
+  double referenceRotation[4];
+  double referencePosition[3];
+  double rotated[3];
+  if (bWorldFromDriver) {
+    QuatMultiply(k_rgOffsetRotation, rotation, referenceRotation);
+    QuatRotateVector(k_rgOffsetRotation, devicePosition, rotated);
+    for (int k = 0; k < 3; ++k) {
+      referencePosition[k] = rotated[k] + k_rgOffsetTranslation[k];
+    }
+  } else {
+    QuatMultiply(rotation, k_rgOffsetRotation, referenceRotation);
+    QuatRotateVector(rotation, k_rgOffsetTranslation, rotated);
+    for (int k = 0; k < 3; ++k) {
+      referencePosition[k] = devicePosition[k] + rotated[k];
+    }
+  }
+  for (int k = 0; k < 3; ++k) {
+    referencePosition[k] += noise(rng);
+  }
+  harness::SetRawPose(outReference, referencePosition, referenceRotation);
+}
+
+// Angle between a solved rotation and the known one, in radians
+double RotationError(const vr::HmdQuaternion_t& q) {
+  const double dot = std::fabs(q.w * k_rgOffsetRotation[0] + q.x * k_rgOffsetRotation[1] + q.y * k_rgOffsetRotation[2] + q.z * k_rgOffsetRotation[3]);
+  return 2.0 * std::acos(std::min(1.0, dot));
+}
+
+}  // namespace
+
+HARNESS_TEST(pose_calibration, SolversRecoverKnownOffsets) {
+  const uint32_t pairs = 200;
+  std::vector<vr::TrackedDevicePose_t> device(pairs);
+  std::vector<vr::TrackedDevicePose_t> reference(pairs);
+
+  for (bool worldFromDriver : {false, true}) {
+    std::mt19937 rng(worldFromDriver ? 2 : 1);
+    for (uint32_t i = 0; i < pairs; ++i) {
+      memset(&device[i], 0, sizeof(device[i]));
+      memset(&reference[i], 0, sizeof(reference[i]));
+      MovingPair(rng, worldFromDriver, 0.001, device[i], reference[i]);
+    }
+    reference[7].bPoseIsValid = false; // Lost tracking; skipped
+    reference[7].mDeviceToAbsoluteTracking.m[0][3] = 100.f;
+
+    vr::PoseOffset offset;
+    double rmsPosition = 0.0;
+    double rmsRotation = 0.0;
+    const bool solved = worldFromDriver ? vr::SolveWorldFromDriverOffset(device.data(), reference.data(), pairs, offset, &rmsPosition, &rmsRotation)
+                                        : vr::SolveDriverFromHeadOffset(device.data(), reference.data(), pairs, offset, &rmsPosition, &rmsRotation);
+    CHECK(solved);
+    CHECK(RotationError(offset.qRotation) < 1e-3);
+    for (int k = 0; k < 3; ++k) {
+      CHECK_NEAR(offset.vecTranslation[k], k_rgOffsetTranslation[k], 0.5e-3);
+    }
+    // The residuals are the 1 mm of noise on each axis
+    CHECK_NEAR(rmsPosition, 0.001 * sqrt(3.0), 0.5e-3);
+    CHECK(rmsRotation < 1e-3);
+  }
+}
+
+// A DebugRequest solve and a tool's solve can overlap; each must see only its own poses
+HARNESS_TEST(pose_calibration, ConcurrentSolvesDoNotShareScratch) {
+  const uint32_t pairs = 200;
+  std::vector<vr::TrackedDevicePose_t> device[2];
+  std::vector<vr::TrackedDevicePose_t> reference[2];
+  for (int solve = 0; solve < 2; ++solve) {
+    std::mt19937 rng(10 + solve);
+    device[solve].assign(pairs, vr::TrackedDevicePose_t());
+    reference[solve].assign(pairs, vr::TrackedDevicePose_t());
+    for (uint32_t i = 0; i < pairs; ++i) {
+      MovingPair(rng, solve == 1, 0.001, device[solve][i], reference[solve][i]);
+    }
+  }
+
+  bool solved[2] = {};
+  vr::PoseOffset offset[2];
+  std::thread threads[2];
+  for (int solve = 0; solve < 2; ++solve) {
+    threads[solve] = std::thread([&, solve] {
+      for (int repeat = 0; repeat < 20; ++repeat) {
+        solved[solve] = solve == 1 ? vr::SolveWorldFromDriverOffset(device[solve].data(), reference[solve].data(), pairs, offset[solve])
+                                   : vr::SolveDriverFromHeadOffset(device[solve].data(), reference[solve].data(), pairs, offset[solve]);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (int solve = 0; solve < 2; ++solve) {
+    CHECK(solved[solve]);
+    CHECK(RotationError(offset[solve].qRotation) < 1e-3);
+    for (int k = 0; k < 3; ++k) {
+      CHECK_NEAR(offset[solve].vecTranslation[k], k_rgOffsetTranslation[k], 0.5e-3);
+    }
+  }
+}
+
+HARNESS_TEST(pose_calibration, SolversRejectRecordingsWithoutPairs) {
+  vr::TrackedDevicePose_t device[4];
+  vr::TrackedDevicePose_t reference[4];
+  memset(device, 0, sizeof(device));
+  memset(reference, 0, sizeof(reference));
+  vr::PoseOffset offset = vr::IdentityPoseOffset();
+  CHECK(!vr::SolveDriverFromHeadOffset(device, reference, 4, offset));
+  CHECK(!vr::SolveOffsetFromRecording("/nonexistent/mydriver_recording.mdpr", 1, 2, false, offset));
+}
+
+// Records a controller with a tracker strapped to it, then solves and applies the mount offset through DebugRequest
+HARNESS_TEST(pose_calibration, DebugRequestSolvesAndAppliesMountOffset) {
+  ProviderFixture fixture;
+  fixture.AddDevices(2); // Left controller at index 1 stands in for the tracker, right controller at 2 for the reference
+  fixture.Init();
+  fixture.RunFrames(2);
+
+  const std::string path = (std::filesystem::temp_directory_path() / "mydriver_calibration_test.mdpr").string();
+  {
+    int32_t deviceClasses[vr::k_unMaxTrackedDeviceCount] = {};
+    int32_t controllerRoles[vr::k_unMaxTrackedDeviceCount] = {};
+    vr::PoseRecorder recorder;
+    CHECK(recorder.Open(path.c_str(), deviceClasses, controllerRoles));
+    std::mt19937 rng(3);
+    vr::TrackedDevicePose_t poses[3];
+    memset(poses, 0, sizeof(poses));
+    for (uint32_t frame = 0; frame < 300; ++frame) {
+      MovingPair(rng, false, 0.0005, poses[1], poses[2]);
+      recorder.Record(poses, 3);
+    }
+    recorder.Close();
+    CHECK_EQ(recorder.GetDroppedFrameCount(), 0u);
+  }
+
+  const uint32_t mirror = fixture.GetMirror("my_left_controller_serial");
+  const std::string request = "solve_calibration mount 2 " + path;
+  const std::string response = fixture.DebugRequest(mirror, request.c_str());
+  std::remove(path.c_str());
+  CHECK(response.compare(0, 15, "{\"solved\":true,") == 0);
+  CHECK(fixture.DebugRequest(mirror, "solve_calibration sideways 2 x").find("usage") != std::string::npos);
+
+  // Stored for the next activation...
+  char translation[128] = {};
+  fixture.Context().Settings().GetString("driver_mydriver_calibration_my_left_controller_serial", "driverFromHeadTranslation", translation,
+                                         sizeof(translation));
+  double stored[3] = {};
+  CHECK_EQ(sscanf(translation, "%lf %lf %lf", &stored[0], &stored[1], &stored[2]), 3);
+  for (int k = 0; k < 3; ++k) {
+    CHECK_NEAR(stored[k], k_rgOffsetTranslation[k], 0.5e-3);
+  }
+
+  // ...and already in the poses the host gets
+  fixture.RunFrames(2);
+  const vr::DriverPose_t& pose = fixture.Host().GetLastPose(mirror);
+  CHECK(RotationError(pose.qDriverFromHeadRotation) < 1e-3);
+  for (int k = 0; k < 3; ++k) {
+    CHECK_NEAR(pose.vecDriverFromHeadTranslation[k], k_rgOffsetTranslation[k], 0.5e-3);
+  }
+  CHECK(pose.poseIsValid);
+}
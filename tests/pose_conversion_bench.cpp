@@ -0,0 +1,35 @@
+#include "harness/harness.h"
+#include "harness/scripted_driver_context.h"
+#include "pose_conversion.h"
+
+#include <cstring>
+
+// One whole-snapshot ConvertRawPoses call (k_unMaxTrackedDeviceCount entries) per kernel
+HARNESS_BENCH(pose_conversion, ConvertRawPoses) {
+  const uint32_t iterations = harness::IsQuickRun() ? 1000 : 200000;
+  static vr::TrackedDevicePose_t raw[vr::k_unMaxTrackedDeviceCount];
+  static vr::PoseConversionBatch batch;
+  memset(raw, 0, sizeof(raw));
+  for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i) {
+    harness::CirclePoseScript(i, 0.37 * i, raw[i]);
+  }
+
+  printf("  Picked kernel: %s\n", vr::GetPoseConversionKernelName());
+  const vr::EPoseConversionKernel kernels[] = {vr::PoseConversionKernel_Scalar, vr::PoseConversionKernel_SSE2, vr::PoseConversionKernel_AVX};
+  const char* const names[] = {"Scalar", "SSE2", "AVX"};
+  for (int kernel = 0; kernel < 3; ++kernel) {
+    if (!vr::IsPoseConversionKernelSupported(kernels[kernel])) {
+      printf("  %-7s not supported here\n", names[kernel]);
+      continue;
+    }
+    harness::LatencySamples samples(iterations);
+    for (uint32_t i = 0; i < iterations; ++i) {
+      const int64_t start = harness::NowNs();
+      vr::ConvertRawPosesWithKernel(kernels[kernel], raw, vr::k_unMaxTrackedDeviceCount, batch);
+      samples.Add(harness::NowNs() - start);
+      harness::DoNotOptimize(batch);
+    }
+    printf("  %-7s devices=%u  p50=%6lld ns  p99=%6lld ns  mean=%8.1f ns  (%.1f ns/device)\n", names[kernel], vr::k_unMaxTrackedDeviceCount,
+           (long long)samples.Percentile(50), (long long)samples.Percentile(99), samples.Mean(), samples.Mean() / vr::k_unMaxTrackedDeviceCount);
+  }
+}
@@ -0,0 +1,129 @@
+#include "harness/harness.h"
+#include "harness/scripted_driver_context.h"
+#include "pose_conversion.h"
+
+#include <cstring>
+#include <random>
+
+namespace {
+
+const vr::EPoseConversionKernel k_rgeKernels[] = {vr::PoseConversionKernel_Scalar, vr::PoseConversionKernel_SSE2, vr::PoseConversionKernel_AVX};
+const char* const k_rgpchKernelNames[] = {"Scalar", "SSE2", "AVX"};
+
+// A full snapshot of reference rotations: identity, half turns and near half turns about the axes and
+// diagonals (where the trace branch of a naive conversion loses precision), then uniform random ones
+struct ReferenceSnapshot {
+  vr::TrackedDevicePose_t raw[vr::k_unMaxTrackedDeviceCount];
+  double rotation[vr::k_unMaxTrackedDeviceCount][4]; // w >= 0
+};
+
+void SetReference(ReferenceSnapshot& snapshot, uint32_t unIndex, double w, double x, double y, double z) {
+  const double norm = std::sqrt(w * w + x * x + y * y + z * z);
+  const double sign = w < 0.0 ? -1.0 : 1.0;
+  double* q = snapshot.rotation[unIndex];
+  q[0] = sign * w / norm;
+  q[1] = sign * x / norm;
+  q[2] = sign * y / norm;
+  q[3] = sign * z / norm;
+  const double position[3] = {0.1 * unIndex, 1.0 + 0.01 * unIndex, -0.02 * unIndex};
+  memset(&snapshot.raw[unIndex], 0, sizeof(snapshot.raw[unIndex]));
+  harness::SetRawPose(snapshot.raw[unIndex], position, q);
+  snapshot.raw[unIndex].vVelocity.v[0] = (float)unIndex;
+  snapshot.raw[unIndex].vAngularVelocity.v[2] = -(float)unIndex;
+}
+
+void MakeReferenceSnapshot(ReferenceSnapshot& snapshot, uint32_t unSeed) {
+  const double axes[][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 1, 0}, {1, 0, 1}, {0, 1, 1}, {1, 1, 1}, {-1, 2, 3}};
+  uint32_t index = 0;
+  SetReference(snapshot, index++, 1.0, 0.0, 0.0, 0.0);
+  for (const double* axis : axes) {
+    for (double angle : {M_PI, M_PI - 1e-3, M_PI - 1e-6}) {
+      const double s = std::sin(angle / 2.0);
+      SetReference(snapshot, index++, std::cos(angle / 2.0), axis[0] * s, axis[1] * s, axis[2] * s);
+    }
+  }
+  std::mt19937 random(unSeed);
+  std::normal_distribution<double> normal;
+  while (index < vr::k_unMaxTrackedDeviceCount) {
+    SetReference(snapshot, index++, normal(random), normal(random), normal(random), normal(random)); // Uniform over SO(3)
+  }
+}
+
+// Largest component difference to the reference, with the reference taken in whichever hemisphere is closer
+double RotationError(const vr::PoseConversionBatch& batch, uint32_t unIndex, const double reference[4]) {
+  double dot = 0.0;
+  for (int k = 0; k < 4; ++k) {
+    dot += batch.rotation[k][unIndex] * reference[k];
+  }
+  const double sign = dot < 0.0 ? -1.0 : 1.0;
+  double error = 0.0;
+  for (int k = 0; k < 4; ++k) {
+    error = std::max(error, std::fabs(batch.rotation[k][unIndex] - sign * reference[k]));
+  }
+  return error;
+}
+
+}  // namespace
+
+HARNESS_TEST(pose_conversion, EveryKernelMatchesTheReferenceRotations) {
+  static ReferenceSnapshot snapshot;
+  static vr::PoseConversionBatch batch;
+  for (uint32_t seed = 1; seed <= 20; ++seed) {
+    MakeReferenceSnapshot(snapshot, seed);
+    for (size_t kernel = 0; kernel < sizeof(k_rgeKernels) / sizeof(k_rgeKernels[0]); ++kernel) {
+      if (!vr::ConvertRawPosesWithKernel(k_rgeKernels[kernel], snapshot.raw, vr::k_unMaxTrackedDeviceCount, batch)) {
+        if (seed == 1) {
+          printf("  %s kernel not supported here, skipped\n", k_rgpchKernelNames[kernel]);
+        }
+        continue;
+      }
+      for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i) {
+        CHECK_NEAR(RotationError(batch, i, snapshot.rotation[i]), 0.0, 1e-6); // A few float ulps
+        CHECK(batch.rotation[0][i] >= 0.f);
+        const double norm = batch.rotation[0][i] * batch.rotation[0][i] + batch.rotation[1][i] * batch.rotation[1][i] +
+                            batch.rotation[2][i] * batch.rotation[2][i] + batch.rotation[3][i] * batch.rotation[3][i];
+        CHECK_NEAR(norm, 1.0, 1e-6);
+      }
+    }
+  }
+}
+
+HARNESS_TEST(pose_conversion, SimdKernelsAgreeWithScalar) {
+  static ReferenceSnapshot snapshot;
+  static vr::PoseConversionBatch scalar;
+  static vr::PoseConversionBatch simd;
+  MakeReferenceSnapshot(snapshot, 7);
+  CHECK(vr::ConvertRawPosesWithKernel(vr::PoseConversionKernel_Scalar, snapshot.raw, vr::k_unMaxTrackedDeviceCount, scalar));
+  for (vr::EPoseConversionKernel kernel : {vr::PoseConversionKernel_SSE2, vr::PoseConversionKernel_AVX}) {
+    if (!vr::ConvertRawPosesWithKernel(kernel, snapshot.raw, vr::k_unMaxTrackedDeviceCount, simd)) {
+      continue;
+    }
+    for (int k = 0; k < 4; ++k) {
+      for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i) {
+        CHECK_NEAR(simd.rotation[k][i], scalar.rotation[k][i], 5e-7); // The sums are associated differently, a few ulps apart
+      }
+    }
+  }
+}
+
+HARNESS_TEST(pose_conversion, CopiesTranslationAndVelocitiesAndPadsWithIdentity) {
+  static ReferenceSnapshot snapshot;
+  static vr::PoseConversionBatch batch;
+  MakeReferenceSnapshot(snapshot, 3);
+  const uint32_t count = 21;
+  vr::ConvertRawPoses(snapshot.raw, count, batch);
+  for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i) {
+    for (int k = 0; k < 3; ++k) {
+      const float position = i < count ? snapshot.raw[i].mDeviceToAbsoluteTracking.m[k][3] : 0.f;
+      const float velocity = i < count ? snapshot.raw[i].vVelocity.v[k] : 0.f;
+      const float angularVelocity = i < count ? snapshot.raw[i].vAngularVelocity.v[k] : 0.f;
+      CHECK_EQ(batch.position[k][i], position);
+      CHECK_EQ(batch.velocity[k][i], velocity);
+      CHECK_EQ(batch.angularVelocity[k][i], angularVelocity);
+    }
+    if (i >= count) {
+      CHECK_EQ(batch.rotation[0][i], 1.f);
+      CHECK_EQ(batch.rotation[1][i], 0.f);
+    }
+  }
+}
@@ -0,0 +1,101 @@
+#include "harness/harness.h"
+#include "pose_export.h"
+#include "pose_exporter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+
+using harness::LatencySamples;
+
+// Publish-to-read latency of the shared-memory export. The driver side publishes sweeps on this
+// thread, 50 us apart so a reader can keep up, while a reader thread spins on the frame count
+// the way a local tool would and copies every slot of each sweep it sees. Latency runs from the
+// newest slot's nPublishTimeNs to the end of that copy. The sweep cost is also measured without
+// a reader, to show a reader does not slow the driver down.
+HARNESS_BENCH(pose_export, PublishToRead) {
+  const uint32_t frames = harness::IsQuickRun() ? 200 : 20000;
+  const int64_t sweepIntervalNs = 50000;
+  const std::string name = "/mydriver_export_bench_" + std::to_string(getpid());
+
+  vr::DriverPose_t pose = {};
+  pose.poseIsValid = true;
+  pose.deviceIsConnected = true;
+  pose.result = vr::TrackingResult_Running_OK;
+  pose.qRotation.w = 1.0;
+  pose.qWorldFromDriverRotation.w = 1.0;
+  pose.qDriverFromHeadRotation.w = 1.0;
+
+  for (uint32_t slots : {1u, 4u, 16u, 64u}) {
+    for (bool withReader : {false, true}) {
+      vr::PoseExporter exporter;
+      if (!exporter.Open(name.c_str())) {
+        printf("  could not create %s\n", name.c_str());
+        return;
+      }
+      vr::PoseExportReader reader;
+      reader.Open(name.c_str());
+
+      std::atomic<bool> done(false);
+      LatencySamples latency(frames);
+      uint64_t torn = 0;
+      std::thread readerThread;
+      if (withReader) {
+        readerThread = std::thread([&] {
+          uint64_t seen = reader.GetFrameCount();
+          vr::PoseExportSample sample;
+          while (!done.load(std::memory_order_relaxed)) {
+            const uint64_t frame = reader.GetFrameCount();
+            if (frame == seen) {
+              std::this_thread::yield(); // Lets the driver side run on a machine without a spare core
+              continue;
+            }
+            seen = frame;
+            int64_t newestPublish = 0;
+            const uint32_t count = reader.GetSlotCount();
+            for (uint32_t slot = 0; slot < count; ++slot) {
+              if (reader.ReadSlot(slot, sample)) {
+                newestPublish = std::max(newestPublish, sample.nPublishTimeNs);
+              } else {
+                ++torn;
+              }
+            }
+            latency.Add(harness::NowNs() - newestPublish);
+          }
+        });
+      }
+
+      LatencySamples sweep(frames);
+      const uint64_t allocations = harness::GetAllocationCount();
+      for (uint32_t frame = 0; frame < frames; ++frame) {
+        const int64_t start = harness::NowNs();
+        const std::chrono::steady_clock::time_point sampleTime = std::chrono::steady_clock::now();
+        for (uint32_t slot = 0; slot < slots; ++slot) {
+          pose.vecPosition[0] = 0.001 * frame + slot;
+          exporter.PublishSlot(slot, slot + 1, slot, pose, sampleTime);
+        }
+        exporter.EndFrame(slots);
+        const int64_t end = harness::NowNs();
+        sweep.Add(end - start);
+        while (harness::NowNs() - start < sweepIntervalNs) {
+          std::this_thread::yield();
+        }
+      }
+      const uint64_t sweepAllocations = harness::GetAllocationCount() - allocations;
+      done.store(true, std::memory_order_relaxed);
+      if (readerThread.joinable()) {
+        readerThread.join();
+      }
+
+      printf("  Publish   slots=%-2u reader=%-3s p50=%7.2f us  p99=%7.2f us  allocations=%llu\n", slots, withReader ? "yes" : "no",
+             sweep.Percentile(50) * 1e-3, sweep.Percentile(99) * 1e-3, (unsigned long long)sweepAllocations);
+      if (withReader) {
+        printf("  Read      slots=%-2u sweeps=%-5zu p50=%7.2f us  p99=%7.2f us  max=%7.2f us  failed reads=%llu\n", slots, latency.GetCount(),
+               latency.Percentile(50) * 1e-3, latency.Percentile(99) * 1e-3, latency.Percentile(100) * 1e-3, (unsigned long long)torn);
+      }
+      reader.Close();
+      exporter.Close();
+    }
+  }
+}
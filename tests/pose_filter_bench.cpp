@@ -0,0 +1,71 @@
+#include "harness/harness.h"
+#include "harness/scripted_driver_context.h"
+#include "pose_conversion.h"
+#include "pose_filter.h"
+
+#include <cstring>
+
+// One PoseFilterBank::Apply pass over every slot, per mode and device count
+HARNESS_BENCH(pose_filter, Apply) {
+  const uint32_t iterations = harness::IsQuickRun() ? 200 : 50000;
+  const uint32_t deviceCounts[] = {1, 4, 16, 64};
+  const vr::EPoseFilterMode modes[] = {vr::PoseFilter_Off, vr::PoseFilter_OneEuro, vr::PoseFilter_Kalman};
+  const char* const names[] = {"Off", "OneEuro", "Kalman"};
+
+  // Every slot moving along its own circle, so the filters never take a shortcut
+  static vr::TrackedDevicePose_t raw[vr::k_unMaxTrackedDeviceCount];
+  static vr::PoseConversionBatch batch;
+  static vr::DriverPose_t input[vr::k_unMaxTrackedDeviceCount];
+  static vr::DriverPose_t poses[vr::k_unMaxTrackedDeviceCount];
+  static bool filter[vr::k_unMaxTrackedDeviceCount];
+  memset(raw, 0, sizeof(raw));
+  memset(input, 0, sizeof(input));
+  for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i) {
+    harness::CirclePoseScript(i, 0.37 * i, raw[i]);
+  }
+  vr::ConvertRawPoses(raw, vr::k_unMaxTrackedDeviceCount, batch);
+  for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i) {
+    input[i].poseIsValid = true;
+    input[i].deviceIsConnected = true;
+    input[i].qRotation = {batch.rotation[0][i], batch.rotation[1][i], batch.rotation[2][i], batch.rotation[3][i]};
+    for (int k = 0; k < 3; ++k) {
+      input[i].vecPosition[k] = batch.position[k][i];
+      input[i].vecVelocity[k] = batch.velocity[k][i];
+    }
+    filter[i] = true;
+  }
+
+  for (int mode = 0; mode < 3; ++mode) {
+    vr::PoseFilterSettings settings = {};
+    settings.eMode = modes[mode];
+    settings.flOneEuroMinCutoffHz = 1.0;
+    settings.flOneEuroPositionBeta = 100.0;
+    settings.flOneEuroRotationBeta = 10.0;
+    settings.flOneEuroDerivativeCutoffHz = 1.0;
+    settings.flKalmanPositionProcessNoise = 1.0;
+    settings.flKalmanPositionMeasurementNoise = 0.001;
+    settings.flKalmanRotationProcessNoise = 10.0;
+    settings.flKalmanRotationMeasurementNoise = 0.0087;
+
+    for (uint32_t devices : deviceCounts) {
+      static vr::PoseFilterBank filters; // ~50 KB of state, kept off the stack
+      filters.Configure(settings);
+      harness::LatencySamples samples(iterations);
+      const uint64_t allocations = harness::GetAllocationCount();
+      for (uint32_t i = 0; i < iterations; ++i) {
+        // Nudge the samples each frame so every pass filters a new measurement
+        for (uint32_t slot = 0; slot < devices; ++slot) {
+          poses[slot] = input[slot];
+          poses[slot].vecPosition[0] += 1e-4 * (i & 7);
+        }
+        const int64_t start = harness::NowNs();
+        filters.Apply(poses, filter, devices, i / 90.0);
+        samples.Add(harness::NowNs() - start);
+        harness::DoNotOptimize(poses);
+      }
+      printf("  %-7s devices=%-2u p50=%7lld ns  p99=%7lld ns  mean=%8.1f ns  (%.1f ns/device)  allocations=%llu\n", names[mode], devices,
+             (long long)samples.Percentile(50), (long long)samples.Percentile(99), samples.Mean(), samples.Mean() / devices,
+             (unsigned long long)(harness::GetAllocationCount() - allocations));
+    }
+  }
+}
@@ -0,0 +1,238 @@
+#include "harness/harness.h"
+#include "harness/scripted_driver_context.h"
+#include "pose_conversion.h"
+#include "pose_filter.h"
+#include "pose_recording.h"
+
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+
+namespace {
+
+const double k_flFrameSeconds = 1.0 / 90.0;
+const uint32_t k_unDevice = 1;          // The recorded controller
+const uint32_t k_unStillFrames = 180;   // 2 s held still...
+const uint32_t k_unMovingFrames = 180;  // ...then 2 s at constant linear and angular velocity
+const uint32_t k_unSettleFrames = 90;   // Skipped at the start of each segment before measuring
+const double k_flSpeed = 0.5;           // m/s along X
+const double k_flAngularSpeed = 1.0;    // rad/s about Y
+const double k_flPositionNoise = 0.001; // m, standard deviation per axis, like an optical tracker
+const double k_flRotationNoise = 0.5 * M_PI / 180.0; // rad, per axis
+
+void TruePose(uint32_t unFrame, double outPosition[3], double outRotation[4]) {
+  const double t = unFrame < k_unStillFrames ? 0.0 : (unFrame - k_unStillFrames) * k_flFrameSeconds;
+  outPosition[0] = 0.1 + k_flSpeed * t;
+  outPosition[1] = 1.2;
+  outPosition[2] = -0.3;
+  const double half = 0.5 * k_flAngularSpeed * t;
+  outRotation[0] = cos(half);
+  outRotation[1] = 0.0;
+  outRotation[2] = sin(half);
+  outRotation[3] = 0.0;
+}
+
+// Records the motion above, with Gaussian noise, the way the driver's recordPath does
+bool RecordNoisyMotion(const std::string& path) {
+  int32_t deviceClasses[vr::k_unMaxTrackedDeviceCount] = {};
+  int32_t controllerRoles[vr::k_unMaxTrackedDeviceCount] = {};
+  deviceClasses[k_unDevice] = vr::TrackedDeviceClass_Controller;
+  controllerRoles[k_unDevice] = vr::TrackedControllerRole_RightHand;
+
+  vr::PoseRecorder recorder;
+  if (!recorder.Open(path.c_str(), deviceClasses, controllerRoles)) {
+    return false;
+  }
+
+  std::mt19937 rng(12);
+  std::normal_distribution<double> positionNoise(0.0, k_flPositionNoise);
+  std::normal_distribution<double> rotationNoise(0.0, k_flRotationNoise);
+  vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+  memset(poses, 0, sizeof(poses));
+  for (uint32_t frame = 0; frame < k_unStillFrames + k_unMovingFrames; ++frame) {
+    double position[3];
+    double rotation[4];
+    TruePose(frame, position, rotation);
+    for (int k = 0; k < 3; ++k) {
+      position[k] += positionNoise(rng);
+    }
+
+    // Small rotation noise applied on top: exp(noise) * rotation
+    const double noise[3] = {rotationNoise(rng), rotationNoise(rng), rotationNoise(rng)};
+    const double d[4] = {1.0, 0.5 * noise[0], 0.5 * noise[1], 0.5 * noise[2]};
+    double noisy[4] = {d[0] * rotation[0] - d[1] * rotation[1] - d[2] * rotation[2] - d[3] * rotation[3],
+                       d[0] * rotation[1] + d[1] * rotation[0] + d[2] * rotation[3] - d[3] * rotation[2],
+                       d[0] * rotation[2] - d[1] * rotation[3] + d[2] * rotation[0] + d[3] * rotation[1],
+                       d[0] * rotation[3] + d[1] * rotation[2] - d[2] * rotation[1] + d[3] * rotation[0]};
+    const double norm = sqrt(noisy[0] * noisy[0] + noisy[1] * noisy[1] + noisy[2] * noisy[2] + noisy[3] * noisy[3]);
+    for (int i = 0; i < 4; ++i) {
+      noisy[i] /= norm;
+    }
+    harness::SetRawPose(poses[k_unDevice], position, noisy);
+    recorder.Record(poses, vr::k_unMaxTrackedDeviceCount);
+  }
+  recorder.Close();
+  return recorder.GetDroppedFrameCount() == 0;
+}
+
+// Jitter while still and lag while moving, each for position and rotation
+struct FilterError {
+  double flPositionJitter; // RMS distance to the true pose, m
+  double flRotationJitter; // RMS angle to the true pose, rad
+  double flPositionLag;    // Mean distance behind the true pose along the motion, s
+  double flRotationLag;    // Mean angle behind the true pose about the rotation axis, s
+  double flMaxNormError;   // Largest deviation of an output rotation from unit length
+};
+
+// Replays the recording through a PoseFilterBank configured with settings and scores the output
+FilterError ReplayThroughFilter(const std::string& path, const vr::PoseFilterSettings& settings) {
+  FilterError error = {};
+  vr::PoseReplay replay;
+  if (!replay.Open(path.c_str(), false, false)) {
+    error.flMaxNormError = INFINITY;
+    return error;
+  }
+
+  vr::PoseFilterBank filters;
+  filters.Configure(settings);
+  static vr::PoseConversionBatch batch;
+  vr::TrackedDevicePose_t raw[vr::k_unMaxTrackedDeviceCount];
+  const bool filter = true;
+
+  uint32_t stillCount = 0;
+  uint32_t movingCount = 0;
+  for (uint32_t frame = 0; frame < k_unStillFrames + k_unMovingFrames; ++frame) {
+    replay.Read(raw, vr::k_unMaxTrackedDeviceCount);
+    vr::ConvertRawPoses(raw, vr::k_unMaxTrackedDeviceCount, batch);
+
+    vr::DriverPose_t pose;
+    memset(&pose, 0, sizeof(pose));
+    pose.poseIsValid = true;
+    pose.deviceIsConnected = true;
+    pose.result = vr::TrackingResult_Running_OK;
+    pose.qRotation = {batch.rotation[0][k_unDevice], batch.rotation[1][k_unDevice], batch.rotation[2][k_unDevice], batch.rotation[3][k_unDevice]};
+    for (int k = 0; k < 3; ++k) {
+      pose.vecPosition[k] = batch.position[k][k_unDevice];
+    }
+    filters.Apply(&pose, &filter, 1, frame * k_flFrameSeconds);
+
+    double position[3];
+    double rotation[4];
+    TruePose(frame, position, rotation);
+    const vr::HmdQuaternion_t& q = pose.qRotation;
+    error.flMaxNormError = std::max(error.flMaxNormError, std::fabs(sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z) - 1.0));
+
+    // Rotation from the output to the true pose: rotation * conj(output), as a rotation vector (small angles)
+    double d[4] = {rotation[0] * q.w + rotation[1] * q.x + rotation[2] * q.y + rotation[3] * q.z,
+                   -rotation[0] * q.x + rotation[1] * q.w - rotation[2] * q.z + rotation[3] * q.y,
+                   -rotation[0] * q.y + rotation[1] * q.z + rotation[2] * q.w - rotation[3] * q.x,
+                   -rotation[0] * q.z - rotation[1] * q.y + rotation[2] * q.x + rotation[3] * q.w};
+    if (d[0] < 0.0) {
+      for (int i = 0; i < 4; ++i) {
+        d[i] = -d[i];
+      }
+    }
+
+    const bool still = frame < k_unStillFrames;
+    const uint32_t segmentFrame = still ? frame : frame - k_unStillFrames;
+    if (segmentFrame < k_unSettleFrames) {
+      continue;
+    }
+    if (still) {
+      for (int k = 0; k < 3; ++k) {
+        const double delta = pose.vecPosition[k] - position[k];
+        error.flPositionJitter += delta * delta;
+      }
+      const double angle = 2.0 * atan2(sqrt(d[1] * d[1] + d[2] * d[2] + d[3] * d[3]), d[0]);
+      error.flRotationJitter += angle * angle;
+      ++stillCount;
+    } else {
+      error.flPositionLag += (position[0] - pose.vecPosition[0]) / k_flSpeed;
+      error.flRotationLag += 2.0 * d[2] / k_flAngularSpeed;
+      ++movingCount;
+    }
+  }
+
+  error.flPositionJitter = sqrt(error.flPositionJitter / stillCount);
+  error.flRotationJitter = sqrt(error.flRotationJitter / stillCount);
+  error.flPositionLag /= movingCount;
+  error.flRotationLag /= movingCount;
+  return error;
+}
+
+// The defaults from default.vrsettings
+vr::PoseFilterSettings DefaultSettings(vr::EPoseFilterMode eMode) {
+  vr::PoseFilterSettings settings;
+  settings.eMode = eMode;
+  settings.flOneEuroMinCutoffHz = 1.0;
+  settings.flOneEuroPositionBeta = 100.0;
+  settings.flOneEuroRotationBeta = 10.0;
+  settings.flOneEuroDerivativeCutoffHz = 1.0;
+  settings.flKalmanPositionProcessNoise = 1.0;
+  settings.flKalmanPositionMeasurementNoise = 0.001;
+  settings.flKalmanRotationProcessNoise = 10.0;
+  settings.flKalmanRotationMeasurementNoise = 0.5 * M_PI / 180.0;
+  return settings;
+}
+
+// A recording in the temp directory, removed again when the test ends
+struct ScopedRecording {
+  explicit ScopedRecording(const char* pchName) : path((std::filesystem::temp_directory_path() / pchName).string()) {}
+  ~ScopedRecording() { std::remove(path.c_str()); }
+  std::string path;
+};
+
+}  // namespace
+
+HARNESS_TEST(pose_filter, OffReplaysTheRecordingUnchanged) {
+  ScopedRecording recording("mydriver_pose_filter_off.mdpr");
+  CHECK(RecordNoisyMotion(recording.path));
+  const FilterError raw = ReplayThroughFilter(recording.path, DefaultSettings(vr::PoseFilter_Off));
+
+  // The noise comes back as recorded, and the raw poses have no lag
+  CHECK_NEAR(raw.flPositionJitter, k_flPositionNoise * sqrt(3.0), 0.3 * k_flPositionNoise);
+  CHECK_NEAR(raw.flRotationJitter, k_flRotationNoise * sqrt(3.0), 0.3 * k_flRotationNoise);
+  CHECK_NEAR(raw.flPositionLag, 0.0, 0.001);
+  CHECK_NEAR(raw.flRotationLag, 0.0, 0.001);
+}
+
+HARNESS_TEST(pose_filter, OneEuroCutsJitterWithLittleLag) {
+  ScopedRecording recording("mydriver_pose_filter_one_euro.mdpr");
+  CHECK(RecordNoisyMotion(recording.path));
+  const FilterError raw = ReplayThroughFilter(recording.path, DefaultSettings(vr::PoseFilter_Off));
+  const FilterError filtered = ReplayThroughFilter(recording.path, DefaultSettings(vr::PoseFilter_OneEuro));
+
+  CHECK(filtered.flPositionJitter < 0.5 * raw.flPositionJitter);
+  CHECK(filtered.flRotationJitter < 0.5 * raw.flRotationJitter);
+  // Speed raises the cutoff, so the lag while moving stays at a few milliseconds
+  CHECK(filtered.flPositionLag >= 0.0 && filtered.flPositionLag < 0.010);
+  CHECK(filtered.flRotationLag >= 0.0 && filtered.flRotationLag < 0.030);
+  CHECK(filtered.flMaxNormError < 1e-6);
+}
+
+HARNESS_TEST(pose_filter, KalmanCutsJitterWithoutSteadyLag) {
+  ScopedRecording recording("mydriver_pose_filter_kalman.mdpr");
+  CHECK(RecordNoisyMotion(recording.path));
+  const FilterError raw = ReplayThroughFilter(recording.path, DefaultSettings(vr::PoseFilter_Off));
+
+  // The default process noise follows quick hand motion, so it only takes the edge off
+  const FilterError defaults = ReplayThroughFilter(recording.path, DefaultSettings(vr::PoseFilter_Kalman));
+  CHECK(defaults.flPositionJitter < 0.9 * raw.flPositionJitter);
+  CHECK(defaults.flRotationJitter < 0.9 * raw.flRotationJitter);
+
+  // Sized for the slow, steady motion of this recording it halves the jitter too
+  vr::PoseFilterSettings settings = DefaultSettings(vr::PoseFilter_Kalman);
+  settings.flKalmanPositionProcessNoise = 0.001;
+  settings.flKalmanRotationProcessNoise = 0.01;
+  const FilterError tuned = ReplayThroughFilter(recording.path, settings);
+  CHECK(tuned.flPositionJitter < 0.5 * raw.flPositionJitter);
+  CHECK(tuned.flRotationJitter < 0.5 * raw.flRotationJitter);
+
+  // Either way the constant-velocity model tracks constant motion with no steady-state lag
+  for (const FilterError* filtered : {&defaults, &tuned}) {
+    CHECK_NEAR(filtered->flPositionLag, 0.0, 0.005);
+    CHECK_NEAR(filtered->flRotationLag, 0.0, 0.005);
+    CHECK(filtered->flMaxNormError < 1e-6);
+  }
+}
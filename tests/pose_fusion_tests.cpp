@@ -0,0 +1,223 @@
+#include "harness/harness.h"
+#include "harness/provider_fixture.h"
+
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <thread>
+
+using harness::ProviderFixture;
+
+namespace {
+
+// The left controller (physical index 1) is the mirror's own device; the tracker at index 3 is
+// mounted on it at a fixed offset
+const uint32_t k_unController = 1;
+const uint32_t k_unTracker = 3;
+const double k_rgflTrackerPosition[3] = {0.2, 1.0, -0.5};
+const double k_rgflMountOffset[3] = {0.1, 0.05, 0.02};
+const double k_flGap = 0.1; // How far the controller's own pose is off the tracker's estimate, along x
+
+struct FusionScene {
+  vr::ETrackingResult eControllerResult = vr::TrackingResult_Fallback_RotationOnly;
+  double flTrackerYawRate = 0.0; // rad/s about y, the only motion in the scene
+};
+
+// Binds the tracker as the left controller mirror's extra source and scripts both devices still
+// (apart from the tracker's yaw), with the controller's pose k_flGap off the tracker's estimate
+void SetUpFusion(ProviderFixture& fixture, const FusionScene& scene, float flBlendMs) {
+  fixture.SetSetting("fusionBlendMs", flBlendMs);
+  fixture.AddDevices(3);
+  const char* pchSection = "driver_mydriver_fusion_my_left_controller_serial";
+  const std::string translation =
+      std::to_string(k_rgflMountOffset[0]) + " " + std::to_string(k_rgflMountOffset[1]) + " " + std::to_string(k_rgflMountOffset[2]);
+  fixture.Context().Settings().SetInt32(pchSection, "source1Index", (int32_t)k_unTracker);
+  fixture.Context().Settings().SetString(pchSection, "source1Translation", translation.c_str());
+
+  fixture.Host().SetPoseScript([&scene](uint32_t unDeviceIndex, double flTimeSeconds, vr::TrackedDevicePose_t& outPose) {
+    const double identity[4] = {1.0, 0.0, 0.0, 0.0};
+    if (unDeviceIndex == k_unController) {
+      const double position[3] = {k_rgflTrackerPosition[0] + k_rgflMountOffset[0] + k_flGap, k_rgflTrackerPosition[1] + k_rgflMountOffset[1],
+                                  k_rgflTrackerPosition[2] + k_rgflMountOffset[2]};
+      harness::SetRawPose(outPose, position, identity);
+      outPose.eTrackingResult = scene.eControllerResult;
+    } else if (unDeviceIndex == k_unTracker) {
+      const double yaw = scene.flTrackerYawRate * flTimeSeconds;
+      const double rotation[4] = {cos(yaw / 2.0), 0.0, sin(yaw / 2.0), 0.0};
+      harness::SetRawPose(outPose, k_rgflTrackerPosition, rotation);
+      outPose.vAngularVelocity.v[1] = (float)scene.flTrackerYawRate;
+    } else {
+      harness::CirclePoseScript(unDeviceIndex, flTimeSeconds, outPose);
+    }
+  });
+}
+
+// Where the tracker puts the mirror while it isn't turning
+double TrackerEstimate(int nAxis) {
+  return k_rgflTrackerPosition[nAxis] + k_rgflMountOffset[nAxis];
+}
+
+double DistanceToTrackerEstimate(const vr::DriverPose_t& pose) {
+  const double dx = pose.vecPosition[0] - TrackerEstimate(0), dy = pose.vecPosition[1] - TrackerEstimate(1), dz = pose.vecPosition[2] - TrackerEstimate(2);
+  return sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+double Distance(const double a[3], const double b[3]) {
+  return sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+}
+
+}  // namespace
+
+HARNESS_TEST(pose_fusion, TrackedSourceDominatesCoastingOne) {
+  FusionScene scene;
+  ProviderFixture fixture;
+  SetUpFusion(fixture, scene, 100.f);
+  fixture.Init();
+  const uint32_t mirror = fixture.GetMirror("my_left_controller_serial");
+  fixture.RunFrames(5);
+
+  // Weights 1 and 0.01: the output sits within 1% of the gap from the tracker's estimate
+  const vr::DriverPose_t& pose = fixture.Host().GetLastPose(mirror);
+  CHECK(pose.poseIsValid);
+  CHECK_EQ(pose.result, vr::TrackingResult_Running_OK);
+  CHECK(DistanceToTrackerEstimate(pose) < 0.011 * k_flGap);
+  CHECK(pose.vecPosition[0] > TrackerEstimate(0)); // Pulled a little toward the controller, not away
+
+  // Both tracked: they count the same, and the output is halfway
+  scene.eControllerResult = vr::TrackingResult_Running_OK;
+  std::this_thread::sleep_for(std::chrono::milliseconds(600)); // Six blend times for the shares to settle
+  fixture.RunFrames(1);
+  CHECK_NEAR(fixture.Host().GetLastPose(mirror).vecPosition[0], TrackerEstimate(0) + 0.5 * k_flGap, 0.01 * k_flGap);
+}
+
+// The tracker's pose is gone at once, so the jump is held as a correction that decays over the blend time
+HARNESS_TEST(pose_fusion, DroppedSourceDecaysInsteadOfJumping) {
+  const float blendMs = 50.f;
+  FusionScene scene;
+  ProviderFixture fixture;
+  SetUpFusion(fixture, scene, blendMs);
+  fixture.Init();
+  const uint32_t mirror = fixture.GetMirror("my_left_controller_serial");
+  fixture.RunFrames(5);
+  const double controller[3] = {TrackerEstimate(0) + k_flGap, TrackerEstimate(1), TrackerEstimate(2)};
+  double last[3];
+  for (int i = 0; i < 3; ++i) {
+    last[i] = fixture.Host().GetLastPose(mirror).vecPosition[i];
+  }
+  const double initialCorrection = Distance(last, controller);
+
+  fixture.Host().SetDeviceConnected(k_unTracker, false);
+  int64_t previousStart = harness::NowNs();
+  fixture.RunFrames(1);
+  const int64_t dropped = harness::NowNs();
+  const vr::DriverPose_t& pose = fixture.Host().GetLastPose(mirror);
+  CHECK(pose.poseIsValid);
+  CHECK_EQ(pose.result, vr::TrackingResult_Fallback_RotationOnly);
+  CHECK(Distance(pose.vecPosition, last) < 1e-9); // Held where it was
+
+  // Every frame moves toward the controller by at most the correction's decay over that frame, and
+  // the sweeps can't be further apart than the calls around them
+  int64_t start = harness::NowNs();
+  while (start - dropped < 5 * (int64_t)blendMs * 1000000) {
+    fixture.RunFrames(1);
+    const double boundSeconds = (harness::NowNs() - previousStart) / 1e9;
+    const double remaining = Distance(last, controller);
+    CHECK(Distance(pose.vecPosition, last) <= remaining * (1.0 - exp(-boundSeconds * 1000.0 / blendMs)) + 1e-9);
+    CHECK(Distance(pose.vecPosition, controller) <= remaining + 1e-9);
+    for (int i = 0; i < 3; ++i) {
+      last[i] = pose.vecPosition[i];
+    }
+    previousStart = start;
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    start = harness::NowNs();
+  }
+  fixture.RunFrames(1);
+  CHECK(Distance(pose.vecPosition, controller) <= initialCorrection * exp(-5.0) + 1e-9);
+}
+
+HARNESS_TEST(pose_fusion, ReturningSourceFadesIn) {
+  const float blendMs = 200.f;
+  FusionScene scene;
+  ProviderFixture fixture;
+  SetUpFusion(fixture, scene, blendMs);
+  fixture.Host().SetDeviceConnected(k_unTracker, false);
+  fixture.Init();
+  const uint32_t mirror = fixture.GetMirror("my_left_controller_serial");
+  fixture.RunFrames(4);
+  const int64_t before = harness::NowNs(); // Before the last sweep without the tracker
+  fixture.RunFrames(1);
+  const vr::DriverPose_t& pose = fixture.Host().GetLastPose(mirror);
+  CHECK_NEAR(DistanceToTrackerEstimate(pose), k_flGap, 1e-6); // The controller alone
+
+  // The tracker's share of the average ramps from zero, so the first frame only moves by the fade over it
+  fixture.Host().SetDeviceConnected(k_unTracker, true);
+  fixture.RunFrames(1);
+  const double boundSeconds = (harness::NowNs() - before) / 1e9;
+  const double moved = k_flGap - DistanceToTrackerEstimate(pose);
+  CHECK(moved >= -1e-6);
+  CHECK(moved <= k_flGap * (1.0 - exp(-boundSeconds * 1000.0 / blendMs)) + 1e-6);
+  CHECK(moved < 0.5 * k_flGap);
+
+  // ...and is all but complete after a few blend times
+  std::this_thread::sleep_for(std::chrono::milliseconds(5 * (int)blendMs));
+  fixture.RunFrames(1);
+  CHECK(DistanceToTrackerEstimate(pose) < 0.02 * k_flGap);
+  CHECK_EQ(pose.result, vr::TrackingResult_Running_OK);
+}
+
+// A source turning about its own origin moves the mirror at w x arm, where arm is the mount offset in
+// tracking space; compare against the central difference of the fused positions
+HARNESS_TEST(pose_fusion, MountArmVelocityMatchesFiniteDifference) {
+  FusionScene scene;
+  scene.flTrackerYawRate = 2.0;
+  ProviderFixture fixture;
+  SetUpFusion(fixture, scene, 100.f);
+  fixture.Host().SetDeviceConnected(k_unController, false); // The tracker alone, so nothing is averaged in
+  fixture.Init();
+  const uint32_t mirror = fixture.GetMirror("my_left_controller_serial");
+  fixture.RunFrames(5);
+
+  const double h = 0.001;
+  double positions[3][3];
+  double velocity[3];
+  for (int step = 0; step < 3; ++step) {
+    fixture.RunFrames(1, h);
+    const vr::DriverPose_t& pose = fixture.Host().GetLastPose(mirror);
+    CHECK(pose.poseIsValid);
+    for (int i = 0; i < 3; ++i) {
+      positions[step][i] = pose.vecPosition[i];
+      if (step == 1) {
+        velocity[i] = pose.vecVelocity[i];
+      }
+    }
+  }
+  double speed = 0.0;
+  for (int i = 0; i < 3; ++i) {
+    CHECK_NEAR(velocity[i], (positions[2][i] - positions[0][i]) / (2.0 * h), 1e-4);
+    speed += velocity[i] * velocity[i];
+  }
+  // |w x arm| for w along y: the arm's length in the xz plane times the yaw rate
+  CHECK_NEAR(sqrt(speed), scene.flTrackerYawRate * sqrt(k_rgflMountOffset[0] * k_rgflMountOffset[0] + k_rgflMountOffset[2] * k_rgflMountOffset[2]), 1e-5);
+}
+
+HARNESS_TEST(pose_fusion, FusedRunFrameDoesNotAllocate) {
+  FusionScene scene;
+  ProviderFixture fixture;
+  SetUpFusion(fixture, scene, 100.f);
+  fixture.Init();
+  fixture.RunFrames(10); // Drains the activation events
+  const uint32_t mirror = fixture.GetMirror("my_left_controller_serial");
+  CHECK(DistanceToTrackerEstimate(fixture.Host().GetLastPose(mirror)) < 0.011 * k_flGap); // Really fused
+
+  const uint64_t before = harness::GetAllocationCount();
+  for (int i = 0; i < 200; ++i) {
+    fixture.Context().AdvanceTime(1.0 / 90.0);
+    fixture.Provider().RunFrame();
+    if (i == 100) {
+      fixture.Host().SetDeviceConnected(k_unTracker, false); // Handover, then fading back in
+    } else if (i == 150) {
+      fixture.Host().SetDeviceConnected(k_unTracker, true);
+    }
+  }
+  CHECK_EQ(harness::GetAllocationCount() - before, 0u);
+}
@@ -0,0 +1,144 @@
+#include "harness/harness.h"
+#include "harness/provider_fixture.h"
+#include "pose_prediction.h"
+
+#include <cstring>
+
+using harness::ProviderFixture;
+
+namespace {
+
+vr::DriverPose_t MovingPose() {
+  vr::DriverPose_t pose;
+  memset(&pose, 0, sizeof(pose));
+  pose.poseIsValid = true;
+  pose.deviceIsConnected = true;
+  pose.result = vr::TrackingResult_Running_OK;
+  pose.qRotation = {1.0, 0.0, 0.0, 0.0};
+  pose.vecPosition[0] = 0.2;
+  pose.vecPosition[1] = 1.1;
+  pose.vecPosition[2] = -0.4;
+  pose.vecVelocity[0] = 1.5;
+  pose.vecVelocity[1] = -0.5;
+  pose.vecVelocity[2] = 0.25;
+  pose.vecAcceleration[1] = 9.8;
+  pose.vecAngularAcceleration[2] = 3.0;
+  return pose;
+}
+
+// Angle between two unit quaternions, in radians
+double AngleBetween(const vr::HmdQuaternion_t& a, const vr::HmdQuaternion_t& b) {
+  const double dot = std::fabs(a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z);
+  return 2.0 * std::acos(std::min(1.0, dot));
+}
+
+double DistanceToRaw(const vr::DriverPose_t& pose, const vr::TrackedDevicePose_t& raw) {
+  double sum = 0.0;
+  for (int k = 0; k < 3; ++k) {
+    const double d = pose.vecPosition[k] - raw.mDeviceToAbsoluteTracking.m[k][3];
+    sum += d * d;
+  }
+  return std::sqrt(sum);
+}
+
+}  // namespace
+
+HARNESS_TEST(pose_prediction, ExtrapolatedPoseHasZeroTimeOffset) {
+  vr::DriverPose_t pose = MovingPose();
+  vr::PredictDriverPose(pose, 0.011);
+  CHECK_EQ(pose.poseTimeOffset, 0.0);
+  for (int k = 0; k < 3; ++k) {
+    CHECK_EQ(pose.vecAcceleration[k], 0.0);
+    CHECK_EQ(pose.vecAngularAcceleration[k], 0.0);
+  }
+}
+
+HARNESS_TEST(pose_prediction, LinearMotionHasNoPositionError) {
+  const double horizon = 0.02;
+  const vr::DriverPose_t start = MovingPose();
+  vr::DriverPose_t predicted = start;
+  vr::PredictDriverPose(predicted, horizon);
+  for (int k = 0; k < 3; ++k) {
+    const double future = start.vecPosition[k] + start.vecVelocity[k] * horizon;
+    CHECK_NEAR(predicted.vecPosition[k], future, 1e-12);
+    CHECK_EQ(predicted.vecVelocity[k], start.vecVelocity[k]);
+  }
+}
+
+HARNESS_TEST(pose_prediction, ConstantSpinHasNoRotationError) {
+  // 2 rad/s about a tilted axis, from a rotated start
+  const double axis[3] = {0.0, 0.6, 0.8};
+  const double speed = 2.0;
+  const double horizon = 0.05;
+  vr::DriverPose_t pose = MovingPose();
+  pose.qRotation = {std::cos(0.3), std::sin(0.3), 0.0, 0.0};
+  for (int k = 0; k < 3; ++k) {
+    pose.vecAngularVelocity[k] = axis[k] * speed;
+  }
+
+  // Truth: the tracking-space delta rotation exp(w t / 2) applied before the start rotation
+  const double half = 0.5 * speed * horizon;
+  const vr::HmdQuaternion_t d = {std::cos(half), axis[0] * std::sin(half), axis[1] * std::sin(half), axis[2] * std::sin(half)};
+  const vr::HmdQuaternion_t q = pose.qRotation;
+  const vr::HmdQuaternion_t truth = {d.w * q.w - d.x * q.x - d.y * q.y - d.z * q.z, d.w * q.x + d.x * q.w + d.y * q.z - d.z * q.y,
+                                     d.w * q.y - d.x * q.z + d.y * q.w + d.z * q.x, d.w * q.z + d.x * q.y - d.y * q.x + d.z * q.w};
+
+  vr::PredictDriverPose(pose, horizon);
+  CHECK_NEAR(AngleBetween(pose.qRotation, truth), 0.0, 1e-6);
+  CHECK_NEAR(AngleBetween(q, truth), speed * horizon, 1e-6); // What sending the raw pose would be off by
+}
+
+HARNESS_TEST(pose_prediction, ZeroHorizonLeavesThePoseUnchanged) {
+  vr::DriverPose_t pose = MovingPose();
+  pose.vecAngularVelocity[1] = 1.0;
+  const vr::DriverPose_t start = pose;
+  vr::PredictDriverPose(pose, 0.0);
+  for (int k = 0; k < 3; ++k) {
+    CHECK_EQ(pose.vecPosition[k], start.vecPosition[k]);
+  }
+  CHECK_NEAR(AngleBetween(pose.qRotation, start.qRotation), 0.0, 1e-12);
+}
+
+// End to end: the submitted pose should be closer to where the scripted device is one horizon later
+// than the raw pose is, on a curved path where constant velocity is only an approximation
+HARNESS_TEST(pose_prediction, FixedHorizonReducesErrorOnACircle) {
+  const double horizon = 0.011;
+  ProviderFixture fixture;
+  fixture.SetSetting("predictionMode", 1.f);
+  fixture.SetSetting("predictionHorizonMs", (float)(horizon * 1000.0));
+  fixture.AddDevices(3);
+  fixture.Init();
+  const uint32_t tracker = fixture.GetMirror("my_mirror_3_serial");
+
+  double predictedError = 0.0;
+  double rawError = 0.0;
+  double worstRotationError = 0.0;
+  for (int frame = 0; frame < 90; ++frame) {
+    fixture.RunFrames(1);
+    const double now = fixture.Context().GetTime();
+    vr::TrackedDevicePose_t future;
+    harness::CirclePoseScript(3, now + horizon, future);
+    vr::TrackedDevicePose_t current;
+    harness::CirclePoseScript(3, now, current);
+
+    const vr::DriverPose_t& pose = fixture.Host().GetLastPose(tracker);
+    CHECK_EQ(pose.poseTimeOffset, 0.0);
+    predictedError = std::max(predictedError, DistanceToRaw(pose, future));
+    double sum = 0.0;
+    for (int k = 0; k < 3; ++k) {
+      const double d = current.mDeviceToAbsoluteTracking.m[k][3] - future.mDeviceToAbsoluteTracking.m[k][3];
+      sum += d * d;
+    }
+    rawError = std::max(rawError, std::sqrt(sum));
+
+    // The script yaws at 1 rad/s about +y
+    const double yaw = now + horizon + 0.3;
+    const vr::HmdQuaternion_t truth = {std::cos(yaw / 2.0), 0.0, std::sin(yaw / 2.0), 0.0};
+    worstRotationError = std::max(worstRotationError, AngleBetween(pose.qRotation, truth));
+  }
+
+  // Raw: speed * horizon = 0.1 m * pi rad/s * 11 ms = 3.5 mm. Predicted: only the chord error, r (w h)^2 / 2 = 0.06 mm
+  CHECK_NEAR(rawError, 0.1 * M_PI * horizon, 1e-4);
+  CHECK(predictedError < 0.1 * rawError);
+  CHECK_NEAR(worstRotationError, 0.0, 1e-5);
+}
@@ -0,0 +1,72 @@
+#include "harness/harness.h"
+#include "harness/provider_fixture.h"
+
+using harness::LatencySamples;
+using harness::ProviderFixture;
+
+namespace {
+
+const uint32_t k_rgunDeviceCounts[] = {1, 4, 16, 31}; // 31 physical + 31 mirrors + the HMD fill the host's 64 indices
+
+void PrintLatency(const char* pchWhat, uint32_t unDevices, LatencySamples& samples, double flAllocations, const char* pchAllocationUnit) {
+  printf("  %-9s devices=%-2u n=%-5zu p50=%8.2f us  p90=%8.2f us  p99=%8.2f us  max=%8.2f us  allocations=%.1f/%s\n", pchWhat, unDevices,
+         samples.GetCount(), samples.Percentile(50) * 1e-3, samples.Percentile(90) * 1e-3, samples.Percentile(99) * 1e-3,
+         samples.Percentile(100) * 1e-3, flAllocations, pchAllocationUnit);
+}
+
+}  // namespace
+
+// Init (device discovery, mirror creation, settings) through host-side activation, per device count
+HARNESS_BENCH(provider, Init) {
+  const uint32_t cycles = harness::IsQuickRun() ? 3 : 50;
+  for (uint32_t devices : k_rgunDeviceCounts) {
+    LatencySamples init(cycles);
+    LatencySamples activate(cycles);
+    uint64_t initAllocations = 0;
+    uint64_t activateAllocations = 0;
+    for (uint32_t cycle = 0; cycle < cycles; ++cycle) {
+      ProviderFixture fixture;
+      fixture.AddDevices(devices);
+
+      uint64_t allocations = harness::GetAllocationCount();
+      int64_t start = harness::NowNs();
+      fixture.InitProvider();
+      init.Add(harness::NowNs() - start);
+      initAllocations += harness::GetAllocationCount() - allocations;
+
+      allocations = harness::GetAllocationCount();
+      start = harness::NowNs();
+      fixture.Host().ActivatePendingDevices();
+      activate.Add(harness::NowNs() - start);
+      activateAllocations += harness::GetAllocationCount() - allocations;
+      fixture.RunFrames(1);
+    }
+    PrintLatency("Init", devices, init, (double)initAllocations / cycles, "call");
+    PrintLatency("Activate", devices, activate, (double)activateAllocations / cycles, "call");
+  }
+}
+
+// Steady-state RunFrame with every device moving, inline sampling (the default settings)
+HARNESS_BENCH(provider, RunFrame) {
+  const uint32_t frames = harness::IsQuickRun() ? 200 : 20000;
+  for (uint32_t devices : k_rgunDeviceCounts) {
+    ProviderFixture fixture;
+    fixture.AddDevices(devices);
+    fixture.Init();
+    fixture.RunFrames(100); // Warm-up; also drains the activation events
+
+    LatencySamples samples(frames);
+    const uint64_t updatesBefore = fixture.Host().GetTotalPoseUpdateCount();
+    const uint64_t allocations = harness::GetAllocationCount();
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+      fixture.Context().AdvanceTime(1.0 / 90.0);
+      const int64_t start = harness::NowNs();
+      fixture.Provider().RunFrame();
+      samples.Add(harness::NowNs() - start);
+    }
+    const double allocationsPerFrame = (double)(harness::GetAllocationCount() - allocations) / frames;
+    const double updatesPerFrame = (double)(fixture.Host().GetTotalPoseUpdateCount() - updatesBefore) / frames;
+    PrintLatency("RunFrame", devices, samples, allocationsPerFrame, "frame");
+    printf("  %-9s devices=%-2u pose updates/frame=%.2f\n", "", devices, updatesPerFrame);
+  }
+}
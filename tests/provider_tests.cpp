@@ -0,0 +1,176 @@
+#include "harness/harness.h"
+#include "harness/provider_fixture.h"
+#include "hand_skeleton.h"
+
+#include <cstring>
+
+using harness::ProviderFixture;
+
+HARNESS_TEST(provider, InitMirrorsControllersAndTrackers) {
+  ProviderFixture fixture;
+  fixture.AddDevices(4);
+  CHECK_EQ(fixture.Init(), vr::VRInitError_None);
+
+  CHECK_EQ(fixture.Host().GetAddedCount(), 4u);
+  CHECK(fixture.GetMirror("my_left_controller_serial") != vr::k_unTrackedDeviceIndexInvalid);
+  CHECK(fixture.GetMirror("my_right_controller_serial") != vr::k_unTrackedDeviceIndexInvalid);
+  CHECK(fixture.GetMirror("my_mirror_3_serial") != vr::k_unTrackedDeviceIndexInvalid);
+  CHECK(fixture.GetMirror("my_mirror_4_serial") != vr::k_unTrackedDeviceIndexInvalid);
+  CHECK_EQ(fixture.Context().GetMissingInterfaceCount(), 0u);
+}
+
+HARNESS_TEST(provider, RunFrameSubmitsTheScriptedPoses) {
+  ProviderFixture fixture;
+  fixture.AddDevices(3);
+  fixture.Init();
+  fixture.RunFrames(10);
+
+  const uint32_t tracker = fixture.GetMirror("my_mirror_3_serial");
+  CHECK_EQ(fixture.Host().GetPoseUpdateCount(tracker), 10u);
+
+  vr::TrackedDevicePose_t expected;
+  harness::CirclePoseScript(3, fixture.Context().GetTime(), expected);
+  const vr::DriverPose_t& pose = fixture.Host().GetLastPose(tracker);
+  CHECK(pose.poseIsValid);
+  CHECK(pose.deviceIsConnected);
+  CHECK_EQ(pose.result, vr::TrackingResult_Running_OK);
+  for (int k = 0; k < 3; ++k) {
+    CHECK_NEAR(pose.vecPosition[k], expected.mDeviceToAbsoluteTracking.m[k][3], 1e-6);
+    CHECK_NEAR(pose.vecVelocity[k], expected.vVelocity.v[k], 1e-6);
+  }
+  CHECK_NEAR(pose.poseTimeOffset, 0.0, 1e-3); // Sampled and sent in the same frame
+}
+
+HARNESS_TEST(provider, RunFrameSamplesTheHostOncePerFrame) {
+  ProviderFixture fixture;
+  fixture.AddDevices(8);
+  fixture.Init();
+  const uint64_t before = fixture.Host().GetRawPoseRequestCount();
+  fixture.RunFrames(20);
+  CHECK_EQ(fixture.Host().GetRawPoseRequestCount() - before, 20u);
+}
+
+HARNESS_TEST(provider, RunFrameDoesNotAllocate) {
+  ProviderFixture fixture;
+  fixture.AddDevices(16);
+  fixture.Init();
+  fixture.RunFrames(10); // Drains the activation events
+
+  const uint64_t before = harness::GetAllocationCount();
+  for (int i = 0; i < 200; ++i) {
+    fixture.Context().AdvanceTime(1.0 / 90.0);
+    fixture.Provider().RunFrame();
+  }
+  CHECK_EQ(harness::GetAllocationCount() - before, 0u);
+}
+
+HARNESS_TEST(provider, HotPluggedDeviceIsMirrored) {
+  ProviderFixture fixture;
+  fixture.AddDevices(2);
+  fixture.Init();
+  fixture.RunFrames(2);
+  CHECK_EQ(fixture.Host().GetAddedCount(), 2u);
+
+  const uint32_t index = fixture.Host().AddPhysicalDevice(vr::TrackedDeviceClass_GenericTracker, vr::TrackedControllerRole_Invalid, "late_tracker");
+  fixture.Host().QueueEvent(vr::VREvent_TrackedDeviceActivated, index);
+  fixture.RunFrames(3);
+
+  const std::string serial = "my_mirror_" + std::to_string(index) + "_serial";
+  const uint32_t mirror = fixture.GetMirror(serial.c_str());
+  CHECK(mirror != vr::k_unTrackedDeviceIndexInvalid);
+  CHECK(fixture.Host().GetPoseUpdateCount(mirror) > 0);
+  CHECK(fixture.Host().GetLastPose(mirror).poseIsValid);
+}
+
+HARNESS_TEST(provider, DisconnectedDeviceReportsOutOfRange) {
+  ProviderFixture fixture;
+  fixture.AddDevices(3);
+  fixture.Init();
+  fixture.RunFrames(2);
+
+  fixture.Host().SetDeviceConnected(3, false);
+  fixture.Host().QueueEvent(vr::VREvent_TrackedDeviceDeactivated, 3);
+  fixture.RunFrames(2);
+
+  const vr::DriverPose_t& pose = fixture.Host().GetLastPose(fixture.GetMirror("my_mirror_3_serial"));
+  CHECK(!pose.poseIsValid);
+  CHECK(pose.deviceIsConnected);
+  CHECK_EQ(pose.result, vr::TrackingResult_Running_OutOfRange);
+}
+
+HARNESS_TEST(provider, DebugRequestReportsCounters) {
+  ProviderFixture fixture;
+  fixture.AddDevices(1);
+  fixture.Init();
+  fixture.RunFrames(5);
+
+  const std::string response = fixture.DebugRequest(fixture.GetMirror("my_left_controller_serial"), "submit_counters");
+  CHECK(response == "{\"sent\":5,\"suppressed\":0}");
+}
+
+HARNESS_TEST(provider, RoleChangeFlipsTheMirrorsHand) {
+  ProviderFixture fixture;
+  fixture.AddDevices(1);
+  fixture.Init();
+  fixture.RunFrames(2);
+
+  const uint32_t mirror = fixture.GetMirror("my_left_controller_serial");
+  const vr::PropertyContainerHandle_t container = fixture.Context().Properties().TrackedDeviceToPropertyContainer(mirror);
+  int32_t role = vr::TrackedControllerRole_Invalid;
+  CHECK(fixture.Context().Properties().GetInt32(mirror, vr::Prop_ControllerRoleHint_Int32, role)); // Set on activation
+  CHECK_EQ(role, (int32_t)vr::TrackedControllerRole_LeftHand);
+  harness::ScriptedDriverInput& input = fixture.Context().Input();
+  const vr::VRInputComponentHandle_t left = input.Find(container, "/input/skeleton/left");
+  CHECK(left != vr::k_ulInvalidInputComponentHandle);
+  CHECK(input.Find(container, "/input/skeleton/right") == vr::k_ulInvalidInputComponentHandle);
+
+  // The physical controller at index 1 is handed to the other hand
+  fixture.Context().Properties().SetInt32(1, vr::Prop_ControllerRoleHint_Int32, vr::TrackedControllerRole_RightHand);
+  fixture.Host().QueueEvent(vr::VREvent_TrackedDeviceRoleChanged, 1);
+  fixture.RunFrames(2);
+
+  CHECK(fixture.Context().Properties().GetInt32(mirror, vr::Prop_ControllerRoleHint_Int32, role));
+  CHECK_EQ(role, (int32_t)vr::TrackedControllerRole_RightHand);
+
+  const vr::VRInputComponentHandle_t right = input.Find(container, "/input/skeleton/right");
+  CHECK(right != vr::k_ulInvalidInputComponentHandle);
+  CHECK(input.Get(right).unUpdates > 0);
+  const uint64_t leftUpdates = input.Get(left).unUpdates;
+
+  // The open right hand, where the left one was
+  alignas(32) vr::VRBoneTransform_t expected[vr::k_unHandBoneLanes];
+  const float openCurls[vr::HandFinger_Count] = {};
+  vr::BlendHandSkeleton(vr::GetHandSkeletonPoses(false), openCurls, expected);
+  bool differsFromLeft = false;
+  for (uint32_t bone = 0; bone < vr::HandBone_Count; ++bone) {
+    const vr::VRBoneTransform_t& submitted = input.Get(right).bones[vr::VRSkeletalMotionRange_WithController][bone];
+    for (int k = 0; k < 3; ++k) {
+      CHECK_NEAR(submitted.position.v[k], expected[bone].position.v[k], 1e-6);
+    }
+    CHECK_NEAR(submitted.orientation.w, expected[bone].orientation.w, 1e-6);
+    CHECK_NEAR(submitted.orientation.x, expected[bone].orientation.x, 1e-6);
+    differsFromLeft |= submitted.position.v[0] != input.Get(left).bones[vr::VRSkeletalMotionRange_WithController][bone].position.v[0];
+  }
+  CHECK(differsFromLeft);
+
+  // Only the new hand is updated from here on
+  const uint64_t rightUpdates = input.Get(right).unUpdates;
+  fixture.DebugRequest(mirror, "input 100 0 1"); // Grip clicked and fully pressed
+  fixture.RunFrames(1);
+  CHECK_EQ(input.Get(left).unUpdates, leftUpdates);
+  CHECK(input.Get(right).unUpdates > rightUpdates);
+
+  // The left hand is free again, so the next left controller takes over its serial and bindings
+  const uint32_t index = fixture.Host().AddPhysicalDevice(vr::TrackedDeviceClass_Controller, vr::TrackedControllerRole_LeftHand, "new_left_controller");
+  fixture.Host().QueueEvent(vr::VREvent_TrackedDeviceActivated, index);
+  fixture.RunFrames(2);
+  const uint32_t added = fixture.Host().GetAddedCount();
+  CHECK_EQ(added, 2u);
+  const uint32_t newMirror = index + 1;
+  CHECK(fixture.Host().IsAdded(newMirror));
+  CHECK(fixture.Host().GetAddedSerial(newMirror) == "my_left_controller_serial");
+  CHECK(fixture.Context().Properties().GetInt32(newMirror, vr::Prop_ControllerRoleHint_Int32, role));
+  CHECK_EQ(role, (int32_t)vr::TrackedControllerRole_LeftHand);
+  const vr::PropertyContainerHandle_t newContainer = fixture.Context().Properties().TrackedDeviceToPropertyContainer(newMirror);
+  CHECK(input.Find(newContainer, "/input/skeleton/left") != vr::k_ulInvalidInputComponentHandle);
+}